@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Souffle - A Datalog Compiler
+Copyright (c) 2021, The Souffle Developers. All rights reserved
+Licensed under the Universal Permissive License v 1.0 as shown at:
+- https://opensource.org/licenses/UPL
+- <souffle root>/licenses/SOUFFLE-UPL.txt
+
+Generates the input facts of the benchmark programs at a given scale.
+The facts only depend on the workload and the scale, so results of
+different machines and revisions are comparable.
+
+usage: generate.py <workload> <scale> <facts dir>
+"""
+
+import os
+import random
+import sys
+
+SCALES = ["small", "medium", "large"]
+
+
+def transitive_closure(rng, n):
+    nodes = {"small": 1000, "medium": 3000, "large": 6000}[n]
+    edges = set()
+    for x in range(nodes):
+        for _ in range(2):
+            y = x + rng.randint(1, 20)
+            if y < nodes:
+                edges.add((x, y))
+    return {"edge": sorted(edges)}
+
+
+def points_to(rng, n):
+    variables = {"small": 5000, "medium": 20000, "large": 80000}[n]
+    heaps = variables // 10
+
+    def var():
+        return "v%d" % rng.randrange(variables)
+
+    def heap():
+        return "h%d" % rng.randrange(heaps)
+
+    return {
+        "new": [(var(), heap()) for _ in range(variables // 5)],
+        "assign": [(var(), var()) for _ in range(variables)],
+        "load": [(var(), var()) for _ in range(variables // 8)],
+        "store": [(var(), var()) for _ in range(variables // 8)],
+    }
+
+
+def cspa(rng, n):
+    variables = {"small": 2000, "medium": 8000, "large": 20000}[n]
+    return {
+        "assign": [(rng.randrange(variables), rng.randrange(variables)) for _ in range(variables)],
+        "dereference": [(rng.randrange(variables), rng.randrange(variables)) for _ in range(variables // 4)],
+    }
+
+
+WORKLOADS = {
+    "transitive_closure": transitive_closure,
+    "points_to": points_to,
+    "cspa": cspa,
+}
+
+
+def generate(workload, scale, facts_dir):
+    """Writes the facts of a workload at a scale into a directory"""
+    rng = random.Random("%s/%s" % (workload, scale))
+    os.makedirs(facts_dir, exist_ok=True)
+    for relation, tuples in WORKLOADS[workload](rng, scale).items():
+        with open(os.path.join(facts_dir, relation + ".facts"), "w") as facts:
+            for t in tuples:
+                facts.write("\t".join(str(value) for value in t) + "\n")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 4 or sys.argv[1] not in WORKLOADS or sys.argv[2] not in SCALES:
+        sys.exit("usage: generate.py {%s} {%s} <facts dir>" % ("|".join(WORKLOADS), "|".join(SCALES)))
+    generate(sys.argv[1], sys.argv[2], sys.argv[3])
@@ -0,0 +1,349 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file data_structures.cpp
+ *
+ * Micro-benchmarks of the relation data structures and the symbol and
+ * record tables, reporting the best time of each operation as JSON.
+ *
+ * usage: souffle_micro_benchmarks [--size N] [--repeat R] [--filter TEXT]
+ *
+ ***********************************************************************/
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/datastructure/BTree.h"
+#include "souffle/datastructure/Brie.h"
+#include "souffle/datastructure/EquivalenceRelation.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace {
+
+using Pair = Tuple<RamDomain, 2>;
+
+/** The parameters of a run */
+struct Config {
+    std::size_t size = 1000000;
+    std::size_t repeat = 3;
+    std::string filter;
+};
+
+/** Measures operations and prints their results as a JSON array */
+class Bench {
+public:
+    explicit Bench(const Config& config) : config(config) {
+        std::cout << "[";
+    }
+
+    ~Bench() {
+        std::cout << "\n]\n";
+    }
+
+    /**
+     * Measures the best time of the given operation over all repetitions, where
+     * setup prepares each repetition without being measured and op performs the
+     * given number of operations, returning a checksum to keep it from being elided.
+     */
+    template <typename Setup, typename Op>
+    void run(const std::string& name, std::size_t operations, Setup setup, Op op) {
+        if (name.find(config.filter) == std::string::npos) {
+            return;
+        }
+        double best = -1;
+        std::size_t checksum = 0;
+        for (std::size_t i = 0; i < config.repeat; i++) {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            checksum += op();
+            auto end = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            if (best < 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+        std::cout << (first ? "\n" : ",\n") << R"(  {"name": "micro/)" << name << R"(", "seconds": )" << best
+                  << R"(, "operations": )" << operations << R"(, "checksum": )" << checksum << "}";
+        first = false;
+    }
+
+    template <typename Op>
+    void run(const std::string& name, std::size_t operations, Op op) {
+        run(name, operations, []() {}, op);
+    }
+
+private:
+    const Config& config;
+    bool first = true;
+};
+
+/** Pairs of a graph with size edges over size / 8 nodes, in random order */
+std::vector<Pair> randomPairs(std::size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    auto nodes = static_cast<RamDomain>(std::max<std::size_t>(size / 8, 1));
+    std::uniform_int_distribution<RamDomain> node(0, nodes);
+    std::vector<Pair> pairs(size);
+    for (auto& pair : pairs) {
+        pair = {node(rng), node(rng)};
+    }
+    return pairs;
+}
+
+void benchBTree(Bench& bench, const Config& config) {
+    using Set = btree_set<Pair>;
+    const auto pairs = randomPairs(config.size, 1);
+    const auto probes = randomPairs(config.size, 2);
+    const auto others = randomPairs(config.size, 3);
+
+    Set set;
+    bench.run(
+            "btree/insert", pairs.size(), [&]() { set.clear(); },
+            [&]() {
+                Set::operation_hints hints;
+                std::size_t res = 0;
+                for (const auto& pair : pairs) {
+                    res += set.insert(pair, hints);
+                }
+                return res;
+            });
+
+    bench.run("btree/lookup", probes.size(), [&]() {
+        Set::operation_hints hints;
+        std::size_t res = 0;
+        for (const auto& pair : probes) {
+            res += set.contains(pair, hints);
+        }
+        return res;
+    });
+
+    bench.run("btree/range", probes.size(), [&]() {
+        Set::operation_hints hints;
+        std::size_t res = 0;
+        for (const auto& probe : probes) {
+            auto it = set.lower_bound({probe[0], MIN_RAM_SIGNED}, hints);
+            auto end = set.upper_bound({probe[0], MAX_RAM_SIGNED}, hints);
+            for (; it != end; ++it) {
+                res++;
+            }
+        }
+        return res;
+    });
+
+    Set other(others.begin(), others.end());
+    Set merged;
+    bench.run(
+            "btree/merge", other.size(), [&]() { merged = set; },
+            [&]() {
+                merged.insert(other.begin(), other.end());
+                return merged.size();
+            });
+}
+
+void benchTrie(Bench& bench, const Config& config) {
+    const auto pairs = randomPairs(config.size, 1);
+    const auto probes = randomPairs(config.size, 2);
+    const auto others = randomPairs(config.size, 3);
+
+    Trie<2> trie;
+    bench.run(
+            "trie/insert", pairs.size(), [&]() { trie.clear(); },
+            [&]() {
+                Trie<2>::op_context ctxt;
+                std::size_t res = 0;
+                for (const auto& pair : pairs) {
+                    res += trie.insert({pair[0], pair[1]}, ctxt);
+                }
+                return res;
+            });
+
+    bench.run("trie/lookup", probes.size(), [&]() {
+        Trie<2>::op_context ctxt;
+        std::size_t res = 0;
+        for (const auto& pair : probes) {
+            res += trie.contains({pair[0], pair[1]}, ctxt);
+        }
+        return res;
+    });
+
+    bench.run("trie/range", probes.size(), [&]() {
+        Trie<2>::op_context ctxt;
+        std::size_t res = 0;
+        for (const auto& probe : probes) {
+            for (const auto& entry : trie.getBoundaries<1>({probe[0], 0}, ctxt)) {
+                res += static_cast<std::size_t>(entry[1] >= 0);
+            }
+        }
+        return res;
+    });
+
+    Trie<2> other;
+    for (const auto& pair : others) {
+        other.insert({pair[0], pair[1]});
+    }
+    Trie<2> merged;
+    bench.run(
+            "trie/merge", other.size(),
+            [&]() {
+                merged.clear();
+                merged.insertAll(trie);
+            },
+            [&]() {
+                merged.insertAll(other);
+                return merged.size();
+            });
+}
+
+void benchEqRel(Bench& bench, const Config& config) {
+    using EqRel = EquivalenceRelation<Pair>;
+    // classes of eight elements each, such that their closure stays linear in size
+    std::vector<Pair> pairs;
+    for (std::size_t i = 0; i < config.size / 8; i++) {
+        auto x = static_cast<RamDomain>(i);
+        pairs.push_back({x, static_cast<RamDomain>((i / 8) * 8)});
+    }
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(1));
+    const auto probes = randomPairs(config.size, 2);
+
+    EqRel eqrel;
+    bench.run(
+            "eqrel/insert", pairs.size(), [&]() { eqrel.clear(); },
+            [&]() {
+                std::size_t res = 0;
+                for (const auto& pair : pairs) {
+                    res += eqrel.insert(pair[0], pair[1]);
+                }
+                return res;
+            });
+
+    bench.run("eqrel/lookup", probes.size(), [&]() {
+        std::size_t res = 0;
+        for (const auto& pair : probes) {
+            res += eqrel.contains(pair[0], pair[1]);
+        }
+        return res;
+    });
+
+    bench.run("eqrel/range", probes.size(), [&]() {
+        std::size_t res = 0;
+        for (const auto& probe : probes) {
+            for (const auto& pair : eqrel.getBoundaries<1>({probe[0], 0})) {
+                res += static_cast<std::size_t>(pair[1] >= 0);
+            }
+        }
+        return res;
+    });
+
+    // joins the classes pairwise
+    EqRel other;
+    std::size_t links = 0;
+    for (std::size_t i = 0; i + 8 < pairs.size(); i += 16, links++) {
+        other.insert(static_cast<RamDomain>(i), static_cast<RamDomain>(i + 8));
+    }
+    EqRel merged;
+    bench.run(
+            "eqrel/merge", links,
+            [&]() {
+                merged.clear();
+                merged.insertAll(eqrel);
+            },
+            [&]() {
+                merged.insertAll(other);
+                return merged.size();
+            });
+}
+
+void benchSymbolTable(Bench& bench, const Config& config) {
+    std::vector<std::string> symbols;
+    for (std::size_t i = 0; i < config.size; i++) {
+        symbols.push_back("symbol_" + std::to_string((i * 7919) % config.size));
+    }
+
+    auto table = mk<SymbolTable>();
+    bench.run(
+            "symbol_table/encode", symbols.size(), [&]() { table = mk<SymbolTable>(); },
+            [&]() {
+                std::size_t res = 0;
+                for (const auto& symbol : symbols) {
+                    res += static_cast<std::size_t>(table->encode(symbol));
+                }
+                return res;
+            });
+
+    bench.run("symbol_table/decode", symbols.size(), [&]() {
+        std::size_t res = 0;
+        for (std::size_t i = 0; i < symbols.size(); i++) {
+            res += table->decode(static_cast<RamDomain>(i)).size();
+        }
+        return res;
+    });
+}
+
+void benchRecordTable(Bench& bench, const Config& config) {
+    const auto pairs = randomPairs(config.size, 1);
+
+    auto table = mk<RecordTable>();
+    std::vector<RamDomain> refs(pairs.size());
+    bench.run(
+            "record_table/pack", pairs.size(), [&]() { table = mk<RecordTable>(); },
+            [&]() {
+                std::size_t res = 0;
+                for (std::size_t i = 0; i < pairs.size(); i++) {
+                    refs[i] = table->pack(pairs[i].data(), 2);
+                    res += static_cast<std::size_t>(refs[i]);
+                }
+                return res;
+            });
+
+    bench.run("record_table/unpack", refs.size(), [&]() {
+        std::size_t res = 0;
+        for (auto ref : refs) {
+            res += static_cast<std::size_t>(table->unpack(ref, 2)[0]);
+        }
+        return res;
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--size") {
+            config.size = std::stoul(argv[i + 1]);
+        } else if (option == "--repeat") {
+            config.repeat = std::stoul(argv[i + 1]);
+        } else if (option == "--filter") {
+            config.filter = argv[i + 1];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--size N] [--repeat R] [--filter TEXT]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    Bench bench(config);
+    benchBTree(bench, config);
+    benchTrie(bench, config);
+    benchEqRel(bench, config);
+    benchSymbolTable(bench, config);
+    benchRecordTable(bench, config);
+    return EXIT_SUCCESS;
+}
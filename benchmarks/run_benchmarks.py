@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+Souffle - A Datalog Compiler
+Copyright (c) 2021, The Souffle Developers. All rights reserved
+Licensed under the Universal Permissive License v 1.0 as shown at:
+- https://opensource.org/licenses/UPL
+- <souffle root>/licenses/SOUFFLE-UPL.txt
+
+Runs the benchmark suite and writes its results as JSON.
+
+The Datalog workloads of programs/ are evaluated on generated facts at each
+requested scale, both interpreted and compiled, with each requested number
+of threads. The micro-benchmarks of the data structures are run if their
+executable is given. Every measurement is the best wall clock time of
+--repeat runs.
+
+If a baseline, i.e., the JSON results of a previous run, is given, each
+measurement is compared to it and slowdowns beyond --threshold are reported
+as regressions.
+
+usage: run_benchmarks.py --souffle <souffle> [--micro <souffle_micro_benchmarks>]
+                         [--workloads cspa,...] [--scales small,...] [--modes interpreter,compiled]
+                         [--jobs 1,8] [--repeat 3] [--output results.json]
+                         [--baseline baseline.json] [--threshold 0.1] [--fail-on-regression]
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+import generate
+
+BENCHMARK_DIR = os.path.dirname(os.path.abspath(__file__))
+PROGRAM_DIR = os.path.join(BENCHMARK_DIR, "programs")
+
+# the size of the data structures of the micro-benchmarks at each scale
+MICRO_SIZES = {"small": 100000, "medium": 1000000, "large": 10000000}
+
+
+def best_time(command, repeat):
+    """Returns the best wall clock time of running a command, or None if it fails"""
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = subprocess.run(command, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+        seconds = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.stderr.write("failed: %s\n%s" % (" ".join(command), result.stderr.decode()))
+            return None
+        best = seconds if best is None else min(best, seconds)
+    return best
+
+
+def run_programs(args, work_dir):
+    results = []
+    for workload in args.workloads:
+        program = os.path.join(PROGRAM_DIR, workload + ".dl")
+
+        # compile once, the compilation time is reported on its own
+        executable = os.path.join(work_dir, workload)
+        if "compiled" in args.modes:
+            compile_time = best_time([args.souffle, "-o", executable, program], 1)
+            results.append({"name": "compile/%s" % workload, "seconds": compile_time})
+
+        for scale in args.scales:
+            facts = os.path.join(work_dir, "facts", workload, scale)
+            generate.generate(workload, scale, facts)
+            output = os.path.join(work_dir, "output")
+            os.makedirs(output, exist_ok=True)
+            for mode in args.modes:
+                for jobs in args.jobs:
+                    options = ["-F", facts, "-D", output, "-j", str(jobs)]
+                    if mode == "interpreter":
+                        command = [args.souffle] + options + [program]
+                    else:
+                        command = [executable] + options
+                    seconds = best_time(command, args.repeat)
+                    results.append({
+                        "name": "program/%s/%s/%s/j%d" % (workload, scale, mode, jobs),
+                        "seconds": seconds,
+                    })
+                    print("%-60s %10s" % (results[-1]["name"], format_seconds(seconds)), flush=True)
+    return results
+
+
+def run_micro(args):
+    results = []
+    for scale in args.scales:
+        command = [args.micro, "--size", str(MICRO_SIZES[scale]), "--repeat", str(args.repeat)]
+        output = subprocess.run(command, stdout=subprocess.PIPE, check=True).stdout
+        for result in json.loads(output.decode()):
+            result["name"] = "%s/%s" % (result["name"], scale)
+            results.append(result)
+            print("%-60s %10s" % (result["name"], format_seconds(result["seconds"])), flush=True)
+    return results
+
+
+def format_seconds(seconds):
+    return "failed" if seconds is None else "%.3f" % seconds
+
+
+def compare(results, baseline, threshold):
+    """Prints the results next to the baseline and returns the names of all regressions"""
+    base = {result["name"]: result["seconds"] for result in baseline["results"]}
+    regressions = []
+    print("\n%-60s %10s %10s %8s" % ("benchmark", "seconds", "baseline", "ratio"))
+    for result in results:
+        name = result["name"]
+        seconds = result["seconds"]
+        reference = base.get(name)
+        if seconds is None or reference is None or reference <= 0:
+            print("%-60s %10s %10s %8s" % (name, format_seconds(seconds), format_seconds(reference), "-"))
+            continue
+        ratio = seconds / reference
+        marker = ""
+        if ratio > 1 + threshold:
+            regressions.append(name)
+            marker = "  REGRESSION"
+        print("%-60s %10.3f %10.3f %7.2fx%s" % (name, seconds, reference, ratio, marker))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Runs the benchmark suite of Souffle")
+    parser.add_argument("--souffle", required=True, help="the souffle executable")
+    parser.add_argument("--micro", help="the executable of the micro-benchmarks")
+    parser.add_argument("--workloads", default=",".join(generate.WORKLOADS))
+    parser.add_argument("--scales", default="small")
+    parser.add_argument("--modes", default="interpreter,compiled")
+    parser.add_argument("--jobs", default="1,%d" % (os.cpu_count() or 1))
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--output", default="benchmark_results.json")
+    parser.add_argument("--baseline", help="the results of a previous run to compare to")
+    parser.add_argument("--threshold", type=float, default=0.1, help="the slowdown reported as regression")
+    parser.add_argument("--fail-on-regression", action="store_true")
+    args = parser.parse_args()
+
+    args.workloads = [w for w in args.workloads.split(",") if w]
+    args.scales = [s for s in args.scales.split(",") if s]
+    args.modes = [m for m in args.modes.split(",") if m]
+    args.jobs = sorted(set(int(j) for j in args.jobs.split(",") if j))
+    for workload in args.workloads:
+        if workload not in generate.WORKLOADS:
+            parser.error("unknown workload %s" % workload)
+    for scale in args.scales:
+        if scale not in generate.SCALES:
+            parser.error("unknown scale %s" % scale)
+    for mode in args.modes:
+        if mode not in ("interpreter", "compiled"):
+            parser.error("unknown mode %s" % mode)
+
+    work_dir = tempfile.mkdtemp(prefix="souffle-benchmarks-")
+    try:
+        results = run_programs(args, work_dir)
+        if args.micro:
+            results += run_micro(args)
+    finally:
+        shutil.rmtree(work_dir, ignore_errors=True)
+
+    report = {
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "cpus": os.cpu_count(),
+        "date": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "souffle": os.path.abspath(args.souffle),
+        "repeat": args.repeat,
+        "results": results,
+    }
+    with open(args.output, "w") as output:
+        json.dump(report, output, indent=2)
+        output.write("\n")
+    print("\nresults written to %s" % args.output)
+
+    failed = [result["name"] for result in results if result["seconds"] is None]
+    regressions = []
+    if args.baseline:
+        with open(args.baseline) as baseline:
+            regressions = compare(results, json.load(baseline), args.threshold)
+        print("\n%d regression(s) beyond %.0f%%" % (len(regressions), args.threshold * 100))
+    if failed or (regressions and args.fail_on_regression):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
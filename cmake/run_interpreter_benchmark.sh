@@ -0,0 +1,64 @@
+# Souffle - A Datalog Compiler
+# Copyright (c) 2021 The Souffle Developers. All rights reserved
+# Licensed under the Universal Permissive License v 1.0 as shown at:
+# - https://opensource.org/licenses/UPL
+# - <souffle root>/licenses/SOUFFLE-UPL.txt
+
+# Measures the interpreter on the evaluation test programs.
+#
+# usage: run_interpreter_benchmark.sh <souffle> <evaluation dir> [<baseline souffle>]
+#
+# Every program is interpreted REPEAT times (default 3) and the best wall
+# clock time is reported.  If a baseline souffle executable is given, it is
+# measured as well and the speedup over the baseline is reported.
+
+set -e
+
+SOUFFLE="$1"
+EVAL_DIR="$2"
+BASELINE="$3"
+REPEAT="${REPEAT:-3}"
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+# Prints the best wall clock time in seconds of interpreting a program
+best_time() {
+    BEST=""
+    for _ in $(seq "${REPEAT}"); do
+        rm -rf "${WORK_DIR:?}"/*
+        START=$(date +%s.%N)
+        "$1" -D "${WORK_DIR}" -F "$3" "$2" > /dev/null 2>&1 || true
+        END=$(date +%s.%N)
+        BEST=$(echo "${START} ${END} ${BEST}" | awk '{t = $2 - $1; if ($3 != "" && $3 < t) t = $3; printf "%.3f", t}')
+    done
+    echo "${BEST}"
+}
+
+TOTAL=0
+BASELINE_TOTAL=0
+for DIR in "${EVAL_DIR}"/*/; do
+    NAME=$(basename "${DIR}")
+    PROGRAM="${DIR}${NAME}.dl"
+    [ -f "${PROGRAM}" ] || continue
+    FACTS="${DIR}facts"
+    [ -d "${FACTS}" ] || FACTS="${DIR}"
+
+    TIME=$(best_time "${SOUFFLE}" "${PROGRAM}" "${FACTS}")
+    TOTAL=$(echo "${TOTAL} ${TIME}" | awk '{printf "%.3f", $1 + $2}')
+    if [ -z "${BASELINE}" ]; then
+        printf "%-40s %10s\n" "${NAME}" "${TIME}"
+    else
+        BASE=$(best_time "${BASELINE}" "${PROGRAM}" "${FACTS}")
+        BASELINE_TOTAL=$(echo "${BASELINE_TOTAL} ${BASE}" | awk '{printf "%.3f", $1 + $2}')
+        printf "%-40s %10s %10s %8s\n" "${NAME}" "${TIME}" "${BASE}" \
+            "$(echo "${BASE} ${TIME}" | awk '{if ($2 > 0) printf "%.2fx", $1 / $2; else print "-"}')"
+    fi
+done
+
+if [ -z "${BASELINE}" ]; then
+    printf "%-40s %10s\n" "total" "${TOTAL}"
+else
+    printf "%-40s %10s %10s %8s\n" "total" "${TOTAL}" "${BASELINE_TOTAL}" \
+        "$(echo "${BASELINE_TOTAL} ${TOTAL}" | awk '{if ($2 > 0) printf "%.2fx", $1 / $2; else print "-"}')"
+fi
@@ -0,0 +1,169 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompilationCache.cpp
+ *
+ * Implements a persistent cache of compiled Datalog programs
+ *
+ ***********************************************************************/
+
+#include "CompilationCache.h"
+#include "Global.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/FileUtil.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#else
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid _getpid
+#endif
+
+namespace souffle {
+
+namespace {
+
+/** Options which do not influence the compiled program */
+bool isCacheOption(const std::string& option) {
+    return option == "cache-dir" || option == "cache-size";
+}
+
+/** Updates a 64-bit FNV-1a hash, which is stable across platforms and builds */
+void hashBytes(std::uint64_t& hash, const std::string& bytes) {
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // terminate the field so that consecutive fields cannot be confused
+    hash ^= 0xff;
+    hash *= 1099511628211ull;
+}
+
+}  // namespace
+
+CompilationCache::CompilationCache(std::string directory, std::size_t capacity)
+        : directory(std::move(directory)), capacity(capacity) {
+    // create the directory and all its parents
+    for (std::size_t pos = 1; pos <= this->directory.size(); ++pos) {
+        if (pos == this->directory.size() || this->directory[pos] == '/') {
+            std::string prefix = this->directory.substr(0, pos);
+            if (!existDir(prefix)) {
+                mkdir(prefix.c_str(), 0755);
+            }
+        }
+    }
+    if (!existDir(this->directory)) {
+        throw std::runtime_error("cannot create cache directory " + this->directory);
+    }
+}
+
+std::string CompilationCache::computeKey(const std::string& source) {
+    std::uint64_t hash = 14695981039346656037ull;
+    hashBytes(hash, std::to_string(RAM_DOMAIN_SIZE));
+    // the configuration includes the version, jobs, pragmas, provenance, directories, etc.
+    for (const auto& option : Global::config().data()) {
+        if (!isCacheOption(option.first)) {
+            hashBytes(hash, option.first);
+            hashBytes(hash, option.second);
+        }
+    }
+    hashBytes(hash, source);
+
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash << '-' << std::dec << source.size();
+    return key.str();
+}
+
+std::string CompilationCache::lookup(const std::string& key) const {
+    std::string path = pathJoin(directory, key);
+    if (!isExecutable(path)) {
+        return "";
+    }
+    // the modification time records the last use for the eviction
+    utime(path.c_str(), nullptr);
+    return path;
+}
+
+void CompilationCache::store(const std::string& key, const std::string& executable) const {
+    std::string path = pathJoin(directory, key);
+    // copy to a private file first, so that concurrent runs never see a partial entry
+    std::string partial = path + ".tmp" + std::to_string(getpid());
+    bool success;
+    {
+        std::ifstream src(executable, std::ios::binary);
+        std::ofstream dst(partial, std::ios::binary | std::ios::trunc);
+        success = src && dst && (dst << src.rdbuf()) && dst.flush();
+    }
+    success = success && chmod(partial.c_str(), 0755) == 0;
+    success = success && std::rename(partial.c_str(), path.c_str()) == 0;
+    if (!success) {
+        std::remove(partial.c_str());
+        if (!Global::config().has("no-warn")) {
+            std::cerr << "Warning: failed to store " << executable << " in the compilation cache "
+                      << directory << "\n";
+        }
+        return;
+    }
+    evict();
+}
+
+void CompilationCache::evict() const {
+#ifndef _WIN32
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    // (last use, size, path) of all complete entries
+    std::vector<std::tuple<time_t, std::size_t, std::string>> entries;
+    std::size_t total = 0;
+    while (const dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name[0] == '.' || name.find(".tmp") != std::string::npos) {
+            continue;
+        }
+        std::string path = pathJoin(directory, name);
+        struct stat info = {};
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            entries.emplace_back(info.st_mtime, info.st_size, path);
+            total += info.st_size;
+        }
+    }
+    closedir(dir);
+
+    std::sort(entries.begin(), entries.end());
+    for (const auto& entry : entries) {
+        if (total <= capacity) {
+            break;
+        }
+        if (std::remove(std::get<2>(entry).c_str()) == 0) {
+            total -= std::get<1>(entry);
+        }
+    }
+#endif
+}
+
+}  // end of namespace souffle
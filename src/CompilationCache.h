@@ -0,0 +1,70 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompilationCache.h
+ *
+ * Defines a persistent cache of compiled Datalog programs
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace souffle {
+
+/**
+ * A directory of compiled programs, keyed by a hash of the pre-processed
+ * source and the configuration they were compiled with.
+ *
+ * Entries are written atomically, so several souffle processes may share a
+ * cache directory. If the cache exceeds its capacity, the least recently used
+ * entries are removed.
+ */
+class CompilationCache {
+public:
+    /**
+     * Opens the cache in the given directory, which is created if it does not
+     * exist yet, holding at most capacity bytes.
+     */
+    CompilationCache(std::string directory, std::size_t capacity);
+
+    /**
+     * Computes the cache key of a pre-processed program for the current
+     * configuration, e.g., the number of jobs, pragmas, provenance, the domain
+     * size and the version of Souffle.
+     */
+    static std::string computeKey(const std::string& source);
+
+    /**
+     * Returns the path of the executable cached for the key, or an empty string
+     * if there is none.
+     */
+    std::string lookup(const std::string& key) const;
+
+    /**
+     * Copies the given executable into the cache and evicts the least recently
+     * used entries beyond the capacity.
+     */
+    void store(const std::string& key, const std::string& executable) const;
+
+private:
+    /** Removes the least recently used entries until the cache fits its capacity */
+    void evict() const;
+
+    /** Path of the cache directory */
+    const std::string directory;
+
+    /** Maximal size of all entries in bytes */
+    const std::size_t capacity;
+};
+
+}  // end of namespace souffle
@@ -16,6 +16,8 @@
 
 #include "tests/test.h"
 
+#include "Global.h"
+#include "RelationTag.h"
 #include "ast/Clause.h"
 #include "ast/Node.h"
 #include "ast/Program.h"
@@ -25,6 +27,7 @@
 #include "ast/analysis/ClauseNormalisation.h"
 #include "ast/transform/MagicSet.h"
 #include "ast/transform/MinimiseProgram.h"
+#include "ast/transform/PreparedQuery.h"
 #include "ast/transform/RemoveRedundantRelations.h"
 #include "ast/transform/RemoveRelationCopies.h"
 #include "ast/transform/ResolveAliases.h"
@@ -785,4 +788,40 @@ TEST(Transformers, MagicSetComprehensive) {
     });
     checkRelMapEq(finalProgram, mappifyRelations(program));
 }
+TEST(Transformers, PreparedQuery) {
+    ErrorReport e;
+    DebugReport d;
+
+    Own<TranslationUnit> tu = ParserDriver::parseTranslationUnit(
+            R"(
+                .decl edge(x:number, y:number)
+                .input edge
+                .decl reach(x:number, y:number)
+                reach(x, y) :- edge(x, y).
+                reach(x, z) :- reach(x, y), edge(y, z).
+                .decl unrelated(x:number)
+                unrelated(x) :- edge(x, _).
+            )",
+            e, d);
+    auto& program = tu->getProgram();
+
+    Global::config().set("prepared-query", "reach:bf");
+    EXPECT_TRUE(mk<PreparedQueryTransformer>()->apply(*tu));
+    Global::config().unset("prepared-query");
+    EXPECT_EQ(0, e.getNumErrors());
+
+    // the arguments hold the bound attribute, the answer all attributes
+    const auto* arguments = getRelation(program, QualifiedName({"@query", "reach", "bf", "args"}));
+    const auto* answer = getRelation(program, QualifiedName({"@query", "reach", "bf"}));
+    ASSERT_TRUE(arguments != nullptr);
+    ASSERT_TRUE(answer != nullptr);
+    EXPECT_EQ(1, arguments->getArity());
+    EXPECT_EQ(2, answer->getArity());
+    EXPECT_EQ(1, getClauses(program, *answer).size());
+
+    // only the queried relation and the relations it is derived from are evaluated on demand
+    EXPECT_TRUE(getRelation(program, "reach")->hasQualifier(RelationQualifier::MAGIC));
+    EXPECT_FALSE(getRelation(program, "edge")->hasQualifier(RelationQualifier::MAGIC));
+    EXPECT_FALSE(getRelation(program, "unrelated")->hasQualifier(RelationQualifier::MAGIC));
+}
 }  // namespace souffle::ast::transform::test
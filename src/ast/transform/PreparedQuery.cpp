@@ -0,0 +1,157 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file PreparedQuery.cpp
+ *
+ ***********************************************************************/
+
+#include "ast/transform/PreparedQuery.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ast/Atom.h"
+#include "ast/Attribute.h"
+#include "ast/Clause.h"
+#include "ast/Directive.h"
+#include "ast/Program.h"
+#include "ast/Relation.h"
+#include "ast/Variable.h"
+#include "ast/analysis/IOType.h"
+#include "ast/analysis/PrecedenceGraph.h"
+#include "ast/utility/Utils.h"
+#include "reports/ErrorReport.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <set>
+#include <utility>
+
+namespace souffle::ast::transform {
+
+std::vector<PreparedQueryTransformer::Query> PreparedQueryTransformer::getQueries() {
+    std::vector<Query> queries;
+    if (!Global::config().has("prepared-query")) {
+        return queries;
+    }
+    for (const auto& spec : splitString(Global::config().get("prepared-query"), ',')) {
+        std::size_t colon = spec.rfind(':');
+        if (colon == std::string::npos) {
+            queries.push_back({QualifiedName(splitString(spec, '.')), ""});
+        } else {
+            queries.push_back(
+                    {QualifiedName(splitString(spec.substr(0, colon), '.')), spec.substr(colon + 1)});
+        }
+    }
+    return queries;
+}
+
+QualifiedName PreparedQueryTransformer::getAnswerName(const Query& query) {
+    QualifiedName name(query.relation);
+    name.prepend("@query");
+    name.append(query.adornment);
+    return name;
+}
+
+QualifiedName PreparedQueryTransformer::getArgumentsName(const Query& query) {
+    QualifiedName name = getAnswerName(query);
+    name.append("args");
+    return name;
+}
+
+std::string PreparedQueryTransformer::getSubroutineName(const Query& query) {
+    return "query_" + toString(query.relation) + "_" + query.adornment;
+}
+
+bool PreparedQueryTransformer::transform(TranslationUnit& translationUnit) {
+    Program& program = translationUnit.getProgram();
+    ErrorReport& report = translationUnit.getErrorReport();
+    const auto& precedenceGraph = translationUnit.getAnalysis<analysis::PrecedenceGraphAnalysis>()->graph();
+    const auto& ioTypes = *translationUnit.getAnalysis<analysis::IOTypeAnalysis>();
+
+    // the queried relations and the relations they depend on are evaluated on demand
+    std::set<Relation*> demanded;
+    bool changed = false;
+    for (const auto& query : getQueries()) {
+        Relation* rel = getRelation(program, query.relation);
+        if (rel == nullptr) {
+            report.addDiagnostic(Diagnostic(Diagnostic::Type::ERROR,
+                    DiagnosticMessage("Prepared query of undefined relation " + toString(query.relation))));
+            continue;
+        }
+        if (query.adornment.size() != rel->getArity() ||
+                query.adornment.find_first_not_of("bf") != std::string::npos) {
+            report.addError("Prepared query of relation " + toString(query.relation) +
+                                    " requires an adornment of 'b' and 'f' for each of its " +
+                                    std::to_string(rel->getArity()) + " attributes",
+                    rel->getSrcLoc());
+            continue;
+        }
+        if (getRelation(program, getAnswerName(query)) != nullptr) {
+            continue;
+        }
+
+        // the relation holding the values of the bound attributes
+        auto arguments = mk<Relation>(getArgumentsName(query), rel->getSrcLoc());
+        auto argumentsAtom = mk<Atom>(getArgumentsName(query));
+        auto queriedAtom = mk<Atom>(query.relation);
+        auto answerAtom = mk<Atom>(getAnswerName(query));
+        for (std::size_t i = 0; i < rel->getArity(); i++) {
+            std::string var = "x" + std::to_string(i);
+            if (query.adornment[i] == 'b') {
+                arguments->addAttribute(clone(rel->getAttributes()[i]));
+                argumentsAtom->addArgument(mk<Variable>(var));
+            }
+            queriedAtom->addArgument(mk<Variable>(var));
+            answerAtom->addArgument(mk<Variable>(var));
+        }
+
+        // the relation holding the answer, i.e., the matching tuples of the queried relation
+        auto answer = mk<Relation>(getAnswerName(query), rel->getSrcLoc());
+        for (const auto* attr : rel->getAttributes()) {
+            answer->addAttribute(clone(attr));
+        }
+        auto clause = mk<Clause>(std::move(answerAtom), rel->getSrcLoc());
+        clause->addToBody(std::move(argumentsAtom));
+        clause->addToBody(std::move(queriedAtom));
+
+        // both relations are filled and read by the subroutine of the query rather than by IO
+        auto load = mk<Directive>(DirectiveType::input, getArgumentsName(query), rel->getSrcLoc());
+        load->addParameter("IO", IO_TYPE);
+        load->addParameter("operation", "input");
+        auto store = mk<Directive>(DirectiveType::output, getAnswerName(query), rel->getSrcLoc());
+        store->addParameter("IO", IO_TYPE);
+        store->addParameter("operation", "output");
+
+        program.addRelation(std::move(arguments));
+        program.addRelation(std::move(answer));
+        program.addClause(std::move(clause));
+        program.addDirective(std::move(load));
+        program.addDirective(std::move(store));
+        changed = true;
+
+        // collect the relations the queried relation depends on
+        std::vector<const Relation*> pending = {rel};
+        while (!pending.empty()) {
+            auto* cur = getRelation(program, pending.back()->getQualifiedName());
+            pending.pop_back();
+            if (ioTypes.isInput(cur) || !demanded.insert(cur).second) {
+                continue;
+            }
+            for (const auto* pred : precedenceGraph.predecessors(cur)) {
+                pending.push_back(pred);
+            }
+        }
+    }
+
+    for (auto* rel : demanded) {
+        rel->addQualifier(RelationQualifier::MAGIC);
+    }
+    return changed;
+}
+
+}  // namespace souffle::ast::transform
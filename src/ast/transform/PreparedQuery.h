@@ -0,0 +1,79 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file PreparedQuery.h
+ *
+ * Transformation pass preparing parameterised queries, which are answered
+ * by a demand-driven subroutine after the evaluation of the program.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ast/QualifiedName.h"
+#include "ast/TranslationUnit.h"
+#include "ast/transform/Transformer.h"
+#include <string>
+#include <vector>
+
+namespace souffle::ast::transform {
+
+/**
+ * Prepares the queries given by the option --prepared-query=<relation>:<adornment>,...
+ * where the adornment marks the bound attributes of the relation with 'b' and
+ * the free ones with 'f', e.g. reach:bf.
+ *
+ * For each query, an argument relation holding the values of the bound
+ * attributes and an answer relation are added:
+ *
+ *      @query.reach.bf(x0, x1) :- @query.reach.bf.args(x0), reach(x0, x1).
+ *
+ * The queried relation and all relations it depends on are subject to the
+ * magic-set transformation, so that the answer relation is computed from the
+ * arguments on demand only. The RAM translation generates a subroutine per
+ * query, which binds the arguments, re-evaluates the strata depending on them
+ * and returns the answer, while the rest of the program stays resident.
+ */
+class PreparedQueryTransformer : public Transformer {
+public:
+    /** A query of a relation for given values of the attributes bound by the adornment */
+    struct Query {
+        QualifiedName relation;
+        std::string adornment;
+    };
+
+    std::string getName() const override {
+        return "PreparedQueryTransformer";
+    }
+
+    /** Obtains the queries of the configuration */
+    static std::vector<Query> getQueries();
+
+    /** Obtains the relation holding the arguments of a query */
+    static QualifiedName getArgumentsName(const Query& query);
+
+    /** Obtains the relation holding the answer of a query */
+    static QualifiedName getAnswerName(const Query& query);
+
+    /** Obtains the subroutine answering a query */
+    static std::string getSubroutineName(const Query& query);
+
+    /** The IO type of the argument and answer relations, which are not read or written */
+    static constexpr const char* IO_TYPE = "prepared";
+
+private:
+    PreparedQueryTransformer* cloning() const override {
+        return new PreparedQueryTransformer();
+    }
+
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
+}  // namespace souffle::ast::transform
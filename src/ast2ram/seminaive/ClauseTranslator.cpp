@@ -17,6 +17,7 @@
 #include "ast2ram/seminaive/ClauseTranslator.h"
 #include "Global.h"
 #include "LogStatement.h"
+#include "RelationTag.h"
 #include "ast/Aggregator.h"
 #include "ast/BranchInit.h"
 #include "ast/Clause.h"
@@ -28,6 +29,7 @@
 #include "ast/Relation.h"
 #include "ast/StringConstant.h"
 #include "ast/UnnamedVariable.h"
+#include "ast/Variable.h"
 #include "ast/analysis/Functor.h"
 #include "ast/utility/Utils.h"
 #include "ast/utility/Visitor.h"
@@ -45,6 +47,7 @@
 #include "ram/FloatConstant.h"
 #include "ram/GuardedInsert.h"
 #include "ram/Insert.h"
+#include "ram/LeapfrogJoin.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
@@ -54,15 +57,59 @@
 #include "ram/SignedConstant.h"
 #include "ram/StringConstant.h"
 #include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
 #include "ram/UnpackRecord.h"
 #include "ram/UnsignedConstant.h"
 #include "ram/utility/Utils.h"
 #include "souffle/utility/StringUtil.h"
+#include <algorithm>
 #include <map>
+#include <optional>
+#include <set>
 #include <vector>
 
 namespace souffle::ast2ram::seminaive {
 
+namespace {
+/**
+ * Determine whether the hypergraph with the given edges is cyclic, i.e.,
+ * whether the GYO reduction leaves more than a single (empty) edge.
+ */
+bool isCyclic(std::vector<std::set<std::string>> edges) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        // remove vertices occurring in a single edge
+        for (auto& edge : edges) {
+            for (auto it = edge.begin(); it != edge.end();) {
+                bool isShared = std::any_of(edges.begin(), edges.end(),
+                        [&](const auto& other) { return &other != &edge && contains(other, *it); });
+                if (isShared) {
+                    ++it;
+                } else {
+                    it = edge.erase(it);
+                    changed = true;
+                }
+            }
+        }
+
+        // remove an edge contained in another edge
+        for (std::size_t i = 0; i < edges.size() && !changed; i++) {
+            for (std::size_t j = 0; j < edges.size(); j++) {
+                if (i != j && std::includes(edges[j].begin(), edges[j].end(), edges[i].begin(),
+                                      edges[i].end())) {
+                    edges.erase(edges.begin() + i);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return edges.size() > 1;
+}
+}  // namespace
+
 ClauseTranslator::ClauseTranslator(const TranslatorContext& context) : ast2ram::ClauseTranslator(context) {}
 
 ClauseTranslator::~ClauseTranslator() = default;
@@ -157,6 +204,11 @@ Own<ram::Statement> ClauseTranslator::createRamFactQuery(const ast::Clause& clau
 Own<ram::Statement> ClauseTranslator::createRamRuleQuery(const ast::Clause& clause) {
     assert(isRule(clause) && "clause should be rule");
 
+    // Cyclic joins are evaluated variable by variable
+    if (isLeapfrogJoin(clause)) {
+        return createLeapfrogRuleQuery(clause);
+    }
+
     // Index all variables and generators in the clause
     valueIndex = mk<ValueIndex>();
     indexClause(clause);
@@ -171,6 +223,168 @@ Own<ram::Statement> ClauseTranslator::createRamRuleQuery(const ast::Clause& clau
     return mk<ram::Query>(std::move(op));
 }
 
+bool ClauseTranslator::isLeapfrogJoin(const ast::Clause& clause) const {
+    const std::string& mode = Global::config().get("leapfrog");
+    if (mode == "none" || Global::config().has("provenance")) {
+        return false;
+    }
+
+    // leapfrog joins are not parallelised yet, so by default rules keep their parallel
+    // nested loops if several threads evaluate the program
+    if (mode != "all" && Global::config().has("jobs") && Global::config().get("jobs") != "1") {
+        return false;
+    }
+
+    // an execution plan for this version imposes nested loops
+    const auto* plan = clause.getExecutionPlan();
+    if (plan != nullptr && contains(plan->getOrders(), version)) {
+        return false;
+    }
+
+    // generators are introduced by their own operations
+    bool hasGenerator = false;
+    visit(clause, [&](const ast::Aggregator&) { hasGenerator = true; });
+    visit(clause, [&](const ast::IntrinsicFunctor& func) {
+        hasGenerator |= ast::analysis::FunctorAnalysis::isMultiResult(func);
+    });
+    if (hasGenerator) {
+        return false;
+    }
+
+    // atoms must be btrees over distinct variables and constants; floats are
+    // excluded since values may be equal with different representations
+    std::vector<std::set<std::string>> edges;
+    std::set<std::string> boundVariables;
+    for (const auto* atom : ast::getBodyLiterals<ast::Atom>(clause)) {
+        const auto* relation = context.getRelation(atom->getQualifiedName());
+        auto repr = relation->getRepresentation();
+        if (repr != RelationRepresentation::BTREE && repr != RelationRepresentation::DEFAULT) {
+            return false;
+        }
+        for (const auto* attribute : relation->getAttributes()) {
+            if (context.getAttributeTypeQualifier(attribute->getTypeName())[0] == 'f') {
+                return false;
+            }
+        }
+        std::set<std::string> variables;
+        for (const auto* arg : atom->getArguments()) {
+            if (const auto* var = as<ast::Variable>(arg)) {
+                if (!variables.insert(var->getName()).second) {
+                    return false;
+                }
+            } else if (!isA<ast::UnnamedVariable>(arg) && !isA<ast::Constant>(arg)) {
+                return false;
+            }
+        }
+        if (!variables.empty()) {
+            boundVariables.insert(variables.begin(), variables.end());
+            edges.push_back(std::move(variables));
+        }
+    }
+    if (edges.size() < 2) {
+        return false;
+    }
+
+    // every variable must be bound by an atom
+    bool isBound = true;
+    visit(clause, [&](const ast::Variable& var) { isBound &= contains(boundVariables, var.getName()); });
+    if (!isBound) {
+        return false;
+    }
+
+    return mode == "all" || isCyclic(edges);
+}
+
+Own<ram::Statement> ClauseTranslator::createLeapfrogRuleQuery(const ast::Clause& clause) {
+    const auto* head = clause.getHead();
+
+    // join the variables of the delta atom first
+    auto atoms = ast::getBodyLiterals<ast::Atom>(clause);
+    if (isRecursive()) {
+        const auto* delta = sccAtoms.at(version);
+        std::stable_partition(
+                atoms.begin(), atoms.end(), [&](const ast::Atom* atom) { return atom == delta; });
+    }
+
+    // each variable is bound by its own level, in order of first occurrence
+    valueIndex = mk<ValueIndex>();
+    std::vector<std::string> variables;
+    for (const auto* atom : atoms) {
+        for (const auto* arg : atom->getArguments()) {
+            const auto* var = as<ast::Variable>(arg);
+            if (var != nullptr && !valueIndex->isDefined(var->getName())) {
+                valueIndex->addVarReference(var->getName(), variables.size(), 0);
+                variables.push_back(var->getName());
+            }
+        }
+    }
+    auto isBoundBefore = [&](const ast::Argument* arg, int level) {
+        const auto* var = as<ast::Variable>(arg);
+        return isA<ast::Constant>(arg) ||
+               (var != nullptr && valueIndex->getDefinitionPoint(var->getName()).identifier < level);
+    };
+
+    // Set up the RAM statement bottom-up
+    auto op = createInsertion(clause);
+    op = addBodyLiteralConstraints(clause, std::move(op));
+
+    // join the atoms containing each variable
+    for (int level = variables.size() - 1; level >= 0; level--) {
+        std::vector<std::string> relations;
+        std::vector<VecOwn<ram::Expression>> patterns;
+        std::vector<std::size_t> columns;
+        for (const auto* atom : atoms) {
+            const auto& args = atom->getArguments();
+            VecOwn<ram::Expression> pattern;
+            std::optional<std::size_t> column;
+            for (std::size_t i = 0; i < args.size(); i++) {
+                const auto* var = as<ast::Variable>(args[i]);
+                if (var != nullptr && var->getName() == variables[level]) {
+                    column = i;
+                }
+                if (isBoundBefore(args[i], level)) {
+                    pattern.push_back(context.translateValue(*valueIndex, args[i]));
+                } else {
+                    pattern.push_back(mk<ram::UndefValue>());
+                }
+            }
+            if (column.has_value()) {
+                relations.push_back(getClauseAtomName(clause, atom));
+                patterns.push_back(std::move(pattern));
+                columns.push_back(*column);
+            }
+        }
+
+        if (head->getArity() == 0) {
+            op = mk<ram::Break>(mk<ram::Negation>(mk<ram::EmptinessCheck>(getClauseAtomName(clause, head))),
+                    std::move(op));
+        }
+        op = mk<ram::LeapfrogJoin>(
+                std::move(relations), std::move(patterns), std::move(columns), level, std::move(op));
+    }
+
+    // atoms without variables are checked upfront
+    for (const auto* atom : atoms) {
+        const auto& args = atom->getArguments();
+        std::string name = getClauseAtomName(clause, atom);
+        bool hasVariable = any_of(args, [](const ast::Argument* arg) { return isA<ast::Variable>(arg); });
+        bool hasConstant = any_of(args, [](const ast::Argument* arg) { return isA<ast::Constant>(arg); });
+        if (!hasVariable && hasConstant) {
+            VecOwn<ram::Expression> values;
+            for (const auto* arg : args) {
+                values.push_back(isA<ast::Constant>(arg) ? context.translateValue(*valueIndex, arg)
+                                                         : mk<ram::UndefValue>());
+            }
+            op = mk<ram::Filter>(mk<ram::ExistenceCheck>(name, std::move(values)), std::move(op));
+        } else {
+            op = mk<ram::Filter>(mk<ram::Negation>(mk<ram::EmptinessCheck>(name)), std::move(op));
+        }
+    }
+
+    op = addEntryPoint(clause, std::move(op));
+    return mk<ram::Query>(std::move(op));
+}
+
 Own<ram::Operation> ClauseTranslator::addEntryPoint(const ast::Clause& clause, Own<ram::Operation> op) const {
     auto cond = createCondition(clause);
     return cond != nullptr ? mk<ram::Filter>(std::move(cond), std::move(op)) : std::move(op);
@@ -239,7 +453,7 @@ Own<ram::Operation> ClauseTranslator::addAtomScan(
         }
 
         std::stringstream ss;
-        if (Global::config().has("profile")) {
+        if (Global::config().has("profile") || Global::config().has("profile-use")) {
             ss << "@frequency-atom" << ';';
             ss << clause.getHead()->getQualifiedName() << ';';
             ss << version << ';';
@@ -79,6 +79,10 @@ protected:
     virtual Own<ram::Statement> createRamFactQuery(const ast::Clause& clause) const;
     virtual Own<ram::Statement> createRamRuleQuery(const ast::Clause& clause);
 
+    /** Worst-case optimal joins */
+    bool isLeapfrogJoin(const ast::Clause& clause) const;
+    Own<ram::Statement> createLeapfrogRuleQuery(const ast::Clause& clause);
+
     virtual Own<ram::Operation> createInsertion(const ast::Clause& clause) const;
     virtual Own<ram::Condition> createCondition(const ast::Clause& clause) const;
 
@@ -19,9 +19,11 @@
 #include "ast/Directive.h"
 #include "ast/Relation.h"
 #include "ast/TranslationUnit.h"
+#include "ast/analysis/PrecedenceGraph.h"
 #include "ast/analysis/TopologicallySortedSCCGraph.h"
 #include "ast/utility/Utils.h"
 #include "ast/utility/Visitor.h"
+#include "ast/transform/PreparedQuery.h"
 #include "ast2ram/utility/TranslatorContext.h"
 #include "ast2ram/utility/Utils.h"
 #include "ram/Call.h"
@@ -51,6 +53,8 @@
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
 #include "ram/Statement.h"
+#include "ram/SubroutineArgument.h"
+#include "ram/SubroutineReturn.h"
 #include "ram/Swap.h"
 #include "ram/TranslationUnit.h"
 #include "ram/TupleElement.h"
@@ -77,6 +81,8 @@
 
 namespace souffle::ast2ram::seminaive {
 
+using ast::transform::PreparedQueryTransformer;
+
 UnitTranslator::UnitTranslator() : ast2ram::UnitTranslator() {}
 
 UnitTranslator::~UnitTranslator() = default;
@@ -147,7 +153,7 @@ Own<ram::Statement> UnitTranslator::generateNonRecursiveRelation(const ast::Rela
     return mk<ram::Sequence>(std::move(result));
 }
 
-Own<ram::Statement> UnitTranslator::generateStratum(std::size_t scc) const {
+Own<ram::Statement> UnitTranslator::generateStratum(std::size_t scc, bool storeOutputs) const {
     // Make a new ram statement for the current SCC
     VecOwn<ram::Statement> current;
 
@@ -167,8 +173,10 @@ Own<ram::Statement> UnitTranslator::generateStratum(std::size_t scc) const {
     }
 
     // Store all internal output relations to the output dir with a .csv extension
-    for (const auto& relation : context->getOutputRelationsInSCC(scc)) {
-        appendStmt(current, generateStoreRelation(relation));
+    if (storeOutputs) {
+        for (const auto& relation : context->getOutputRelationsInSCC(scc)) {
+            appendStmt(current, generateStoreRelation(relation));
+        }
     }
 
     return mk<ram::Sequence>(std::move(current));
@@ -285,7 +293,7 @@ Own<ram::Statement> UnitTranslator::generateStratumTableUpdates(
         std::string deltaRelation = getDeltaRelationName(rel->getQualifiedName());
         Own<ram::Statement> updateRelTable =
                 mk<ram::Sequence>(generateMergeRelations(rel, mainRelation, newRelation),
-                        mk<ram::Swap>(deltaRelation, newRelation), mk<ram::Clear>(newRelation));
+                        mk<ram::Swap>(deltaRelation, newRelation), mk<ram::Clear>(newRelation, true));
 
         // Measure update time
         if (Global::config().has("profile")) {
@@ -375,9 +383,19 @@ void UnitTranslator::addAuxiliaryArity(
     directives.insert(std::make_pair("auxArity", "0"));
 }
 
+bool UnitTranslator::isPreparedQueryDirective(const ast::Directive* directive) {
+    // the relations of prepared queries are filled and read by their subroutines
+    return directive->hasParameter("IO") &&
+           directive->getParameter("IO") == ast::transform::PreparedQueryTransformer::IO_TYPE;
+}
+
 Own<ram::Statement> UnitTranslator::generateLoadRelation(const ast::Relation* relation) const {
     VecOwn<ram::Statement> loadStmts;
     for (const auto* load : context->getLoadDirectives(relation->getQualifiedName())) {
+        if (isPreparedQueryDirective(load)) {
+            continue;
+        }
+
         // Set up the corresponding directive map
         std::map<std::string, std::string> directives;
         for (const auto& [key, value] : load->getParameters()) {
@@ -402,6 +420,10 @@ Own<ram::Statement> UnitTranslator::generateLoadRelation(const ast::Relation* re
 Own<ram::Statement> UnitTranslator::generateStoreRelation(const ast::Relation* relation) const {
     VecOwn<ram::Statement> storeStmts;
     for (const auto* store : context->getStoreDirectives(relation->getQualifiedName())) {
+        if (isPreparedQueryDirective(store)) {
+            continue;
+        }
+
         // Set up the corresponding directive map
         std::map<std::string, std::string> directives;
         for (const auto& [key, value] : store->getParameters()) {
@@ -471,20 +493,83 @@ Own<ram::Sequence> UnitTranslator::generateProgram(const ast::TranslationUnit& t
     const auto& sccOrdering =
             translationUnit.getAnalysis<ast::analysis::TopologicallySortedSCCGraphAnalysis>()->order();
 
+    // With streaming output, output relations not read by any later stratum expire after being stored
+    std::vector<std::set<const ast::Relation*>> storedRelations(sccOrdering.size());
+    if (Global::config().has("stream-output") && !Global::config().has("profile") &&
+            !Global::config().has("provenance")) {
+        std::set<const ast::Relation*> readLater;
+        for (std::size_t i = sccOrdering.size(); i-- > 0;) {
+            const auto& expiredRelations = context->getExpiredRelations(i);
+            readLater.insert(expiredRelations.begin(), expiredRelations.end());
+            for (const auto* relation : context->getOutputRelationsInSCC(sccOrdering.at(i))) {
+                if (!contains(readLater, relation)) {
+                    storedRelations[i].insert(relation);
+                }
+            }
+        }
+    }
+
+    // The relations answering prepared queries must outlive the evaluation of the program
+    const auto& precedenceGraph =
+            translationUnit.getAnalysis<ast::analysis::PrecedenceGraphAnalysis>()->graph();
+    std::set<const ast::Relation*> queriedRelations;
+    for (const auto& query : PreparedQueryTransformer::getQueries()) {
+        const auto* answer = context->getRelation(PreparedQueryTransformer::getAnswerName(query));
+        std::vector<const ast::Relation*> pending;
+        if (answer != nullptr) {
+            pending.push_back(answer);
+        }
+        while (!pending.empty()) {
+            const auto* cur = pending.back();
+            pending.pop_back();
+            if (queriedRelations.insert(cur).second) {
+                const auto& predecessors = precedenceGraph.predecessors(cur);
+                pending.insert(pending.end(), predecessors.begin(), predecessors.end());
+            }
+        }
+    }
+
+    // Relations expiring after the i-th stratum
+    auto getExpiredRelations = [&](std::size_t i) {
+        auto expiredRelations = context->getExpiredRelations(i);
+        expiredRelations.insert(storedRelations[i].begin(), storedRelations[i].end());
+        for (const auto* relation : queriedRelations) {
+            expiredRelations.erase(relation);
+        }
+        return expiredRelations;
+    };
+
     // Create subroutines for each SCC according to topological order
     for (std::size_t i = 0; i < sccOrdering.size(); i++) {
         // Generate the main stratum code
         auto stratum = generateStratum(sccOrdering.at(i));
 
         // Clear expired relations
-        const auto& expiredRelations = context->getExpiredRelations(i);
-        stratum = mk<ram::Sequence>(std::move(stratum), generateClearExpiredRelations(expiredRelations));
+        stratum = mk<ram::Sequence>(
+                std::move(stratum), generateClearExpiredRelations(getExpiredRelations(i)));
 
         // Add the subroutine
         std::string stratumID = "stratum_" + toString(i);
         addRamSubroutine(stratumID, std::move(stratum));
     }
 
+    // Create subroutines for each prepared query, and for each stratum re-evaluated by
+    // prepared queries, which does not store its output relations again
+    std::set<std::size_t> queriedStrata;
+    for (const auto& query : PreparedQueryTransformer::getQueries()) {
+        if (context->getRelation(PreparedQueryTransformer::getAnswerName(query)) != nullptr) {
+            addRamSubroutine(PreparedQueryTransformer::getSubroutineName(query),
+                    generatePreparedQuery(translationUnit, query));
+            const auto strata = getPreparedQueryStrata(translationUnit, query);
+            queriedStrata.insert(strata.begin(), strata.end());
+        }
+    }
+    for (std::size_t i : queriedStrata) {
+        addRamSubroutine("query_stratum_" + toString(i),
+                mk<ram::Sequence>(generateStratum(sccOrdering.at(i), false),
+                        generateClearExpiredRelations(getExpiredRelations(i))));
+    }
+
     // Invoke all strata
     VecOwn<ram::Statement> res;
     for (std::size_t i = 0; i < sccOrdering.size(); i++) {
@@ -502,6 +587,67 @@ Own<ram::Sequence> UnitTranslator::generateProgram(const ast::TranslationUnit& t
     return mk<ram::Sequence>(std::move(res));
 }
 
+Own<ram::Statement> UnitTranslator::generatePreparedQuery(
+        const ast::TranslationUnit& translationUnit, const PreparedQueryTransformer::Query& query) const {
+    const auto& precedenceGraph =
+            translationUnit.getAnalysis<ast::analysis::PrecedenceGraphAnalysis>()->graph();
+    const auto* arguments = context->getRelation(PreparedQueryTransformer::getArgumentsName(query));
+    const auto* answer = context->getRelation(PreparedQueryTransformer::getAnswerName(query));
+    VecOwn<ram::Statement> res;
+
+    // Discard the answer of the previous query, including all relations derived from its arguments
+    std::set<const ast::Relation*> demanded;
+    precedenceGraph.visit(arguments, [&](const ast::Relation* rel) { demanded.insert(rel); });
+    for (const auto* rel : demanded) {
+        appendStmt(res, generateClearRelation(rel));
+    }
+
+    // Bind the arguments
+    VecOwn<ram::Expression> values;
+    for (std::size_t i = 0; i < arguments->getArity(); i++) {
+        values.push_back(mk<ram::SubroutineArgument>(i));
+    }
+    std::string argumentsName = getConcreteRelationName(arguments->getQualifiedName());
+    appendStmt(res, mk<ram::Query>(mk<ram::Insert>(argumentsName, std::move(values))));
+
+    // Re-evaluate the strata depending on the arguments, the others are still resident
+    for (std::size_t i : getPreparedQueryStrata(translationUnit, query)) {
+        appendStmt(res, mk<ram::Call>("query_stratum_" + toString(i)));
+    }
+
+    // Return the answer
+    VecOwn<ram::Expression> returnValues;
+    for (std::size_t i = 0; i < answer->getArity(); i++) {
+        returnValues.push_back(mk<ram::TupleElement>(0, i));
+    }
+    std::string answerName = getConcreteRelationName(answer->getQualifiedName());
+    appendStmt(res, mk<ram::Query>(
+                            mk<ram::Scan>(answerName, 0, mk<ram::SubroutineReturn>(std::move(returnValues)))));
+
+    return mk<ram::Sequence>(std::move(res));
+}
+
+std::set<std::size_t> UnitTranslator::getPreparedQueryStrata(
+        const ast::TranslationUnit& translationUnit, const PreparedQueryTransformer::Query& query) const {
+    const auto& sccOrdering =
+            translationUnit.getAnalysis<ast::analysis::TopologicallySortedSCCGraphAnalysis>()->order();
+    const auto& precedenceGraph =
+            translationUnit.getAnalysis<ast::analysis::PrecedenceGraphAnalysis>()->graph();
+    const auto* arguments = context->getRelation(PreparedQueryTransformer::getArgumentsName(query));
+
+    // the strata of the relations derived from the arguments
+    std::set<const ast::Relation*> demanded;
+    precedenceGraph.visit(arguments, [&](const ast::Relation* rel) { demanded.insert(rel); });
+    std::set<std::size_t> strata;
+    for (std::size_t i = 0; i < sccOrdering.size(); i++) {
+        const auto& sccRelations = context->getRelationsInSCC(sccOrdering.at(i));
+        if (any_of(sccRelations, [&](const ast::Relation* rel) { return contains(demanded, rel); })) {
+            strata.insert(i);
+        }
+    }
+    return strata;
+}
+
 Own<ram::TranslationUnit> UnitTranslator::translateUnit(ast::TranslationUnit& tu) {
     /* -- Set-up -- */
     auto ram_start = std::chrono::high_resolution_clock::now();
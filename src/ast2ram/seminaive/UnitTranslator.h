@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "ast/transform/PreparedQuery.h"
 #include "ast2ram/UnitTranslator.h"
 #include "souffle/utility/ContainerUtil.h"
 #include <map>
@@ -23,6 +24,7 @@
 
 namespace souffle::ast {
 class Clause;
+class Directive;
 class Relation;
 class TranslationUnit;
 }  // namespace souffle::ast
@@ -66,9 +68,16 @@ protected:
     /** IO translation */
     Own<ram::Statement> generateStoreRelation(const ast::Relation* relation) const;
     Own<ram::Statement> generateLoadRelation(const ast::Relation* relation) const;
+    static bool isPreparedQueryDirective(const ast::Directive* directive);
 
-    /** Low-level stratum translation */
-    Own<ram::Statement> generateStratum(std::size_t scc) const;
+    /** Prepared query translation */
+    Own<ram::Statement> generatePreparedQuery(const ast::TranslationUnit& translationUnit,
+            const ast::transform::PreparedQueryTransformer::Query& query) const;
+    std::set<std::size_t> getPreparedQueryStrata(const ast::TranslationUnit& translationUnit,
+            const ast::transform::PreparedQueryTransformer::Query& query) const;
+
+    /** Low-level stratum translation, storing the output relations of the stratum unless disabled */
+    Own<ram::Statement> generateStratum(std::size_t scc, bool storeOutputs = true) const;
     Own<ram::Statement> generateStratumPreamble(const std::set<const ast::Relation*>& scc) const;
     Own<ram::Statement> generateStratumPostamble(const std::set<const ast::Relation*>& scc) const;
     Own<ram::Statement> generateStratumLoopBody(const std::set<const ast::Relation*>& scc) const;
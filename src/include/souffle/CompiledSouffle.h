@@ -23,8 +23,10 @@
 #include "souffle/SymbolTable.h"
 #include "souffle/datastructure/Brie.h"
 #include "souffle/datastructure/EquivalenceRelation.h"
+#include "souffle/datastructure/HashIndex.h"
 #include "souffle/datastructure/Table.h"
 #include "souffle/io/IOSystem.h"
+#include "souffle/io/OutputScheduler.h"
 #include "souffle/io/WriteStream.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
@@ -40,6 +42,7 @@
 #include "souffle/profile/Logger.h"
 #include "souffle/profile/ProfileEvent.h"
 #endif
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
@@ -146,6 +149,26 @@ public:
         }
         return relation.contains(t);
     }
+    void insertColumns(const RamDomain* const* columns, std::size_t n) override {
+        TupleType t;
+        auto h = relation.createContext();
+        for (std::size_t row = 0; row < n; row++) {
+            for (std::size_t i = 0; i < Arity; i++) {
+                t[i] = columns[i][row];
+            }
+            relation.insert(t, h);
+        }
+    }
+    std::size_t exportColumns(RamDomain* const* columns, std::size_t n) const override {
+        std::size_t row = 0;
+        for (auto it = relation.begin(); row < n && it != relation.end(); ++it, ++row) {
+            auto&& value = *it;
+            for (std::size_t i = 0; i < Arity; i++) {
+                columns[i][row] = value[i];
+            }
+        }
+        return row;
+    }
     std::size_t size() const override {
         return relation.size();
     }
@@ -256,7 +279,13 @@ public:
     void purge() {
         data = false;
     }
+    void reset() {
+        purge();
+    }
     void printStatistics(std::ostream& /* o */) const {}
+    std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {
+        return {{"[]", sizeof(*this)}};
+    }
 };
 
 /** Info relations */
@@ -339,7 +368,13 @@ public:
     void purge() {
         data.clear();
     }
+    void reset() {
+        purge();
+    }
     void printStatistics(std::ostream& /* o */) const {}
+    std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {
+        return {{"[]", sizeof(*this) + data.capacity() * sizeof(Tuple<RamDomain, Arity>)}};
+    }
 
 private:
     std::vector<Tuple<RamDomain, Arity>> data;
@@ -487,6 +522,9 @@ struct t_eqrel {
     void purge() {
         ind.clear();
     }
+    void reset() {
+        purge();
+    }
     iterator begin() const {
         return iterator(ind.begin());
     }
@@ -500,6 +538,9 @@ struct t_eqrel {
         return res;
     }
     void printStatistics(std::ostream& /* o */) const {}
+    std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {
+        return {{"[0,1]", ind.getMemoryUsage()}};
+    }
 };
 
 }  // namespace souffle
@@ -103,6 +103,14 @@ public:
         res = indexToRecord[index].data();
         return res;
     }
+
+    /** @brief number of records */
+    std::size_t size() const {
+        std::size_t res;
+#pragma omp critical(record_unpack)
+        res = indexToRecord.size() - 1;
+        return res;
+    }
 };
 
 class RecordTable {
@@ -126,6 +134,19 @@ public:
         return (iter->second).unpack(ref);
     }
 
+    /**
+     * @brief pack all records of another table in the order of their references
+     *
+     * Records packed into an empty table retain their references.
+     */
+    void packAll(const RecordTable& other) {
+        for (const auto& [arity, map] : other.maps) {
+            for (std::size_t i = 1; i <= map.size(); ++i) {
+                pack(map.unpack(static_cast<RamDomain>(i)), arity);
+            }
+        }
+    }
+
 private:
     /** @brief lookup RecordMap for a given arity; if it does not exist, create new RecordMap */
     RecordMap& lookupArity(std::size_t arity) {
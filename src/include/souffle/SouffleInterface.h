@@ -424,6 +424,27 @@ public:
      * in the table, set the next element pointer points to the current element itself.
      */
     virtual void purge() = 0;
+
+    /**
+     * Insert tuples given column by column.
+     *
+     * Column i holds the values of attribute i of all tuples, where symbols are given by their index in the
+     * symbol table (see SymbolTable::encode) and floats and unsigned numbers by their bit representation.
+     * Relations may override this method to insert the tuples without constructing tuple objects.
+     *
+     * @param columns The columns, one per attribute, each of n values
+     * @param n The number of tuples
+     */
+    virtual void insertColumns(const RamDomain* const* columns, std::size_t n);
+
+    /**
+     * Export tuples column by column, in the representation of insertColumns.
+     *
+     * @param columns The columns to fill, one per attribute, each of space for n values
+     * @param n The maximal number of tuples to export
+     * @return The number of tuples exported, i.e., the minimum of n and the size of the relation
+     */
+    virtual std::size_t exportColumns(RamDomain* const* columns, std::size_t n) const;
 };
 
 /**
@@ -685,6 +706,28 @@ public:
     }
 };
 
+inline void Relation::insertColumns(const RamDomain* const* columns, std::size_t n) {
+    tuple t(this);
+    for (std::size_t row = 0; row < n; row++) {
+        for (arity_type i = 0; i < getArity(); i++) {
+            t[i] = columns[i][row];
+        }
+        insert(t);
+    }
+}
+
+inline std::size_t Relation::exportColumns(RamDomain* const* columns, std::size_t n) const {
+    std::size_t row = 0;
+    const auto last = end();
+    for (auto it = begin(); row < n && it != last; ++it, ++row) {
+        const tuple& t = *it;
+        for (arity_type i = 0; i < getArity(); i++) {
+            columns[i][row] = t[i];
+        }
+    }
+    return row;
+}
+
 /**
  * Abstract base class for generated Datalog programs.
  */
@@ -776,6 +819,20 @@ public:
      */
     virtual void runAll(std::string inputDirectory = "", std::string outputDirectory = "") = 0;
 
+    /**
+     * Execute the statements of the main program from the given one on,
+     * loading inputs and storing outputs as required. This continues an
+     * evaluation whose relations, symbols and records have been transferred
+     * into the program; it is only supported by programs generated for
+     * tiered execution.
+     *
+     * @param statement Index of the first statement of the main program to execute
+     * @param counter Next value of the auto-increment counter
+     */
+    virtual void runFrom(std::size_t /* statement */, RamDomain /* counter */) {
+        fatal("resuming an evaluation is not supported");
+    }
+
     /**
      * Read all input relations.
      *
@@ -911,6 +968,24 @@ public:
         fatal("unknown subroutine");
     }
 
+    /**
+     * Answer a query prepared by --prepared-query=<relation>:<adornment>, after the program has run.
+     *
+     * The values of the bound attributes are given in order; the matching tuples of the relation
+     * are returned one after another, with all attributes. Queries must not be run concurrently.
+     *
+     * @param relation Name of the queried relation (std::string)
+     * @param adornment Bound ('b') and free ('f') attributes of the query (std::string)
+     * @param args Values of the bound attributes (std::vector<RamDomain>&)
+     * @return The flattened tuples of the answer (std::vector<RamDomain>)
+     */
+    std::vector<RamDomain> executeQuery(
+            const std::string& relation, const std::string& adornment, const std::vector<RamDomain>& args) {
+        std::vector<RamDomain> ret;
+        executeSubroutine("query_" + relation + "_" + adornment, args, ret);
+        return ret;
+    }
+
     /**
      * Get the symbol table of the program.
      */
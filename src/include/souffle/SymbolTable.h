@@ -21,6 +21,7 @@
 #include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <deque>
 #include <initializer_list>
@@ -45,9 +46,28 @@ private:
     /** Stores symbol indices to symbols information */
     std::deque<std::string> numToStr;
 
+    /** Stores symbol indices to the sort keys of symbols */
+    std::deque<uint64_t> numToKey;
+
     /** Stores symbols to symbol indices information */
     std::unordered_map<std::string, std::size_t> strToNum;
 
+    /**
+     * Get the sort key of a symbol, its first eight bytes in big-endian order.
+     * Symbols with different keys compare as their keys do; only symbols with
+     * equal keys need to be compared in full.
+     */
+    static uint64_t getSortKey(const std::string& symbol) {
+        uint64_t key = 0;
+        for (std::size_t i = 0; i < sizeof(key); i++) {
+            key <<= 8;
+            if (i < symbol.size()) {
+                key |= static_cast<unsigned char>(symbol[i]);
+            }
+        }
+        return key;
+    }
+
     /** Convenience method to place a new symbol in the table, if it does not exist, and return the index of
      * it; otherwise return the index. */
     inline std::size_t newSymbolOfIndex(const std::string& symbol) {
@@ -57,6 +77,7 @@ private:
             index = numToStr.size();
             strToNum[symbol] = index;
             numToStr.push_back(symbol);
+            numToKey.push_back(getSortKey(symbol));
         } else {
             index = it->second;
         }
@@ -71,6 +92,7 @@ public:
             if (strToNum.find(symbol) == strToNum.end()) {
                 strToNum[symbol] = numToStr.size();
                 numToStr.push_back(symbol);
+                numToKey.push_back(getSortKey(symbol));
             }
         }
     }
@@ -105,6 +127,53 @@ public:
         }
     }
 
+    /** Encode n symbols to symbol indexes, acquiring the lock once; this method is thread-safe. */
+    void encode(const std::string* symbols, std::size_t n, RamDomain* indexes) {
+        auto lease = access.acquire();
+        (void)lease;  // avoid warning;
+        for (std::size_t i = 0; i < n; i++) {
+            indexes[i] = static_cast<RamDomain>(newSymbolOfIndex(symbols[i]));
+        }
+    }
+
+    /** Decode n symbol indexes to symbols, acquiring the lock once; this method is thread-safe. */
+    void decode(const RamDomain* indexes, std::size_t n, std::string* symbols) const {
+        auto lease = access.acquire();
+        (void)lease;  // avoid warning;
+        for (std::size_t i = 0; i < n; i++) {
+            auto pos = static_cast<std::size_t>(indexes[i]);
+            if (pos >= size()) {
+                fatal("Error index out of bounds in call to `SymbolTable::decode`. index = `%d`", indexes[i]);
+            }
+            symbols[i] = numToStr[pos];
+        }
+    }
+
+    /**
+     * Compare the symbols of two symbol indexes lexicographically, returning a
+     * negative number, zero, or a positive number as std::string::compare does;
+     * this method is thread-safe.
+     */
+    int compare(const RamDomain left, const RamDomain right) const {
+        if (left == right) {
+            return 0;
+        }
+        auto lease = access.acquire();
+        (void)lease;  // avoid warning;
+        auto leftPos = static_cast<std::size_t>(left);
+        auto rightPos = static_cast<std::size_t>(right);
+        if (leftPos >= size() || rightPos >= size()) {
+            fatal("Error index out of bounds in call to `SymbolTable::compare`. index = `%d`",
+                    leftPos >= size() ? left : right);
+        }
+        const uint64_t leftKey = numToKey[leftPos];
+        const uint64_t rightKey = numToKey[rightPos];
+        if (leftKey != rightKey) {
+            return leftKey < rightKey ? -1 : 1;
+        }
+        return numToStr[leftPos].compare(numToStr[rightPos]);
+    }
+
     /** Acquire symbol table lock */
     Lock::Lease acquireLock() const {
         return access.acquire();
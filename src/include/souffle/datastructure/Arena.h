@@ -0,0 +1,215 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Arena.h
+ *
+ * A region of memory for the nodes of a data structure, which are
+ * released all at once.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/NumaUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace souffle {
+
+/**
+ * An arena serves the allocation of many small objects, e.g., the nodes of
+ * a tree, which are never released individually.
+ *
+ * Memory is obtained in chunks of growing size, up to the size of a huge page.
+ * Resetting the arena makes its chunks available to subsequent allocations
+ * without returning them to the system, so clearing a data structure which is
+ * filled again afterwards, e.g., the delta relation of a fixpoint computation,
+ * takes constant time and reuses its memory. Releasing the arena returns the
+ * chunks to the system.
+ *
+ * Chunks of the size of a huge page are aligned to it, and advised to be
+ * backed by transparent huge pages if enabled by setHugePages(). On NUMA
+ * machines, their pages may be interleaved across the nodes by
+ * setNumaInterleave(), such that parallel scans of large relations spread
+ * their memory traffic over all nodes.
+ *
+ * Allocations are thread-safe. Objects are not destructed by the arena.
+ */
+class Arena {
+public:
+    /** The alignment of all allocations, a cache line */
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    /** The size of the first chunk of an arena */
+    static constexpr std::size_t MIN_CHUNK_SIZE = 4096;
+
+    /** The size of a huge page, which is the size of all chunks of large arenas */
+    static constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept {
+        swap(other);
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        release();
+        swap(other);
+        return *this;
+    }
+
+    ~Arena() {
+        release();
+    }
+
+    /**
+     * Enables or disables the advice to back large arenas by transparent huge pages.
+     */
+    static void setHugePages(bool enabled) {
+        hugePages() = enabled;
+    }
+
+    /**
+     * Enables or disables interleaving the pages of large arenas across NUMA nodes.
+     */
+    static void setNumaInterleave(bool enabled) {
+        numaInterleave() = enabled;
+    }
+
+    /**
+     * Obtains memory for an object of the given size, aligned to a cache line.
+     */
+    void* allocate(std::size_t bytes) {
+        bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        lock.lock();
+        if (inUse == 0 || offset + bytes > chunks[inUse - 1].size) {
+            nextChunk(bytes);
+        }
+        void* res = chunks[inUse - 1].data + offset;
+        offset += bytes;
+        lock.unlock();
+        return res;
+    }
+
+    /**
+     * Makes all memory available to subsequent allocations, retaining it.
+     * All objects allocated so far become invalid.
+     */
+    void reset() {
+        inUse = 0;
+        offset = 0;
+    }
+
+    /**
+     * Returns all memory to the system. All objects allocated so far become invalid.
+     */
+    void release() {
+        for (const auto& chunk : chunks) {
+            ::operator delete(chunk.data, std::align_val_t(alignment(chunk.size)));
+        }
+        chunks.clear();
+        reserved = 0;
+        reset();
+    }
+
+    /**
+     * Swaps the memory of two arenas.
+     */
+    void swap(Arena& other) {
+        std::swap(chunks, other.chunks);
+        std::swap(inUse, other.inUse);
+        std::swap(offset, other.offset);
+        std::swap(reserved, other.reserved);
+    }
+
+    /**
+     * Obtains the number of bytes of all chunks of this arena, including retained ones.
+     */
+    std::size_t getMemoryUsage() const {
+        return reserved;
+    }
+
+private:
+    struct Chunk {
+        char* data;
+        std::size_t size;
+    };
+
+    static bool& hugePages() {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    static bool& numaInterleave() {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    static std::size_t alignment(std::size_t size) {
+        return (size >= HUGE_PAGE_SIZE) ? HUGE_PAGE_SIZE : ALIGNMENT;
+    }
+
+    /** Moves on to the next retained chunk fitting the given size, or obtains a new one */
+    void nextChunk(std::size_t bytes) {
+        offset = 0;
+        while (inUse < chunks.size()) {
+            if (chunks[inUse++].size >= bytes) {
+                return;
+            }
+        }
+
+        // the chunks double in size up to a huge page
+        std::size_t size = chunks.empty() ? MIN_CHUNK_SIZE : chunks.back().size;
+        if (!chunks.empty() && size < HUGE_PAGE_SIZE) {
+            size *= 2;
+        }
+        while (size < bytes) {
+            size *= 2;
+        }
+        auto* data = static_cast<char*>(::operator new(size, std::align_val_t(alignment(size))));
+#ifdef MADV_HUGEPAGE
+        if (size >= HUGE_PAGE_SIZE && hugePages()) {
+            madvise(data, size, MADV_HUGEPAGE);
+        }
+#endif
+        if (size >= HUGE_PAGE_SIZE && numaInterleave()) {
+            interleaveNumaNodes(data, size);
+        }
+        chunks.push_back({data, size});
+        reserved += size;
+        inUse = chunks.size();
+    }
+
+    // the chunks of this arena, in the order they are used
+    std::vector<Chunk> chunks;
+
+    // the number of chunks in use, the last one is filled up
+    std::size_t inUse = 0;
+
+    // the number of bytes allocated from the last chunk in use
+    std::size_t offset = 0;
+
+    // the number of bytes of all chunks
+    std::size_t reserved = 0;
+
+    // serializes allocations
+    SpinLock lock;
+};
+
+}  // end of namespace souffle
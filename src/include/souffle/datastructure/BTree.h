@@ -17,11 +17,13 @@
 
 #pragma once
 
+#include "souffle/datastructure/Arena.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -385,10 +387,10 @@ protected:
         /**
          * A deep-copy operation creating a clone of this node.
          */
-        node* clone() const {
+        node* clone(Arena& arena) const {
             // create a clone of this node
-            node* res = (this->isInner()) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* res = (this->isInner()) ? static_cast<node*>(newInner(arena))
+                                          : static_cast<node*>(newLeaf(arena));
 
             // copy basic fields
             res->position = this->position;
@@ -406,7 +408,7 @@ protected:
             // copy child nodes recursively
             auto* ires = (inner_node*)res;
             for (size_type i = 0; i <= this->numElements; ++i) {
-                ires->children[i] = this->getChild(i)->clone();
+                ires->children[i] = this->getChild(i)->clone(arena);
                 ires->children[i]->parent = res;
             }
 
@@ -544,14 +546,15 @@ protected:
          * @param idx  .. the position of the insert causing the split
          */
 #ifdef IS_PARALLEL
-        void split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        void split(node** root, lock_type& root_lock, Arena& arena, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void split(node** root, lock_type& root_lock, int idx) {
+        void split(node** root, lock_type& root_lock, Arena& arena, int idx) {
 #endif
             assert(this->numElements == maxKeys);
 
@@ -559,8 +562,8 @@ protected:
             int split_point = getSplitPoint(idx);
 
             // create a new sibling node
-            node* sibling = (this->inner) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* sibling = (this->inner) ? static_cast<node*>(newInner(arena))
+                                          : static_cast<node*>(newLeaf(arena));
 
 #ifdef IS_PARALLEL
             // lock sibling
@@ -590,9 +593,9 @@ protected:
 
             // update parent
 #ifdef IS_PARALLEL
-            grow_parent(root, root_lock, sibling, locked_nodes);
+            grow_parent(root, root_lock, arena, sibling, locked_nodes);
 #else
-            grow_parent(root, root_lock, sibling);
+            grow_parent(root, root_lock, arena, sibling);
 #endif
         }
 
@@ -609,14 +612,16 @@ protected:
          */
         // TODO: remove root_lock ... no longer needed
 #ifdef IS_PARALLEL
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        int rebalance_or_split(node** root, lock_type& root_lock, Arena& arena, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx) {
+        int rebalance_or_split(
+                node** root, lock_type& root_lock, Arena& arena, int idx) {
 #endif
 
             // this node is full ... and needs some space
@@ -634,7 +639,7 @@ protected:
                 // lock access to left sibling
                 if (!left->lock.try_start_write()) {
                     // left node is currently updated => skip balancing and split
-                    split(root, root_lock, idx, locked_nodes);
+                    split(root, root_lock, arena, idx, locked_nodes);
                     return 0;
                 }
 #endif
@@ -707,9 +712,9 @@ protected:
 
             // Option B) split node
 #ifdef IS_PARALLEL
-            split(root, root_lock, idx, locked_nodes);
+            split(root, root_lock, arena, idx, locked_nodes);
 #else
-            split(root, root_lock, idx);
+            split(root, root_lock, arena, idx);
 #endif
             return 0;  // = no re-balancing
         }
@@ -724,21 +729,23 @@ protected:
          * @param sibling .. the new right-sibling to be add to the parent node
          */
 #ifdef IS_PARALLEL
-        void grow_parent(node** root, lock_type& root_lock, node* sibling, std::vector<node*>& locked_nodes) {
+        void grow_parent(node** root, lock_type& root_lock, Arena& arena, node* sibling,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void grow_parent(node** root, lock_type& root_lock, node* sibling) {
+        void grow_parent(
+                node** root, lock_type& root_lock, Arena& arena, node* sibling) {
 #endif
 
             if (this->parent == nullptr) {
                 assert(*root == this);
 
                 // create a new root node
-                auto* new_root = new inner_node();
+                auto* new_root = newInner(arena);
                 new_root->numElements = 1;
                 new_root->keys[0] = keys[this->numElements];
 
@@ -759,10 +766,10 @@ protected:
                 auto pos = this->position;
 
 #ifdef IS_PARALLEL
-                parent->insert_inner(
-                        root, root_lock, pos, this, keys[this->numElements], sibling, locked_nodes);
+                parent->insert_inner(root, root_lock, arena, pos, this, keys[this->numElements], sibling,
+                        locked_nodes);
 #else
-                parent->insert_inner(root, root_lock, pos, this, keys[this->numElements], sibling);
+                parent->insert_inner(root, root_lock, arena, pos, this, keys[this->numElements], sibling);
 #endif
             }
         }
@@ -776,13 +783,13 @@ protected:
          * @param newNode .. the new right-child of the inserted key
          */
 #ifdef IS_PARALLEL
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode, std::vector<node*>& locked_nodes) {
+        void insert_inner(node** root, lock_type& root_lock, Arena& arena, unsigned pos,
+                node* predecessor, const Key& key, node* newNode, std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(souffle::contains(locked_nodes, this));
 #else
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode) {
+        void insert_inner(node** root, lock_type& root_lock, Arena& arena, unsigned pos,
+                node* predecessor, const Key& key, node* newNode) {
 #endif
 
             // check capacity
@@ -795,9 +802,9 @@ protected:
 
                 // split this node
 #ifdef IS_PARALLEL
-                pos -= rebalance_or_split(root, root_lock, pos, locked_nodes);
+                pos -= rebalance_or_split(root, root_lock, arena, pos, locked_nodes);
 #else
-                pos -= rebalance_or_split(root, root_lock, pos);
+                pos -= rebalance_or_split(root, root_lock, arena, pos);
 #endif
 
                 // complete insertion within new sibling if necessary
@@ -822,9 +829,10 @@ protected:
                     }
 
                     pos = (i > other->numElements) ? 0 : i;
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode, locked_nodes);
+                    other->insert_inner(
+                            root, root_lock, arena, pos, predecessor, key, newNode, locked_nodes);
 #else
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode);
+                    other->insert_inner(root, root_lock, arena, pos, predecessor, key, newNode);
 #endif
                     return;
                 }
@@ -1068,19 +1076,6 @@ protected:
 
         // a simple default constructor initializing member fields
         inner_node() : node(true) {}
-
-        // clear up child nodes recursively
-        ~inner_node() {
-            for (unsigned i = 0; i <= this->numElements; ++i) {
-                if (children[i] != nullptr) {
-                    if (children[i]->isLeaf()) {
-                        delete static_cast<leaf_node*>(children[i]);
-                    } else {
-                        delete static_cast<inner_node*>(children[i]);
-                    }
-                }
-            }
-        }
     };
 
     /**
@@ -1092,6 +1087,32 @@ protected:
         leaf_node() : node(false) {}
     };
 
+    // creates a leaf node in the given arena
+    static leaf_node* newLeaf(Arena& arena) {
+        return new (arena.allocate(sizeof(leaf_node))) leaf_node();
+    }
+
+    // creates an inner node in the given arena
+    static inner_node* newInner(Arena& arena) {
+        return new (arena.allocate(sizeof(inner_node))) inner_node();
+    }
+
+    // destroys the keys of the sub-tree rooted by the given node, whose memory is owned by the arena
+    static void destroy(node* cur) {
+        if (std::is_trivially_destructible<Key>::value || cur == nullptr) {
+            return;
+        }
+        if (cur->isLeaf()) {
+            static_cast<leaf_node*>(cur)->~leaf_node();
+            return;
+        }
+        auto* inner = static_cast<inner_node*>(cur);
+        for (unsigned i = 0; i <= inner->numElements; ++i) {
+            destroy(inner->children[i]);
+        }
+        inner->~inner_node();
+    }
+
     // ------------------- iterators ------------------------
 
 public:
@@ -1235,6 +1256,9 @@ protected:
     // a pointer to the left-most node of this tree (initial note for iteration)
     leaf_node* leftmost;
 
+    // the memory of the nodes of this tree
+    Arena arena;
+
     /* -------------- operator hint statistics ----------------- */
 
     // an aggregation of statistical values of the hint utilization
@@ -1273,7 +1297,8 @@ public:
 
     // a move constructor
     btree(btree&& other)
-            : comp(other.comp), weak_comp(other.weak_comp), root(other.root), leftmost(other.leftmost) {
+            : comp(other.comp), weak_comp(other.weak_comp), root(other.root), leftmost(other.leftmost),
+              arena(std::move(other.arena)) {
         other.root = nullptr;
         other.leftmost = nullptr;
     }
@@ -1289,7 +1314,8 @@ protected:
      * An internal constructor enabling the specific creation of a tree
      * based on internal parameters.
      */
-    btree(size_type /* size */, node* root, leaf_node* leftmost) : root(root), leftmost(leftmost) {}
+    btree(size_type /* size */, node* root, leaf_node* leftmost, Arena&& arena)
+            : root(root), leftmost(leftmost), arena(std::move(arena)) {}
 
 public:
     // the destructor freeing all contained nodes
@@ -1339,7 +1365,7 @@ public:
             }
 
             // create new node
-            leftmost = new leaf_node();
+            leftmost = newLeaf(arena);
             leftmost->numElements = 1;
             leftmost->keys[0] = k;
             root = leftmost;
@@ -1537,7 +1563,8 @@ public:
 
                 // split this node
                 auto old_root = root;
-                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, idx, parents);
+                idx -= cur->rebalance_or_split(
+                        const_cast<node**>(&root), root_lock, arena, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -1589,7 +1616,7 @@ public:
         // special handling for inserting first element
         if (empty()) {
             // create new node
-            leftmost = new leaf_node();
+            leftmost = newLeaf(arena);
             leftmost->numElements = 1;
             leftmost->keys[0] = k;
             root = leftmost;
@@ -1664,7 +1691,7 @@ public:
 
             if (cur->numElements >= node::maxKeys) {
                 // split this node
-                idx -= cur->rebalance_or_split(&root, root_lock, static_cast<int>(idx));
+                idx -= cur->rebalance_or_split(&root, root_lock, arena, static_cast<int>(idx));
 
                 // insert element in right fragment
                 if (((size_type)idx) > cur->numElements) {
@@ -1933,15 +1960,22 @@ public:
      * Clears this tree.
      */
     void clear() {
-        if (root != nullptr) {
-            if (root->isLeaf()) {
-                delete static_cast<leaf_node*>(root);
-            } else {
-                delete static_cast<inner_node*>(root);
-            }
-        }
+        destroy(root);
+        root = nullptr;
+        leftmost = nullptr;
+        arena.release();
+    }
+
+    /**
+     * Clears this tree, retaining the memory of its nodes for subsequent
+     * insertions. In contrast to clear(), this takes constant time for trees
+     * of trivially destructible keys.
+     */
+    void reset() {
+        destroy(root);
         root = nullptr;
         leftmost = nullptr;
+        arena.reset();
     }
 
     /**
@@ -1953,6 +1987,7 @@ public:
         // swap the content
         std::swap(root, other.root);
         std::swap(leftmost, other.leftmost);
+        arena.swap(other.arena);
     }
 
     // Implementation of the assignment operation for trees.
@@ -1963,13 +1998,15 @@ public:
         }
 
         // create a deep-copy of the content of the other tree
+        clear();
+
         // shortcut for empty sets
         if (other.empty()) {
             return *this;
         }
 
         // clone content (deep copy)
-        root = other.root->clone();
+        root = other.root->clone(arena);
 
         // update leftmost reference
         auto tmp = root;
@@ -2023,9 +2060,10 @@ public:
         return (empty()) ? 0 : root->countNodes();
     }
 
-    // Determines the amount of memory used by this data structure
+    // Determines the amount of memory used by this data structure, including the memory
+    // retained by reset(), which is cheap enough to be sampled while running
     size_type getMemoryUsage() const {
-        return sizeof(*this) + (empty() ? 0 : root->getMemoryUsage());
+        return sizeof(*this) + arena.getMemoryUsage();
     }
 
     /*
@@ -2100,7 +2138,8 @@ public:
         }
 
         // resolve tree recursively
-        auto root = buildSubTree(a, b - 1);
+        Arena arena;
+        auto root = buildSubTree(arena, a, b - 1);
 
         // find leftmost node
         node* leftmost = root;
@@ -2109,7 +2148,7 @@ public:
         }
 
         // build result
-        return R(b - a, root, static_cast<leaf_node*>(leftmost));
+        return R(b - a, root, static_cast<leaf_node*>(leftmost), std::move(arena));
     }
 
 protected:
@@ -2153,7 +2192,7 @@ private:
 
     // Utility function for the load operation above.
     template <typename Iter>
-    static node* buildSubTree(const Iter& a, const Iter& b) {
+    static node* buildSubTree(Arena& arena, const Iter& a, const Iter& b) {
         const int N = node::maxKeys;
 
         // divide range in N+1 sub-ranges
@@ -2162,7 +2201,7 @@ private:
         // terminal case: length is less then maxKeys
         if (length <= N) {
             // create a leaf node
-            node* res = new leaf_node();
+            node* res = newLeaf(arena);
             res->numElements = length;
 
             for (int i = 0; i < length; ++i) {
@@ -2182,7 +2221,7 @@ private:
         }
 
         // create inner node
-        node* res = new inner_node();
+        node* res = newInner(arena);
         res->numElements = numKeys;
 
         Iter c = a;
@@ -2191,7 +2230,7 @@ private:
             res->keys[i] = c[step];
 
             // get sub-tree
-            auto child = buildSubTree(c, c + (step - 1));
+            auto child = buildSubTree(arena, c, c + (step - 1));
             child->parent = res;
             child->position = i;
             res->getChildren()[i] = child;
@@ -2200,7 +2239,7 @@ private:
         }
 
         // and the remaining part
-        auto child = buildSubTree(c, b);
+        auto child = buildSubTree(arena, c, b);
         child->parent = res;
         child->position = numKeys;
         res->getChildren()[numKeys] = child;
@@ -2264,7 +2303,8 @@ public:
 private:
     // A constructor required by the bulk-load facility.
     template <typename s, typename n, typename l>
-    btree_set(s size, n* root, l* leftmost) : super(size, root, leftmost) {}
+    btree_set(s size, n* root, l* leftmost, Arena&& arena)
+            : super(size, root, leftmost, std::move(arena)) {}
 
 public:
     // Support for the assignment operator.
@@ -2326,7 +2366,8 @@ public:
 private:
     // A constructor required by the bulk-load facility.
     template <typename s, typename n, typename l>
-    btree_multiset(s size, n* root, l* leftmost) : super(size, root, leftmost) {}
+    btree_multiset(s size, n* root, l* leftmost, Arena&& arena)
+            : super(size, root, leftmost, std::move(arena)) {}
 
 public:
     // Support for the assignment operator.
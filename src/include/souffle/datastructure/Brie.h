@@ -391,6 +391,9 @@ private:
         index_type firstOffset;
     };
 
+    // the number of bytes allocated for nodes of the tree
+    std::atomic<std::size_t> allocatedBytes{0};
+
     union {
         RootInfo unsynced;         // for sequential operations
         volatile RootInfo synced;  // for synchronized operations
@@ -422,7 +425,8 @@ public:
      * handed in array.
      */
     SparseArray(SparseArray&& other)
-            : unsynced(RootInfo{other.unsynced.root, other.unsynced.levels, other.unsynced.offset,
+            : allocatedBytes(other.allocatedBytes.exchange(0)),
+              unsynced(RootInfo{other.unsynced.root, other.unsynced.levels, other.unsynced.offset,
                       other.unsynced.first, other.unsynced.firstOffset}) {
         other.unsynced.root = nullptr;
         other.unsynced.levels = 0;
@@ -471,6 +475,7 @@ public:
         clean();
 
         // harvest content
+        allocatedBytes = other.allocatedBytes.exchange(0);
         unsynced.root = other.unsynced.root;
         unsynced.levels = other.unsynced.levels;
         unsynced.offset = other.unsynced.offset;
@@ -510,43 +515,13 @@ public:
         return res;
     }
 
-private:
     /**
-     * Computes the memory usage of the given sub-tree.
-     */
-    static std::size_t getMemoryUsage(const Node* node, int level) {
-        // support null-nodes
-        if (!node) return 0;
-
-        // add size of current node
-        std::size_t res = sizeof(Node);
-
-        // sum up memory usage of child nodes
-        if (level > 0) {
-            for (int i = 0; i < NUM_CELLS; i++) {
-                res += getMemoryUsage(node->cell[i].ptr, level - 1);
-            }
-        }
-
-        // done
-        return res;
-    }
-
-public:
-    /**
-     * Computes the total memory usage of this data structure.
+     * Computes the total memory usage of this data structure. The size of
+     * the nodes is maintained while the tree is modified, such that this
+     * operation is cheap and may be conducted concurrently to inserts.
      */
     std::size_t getMemoryUsage() const {
-        // the memory of the wrapper class
-        std::size_t res = sizeof(*this);
-
-        // add nodes
-        if (unsynced.root) {
-            res += getMemoryUsage(unsynced.root, unsynced.levels);
-        }
-
-        // done
-        return res;
+        return sizeof(*this) + allocatedBytes.load(std::memory_order_relaxed);
     }
 
     /**
@@ -811,7 +786,7 @@ private:
             }
 
             // somebody else was faster => use standard insertion procedure
-            delete info.root;
+            deleteNode(info.root);
 
             // retrieve new root info
             info = getRootInfo();
@@ -854,7 +829,7 @@ private:
                 // try to update next
                 if (!aNext.compare_exchange_strong(next, newNext)) {
                     // some other thread was faster => use updated next
-                    delete newNext;
+                    deleteNode(newNext);
                 } else {
                     // the locally created next is the new next
                     next = newNext;
@@ -987,7 +962,7 @@ private:
      * @param src the node to be cloned
      * @param levels the height of the cloned node
      */
-    static void merge(const Node* parent, Node*& trg, const Node* src, int levels) {
+    void merge(const Node* parent, Node*& trg, const Node* src, int levels) {
         // if other side is null => done
         if (src == nullptr) {
             return;
@@ -1313,21 +1288,30 @@ private:
     /**
      * Creates new nodes and initializes them with 0.
      */
-    static Node* newNode() {
+    Node* newNode() {
+        allocatedBytes.fetch_add(sizeof(Node), std::memory_order_relaxed);
         return new Node();
     }
 
+    /**
+     * Destroys a single node created by newNode().
+     */
+    void deleteNode(Node* node) {
+        allocatedBytes.fetch_sub(sizeof(Node), std::memory_order_relaxed);
+        delete node;
+    }
+
     /**
      * Destroys a node and all its sub-nodes recursively.
      */
-    static void freeNodes(Node* node, int level) {
+    void freeNodes(Node* node, int level) {
         if (!node) return;
         if (level != 0) {
             for (int i = 0; i < NUM_CELLS; i++) {
                 freeNodes(node->cell[i].ptr, level - 1);
             }
         }
-        delete node;
+        deleteNode(node);
     }
 
     /**
@@ -1342,14 +1326,14 @@ private:
     /**
      * Clones the given node and all its sub-nodes.
      */
-    static Node* clone(const Node* node, int level) {
+    Node* clone(const Node* node, int level) {
         // support null-pointers
         if (node == nullptr) {
             return nullptr;
         }
 
         // create a clone
-        auto* res = new Node();
+        auto* res = newNode();
 
         // handle leaf level
         if (level == 0) {
@@ -1454,7 +1438,7 @@ private:
             oldRoot->parent = info.root;
         } else {
             // throw away temporary new node
-            delete newRoot;
+            deleteNode(newRoot);
         }
     }
 
@@ -1960,6 +1944,14 @@ public:
 
     explicit TrieIterator(iter_core_arg_type param) : iter_core(std::move(param), value) {}
 
+    // lifts an iterator of a nested trie to this level, placing it below the given store entry
+    template <typename NestedValue, typename NestedCore>
+    TrieIterator(iter_core_arg_type param, const TrieIterator<NestedValue, NestedCore>& nested)
+            : iter_core(std::move(param), nested.iter_core) {
+        value[0] = brie_element_type(iter_core.getIterator()->first);
+        std::copy(nested.value.begin(), nested.value.end(), value.begin() + 1);
+    }
+
     // the equality operator as required by the iterator concept
     bool operator==(const TrieIterator& other) const {
         // equivalent if pointing to the same value
@@ -2489,6 +2481,9 @@ struct TrieTypes {
             nested = {iter->second->getStore().begin(), tail(entry)};
         }
 
+        iterator_core(store_iter store_iter, nested_core_iter nested)
+                : iter(std::move(store_iter)), nested(std::move(nested)) {}
+
         void setIterator(store_iter store_iter) {
             iter = std::move(store_iter);
         }
@@ -2875,6 +2870,10 @@ public:
      * of this trie. Thus, the union of the resulting set of disjoint ranges is
      * equivalent to the content of this trie.
      *
+     * Chunks are balanced by the number of entries they cover: consecutive small
+     * sub-tries are grouped together, while sub-tries exceeding the size of a chunk
+     * are split within their nested levels.
+     *
      * @param chunks the number of chunks requested
      * @return a list of sub-ranges forming a partition of the content of this trie
      */
@@ -2884,21 +2883,37 @@ public:
         // shortcut for empty trie
         if (this->empty()) return res;
 
-        // use top-level elements for partitioning
-        int step = std::max(store.size() / chunks, std::size_t(1));
+        // the number of entries to be covered by each chunk
+        const std::size_t total = size();
+        const std::size_t step = std::max(total / std::max(chunks, 1u), std::size_t(1));
+
+        // collect the starting points of the chunks
+        std::vector<iterator> starts;
+        std::size_t covered = step;
+        for (auto it = store.begin(); it != store.end(); ++it) {
+            if (covered >= step) {
+                starts.push_back(iterator(it));
+                covered = 0;
+            }
 
-        int c = 1;
-        auto priv = begin();
-        for (auto it = store.begin(); it != store.end(); ++it, c++) {
-            if (c % step != 0 || c == 1) {
+            const std::size_t nestedSize = it->second->size();
+            if (nestedSize <= step) {
+                covered += nestedSize;
                 continue;
             }
-            auto cur = iterator(it);
-            res.push_back(make_range(priv, cur));
-            priv = cur;
+
+            // split the oversized sub-trie; its first part extends the current chunk
+            auto parts = it->second->partition((nestedSize + step - 1) / step);
+            for (std::size_t i = 1; i < parts.size(); ++i) {
+                starts.push_back(iterator(it, parts[i].begin()));
+            }
+            covered = step;
+        }
+
+        // assemble the ranges
+        for (std::size_t i = 0; i < starts.size(); ++i) {
+            res.push_back(make_range(starts[i], i + 1 < starts.size() ? starts[i + 1] : end()));
         }
-        // add final chunk
-        res.push_back(make_range(priv, end()));
         return res;
     }
 };
@@ -2992,6 +3007,9 @@ public:
      * Obtains a partition of this tire such that the resulting list of ranges
      * cover disjoint subsets of the elements stored in this trie. Their union
      * is equivalent to the content of this trie.
+     *
+     * Chunks are balanced by the population count of the words of the underlying
+     * bit map, hence they cover roughly the same number of elements.
      */
     std::vector<range<iterator>> partition(unsigned chunks = 500) const {
         std::vector<range<iterator>> res;
@@ -2999,21 +3017,25 @@ public:
         // shortcut for empty trie
         if (this->empty()) return res;
 
-        // use top-level elements for partitioning
-        int step = static_cast<int>(std::max(store.size() / chunks, std::size_t(1)));
-
-        int c = 1;
-        auto priv = begin();
-        for (auto it = store.begin(); it != store.end(); ++it, c++) {
-            if (c % step != 0 || c == 1) {
-                continue;
+        // the number of elements to be covered by each chunk
+        const std::size_t step = std::max(size() / std::max(chunks, 1u), std::size_t(1));
+
+        // collect the starting points of the chunks at word granularity
+        std::vector<iterator> starts;
+        std::size_t covered = step;
+        const auto& words = store.getStore();
+        for (auto it = words.begin(); it != words.end(); ++it) {
+            if (covered >= step) {
+                starts.push_back(iterator(store_type::iterator(it)));
+                covered = 0;
             }
-            auto cur = iterator(it);
-            res.push_back(make_range(priv, cur));
-            priv = cur;
+            covered += __builtin_popcountll(it->second);
+        }
+
+        // assemble the ranges
+        for (std::size_t i = 0; i < starts.size(); ++i) {
+            res.push_back(make_range(starts[i], i + 1 < starts.size() ? starts[i + 1] : end()));
         }
-        // add final chunk
-        res.push_back(make_range(priv, end()));
         return res;
     }
 
@@ -19,7 +19,6 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
-#include "souffle/datastructure/LambdaBTree.h"
 #include "souffle/datastructure/PiggyList.h"
 #include "souffle/datastructure/UnionFind.h"
 #include "souffle/utility/ContainerUtil.h"
@@ -31,7 +30,6 @@
 #include <iostream>
 #include <iterator>
 #include <set>
-#include <shared_mutex>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
@@ -42,21 +40,10 @@ template <typename TupleType>
 class EquivalenceRelation {
     using value_type = typename TupleType::value_type;
 
-    // mapping from representative to disjoint set
-    // just a cache, essentially, used for iteration over
-    using StatesList = souffle::PiggyList<value_type>;
-    using StatesBucket = StatesList*;
-    using StorePair = std::pair<value_type, StatesBucket>;
-    using StatesMap = souffle::LambdaBTreeSet<StorePair, std::function<StatesBucket(StorePair&)>,
-            souffle::EqrelMapComparator<StorePair>>;
-
 public:
     using element_type = TupleType;
 
-    EquivalenceRelation() : statesMapStale(false){};
-    ~EquivalenceRelation() {
-        emptyPartition();
-    }
+    EquivalenceRelation() = default;
 
     /**
      * A collection of operation hints speeding up some of the involved operations
@@ -98,8 +85,6 @@ public:
      * @return true if the pair is new to the data structure
      */
     bool insert(value_type x, value_type y, operation_hints) {
-        // indicate that iterators will have to generate on request
-        this->statesMapStale.store(true, std::memory_order_relaxed);
         bool retval = contains(x, y);
         sds.unionNodes(x, y);
         return retval;
@@ -110,21 +95,12 @@ public:
      * @param other the binary relation from which to add elements from
      */
     void insertAll(const EquivalenceRelation<TupleType>& other) {
-        other.genAllDisjointSetLists();
-
-        // iterate over partitions at a time
-        for (typename StatesMap::chunk it : other.equivalencePartition.getChunks(MAX_THREADS)) {
-            for (auto& p : it) {
-                value_type rep = p.first;
-                StatesList& pl = *p.second;
-                const std::size_t ksize = pl.size();
-                for (std::size_t i = 0; i < ksize; ++i) {
-                    this->sds.unionNodes(rep, pl.get(i));
-                }
-            }
+        // joining every element with its successor in the member list of its set
+        // reproduces all sets of the other relation
+        const std::size_t numNodes = other.sds.ds.size();
+        for (std::size_t i = 0; i < numNodes; ++i) {
+            this->sds.unionNodes(other.sds.toSparse(i), other.sds.toSparse(other.sds.ds.next(i)));
         }
-        // invalidate iterators unconditionally
-        this->statesMapStale.store(true, std::memory_order_relaxed);
     }
 
     /**
@@ -137,10 +113,7 @@ public:
         // nothing to extend if there's no new/original knowledge
         if (other.size() == 0 || this->size() == 0) return;
 
-        this->genAllDisjointSetLists();
-        other.genAllDisjointSetLists();
-
-        std::set<value_type> repsCovered;
+        std::set<parent_t> repsCovered;
 
         // find all the disjoint sets that need to be added to this relation
         // that exist in other (and exist in this)
@@ -151,27 +124,19 @@ public:
             for (; it != end; ++it) {
                 std::tie(el, std::ignore) = *it;
                 if (other.containsElement(el)) {
-                    value_type rep = other.sds.findNode(el);
-                    if (repsCovered.count(rep) == 0) {
-                        repsCovered.emplace(rep);
-                    }
+                    repsCovered.emplace(other.sds.ds.findNode(other.sds.toDense(el)));
                 }
             }
         }
 
         // add the intersecting dj sets into this one
-        {
-            value_type el;
-            value_type rep;
-            auto it = other.sds.sparseToDenseMap.begin();
-            auto end = other.sds.sparseToDenseMap.end();
-            for (; it != end; ++it) {
-                std::tie(el, std::ignore) = *it;
-                rep = other.sds.findNode(el);
-                if (repsCovered.count(rep) != 0) {
-                    this->insert(el, rep);
-                }
-            }
+        for (parent_t rep : repsCovered) {
+            const value_type repVal = other.sds.toSparse(rep);
+            parent_t cur = rep;
+            do {
+                this->insert(other.sds.toSparse(cur), repVal);
+                cur = other.sds.ds.next(cur);
+            } while (cur != rep);
         }
     }
 
@@ -196,27 +161,11 @@ public:
         return contains(tuple[0], tuple[1]);
     };
 
-    void emptyPartition() const {
-        // delete the beautiful values inside (they're raw ptrs, so they need to be.)
-        for (auto& pair : equivalencePartition) {
-            delete pair.second;
-        }
-        // invalidate it my dude
-        this->statesMapStale.store(true, std::memory_order_relaxed);
-
-        equivalencePartition.clear();
-    }
-
     /**
      * Empty the relation
      */
     void clear() {
-        statesLock.lock();
-
         sds.clear();
-        emptyPartition();
-
-        statesLock.unlock();
     }
 
     /**
@@ -224,24 +173,34 @@ public:
      * @return the sum of the number of pairs per disjoint set
      */
     std::size_t size() const {
-        genAllDisjointSetLists();
-
-        statesLock.lock_shared();
+        return sds.ds.pairs();
+    }
 
-        std::size_t retVal = 0;
-        for (auto& e : this->equivalencePartition) {
-            const std::size_t s = e.second->size();
-            retVal += s * s;
-        }
+    /**
+     * Computes the memory allocated for the disjoint sets of this relation
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(sds) + sds.getMemoryUsage();
+    }
 
-        statesLock.unlock_shared();
-        return retVal;
+    /**
+     * Size of the equivalence class of an element
+     * @param x element of the class
+     * @return the number of elements equivalent to x (0 if x is not part of the relation)
+     */
+    std::size_t classSize(value_type x) const {
+        if (!sds.nodeExists(x)) return 0;
+        return sds.classSize(x);
     }
 
     // an almighty iterator for several types of iteration.
     // Unfortunately, subclassing isn't an option with souffle
     //   - we don't deal with pointers (so no virtual)
     //   - and a single iter type is expected (see Relation::iterator e.g.) (i think)
+    //
+    // Iteration walks the member lists maintained by the disjoint set, hence it operates on
+    // dense node ids and translates to sparse values on the fly. The relation must not be
+    // inserted into while it is iterated, as merging sets re-links the member lists.
     class iterator {
     public:
         typedef std::forward_iterator_tag iterator_category;
@@ -250,59 +209,66 @@ public:
         using pointer = value_type*;
         using reference = value_type&;
 
+        // all the different types of iterator this can be
+        enum IterType { ALL, ANTERIOR, ANTPOST, WITHIN };
+
         // one iterator for signalling the end (simplifies)
         explicit iterator(const EquivalenceRelation* br, bool /* signalIsEndIterator */)
                 : br(br), isEndVal(true){};
 
-        explicit iterator(const EquivalenceRelation* br)
-                : br(br), ityp(IterType::ALL), djSetMapListIt(br->equivalencePartition.begin()),
-                  djSetMapListEnd(br->equivalencePartition.end()) {
-            // no need to fast forward if this iterator is empty
-            if (djSetMapListIt == djSetMapListEnd) {
-                isEndVal = true;
-                return;
-            }
-            // grab the pointer to the list, and make it our current list
-            djSetList = (*djSetMapListIt).second;
-            assert(djSetList->size() != 0);
-
-            updateAnterior();
-            updatePosterior();
-        }
+        explicit iterator(const EquivalenceRelation* br) : iterator(br, IterType::ALL, 0, 0) {}
 
         // WITHIN: iterator for everything within the same DJset (used for EquivalenceRelation.partition())
-        explicit iterator(const EquivalenceRelation* br, const StatesBucket within)
-                : br(br), ityp(IterType::WITHIN), djSetList(within) {
-            // empty dj set
-            if (djSetList->size() == 0) {
-                isEndVal = true;
+        explicit iterator(const EquivalenceRelation* br, const parent_t within)
+                : iterator(br, IterType::WITHIN, within, within) {}
+
+        // ALL or WITHIN, starting at a given position (used for EquivalenceRelation.partition())
+        //   ALL: iterates over all dj sets whose representatives are not less than the dense node root
+        //   WITHIN: iterates over the dj set of the dense node root
+        // the walk over the first dj set starts at the dense node anterior
+        explicit iterator(
+                const EquivalenceRelation* br, IterType ityp, const parent_t root, const parent_t anterior)
+                : br(br), ityp(ityp), cRoot(root), cAnterior(anterior), cPosterior(root),
+                  merges(br->sds.ds.merges()) {
+            if (ityp == IterType::ALL) {
+                // find the first representative
+                numNodes = br->sds.ds.size();
+                while (cRoot < numNodes && !br->sds.ds.isRoot(cRoot)) {
+                    ++cRoot;
+                }
+                // no need to fast forward if this iterator is empty
+                if (cRoot == numNodes) {
+                    isEndVal = true;
+                    return;
+                }
+                if (cRoot != root) {
+                    cAnterior = cPosterior = cRoot;
+                }
             }
 
             updateAnterior();
             updatePosterior();
         }
 
-        // ANTERIOR: iterator that yields all (former, _) \in djset(former) (djset(former) === within)
+        // ANTERIOR: iterator that yields all (former, _) \in djset(former)
         explicit iterator(const EquivalenceRelation* br, const typename TupleType::value_type former,
-                const StatesBucket within)
-                : br(br), ityp(IterType::ANTERIOR), djSetList(within) {
-            if (djSetList->size() == 0) {
-                isEndVal = true;
-            }
+                const parent_t within)
+                : iterator(br, former, within, within) {}
 
+        // ANTERIOR: as above, but starting the walk over the dj set at the dense node start
+        explicit iterator(const EquivalenceRelation* br, const typename TupleType::value_type former,
+                const parent_t within, const parent_t start)
+                : br(br), ityp(IterType::ANTERIOR), cRoot(within), cPosterior(start),
+                  merges(br->sds.ds.merges()) {
             setAnterior(former);
             updatePosterior();
         }
 
         // ANTPOST: iterator that yields all (former, latter) \in djset(former), (djset(former) ==
-        // djset(latter) == within)
+        // djset(latter))
         explicit iterator(const EquivalenceRelation* br, const typename TupleType::value_type former,
-                typename TupleType::value_type latter, const StatesBucket within)
-                : br(br), ityp(IterType::ANTPOST), djSetList(within) {
-            if (djSetList->size() == 0) {
-                isEndVal = true;
-            }
-
+                typename TupleType::value_type latter)
+                : br(br), ityp(IterType::ANTPOST), merges(br->sds.ds.merges()) {
             setAnterior(former);
             setPosterior(latter);
         }
@@ -314,7 +280,7 @@ public:
 
         /** quick update to whatever the current index is pointing to */
         inline void updateAnterior() {
-            this->cPair[0] = this->djSetList->get(this->cAnteriorIndex);
+            this->cPair[0] = br->sds.toSparse(cAnterior);
         }
 
         /** explicit set second half of cPair */
@@ -324,7 +290,7 @@ public:
 
         /** quick update to whatever the current index is pointing to */
         inline void updatePosterior() {
-            this->cPair[1] = this->djSetList->get(this->cPosteriorIndex);
+            this->cPair[1] = br->sds.toSparse(cPosterior);
         }
 
         // copy ctor
@@ -357,47 +323,44 @@ public:
                 throw std::out_of_range("error: incrementing an out of range iterator");
             }
 
+            const DisjointSet& ds = br->sds.ds;
+            if (ds.merges() != merges) {
+                throw std::logic_error("error: equivalence relation inserted into during iteration");
+            }
             switch (ityp) {
                 case IterType::ALL:
+                case IterType::WITHIN:
                     // move posterior along one
                     // see if we can't move the posterior along
-                    if (++cPosteriorIndex == djSetList->size()) {
+                    if ((cPosterior = ds.next(cPosterior)) == cRoot) {
                         // move anterior along one
                         // see if we can't move the anterior along one
-                        if (++cAnteriorIndex == djSetList->size()) {
-                            // move the djset it along one
-                            // see if we can't move it along one (we're at the end)
-                            if (++djSetMapListIt == djSetMapListEnd) {
+                        if ((cAnterior = ds.next(cAnterior)) == cRoot) {
+                            if (ityp == IterType::WITHIN) {
                                 isEndVal = true;
                                 return *this;
                             }
 
-                            // we can't iterate along this djset if it is empty
-                            djSetList = (*djSetMapListIt).second;
-                            if (djSetList->size() == 0) {
-                                throw std::out_of_range("error: encountered a zero size djset");
+                            // move on to the next dj set, if there is any
+                            do {
+                                ++cRoot;
+                            } while (cRoot < numNodes && !ds.isRoot(cRoot));
+                            if (cRoot == numNodes) {
+                                isEndVal = true;
+                                return *this;
                             }
-
-                            // update our cAnterior and cPosterior
-                            cAnteriorIndex = 0;
-                            cPosteriorIndex = 0;
-                            updateAnterior();
-                            updatePosterior();
+                            cAnterior = cPosterior = cRoot;
                         }
 
                         // we moved our anterior along one
                         updateAnterior();
-
-                        cPosteriorIndex = 0;
-                        updatePosterior();
                     }
                     // we just moved our posterior along one
                     updatePosterior();
-
                     break;
                 case IterType::ANTERIOR:
                     // step posterior along one, and if we can't, then we're done.
-                    if (++cPosteriorIndex == djSetList->size()) {
+                    if ((cPosterior = ds.next(cPosterior)) == cRoot) {
                         isEndVal = true;
                         return *this;
                     }
@@ -409,26 +372,6 @@ public:
                     // end
                     isEndVal = true;
                     break;
-                case IterType::WITHIN:
-                    // move posterior along one
-                    // see if we can't move the posterior along
-                    if (++cPosteriorIndex == djSetList->size()) {
-                        // move anterior along one
-                        // see if we can't move the anterior along one
-                        if (++cAnteriorIndex == djSetList->size()) {
-                            isEndVal = true;
-                            return *this;
-                        }
-
-                        // we moved our anterior along one
-                        updateAnterior();
-
-                        cPosteriorIndex = 0;
-                        updatePosterior();
-                    }
-                    // we just moved our posterior along one
-                    updatePosterior();
-                    break;
             }
 
             return *this;
@@ -439,21 +382,22 @@ public:
         // special tombstone value to notify that this iter represents the end
         bool isEndVal = false;
 
-        // all the different types of iterator this can be
-        enum IterType { ALL, ANTERIOR, ANTPOST, WITHIN };
         IterType ityp;
 
         TupleType cPair;
 
-        // the disjoint set that we're currently iterating through
-        StatesBucket djSetList;
-        typename StatesMap::iterator djSetMapListIt;
-        typename StatesMap::iterator djSetMapListEnd;
+        // the dense node at which the walk over the current dj set started and ends
+        parent_t cRoot = 0;
+        // used for ALL (the number of dense nodes to scan for representatives)
+        std::size_t numNodes = 0;
+
+        // used for ALL and WITHIN (current dense node of the first half)
+        parent_t cAnterior = 0;
+        // used for ALL, WITHIN, and ANTERIOR (current dense node of the second half)
+        parent_t cPosterior = 0;
 
-        // used for ALL, and POSTERIOR (just a current index in the cList)
-        std::size_t cAnteriorIndex = 0;
-        // used for ALL, and ANTERIOR (just a current index in the cList)
-        std::size_t cPosteriorIndex = 0;
+        // the number of merges of sets when the iteration started
+        std::size_t merges = 0;
     };
 
 public:
@@ -462,7 +406,6 @@ public:
      * @return the iterator that corresponds to the beginning of the binary relation
      */
     iterator begin() const {
-        genAllDisjointSetLists();
         return iterator(this);
     }
 
@@ -601,14 +544,7 @@ public:
      * @return the iterator representing this.
      */
     iterator anteriorIt(value_type anteriorVal) const {
-        genAllDisjointSetLists();
-
-        // locate the blocklist that the anterior val resides in
-        auto found = equivalencePartition.find({sds.findNode(anteriorVal), nullptr});
-        assert(found != equivalencePartition.end() && "iterator called on partition that doesn't exist");
-
-        return iterator(static_cast<const EquivalenceRelation*>(this),
-                static_cast<const value_type>(anteriorVal), static_cast<const StatesBucket>((*found).second));
+        return iterator(this, anteriorVal, sds.toDense(anteriorVal));
     }
 
     /**
@@ -623,13 +559,7 @@ public:
         // obv if they're in diff sets, then iteration for this pair just ends.
         if (!sds.sameSet(anteriorVal, posteriorVal)) return end();
 
-        genAllDisjointSetLists();
-
-        // locate the blocklist that the val resides in
-        auto found = equivalencePartition.find({sds.findNode(posteriorVal), nullptr});
-        assert(found != equivalencePartition.end() && "iterator called on partition that doesn't exist");
-
-        return iterator(this, anteriorVal, posteriorVal, (*found).second);
+        return iterator(this, anteriorVal, posteriorVal);
     }
 
     /**
@@ -638,56 +568,110 @@ public:
      * @return an iterator that will generate all pairs within the disjoint set
      */
     iterator closure(value_type rep) const {
-        genAllDisjointSetLists();
-
-        // locate the blocklist that the val resides in
-        auto found = equivalencePartition.find({sds.findNode(rep), nullptr});
-        return iterator(this, (*found).second);
+        return iterator(this, sds.toDense(rep));
     }
 
     /**
      * Generate an approximate number of iterators for parallel iteration
-     * The iterators returned are not necessarily equal in size, but in practise are approximately similarly
-     * sized
+     * The iterators returned are balanced by the number of pairs they cover: consecutive small disjoint
+     * sets are grouped into a single chunk, whereas disjoint sets exceeding the size of a chunk are split
+     * by their anterior elements.
      * Depending on the structure of the data, there can be more or less partitions returned than requested.
      * @param chunks the number of requested partitions
      * @return a list of the iterators as ranges
      */
     std::vector<souffle::range<iterator>> partition(std::size_t chunks) const {
-        // generate all reps
-        genAllDisjointSetLists();
-
         std::size_t numPairs = this->size();
         if (numPairs == 0) return {};
         if (numPairs == 1 || chunks <= 1) return {souffle::make_range(begin(), end())};
 
-        // if there's more dj sets than requested chunks, then just return an iter per dj set
+        const DisjointSet& ds = sds.ds;
+        const std::size_t numNodes = ds.size();
+        const std::size_t perchunk = std::max<std::size_t>(numPairs / chunks, 1);
+
         std::vector<souffle::range<iterator>> ret;
-        if (chunks <= equivalencePartition.size()) {
-            for (auto& p : equivalencePartition) {
-                ret.push_back(souffle::make_range(closure(p.first), end()));
-            }
-            return ret;
-        }
 
-        // keep it simple stupid
-        // just go through and if the size of the binrel is > numpairs/chunks, then generate an anteriorIt for
-        // each
-        const std::size_t perchunk = numPairs / chunks;
-        for (const auto& itp : equivalencePartition) {
-            const std::size_t s = itp.second->size();
+        // the first representative of the group of small dj sets currently being assembled
+        parent_t groupStart = 0;
+        std::size_t groupPairs = 0;
+        auto closeGroup = [&](parent_t groupEnd) {
+            if (groupPairs == 0) return;
+            ret.push_back(souffle::make_range(iterator(this, iterator::ALL, groupStart, groupStart),
+                    groupEnd < numNodes ? iterator(this, iterator::ALL, groupEnd, groupEnd) : end()));
+            groupPairs = 0;
+        };
+
+        for (parent_t rep = 0; rep < numNodes; ++rep) {
+            if (!ds.isRoot(rep)) continue;
+            const std::size_t s = ds.a_blocks.get(rep).classSize.load(std::memory_order_acquire);
             if (s * s > perchunk) {
-                for (const auto& i : *itp.second) {
-                    ret.push_back(souffle::make_range(anteriorIt(i), end()));
+                closeGroup(rep);
+                // split the dj set into ranges of anterior elements covering about perchunk pairs each
+                const std::size_t perRange = std::max<std::size_t>(perchunk / s, 1);
+                parent_t cur = rep;
+                do {
+                    const parent_t first = cur;
+                    for (std::size_t i = 0; i < perRange && (i == 0 || cur != rep); ++i) {
+                        cur = ds.next(cur);
+                    }
+                    ret.push_back(souffle::make_range(iterator(this, iterator::WITHIN, rep, first),
+                            cur != rep ? iterator(this, iterator::WITHIN, rep, cur) : end()));
+                } while (cur != rep);
+                continue;
+            }
+
+            if (groupPairs == 0) groupStart = rep;
+            groupPairs += s * s;
+            if (groupPairs >= perchunk) {
+                // find the start of the next group
+                parent_t next = rep + 1;
+                while (next < numNodes && !ds.isRoot(next)) {
+                    ++next;
                 }
-            } else {
-                ret.push_back(souffle::make_range(closure(itp.first), end()));
+                closeGroup(next);
+                rep = next - 1;
             }
         }
+        closeGroup(numNodes);
 
         return ret;
     }
 
+    /**
+     * Partition the elements within the given bounds, following the conventions of lower_bound, i.e.
+     * unbound columns are set to MIN_RAM_SIGNED.
+     * @param entry the bound values
+     * @param chunks the number of requested partitions
+     * @return a list of the iterators as ranges
+     */
+    std::vector<souffle::range<iterator>> partitionRange(const TupleType& entry, std::size_t chunks) const {
+        // nothing bound: partition everything
+        if (entry[0] == MIN_RAM_SIGNED && entry[1] == MIN_RAM_SIGNED) return partition(chunks);
+
+        // both bound, or only the posterior bound (unsupported by lower_bound): a single range
+        if (entry[0] == MIN_RAM_SIGNED || entry[1] != MIN_RAM_SIGNED || chunks <= 1) {
+            return {souffle::make_range(lower_bound(entry), end())};
+        }
+
+        // anterior bound: split the walk over the posteriors of its dj set
+        if (!sds.nodeExists(entry[0])) return {};
+        const parent_t start = sds.toDense(entry[0]);
+        const std::size_t s = sds.classSize(entry[0]);
+        const std::size_t perRange = std::max<std::size_t>(s / chunks, 1);
+
+        std::vector<souffle::range<iterator>> ret;
+        parent_t cur = start;
+        do {
+            const parent_t first = cur;
+            for (std::size_t i = 0; i < perRange && (i == 0 || cur != start); ++i) {
+                cur = sds.ds.next(cur);
+            }
+            ret.push_back(souffle::make_range(iterator(this, entry[0], start, first),
+                    cur != start ? iterator(this, entry[0], start, cur) : end()));
+        } while (cur != start);
+        return ret;
+    }
+
     iterator find(const TupleType&, operation_hints&) const {
         throw std::runtime_error("error: find() is not compatible with equivalence relations");
         return begin();
@@ -707,46 +691,5 @@ private:
     // marked as mutable due to difficulties with the const enforcement via the Relation API
     // const operations *may* safely change internal state (i.e. collapse djset forest)
     mutable souffle::SparseDisjointSet<value_type> sds;
-
-    // read/write lock on equivalencePartition
-    mutable std::shared_mutex statesLock;
-
-    mutable StatesMap equivalencePartition;
-    // whether the cache is stale
-    mutable std::atomic<bool> statesMapStale;
-
-    /**
-     * Generate a cache of the sets such that they can be iterated over efficiently.
-     * Each set is partitioned into a PiggyList.
-     */
-    void genAllDisjointSetLists() const {
-        statesLock.lock();
-
-        // no need to generate again, already done.
-        if (!this->statesMapStale.load(std::memory_order_acquire)) {
-            statesLock.unlock();
-            return;
-        }
-
-        // btree version
-        emptyPartition();
-
-        std::size_t dSetSize = this->sds.ds.a_blocks.size();
-        for (std::size_t i = 0; i < dSetSize; ++i) {
-            typename TupleType::value_type sparseVal = this->sds.toSparse(i);
-            parent_t rep = this->sds.findNode(sparseVal);
-
-            StorePair p = {static_cast<value_type>(rep), nullptr};
-            StatesList* mapList = equivalencePartition.insert(p, [&](StorePair& sp) {
-                auto* r = new StatesList(1);
-                sp.second = r;
-                return r;
-            });
-            mapList->append(sparseVal);
-        }
-
-        statesMapStale.store(false, std::memory_order_release);
-        statesLock.unlock();
-    }
 };
 }  // namespace souffle
@@ -0,0 +1,496 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HashIndex.h
+ *
+ * A concurrent hash index of tuples, answering membership tests and
+ * lookups of all tuples with given values in a fixed set of columns.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/utility/Iteration.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace souffle {
+
+namespace detail {
+
+/** Mixes all bits of a hash value (the finaliser of MurmurHash3) */
+inline uint64_t hashFinalise(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/** The position of the highest set bit of a non-zero value */
+inline std::size_t floorLog2(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long msb = 0;
+    _BitScanReverse64(&msb, value);
+    return msb;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+}  // namespace detail
+
+/**
+ * A hash index stores tuples grouped by their values in the key columns.
+ *
+ * If the index is unique, the key determines a tuple, e.g., if it covers all
+ * columns, and insertions of a tuple with a known key are rejected. Otherwise,
+ * the tuples of a key are chained, and a lookup yields the chain of its key.
+ *
+ * The index is split into shards by the hash of the key, each of which is an
+ * open-addressing table with linear probing over the entries of the shard.
+ * Insertions lock the shard they insert into, whereas membership tests,
+ * lookups and scans never block: entries are stored in blocks which never
+ * move, and a table replaced by a larger one is retained until the index is
+ * cleared or reset, such that a reader always probes a consistent table.
+ *
+ * @tparam Tuple the type of the stored tuples
+ * @tparam Unique whether the key determines a tuple
+ * @tparam Columns the key columns
+ */
+template <typename Tuple, bool Unique, std::size_t... Columns>
+class HashIndex {
+    static_assert(sizeof...(Columns) > 0, "a hash index requires a key");
+
+    /** The number of shards, a power of two */
+    static constexpr std::size_t NUM_SHARDS = 32;
+
+    /** The number of entries of the first block of a shard is 2^BLOCK_BITS */
+    static constexpr std::size_t BLOCK_BITS = 4;
+
+    /** The maximal number of blocks of a shard, i.e., of 2^32 entries */
+    static constexpr std::size_t MAX_BLOCKS = 32 - BLOCK_BITS;
+
+    /** The capacity of the first table of a shard */
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+    struct Entry {
+        Tuple tuple;
+        uint64_t hash;
+        /** The position plus one of the next entry with the same key, or zero */
+        uint32_t next;
+    };
+
+    /** Holds the position plus one of the first entry of a key, or zero */
+    using Slot = std::atomic<uint32_t>;
+
+    struct Table {
+        explicit Table(std::size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {
+            for (std::size_t i = 0; i < capacity; i++) {
+                slots[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t capacity() const {
+            return mask + 1;
+        }
+
+        const std::size_t mask;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    struct Shard {
+        /** Serialises the insertions into this shard */
+        SpinLock lock;
+
+        /** The number of entries */
+        std::atomic<std::size_t> size{0};
+
+        /** The number of occupied slots, i.e., of distinct keys */
+        std::size_t keys = 0;
+
+        /** The current table */
+        std::atomic<Table*> table{nullptr};
+
+        /** All tables of this shard, the current one being the last */
+        std::vector<std::unique_ptr<Table>> tables;
+
+        /** The blocks of entries, where block i holds 2^(BLOCK_BITS + i) entries */
+        std::array<std::unique_ptr<Entry[]>, MAX_BLOCKS> blocks;
+
+        static std::size_t blockOf(std::size_t pos) {
+            return detail::floorLog2(pos + (1ull << BLOCK_BITS)) - BLOCK_BITS;
+        }
+
+        const Entry& entry(std::size_t pos) const {
+            std::size_t block = blockOf(pos);
+            return blocks[block][pos + (1ull << BLOCK_BITS) - (1ull << (block + BLOCK_BITS))];
+        }
+
+        Entry& entry(std::size_t pos) {
+            return const_cast<Entry&>(static_cast<const Shard*>(this)->entry(pos));
+        }
+    };
+
+public:
+    /** Iterates over all tuples of the index, shard by shard */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Tuple;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Tuple*;
+        using reference = const Tuple&;
+
+        iterator() = default;
+
+        iterator(const Shard* shards, std::size_t shard, std::size_t pos)
+                : shards(shards), shard(shards == nullptr ? NUM_SHARDS : shard), pos(pos) {
+            skipExhausted();
+        }
+
+        const Tuple& operator*() const {
+            return shards[shard].entry(pos).tuple;
+        }
+
+        const Tuple* operator->() const {
+            return &**this;
+        }
+
+        iterator& operator++() {
+            ++pos;
+            skipExhausted();
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const {
+            return shard == other.shard && pos == other.pos;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        void skipExhausted() {
+            while (shard < NUM_SHARDS && pos >= shards[shard].size.load(std::memory_order_acquire)) {
+                ++shard;
+                pos = 0;
+            }
+        }
+
+        const Shard* shards = nullptr;
+        std::size_t shard = NUM_SHARDS;
+        std::size_t pos = 0;
+    };
+
+    /** Iterates over the tuples of a key */
+    class chain_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Tuple;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Tuple*;
+        using reference = const Tuple&;
+
+        chain_iterator() = default;
+
+        chain_iterator(const Shard* shard, uint32_t cur) : shard(shard), cur(cur) {}
+
+        const Tuple& operator*() const {
+            return shard->entry(cur - 1).tuple;
+        }
+
+        const Tuple* operator->() const {
+            return &**this;
+        }
+
+        chain_iterator& operator++() {
+            cur = shard->entry(cur - 1).next;
+            return *this;
+        }
+
+        bool operator==(const chain_iterator& other) const {
+            return cur == other.cur;
+        }
+
+        bool operator!=(const chain_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const Shard* shard = nullptr;
+        uint32_t cur = 0;
+    };
+
+    HashIndex() = default;
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    ~HashIndex() {
+        clear();
+    }
+
+    /**
+     * Inserts a tuple, returning false if the index is unique and already
+     * holds a tuple with the same key.
+     */
+    bool insert(const Tuple& tuple) {
+        const uint64_t hash = hashKey(tuple);
+        Shard& shard = getShards()[shardOf(hash)];
+        std::lock_guard<SpinLock> guard(shard.lock);
+
+        Table* table = shard.table.load(std::memory_order_relaxed);
+        if (table == nullptr || (shard.keys + 1) * 4 > table->capacity() * 3) {
+            table = grow(shard);
+        }
+
+        std::size_t pos = hash & table->mask;
+        for (uint32_t first; (first = table->slots[pos].load(std::memory_order_relaxed)) != 0;
+                pos = (pos + 1) & table->mask) {
+            const Entry& entry = shard.entry(first - 1);
+            if (entry.hash == hash && equalKey(entry.tuple, tuple)) {
+                if constexpr (Unique) {
+                    return false;
+                }
+                // prepend the tuple to the chain of its key, leaving the chain of readers intact
+                table->slots[pos].store(append(shard, tuple, hash, first), std::memory_order_release);
+                return true;
+            }
+        }
+        table->slots[pos].store(append(shard, tuple, hash, 0), std::memory_order_release);
+        shard.keys++;
+        return true;
+    }
+
+    /** Tests whether the index holds a tuple with the key of the given tuple */
+    bool contains(const Tuple& key) const {
+        return findFirst(key).second != 0;
+    }
+
+    /** Finds the tuple with the key of the given tuple, or the end of a unique index */
+    iterator find(const Tuple& key) const {
+        auto [shard, first] = findFirst(key);
+        if (first == 0) {
+            return end();
+        }
+        const Shard* all = shards.load(std::memory_order_acquire);
+        return iterator(all, shard - all, first - 1);
+    }
+
+    /** Obtains all tuples with the key of the given tuple */
+    range<chain_iterator> equalRange(const Tuple& key) const {
+        auto [shard, first] = findFirst(key);
+        return make_range(chain_iterator(shard, first), chain_iterator());
+    }
+
+    iterator begin() const {
+        return iterator(shards.load(std::memory_order_acquire), 0, 0);
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    std::size_t size() const {
+        const Shard* all = shards.load(std::memory_order_acquire);
+        std::size_t res = 0;
+        for (std::size_t i = 0; all != nullptr && i < NUM_SHARDS; i++) {
+            res += all[i].size.load(std::memory_order_relaxed);
+        }
+        return res;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Splits the tuples into about the given number of ranges of similar size,
+     * none of which spans shards. This must not run concurrently to insertions.
+     */
+    std::vector<range<iterator>> getChunks(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        const Shard* all = shards.load(std::memory_order_acquire);
+        const std::size_t chunkSize = std::max<std::size_t>(size() / std::max<std::size_t>(num, 1), 1);
+        for (std::size_t i = 0; all != nullptr && i < NUM_SHARDS; i++) {
+            const std::size_t entries = all[i].size.load(std::memory_order_relaxed);
+            for (std::size_t pos = 0; pos < entries; pos += chunkSize) {
+                res.push_back(make_range(
+                        iterator(all, i, pos), iterator(all, i, std::min(pos + chunkSize, entries))));
+            }
+        }
+        return res;
+    }
+
+    /** Removes all tuples and releases the memory of the index */
+    void clear() {
+        delete[] shards.exchange(nullptr);
+    }
+
+    /** Removes all tuples, retaining the blocks and the largest table of each shard */
+    void reset() {
+        Shard* all = shards.load(std::memory_order_acquire);
+        for (std::size_t i = 0; all != nullptr && i < NUM_SHARDS; i++) {
+            Shard& shard = all[i];
+            shard.size.store(0, std::memory_order_relaxed);
+            shard.keys = 0;
+            if (!shard.tables.empty()) {
+                shard.tables.erase(shard.tables.begin(), shard.tables.end() - 1);
+                Table& table = *shard.tables.back();
+                for (std::size_t j = 0; j < table.capacity(); j++) {
+                    table.slots[j].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    /** Computes the number of bytes allocated by the index */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this);
+        const Shard* all = shards.load(std::memory_order_acquire);
+        for (std::size_t i = 0; all != nullptr && i < NUM_SHARDS; i++) {
+            res += sizeof(Shard);
+            for (std::size_t block = 0; block < MAX_BLOCKS; block++) {
+                if (all[i].blocks[block]) {
+                    res += (1ull << (block + BLOCK_BITS)) * sizeof(Entry);
+                }
+            }
+            for (const auto& table : all[i].tables) {
+                res += sizeof(Table) + table->capacity() * sizeof(Slot);
+            }
+        }
+        return res;
+    }
+
+    void printStats(std::ostream& out) const {
+        std::size_t keys = 0;
+        std::size_t capacity = 0;
+        const Shard* all = shards.load(std::memory_order_acquire);
+        for (std::size_t i = 0; all != nullptr && i < NUM_SHARDS; i++) {
+            keys += all[i].keys;
+            const Table* table = all[i].table.load(std::memory_order_relaxed);
+            capacity += table == nullptr ? 0 : table->capacity();
+        }
+        out << "---------------------------------\n";
+        out << "  Hash Index of " << sizeof...(Columns) << " key column(s)\n";
+        out << "  Tuples: " << size() << "\n";
+        out << "  Keys: " << keys << "\n";
+        out << "  Shards: " << (all == nullptr ? 0 : NUM_SHARDS) << "\n";
+        out << "  Slots: " << capacity << "\n";
+        out << "  Load factor: " << (capacity == 0 ? 0.0 : static_cast<double>(keys) / capacity) << "\n";
+        out << "  Memory usage: " << getMemoryUsage() << " bytes\n";
+        out << "---------------------------------\n";
+    }
+
+private:
+    static uint64_t hashKey(const Tuple& tuple) {
+        uint64_t h = 0;
+        ((h = (h ^ static_cast<uint64_t>(static_cast<RamUnsigned>(tuple[Columns]))) * 0x9e3779b97f4a7c15ULL),
+                ...);
+        return detail::hashFinalise(h);
+    }
+
+    static bool equalKey(const Tuple& a, const Tuple& b) {
+        return ((a[Columns] == b[Columns]) && ...);
+    }
+
+    static std::size_t shardOf(uint64_t hash) {
+        // the high bits select the shard, the low bits the slot within it
+        return hash >> (64 - detail::floorLog2(NUM_SHARDS));
+    }
+
+    Shard* getShards() {
+        Shard* all = shards.load(std::memory_order_acquire);
+        if (all == nullptr) {
+            auto* fresh = new Shard[NUM_SHARDS];
+            if (shards.compare_exchange_strong(all, fresh, std::memory_order_acq_rel)) {
+                all = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return all;
+    }
+
+    /** Finds the shard of a key and the position plus one of its first entry, or zero */
+    std::pair<const Shard*, uint32_t> findFirst(const Tuple& key) const {
+        const Shard* all = shards.load(std::memory_order_acquire);
+        if (all == nullptr) {
+            return {nullptr, 0};
+        }
+        const uint64_t hash = hashKey(key);
+        const Shard& shard = all[shardOf(hash)];
+        const Table* table = shard.table.load(std::memory_order_acquire);
+        if (table == nullptr) {
+            return {&shard, 0};
+        }
+        std::size_t pos = hash & table->mask;
+        for (uint32_t first; (first = table->slots[pos].load(std::memory_order_acquire)) != 0;
+                pos = (pos + 1) & table->mask) {
+            const Entry& entry = shard.entry(first - 1);
+            if (entry.hash == hash && equalKey(entry.tuple, key)) {
+                return {&shard, first};
+            }
+        }
+        return {&shard, 0};
+    }
+
+    /** Appends an entry to a locked shard, returning its position plus one */
+    static uint32_t append(Shard& shard, const Tuple& tuple, uint64_t hash, uint32_t next) {
+        const std::size_t pos = shard.size.load(std::memory_order_relaxed);
+        const std::size_t block = Shard::blockOf(pos);
+        if (!shard.blocks[block]) {
+            shard.blocks[block] = std::make_unique<Entry[]>(1ull << (block + BLOCK_BITS));
+        }
+        shard.entry(pos) = Entry{tuple, hash, next};
+        shard.size.store(pos + 1, std::memory_order_release);
+        return static_cast<uint32_t>(pos + 1);
+    }
+
+    /** Replaces the table of a locked shard by one of twice its capacity */
+    static Table* grow(Shard& shard) {
+        const Table* old = shard.table.load(std::memory_order_relaxed);
+        auto table = std::make_unique<Table>(old == nullptr ? MIN_CAPACITY : old->capacity() * 2);
+        for (std::size_t i = 0; old != nullptr && i < old->capacity(); i++) {
+            const uint32_t first = old->slots[i].load(std::memory_order_relaxed);
+            if (first != 0) {
+                std::size_t pos = shard.entry(first - 1).hash & table->mask;
+                while (table->slots[pos].load(std::memory_order_relaxed) != 0) {
+                    pos = (pos + 1) & table->mask;
+                }
+                table->slots[pos].store(first, std::memory_order_relaxed);
+            }
+        }
+        Table* res = table.get();
+        shard.tables.push_back(std::move(table));
+        shard.table.store(res, std::memory_order_release);
+        return res;
+    }
+
+    std::atomic<Shard*> shards{nullptr};
+};
+
+}  // namespace souffle
@@ -83,7 +83,7 @@ public:
             }
 
             // create new node
-            this->leftmost = new typename parenttype::leaf_node();
+            this->leftmost = parenttype::newLeaf(this->arena);
             this->leftmost->numElements = 1;
             // call the functor as we've successfully inserted
             typename Functor::result_type res = f(k);
@@ -314,7 +314,8 @@ public:
                 // split this node
                 auto old_root = this->root;
                 idx -= cur->rebalance_or_split(
-                        const_cast<typename parenttype::node**>(&this->root), this->root_lock, idx, parents);
+                        const_cast<typename parenttype::node**>(&this->root), this->root_lock,
+                        this->arena, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -367,7 +368,7 @@ public:
         // special handling for inserting first element
         if (this->empty()) {
             // create new node
-            this->leftmost = new typename parenttype::leaf_node();
+            this->leftmost = parenttype::newLeaf(this->arena);
             this->leftmost->numElements = 1;
             // call the functor as we've successfully inserted
             typename Functor::result_type res = f(k);
@@ -445,7 +446,8 @@ public:
             if (cur->numElements >= parenttype::node::maxKeys) {
                 // split this node
                 idx -= cur->rebalance_or_split(
-                        const_cast<typename parenttype::node**>(&this->root), this->root_lock, idx);
+                        const_cast<typename parenttype::node**>(&this->root), this->root_lock,
+                        this->arena, idx);
 
                 // insert element in right fragment
                 if (((typename parenttype::size_type)idx) > cur->numElements) {
@@ -498,6 +500,7 @@ public:
         // swap the content
         std::swap(this->root, other.root);
         std::swap(this->leftmost, other.leftmost);
+        this->arena.swap(other.arena);
     }
 
     // Implementation of the assignment operation for trees.
@@ -508,13 +511,15 @@ public:
         }
 
         // create a deep-copy of the content of the other tree
+        this->clear();
+
         // shortcut for empty sets
         if (other.empty()) {
             return *this;
         }
 
         // clone content (deep copy)
-        this->root = other.root->clone();
+        this->root = other.root->clone(this->arena);
 
         // update leftmost reference
         auto tmp = this->root;
@@ -601,7 +606,8 @@ public:
 private:
     // A constructor required by the bulk-load facility.
     template <typename s, typename n, typename l>
-    LambdaBTreeSet(s size, n* root, l* leftmost) : super::parenttype(size, root, leftmost) {}
+    LambdaBTreeSet(s size, n* root, l* leftmost, Arena&& arena)
+            : super::parenttype(size, root, leftmost, std::move(arena)) {}
 
 public:
     // Support for the assignment operator.
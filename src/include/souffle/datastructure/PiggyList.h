@@ -111,6 +111,19 @@ public:
         freeList();
         numElements.store(0);
     }
+
+    /**
+     * Computes the memory allocated for the blocks of this list
+     */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this);
+        for (std::size_t i = 0; i < maxContainers; ++i) {
+            if (blockLookupTable[i].load() != nullptr) {
+                res += (INITIALBLOCKSIZE << i) * sizeof(T);
+            }
+        }
+        return res;
+    }
     const std::size_t BLOCKBITS = 16ul;
     const std::size_t INITIALBLOCKSIZE = (1ul << BLOCKBITS);
 
@@ -252,6 +265,13 @@ public:
         container_size = 0;
     }
 
+    /**
+     * Computes the memory allocated for the containers of this list
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + container_size.load() * sizeof(T);
+    }
+
     class iterator : std::iterator<std::forward_iterator_tag, T> {
         std::size_t cIndex = 0;
         PiggyList* bl;
@@ -23,6 +23,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <mutex>
 #include <utility>
 
 namespace souffle {
@@ -43,14 +44,47 @@ using block_t = uint64_t;
 // block_t & rank_mask extracts the rank
 constexpr block_t rank_mask = (1ul << split_size) - 1;
 
+/**
+ * Per-node storage of the disjoint set.
+ *
+ * Besides the parent/rank block used by union-find, each node is a member of a circular
+ * linked list that enumerates all members of its set, and the root of each set records
+ * the number of members of the set. Both are maintained on every union so that a set can
+ * be enumerated and sized without having to rebuild any auxiliary structure.
+ */
+struct DisjointSetNode {
+    // parent and rank of the node
+    std::atomic<block_t> block;
+    // next member of the same set (circular)
+    std::atomic<parent_t> next;
+    // number of members of the set (only valid for the root of the set)
+    std::atomic<std::size_t> classSize;
+};
+
 /**
  * Structure that emulates a Disjoint Set, i.e. a data structure that supports efficient union-find operations
+ *
+ * Finds and unions of nodes already in the same set are lock-free; a union that actually merges two sets
+ * serialises the re-linking of the roots, so that member lists and set sizes stay consistent.
+ *
+ * Splicing the member lists of two sets takes two stores, and a walk over a list in between may cycle
+ * through the other set. Hence sets must not be merged while their members are enumerated; walkers can
+ * detect a violation by comparing the number of merges before and during the walk.
  */
 class DisjointSet {
     template <typename TupleType>
     friend class EquivalenceRelation;
 
-    PiggyList<std::atomic<block_t>> a_blocks;
+    PiggyList<DisjointSetNode> a_blocks;
+
+    // the number of pairs in the equivalence relation spanned by the sets, i.e. sum of squared set sizes
+    std::atomic<std::size_t> numPairs{0};
+
+    // serialises merging of sets
+    SpinLock mergeLock;
+
+    // the number of merges of two sets
+    std::atomic<std::size_t> numMerges{0};
 
 public:
     DisjointSet() = default;
@@ -68,7 +102,7 @@ public:
     /**
      * Return the number of elements in this disjoint set (not the number of pairs)
      */
-    inline std::size_t size() {
+    inline std::size_t size() const {
         auto sz = a_blocks.size();
         return sz;
     };
@@ -79,10 +113,51 @@ public:
      * @return the parent block of the specified node
      */
     inline std::atomic<block_t>& get(parent_t node) const {
-        auto& ret = a_blocks.get(node);
+        auto& ret = a_blocks.get(node).block;
         return ret;
     };
 
+    /**
+     * Yield the next member of the set of a node; following the links enumerates the whole set and
+     * eventually yields the node itself again.
+     * @param node node of the set
+     * @return the successor of the node in the member list of its set
+     */
+    inline parent_t next(parent_t node) const {
+        return a_blocks.get(node).next.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Return the number of members of the set the node belongs to
+     * @param node node of the set
+     * @return the size of the set
+     */
+    inline std::size_t classSize(parent_t node) {
+        return a_blocks.get(findNode(node)).classSize.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Return the number of pairs of the equivalence relation spanned by all sets
+     */
+    inline std::size_t pairs() const {
+        return numPairs.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Return the number of merges of two sets so far, which changes whenever member lists are spliced
+     */
+    inline std::size_t merges() const {
+        return numMerges.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Check whether the node is the root (and thus representative) of its set
+     * @param node node to be checked
+     */
+    inline bool isRoot(parent_t node) const {
+        return b2p(get(node)) == node;
+    }
+
     /**
      * Equivalent to the find() function in union/find
      * Find the highest ancestor of the provided node - flattening as we go
@@ -134,6 +209,14 @@ public:
      */
     void clear() {
         a_blocks.clear();
+        numPairs.store(0);
+    }
+
+    /**
+     * Computes the memory allocated for the nodes of this DisjointSet
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(a_blocks) + a_blocks.getMemoryUsage();
     }
 
     /**
@@ -158,11 +241,17 @@ public:
      * @param y node to be unioned
      */
     void unionNodes(parent_t x, parent_t y) {
+        x = findNode(x);
+        y = findNode(y);
+
+        // no need to union if both already in same set
+        if (x == y) return;
+
+        std::lock_guard<SpinLock> guard(mergeLock);
         while (true) {
+            // roots may have changed whilst waiting for the lock
             x = findNode(x);
             y = findNode(y);
-
-            // no need to union if both already in same set
             if (x == y) return;
 
             rank_t xrank = b2r(get(x));
@@ -174,7 +263,6 @@ public:
                 std::swap(xrank, yrank);
             }
             // join the trees together
-            // perhaps we can optimise the use of compare_exchange_strong here, as we're in a pessimistic loop
             if (!updateRoot(x, xrank, y, yrank)) {
                 continue;
             }
@@ -184,6 +272,20 @@ public:
             }
             break;
         }
+
+        // splice the member lists of both sets into a single cycle
+        numMerges.fetch_add(1, std::memory_order_acq_rel);
+        DisjointSetNode& xNode = a_blocks.get(x);
+        DisjointSetNode& yNode = a_blocks.get(y);
+        parent_t xNext = xNode.next.load(std::memory_order_relaxed);
+        xNode.next.store(yNode.next.load(std::memory_order_relaxed), std::memory_order_release);
+        yNode.next.store(xNext, std::memory_order_release);
+
+        // (|x| + |y|)^2 = |x|^2 + |y|^2 + 2|x||y|
+        const std::size_t xSize = xNode.classSize.load(std::memory_order_relaxed);
+        const std::size_t ySize = yNode.classSize.load(std::memory_order_relaxed);
+        yNode.classSize.store(xSize + ySize, std::memory_order_release);
+        numPairs.fetch_add(2 * xSize * ySize, std::memory_order_acq_rel);
     }
 
     /**
@@ -194,9 +296,13 @@ public:
         // make node and find out where we've added it
         std::size_t nodeDetails = a_blocks.createNode();
 
-        a_blocks.get(nodeDetails).store(pr2b(nodeDetails, 0));
+        DisjointSetNode& node = a_blocks.get(nodeDetails);
+        node.next.store(nodeDetails, std::memory_order_relaxed);
+        node.classSize.store(1, std::memory_order_relaxed);
+        node.block.store(pr2b(nodeDetails, 0));
+        numPairs.fetch_add(1, std::memory_order_acq_rel);
 
-        return a_blocks.get(nodeDetails).load();
+        return node.block.load();
     };
 
     /**
@@ -327,6 +433,11 @@ public:
         return ds.size();
     };
 
+    /* the number of members of the set of the supplied node, which must exist */
+    inline std::size_t classSize(const SparseDomain x) {
+        return ds.classSize(toDense(x));
+    };
+
     /**
      * Remove all elements from this disjoint set
      */
@@ -336,6 +447,13 @@ public:
         denseToSparseMap.clear();
     }
 
+    /**
+     * Computes the memory of the disjoint set and the mappings between sparse and dense values
+     */
+    std::size_t getMemoryUsage() const {
+        return ds.getMemoryUsage() + sparseToDenseMap.getMemoryUsage() + denseToSparseMap.getMemoryUsage();
+    }
+
     /* wrapper for node creation */
     inline void makeNode(SparseDomain val) {
         // dense has the behaviour of creating if not exists.
@@ -0,0 +1,142 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file OutputScheduler.h
+ *
+ * Streams output relations on a background thread while the evaluation
+ * of the program proceeds.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/ParallelUtil.h"
+
+#include <exception>
+#include <functional>
+#include <utility>
+
+#ifdef IS_PARALLEL
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace souffle {
+
+/**
+ * Executes output jobs, i.e., writing a final relation or releasing it
+ * afterwards, one by one on a background I/O thread in the order they have
+ * been scheduled. A job must only access relations which are not modified
+ * by the evaluation any more.
+ *
+ * The first exception raised by a job is re-thrown on the next call of
+ * schedule() or flush(); later jobs are dropped. Without parallel support
+ * jobs are executed right away.
+ */
+class OutputScheduler {
+public:
+    OutputScheduler() = default;
+    OutputScheduler(const OutputScheduler&) = delete;
+    OutputScheduler& operator=(const OutputScheduler&) = delete;
+
+    ~OutputScheduler() {
+#ifdef IS_PARALLEL
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+#endif
+    }
+
+    /**
+     * Appends the given job to the queue of the I/O thread.
+     */
+    void schedule(std::function<void()> job) {
+#ifdef IS_PARALLEL
+        std::unique_lock<std::mutex> guard(lock);
+        rethrow();
+        if (!worker.joinable()) {
+            worker = std::thread([this]() { run(); });
+        }
+        jobs.push_back(std::move(job));
+        guard.unlock();
+        changed.notify_all();
+#else
+        job();
+#endif
+    }
+
+    /**
+     * Waits until all scheduled jobs have been executed.
+     */
+    void flush() {
+#ifdef IS_PARALLEL
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&]() { return jobs.empty() && !busy; });
+        rethrow();
+#endif
+    }
+
+private:
+#ifdef IS_PARALLEL
+    /** Re-throws a pending failure; the caller holds the lock */
+    void rethrow() {
+        if (error) {
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+    }
+
+    /** The main loop of the I/O thread */
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            changed.wait(guard, [&]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            busy = true;
+            guard.unlock();
+
+            std::exception_ptr failure;
+            try {
+                job();
+            } catch (...) {
+                failure = std::current_exception();
+            }
+
+            guard.lock();
+            busy = false;
+            if (failure && !error) {
+                error = failure;
+                jobs.clear();
+            }
+            changed.notify_all();
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::function<void()>> jobs;
+    std::thread worker;
+    std::exception_ptr error;
+    bool busy = false;
+    bool stopping = false;
+#endif
+};
+
+}  // namespace souffle
@@ -19,21 +19,25 @@
 #include "souffle/io/ReadStream.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/FileUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StringUtil.h"
 
 #include <algorithm>
-#include <cassert>
+#include <cctype>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
-#include <queue>
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <tuple>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
 #include <vector>
 
 namespace souffle {
@@ -46,272 +50,536 @@ template <typename... T>
     throw std::runtime_error(out.str());
 }
 
+/**
+ * A pull tokenizer reading JSON values from a text held in memory, e.g., a
+ * memory-mapped file. Values are consumed one by one without building a
+ * document tree.
+ */
+class JsonScanner {
+public:
+    JsonScanner() = default;
+
+    /**
+     * @param origin - start of the whole text, used for error positions
+     * @param begin - start of the scanned range
+     * @param end - end of the scanned range
+     */
+    JsonScanner(const char* origin, const char* begin, const char* end)
+            : start(origin), cur(begin), end(end) {}
+
+    const char* origin() const {
+        return start;
+    }
+
+    const char* position() const {
+        return cur;
+    }
+
+    const char* limit() const {
+        return end;
+    }
+
+    bool atEnd() {
+        skipWhitespace();
+        return cur == end;
+    }
+
+    char peek() {
+        skipWhitespace();
+        return cur == end ? '\0' : *cur;
+    }
+
+    bool tryConsume(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        ++cur;
+        return true;
+    }
+
+    void consume(char c) {
+        if (!tryConsume(c)) {
+            fail("expected '", c, "'");
+        }
+    }
+
+    bool tryNull() {
+        if (peek() != 'n' || end - cur < 4 || std::string_view(cur, 4) != "null") {
+            return false;
+        }
+        cur += 4;
+        return true;
+    }
+
+    /**
+     * Reads a string; the result remains valid until the next call.
+     */
+    const std::string& readString() {
+        consume('"');
+        buffer.clear();
+        while (true) {
+            const char* run = cur;
+            while (cur != end && *cur != '"' && *cur != '\\' && static_cast<unsigned char>(*cur) >= 0x20) {
+                ++cur;
+            }
+            buffer.append(run, cur);
+            if (cur == end) {
+                fail("unterminated string");
+            }
+            const char c = *cur++;
+            if (c == '"') {
+                return buffer;
+            }
+            if (c != '\\') {
+                fail("control character in string");
+            }
+            if (cur == end) {
+                fail("unterminated string");
+            }
+            switch (*cur++) {
+                case '"': buffer += '"'; break;
+                case '\\': buffer += '\\'; break;
+                case '/': buffer += '/'; break;
+                case 'b': buffer += '\b'; break;
+                case 'f': buffer += '\f'; break;
+                case 'n': buffer += '\n'; break;
+                case 'r': buffer += '\r'; break;
+                case 't': buffer += '\t'; break;
+                case 'u': appendCodePoint(); break;
+                default: fail("invalid escape sequence");
+            }
+        }
+    }
+
+    RamSigned readSigned() {
+        const std::string_view token = readNumber();
+        if (token.find_first_of(".eE") != std::string_view::npos) {
+            return static_cast<RamSigned>(std::strtod(std::string(token).c_str(), nullptr));
+        }
+        return parseInteger<RamSigned>(token);
+    }
+
+    RamUnsigned readUnsigned() {
+        const std::string_view token = readNumber();
+        if (token.find_first_of(".eE") != std::string_view::npos) {
+            return static_cast<RamUnsigned>(std::strtod(std::string(token).c_str(), nullptr));
+        }
+        // negative values are accepted as they are written for large unsigned numbers
+        if (token.front() == '-') {
+            return ramBitCast<RamUnsigned>(parseInteger<RamSigned>(token));
+        }
+        return parseInteger<RamUnsigned>(token);
+    }
+
+    RamFloat readFloat() {
+        return static_cast<RamFloat>(std::strtod(std::string(readNumber()).c_str(), nullptr));
+    }
+
+    template <typename... T>
+    [[noreturn]] void fail(T const&... t) const {
+        std::ostringstream out;
+        out << "cannot deserialize json at line " << (1 + std::count(start, cur, '\n')) << ": ";
+        (out << ... << t);
+        throw std::invalid_argument(out.str());
+    }
+
+private:
+    void skipWhitespace() {
+        while (cur != end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t')) {
+            ++cur;
+        }
+    }
+
+    std::string_view readNumber() {
+        skipWhitespace();
+        const char* first = cur;
+        while (cur != end && (std::isdigit(static_cast<unsigned char>(*cur)) != 0 || *cur == '-' ||
+                                     *cur == '+' || *cur == '.' || *cur == 'e' || *cur == 'E')) {
+            ++cur;
+        }
+        if (first == cur) {
+            fail("expected a number");
+        }
+        return std::string_view(first, static_cast<std::size_t>(cur - first));
+    }
+
+    template <typename T>
+    T parseInteger(std::string_view token) const {
+        T value = 0;
+        const char* last = token.data() + token.size();
+        auto [ptr, ec] = std::from_chars(token.data(), last, value);
+        if (ec != std::errc() || ptr != last) {
+            fail("invalid number ", token);
+        }
+        return value;
+    }
+
+    std::uint32_t readHex() {
+        if (end - cur < 4) {
+            fail("invalid unicode escape");
+        }
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = *cur++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<std::uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<std::uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<std::uint32_t>(c - 'A' + 10);
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return value;
+    }
+
+    /** Appends the UTF-8 encoding of a \u escape, combining surrogate pairs */
+    void appendCodePoint() {
+        std::uint32_t cp = readHex();
+        if (cp >= 0xD800 && cp <= 0xDBFF && end - cur >= 6 && cur[0] == '\\' && cur[1] == 'u') {
+            const char* low = cur;
+            cur += 2;
+            const std::uint32_t next = readHex();
+            if (next >= 0xDC00 && next <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (next - 0xDC00);
+            } else {
+                cur = low;
+            }
+        }
+        if (cp < 0x80) {
+            buffer += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            buffer += static_cast<char>(0xC0 | (cp >> 6));
+            buffer += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            buffer += static_cast<char>(0xE0 | (cp >> 12));
+            buffer += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            buffer += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            buffer += static_cast<char>(0xF0 | (cp >> 18));
+            buffer += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            buffer += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            buffer += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    const char* start = nullptr;
+    const char* cur = nullptr;
+    const char* end = nullptr;
+    std::string buffer;
+};
+
+/**
+ * Reads tuples from JSON, either a single array of tuples or, with the
+ * directive ndjson=true, one tuple per line. Each tuple is a list of values
+ * or an object keyed by the attribute names. The input is tokenized as it is
+ * consumed; large NDJSON inputs of relations without records are parsed in
+ * parallel chunks.
+ */
 class ReadStreamJSON : public ReadStream {
 public:
     ReadStreamJSON(std::istream& file, const std::map<std::string, std::string>& rwOperation,
             SymbolTable& symbolTable, RecordTable& recordTable)
-            : ReadStream(rwOperation, symbolTable, recordTable), file(file), pos(0), isInitialized(false) {
+            : ReadStreamJSON(rwOperation, symbolTable, recordTable) {
+        this->file = &file;
+    }
+
+protected:
+    ReadStreamJSON(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStream(rwOperation, symbolTable, recordTable),
+              ndjson(getOr(rwOperation, "ndjson", "false") == "true") {
         std::string err;
         params = Json::parse(rwOperation.at("params"), err);
         if (err.length() > 0) {
             throwError("cannot get internal params: ", err);
         }
+        std::size_t index_pos = 0;
+        for (auto param : params["relation"]["params"].array_items()) {
+            paramIndex.insert(std::make_pair(param.string_value(), index_pos));
+            index_pos++;
+        }
     }
 
-protected:
-    std::istream& file;
-    std::size_t pos;
-    Json jsonSource;
+    /** A range of NDJSON lines and the tuples parsed from it */
+    struct ParsedChunk {
+        ParsedChunk(const char* begin, const char* end) : begin(begin), end(end) {}
+
+        const char* begin;
+        const char* end;
+        std::size_t numTuples = 0;
+        std::vector<RamDomain> tuples;
+        /** Symbols of the chunk, referenced by their index until resolved */
+        std::vector<std::string> symbols;
+    };
+
+    /** Inputs below this size are always parsed sequentially */
+    static constexpr std::size_t parallelThreshold = 1 << 20;
+
+    std::istream* file = nullptr;
+    std::string content;
+    JsonScanner scanner;
     Json params;
-    bool isInitialized;
-    bool useObjects;
-    std::map<const std::string, const std::size_t> paramIndex;
+    const bool ndjson;
+    bool isInitialized = false;
+    bool isFirst = true;
+    bool isDone = false;
+    std::map<std::string, std::size_t> paramIndex;
+    std::map<std::string, std::map<std::string, std::size_t>> recordParamIndex;
+    std::vector<ParsedChunk> chunks;
+    std::size_t chunkPos = 0;
+    std::size_t tuplePos = 0;
+
+    /**
+     * Sets the text to be read; it must outlive the stream.
+     */
+    void setSource(const char* begin, const char* end) {
+        scanner = JsonScanner(begin, begin, end);
+    }
 
     Own<RamDomain[]> readNextTuple() override {
-        // for some reasons we cannot initalized our json objects in constructor
-        // otherwise it will segfault, so we initialize in the first call
         if (!isInitialized) {
             isInitialized = true;
-            std::string error = "";
-            std::string source(std::istreambuf_iterator<char>(file), {});
-
-            jsonSource = Json::parse(source, error);
-            // it should be wrapped by an extra array
-            if (error.length() > 0 || !jsonSource.is_array()) {
-                throwError("cannot deserialize json because ", error, ":\n", source);
+            if (file != nullptr) {
+                content.assign(std::istreambuf_iterator<char>(*file), {});
+                setSource(content.data(), content.data() + content.size());
+            }
+            if (!ndjson) {
+                scanner.consume('[');
+            } else if (parseInParallel()) {
+                isDone = true;
             }
+        }
+
+        if (!chunks.empty()) {
+            return readNextParsedTuple();
+        }
 
-            if (jsonSource.array_items().empty()) {
-                // No tuples defined
+        if (ndjson) {
+            if (scanner.atEnd()) {
                 return nullptr;
             }
-
-            // we only check the first one, since there are extra checks
-            // in readNextTupleObject/readNextTupleList
-            if (jsonSource[0].is_array()) {
-                useObjects = false;
-            } else if (jsonSource[0].is_object()) {
-                useObjects = true;
-                std::size_t index_pos = 0;
-                for (auto param : params["relation"]["params"].array_items()) {
-                    paramIndex.insert(std::make_pair(param.string_value(), index_pos));
-                    index_pos++;
+        } else {
+            if (isDone) {
+                return nullptr;
+            }
+            if (scanner.tryConsume(']')) {
+                isDone = true;
+                if (!scanner.atEnd()) {
+                    scanner.fail("unexpected content after the array of tuples");
                 }
-            } else {
-                throwError("the input is neither list nor object format");
+                return nullptr;
+            }
+            if (!isFirst) {
+                scanner.consume(',');
             }
+            isFirst = false;
         }
 
-        if (useObjects) {
-            return readNextTupleObject();
-        } else {
-            return readNextTupleList();
-        }
+        Own<RamDomain[]> tuple = mk<RamDomain[]>(typeAttributes.size());
+        auto encode = [&](const std::string& symbol) { return symbolTable.unsafeEncode(symbol); };
+        readTuple(scanner, tuple.get(), encode);
+        return tuple;
     }
 
-    Own<RamDomain[]> readNextTupleList() {
-        if (pos >= jsonSource.array_items().size()) {
-            return nullptr;
+    /**
+     * Reads a tuple given as a list or an object into the given array.
+     */
+    template <typename Encode>
+    void readTuple(JsonScanner& source, RamDomain* tuple, Encode& encode) {
+        if (typeAttributes.empty() && source.tryNull()) {
+            return;
         }
-
-        Own<RamDomain[]> tuple = mk<RamDomain[]>(typeAttributes.size());
-        const Json& jsonObj = jsonSource[pos];
-        assert(jsonObj.is_array() && "the input is not json array");
-        pos++;
-        for (std::size_t i = 0; i < typeAttributes.size(); ++i) {
-            try {
-                auto&& ty = typeAttributes.at(i);
-                switch (ty[0]) {
-                    case 's': {
-                        tuple[i] = symbolTable.unsafeEncode(jsonObj[i].string_value());
-                        break;
-                    }
-                    case 'r': {
-                        tuple[i] = readNextElementList(jsonObj[i], ty);
-                        break;
-                    }
-                    case 'i': {
-                        tuple[i] = jsonObj[i].int_value();
-                        break;
-                    }
-                    case 'u': {
-                        tuple[i] = jsonObj[i].int_value();
-                        break;
-                    }
-                    case 'f': {
-                        tuple[i] = static_cast<RamDomain>(jsonObj[i].number_value());
-                        break;
-                    }
-                    default: throwError("invalid type attribute: '", ty[0], "'");
-                }
-            } catch (...) {
-                std::stringstream errorMessage;
-                if (jsonObj.is_array() && i < jsonObj.array_items().size()) {
-                    errorMessage << "Error converting: " << jsonObj[i].dump();
-                } else {
-                    errorMessage << "Invalid index: " << i;
+        if (source.tryConsume('[')) {
+            for (std::size_t i = 0; i < typeAttributes.size(); ++i) {
+                if (i > 0) {
+                    source.consume(',');
                 }
-                throw std::invalid_argument(errorMessage.str());
+                tuple[i] = readValue(source, typeAttributes[i], encode);
             }
+            source.consume(']');
+        } else if (source.tryConsume('{')) {
+            readObject(source, paramIndex,
+                    [&](std::size_t i) { tuple[i] = readValue(source, typeAttributes.at(i), encode); });
+        } else {
+            source.fail("the input is neither list nor object format");
         }
+    }
 
-        return tuple;
+    /**
+     * Reads the members of an object after its opening brace, passing the
+     * index of each member to the given reader of its value.
+     */
+    template <typename Member>
+    void readObject(
+            JsonScanner& source, const std::map<std::string, std::size_t>& index, const Member& readMember) {
+        if (source.tryConsume('}')) {
+            return;
+        }
+        do {
+            const std::string& name = source.readString();
+            auto pos = index.find(name);
+            if (pos == index.end()) {
+                source.fail("invalid parameter: ", name);
+            }
+            source.consume(':');
+            readMember(pos->second);
+        } while (source.tryConsume(','));
+        source.consume('}');
     }
 
-    RamDomain readNextElementList(const Json& source, const std::string& recordTypeName) {
-        auto&& recordInfo = types["records"][recordTypeName];
+    template <typename Encode>
+    RamDomain readValue(JsonScanner& source, const std::string& type, Encode& encode) {
+        switch (type[0]) {
+            case 's': return encode(source.readString());
+            case 'r': return readRecord(source, type, encode);
+            case 'i': return source.readSigned();
+            case 'u': return ramBitCast(source.readUnsigned());
+            case 'f': return ramBitCast(source.readFloat());
+            default: throwError("invalid type attribute: '", type[0], "'");
+        }
+    }
 
+    template <typename Encode>
+    RamDomain readRecord(JsonScanner& source, const std::string& recordTypeName, Encode& encode) {
+        auto&& recordInfo = types["records"][recordTypeName];
         if (recordInfo.is_null()) {
             throw std::invalid_argument("Missing record type information: " + recordTypeName);
         }
 
         // Handle null case
-        if (source.is_null()) {
+        if (source.tryNull()) {
             return 0;
         }
 
-        assert(source.is_array() && "the input is not json array");
         auto&& recordTypes = recordInfo["types"];
         const std::size_t recordArity = recordInfo["arity"].long_value();
         std::vector<RamDomain> recordValues(recordArity);
-        for (std::size_t i = 0; i < recordArity; ++i) {
-            const std::string& recordType = recordTypes[i].string_value();
-            switch (recordType[0]) {
-                case 's': {
-                    recordValues[i] = symbolTable.unsafeEncode(source[i].string_value());
-                    break;
-                }
-                case 'r': {
-                    recordValues[i] = readNextElementList(source[i], recordType);
-                    break;
-                }
-                case 'i': {
-                    recordValues[i] = source[i].int_value();
-                    break;
+        if (source.tryConsume('[')) {
+            for (std::size_t i = 0; i < recordArity; ++i) {
+                if (i > 0) {
+                    source.consume(',');
                 }
-                case 'u': {
-                    recordValues[i] = source[i].int_value();
-                    break;
-                }
-                case 'f': {
-                    recordValues[i] = static_cast<RamDomain>(source[i].number_value());
-                    break;
-                }
-                default: throwError("invalid type attribute");
+                recordValues[i] = readValue(source, recordTypes[i].string_value(), encode);
             }
+            source.consume(']');
+        } else if (source.tryConsume('{')) {
+            readObject(source, getRecordParamIndex(recordTypeName), [&](std::size_t i) {
+                recordValues[i] = readValue(source, recordTypes[i].string_value(), encode);
+            });
+        } else {
+            source.fail("the record is neither list nor object format");
         }
 
         return recordTable.pack(recordValues.data(), recordValues.size());
     }
 
-    Own<RamDomain[]> readNextTupleObject() {
-        if (pos >= jsonSource.array_items().size()) {
-            return nullptr;
+    /** Maps the attribute names of a record type to their positions */
+    const std::map<std::string, std::size_t>& getRecordParamIndex(const std::string& recordTypeName) {
+        auto pos = recordParamIndex.find(recordTypeName);
+        if (pos != recordParamIndex.end()) {
+            return pos->second;
         }
-
-        Own<RamDomain[]> tuple = mk<RamDomain[]>(typeAttributes.size());
-        const Json& jsonObj = jsonSource[pos];
-        assert(jsonObj.is_object() && "the input is not json object");
-        pos++;
-        for (auto p : jsonObj.object_items()) {
-            try {
-                // get the corresponding position by parameter name
-                if (paramIndex.find(p.first) == paramIndex.end()) {
-                    throwError("invalid parameter: ", p.first);
-                }
-                std::size_t i = paramIndex.at(p.first);
-                auto&& ty = typeAttributes.at(i);
-                switch (ty[0]) {
-                    case 's': {
-                        tuple[i] = symbolTable.unsafeEncode(p.second.string_value());
-                        break;
-                    }
-                    case 'r': {
-                        tuple[i] = readNextElementObject(p.second, ty);
-                        break;
-                    }
-                    case 'i': {
-                        tuple[i] = p.second.int_value();
-                        break;
-                    }
-                    case 'u': {
-                        tuple[i] = p.second.int_value();
-                        break;
-                    }
-                    case 'f': {
-                        tuple[i] = static_cast<RamDomain>(p.second.number_value());
-                        break;
-                    }
-                    default: throwError("invalid type attribute: '", ty[0], "'");
-                }
-            } catch (...) {
-                std::stringstream errorMessage;
-                errorMessage << "Error converting: " << p.second.dump();
-                throw std::invalid_argument(errorMessage.str());
-            }
-        }
-
-        return tuple;
-    }
-
-    RamDomain readNextElementObject(const Json& source, const std::string& recordTypeName) {
-        auto&& recordInfo = types["records"][recordTypeName];
-        const std::string recordName = recordTypeName.substr(2);
-        std::map<const std::string, const std::size_t> recordIndex;
-
+        auto& recordIndex = recordParamIndex[recordTypeName];
         std::size_t index_pos = 0;
-        for (auto param : params["records"][recordName]["params"].array_items()) {
+        for (auto param : params["records"][recordTypeName.substr(2)]["params"].array_items()) {
             recordIndex.insert(std::make_pair(param.string_value(), index_pos));
             index_pos++;
         }
+        return recordIndex;
+    }
 
-        if (recordInfo.is_null()) {
-            throw std::invalid_argument("Missing record type information: " + recordTypeName);
+    /**
+     * Parses the remaining NDJSON lines in chunks on the task pool, if the
+     * input is large enough and the relation has no record attributes.
+     * Symbols are collected per chunk and encoded afterwards, since the
+     * symbol table must not be modified concurrently.
+     *
+     * @return whether the input has been parsed
+     */
+    bool parseInParallel() {
+        const std::size_t numThreads = TaskPool::instance().getNumThreads();
+        const char* begin = scanner.position();
+        const char* end = scanner.limit();
+        const auto size = static_cast<std::size_t>(end - begin);
+        if (numThreads <= 1 || size < parallelThreshold) {
+            return false;
         }
-
-        // Handle null case
-        if (source.is_null()) {
-            return 0;
+        for (const auto& type : typeAttributes) {
+            if (type[0] == 'r') {
+                return false;
+            }
         }
 
-        assert(source.is_object() && "the input is not json object");
-        auto&& recordTypes = recordInfo["types"];
-        const std::size_t recordArity = recordInfo["arity"].long_value();
-        std::vector<RamDomain> recordValues(recordArity);
-        recordValues.reserve(recordIndex.size());
-        for (auto readParam : source.object_items()) {
-            // get the corresponding position by parameter name
-            if (recordIndex.find(readParam.first) == recordIndex.end()) {
-                throwError("invalid parameter: ", readParam.first);
+        // split at line breaks, which cannot occur within JSON strings
+        const std::size_t chunkSize = size / (4 * numThreads) + 1;
+        while (begin != end) {
+            const char* next = begin + std::min(chunkSize, static_cast<std::size_t>(end - begin));
+            next = std::find(next, end, '\n');
+            if (next != end) {
+                ++next;
             }
-            std::size_t i = recordIndex.at(readParam.first);
-            auto&& type = recordTypes[i].string_value();
-            switch (type[0]) {
-                case 's': {
-                    recordValues[i] = symbolTable.unsafeEncode(readParam.second.string_value());
-                    break;
-                }
-                case 'r': {
-                    recordValues[i] = readNextElementObject(readParam.second, type);
-                    break;
-                }
-                case 'i': {
-                    recordValues[i] = readParam.second.int_value();
-                    break;
+            chunks.emplace_back(begin, next);
+            begin = next;
+        }
+
+        const std::size_t width = typeAttributes.size();
+        const char* origin = scanner.origin();
+        TaskPool::instance().parallelFor(chunks.begin(), chunks.end(), [&](auto chunk) {
+            JsonScanner source(origin, chunk->begin, chunk->end);
+            std::unordered_map<std::string, RamDomain> localSymbols;
+            auto encode = [&](const std::string& symbol) {
+                auto pos = localSymbols.emplace(symbol, static_cast<RamDomain>(chunk->symbols.size()));
+                if (pos.second) {
+                    chunk->symbols.push_back(symbol);
                 }
-                case 'u': {
-                    recordValues[i] = readParam.second.int_value();
-                    break;
+                return pos.first->second;
+            };
+            while (!source.atEnd()) {
+                chunk->tuples.resize(chunk->tuples.size() + width);
+                readTuple(source, chunk->tuples.data() + chunk->numTuples * width, encode);
+                chunk->numTuples++;
+            }
+        });
+
+        // replace the chunk-local symbol indices by their encoding
+        std::vector<RamDomain> encoded;
+        for (auto& chunk : chunks) {
+            encoded.clear();
+            for (const auto& symbol : chunk.symbols) {
+                encoded.push_back(symbolTable.unsafeEncode(symbol));
+            }
+            for (std::size_t i = 0; i < width; ++i) {
+                if (typeAttributes[i][0] != 's') {
+                    continue;
                 }
-                case 'f': {
-                    recordValues[i] = static_cast<RamDomain>(readParam.second.number_value());
-                    break;
+                for (std::size_t t = 0; t < chunk.numTuples; ++t) {
+                    RamDomain& value = chunk.tuples[t * width + i];
+                    value = encoded[static_cast<std::size_t>(value)];
                 }
-                default: throwError("invalid type attribute: '", type[0], "'");
             }
+            chunk.symbols = {};
         }
+        return true;
+    }
 
-        return recordTable.pack(recordValues.data(), recordValues.size());
+    Own<RamDomain[]> readNextParsedTuple() {
+        while (chunkPos < chunks.size() && tuplePos == chunks[chunkPos].numTuples) {
+            chunks[chunkPos].tuples = {};
+            chunkPos++;
+            tuplePos = 0;
+        }
+        if (chunkPos == chunks.size()) {
+            return nullptr;
+        }
+        const std::size_t width = typeAttributes.size();
+        Own<RamDomain[]> tuple = mk<RamDomain[]>(width);
+        const RamDomain* values = chunks[chunkPos].tuples.data() + tuplePos * width;
+        std::copy(values, values + width, tuple.get());
+        tuplePos++;
+        return tuple;
     }
 };
 
@@ -319,14 +587,12 @@ class ReadFileJSON : public ReadStreamJSON {
 public:
     ReadFileJSON(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
             RecordTable& recordTable)
-            // FIXME: This is bordering on UB - we're passing an unconstructed
-            // object (fileHandle) to the base class
-            : ReadStreamJSON(fileHandle, rwOperation, symbolTable, recordTable),
-              baseName(souffle::baseName(getFileName(rwOperation))),
-              fileHandle(getFileName(rwOperation), std::ios::in | std::ios::binary) {
-        if (!fileHandle.is_open()) {
+            : ReadStreamJSON(rwOperation, symbolTable, recordTable),
+              baseName(souffle::baseName(getFileName(rwOperation))), input(getFileName(rwOperation)) {
+        if (!input.isOpen()) {
             throw std::invalid_argument("Cannot open json file " + baseName + "\n");
         }
+        setSource(input.begin(), input.end());
     }
 
     ~ReadFileJSON() override = default;
@@ -348,7 +614,7 @@ protected:
     }
 
     std::string baseName;
-    std::ifstream fileHandle;
+    MappedFile input;
 };
 
 class ReadCinJSONFactory : public ReadStreamFactory {
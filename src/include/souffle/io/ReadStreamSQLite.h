@@ -26,12 +26,23 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <sqlite3.h>
 
 namespace souffle {
 class RecordTable;
 
+/**
+ * Reads a relation from an SQLite database.
+ *
+ * Relations written by Souffle are read from their underlying table of
+ * numbers rather than from the view resolving their symbols. The symbols
+ * referenced by the relation are loaded and encoded in bulk beforehand; as
+ * with the view, rows referencing a symbol missing from the database are
+ * skipped. Any other table or view is read as text. Records and ADTs are
+ * read from their textual form, or taken as is if stored as numbers.
+ */
 class ReadStreamSQLite : public ReadStream {
 public:
     ReadStreamSQLite(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
@@ -56,6 +67,10 @@ protected:
      * @return
      */
     Own<RamDomain[]> readNextTuple() override {
+        if (readsNumbers) {
+            return readNextNumbers();
+        }
+
         if (sqlite3_step(selectStatement) != SQLITE_ROW) {
             return nullptr;
         }
@@ -76,8 +91,9 @@ protected:
                     case 's': tuple[column] = symbolTable.unsafeEncode(element); break;
                     case 'i':
                     case 'u':
-                    case 'f':
-                    case 'r': tuple[column] = RamSignedFromString(element); break;
+                    case 'f': tuple[column] = RamSignedFromString(element); break;
+                    case 'r':
+                    case '+': tuple[column] = readComposite(column, ty); break;
                     default: fatal("invalid type attribute: `%c`", ty[0]);
                 }
             } catch (...) {
@@ -90,6 +106,51 @@ protected:
         return tuple;
     }
 
+    /**
+     * Read and return the next tuple of a relation written by Souffle.
+     *
+     * Returns nullptr if no tuple was readable.
+     */
+    Own<RamDomain[]> readNextNumbers() {
+        Own<RamDomain[]> tuple = mk<RamDomain[]>(arity + auxiliaryArity);
+        while (sqlite3_step(selectStatement) == SQLITE_ROW) {
+            bool resolved = true;
+            for (uint32_t column = 0; column < arity && resolved; column++) {
+                auto value = static_cast<RamDomain>(sqlite3_column_int64(selectStatement, column));
+                auto&& ty = typeAttributes.at(column);
+                switch (ty[0]) {
+                    case 's': {
+                        auto symbol = symbols.find(value);
+                        resolved = symbol != symbols.end();
+                        tuple[column] = resolved ? symbol->second : 0;
+                        break;
+                    }
+                    case 'i':
+                    case 'u':
+                    case 'f': tuple[column] = value; break;
+                    case 'r':
+                    case '+': tuple[column] = readComposite(column, ty); break;
+                    default: fatal("invalid type attribute: `%c`", ty[0]);
+                }
+            }
+            if (resolved) {
+                return tuple;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Read a record or ADT from its textual form, or take it as is if stored as a number.
+     */
+    RamDomain readComposite(uint32_t column, const std::string& type) {
+        if (sqlite3_column_type(selectStatement, column) == SQLITE_INTEGER) {
+            return static_cast<RamDomain>(sqlite3_column_int64(selectStatement, column));
+        }
+        std::string element(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, column)));
+        return type[0] == 'r' ? readRecord(element, type) : readADT(element, type);
+    }
+
     void executeSQL(const std::string& sql) {
         assert(db && "Database connection is closed");
 
@@ -112,9 +173,58 @@ protected:
         throw std::invalid_argument(error.str());
     }
 
+    /**
+     * Load the symbols of the database referenced by the symbol columns of
+     * the relation, encoding them at once.
+     */
+    void loadSymbols(const std::string& tableName) {
+        std::stringstream ids;
+        for (uint32_t column = 0; column < arity; column++) {
+            if (typeAttributes.at(column)[0] == 's') {
+                ids << (ids.tellp() > 0 ? " UNION " : "") << "SELECT \"" << column << "\" FROM '" << tableName
+                    << "'";
+            }
+        }
+        if (ids.tellp() == 0) {
+            return;
+        }
+
+        sqlite3_stmt* symbolStatement = nullptr;
+        std::string symbolSQL =
+                "SELECT id, symbol FROM '" + symbolTableName + "' WHERE id IN (" + ids.str() + ");";
+        if (sqlite3_prepare_v2(db, symbolSQL.c_str(), -1, &symbolStatement, nullptr) != SQLITE_OK) {
+            throwError("SQLite error in sqlite3_prepare_v2: ");
+        }
+        std::vector<RamDomain> symbolIds;
+        std::vector<std::string> symbolTexts;
+        int rc;
+        while ((rc = sqlite3_step(symbolStatement)) == SQLITE_ROW) {
+            symbolIds.push_back(static_cast<RamDomain>(sqlite3_column_int64(symbolStatement, 0)));
+            const auto* text = reinterpret_cast<const char*>(sqlite3_column_text(symbolStatement, 1));
+            symbolTexts.emplace_back(text == nullptr || *text == '\0' ? "n/a" : text);
+        }
+        sqlite3_finalize(symbolStatement);
+        if (rc != SQLITE_DONE) {
+            throwError("SQLite error in sqlite3_step: ");
+        }
+
+        std::vector<RamDomain> indexes(symbolTexts.size());
+        symbolTable.encode(symbolTexts.data(), symbolTexts.size(), indexes.data());
+        for (std::size_t i = 0; i < symbolIds.size(); i++) {
+            symbols.emplace(symbolIds[i], indexes[i]);
+        }
+    }
+
     void prepareSelectStatement() {
+        // read the numbers of relations written by Souffle, resolving their symbols separately
+        const std::string tableName = "_" + relationName;
+        readsNumbers = tableExists(tableName, "'table'") && tableExists(symbolTableName, "'table'");
+        if (readsNumbers) {
+            loadSymbols(tableName);
+        }
+
         std::stringstream selectSQL;
-        selectSQL << "SELECT * FROM '" << relationName << "'";
+        selectSQL << "SELECT * FROM '" << (readsNumbers ? tableName : relationName) << "'";
         const char* tail = nullptr;
         if (sqlite3_prepare_v2(db, selectSQL.str().c_str(), -1, &selectStatement, &tail) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_prepare_v2: ");
@@ -130,27 +240,31 @@ protected:
         executeSQL("PRAGMA journal_mode = MEMORY");
     }
 
-    void checkTableExists() {
+    bool tableExists(const std::string& name, const std::string& types = "'table', 'view'") {
         sqlite3_stmt* tableStatement;
         std::stringstream selectSQL;
-        selectSQL << "SELECT count(*) FROM sqlite_master WHERE type IN ('table', 'view') AND ";
-        selectSQL << " name = '" << relationName << "';";
+        selectSQL << "SELECT count(*) FROM sqlite_master WHERE type IN (" << types << ") AND ";
+        selectSQL << " name = ?;";
         const char* tail = nullptr;
 
         if (sqlite3_prepare_v2(db, selectSQL.str().c_str(), -1, &tableStatement, &tail) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_prepare_v2: ");
         }
+        sqlite3_bind_text(tableStatement, 1, name.c_str(), -1, SQLITE_STATIC);
 
+        bool exists = false;
         if (sqlite3_step(tableStatement) == SQLITE_ROW) {
-            int count = sqlite3_column_int(tableStatement, 0);
-            if (count > 0) {
-                sqlite3_finalize(tableStatement);
-                return;
-            }
+            exists = sqlite3_column_int(tableStatement, 0) > 0;
         }
         sqlite3_finalize(tableStatement);
-        throw std::invalid_argument(
-                "Required table or view does not exist in " + dbFilename + " for relation " + relationName);
+        return exists;
+    }
+
+    void checkTableExists() {
+        if (!tableExists(relationName)) {
+            throw std::invalid_argument("Required table or view does not exist in " + dbFilename +
+                                        " for relation " + relationName);
+        }
     }
 
     /**
@@ -174,7 +288,12 @@ protected:
 
     const std::string dbFilename;
     const std::string relationName;
+    const std::string symbolTableName = "__SymbolTable";
     sqlite3_stmt* selectStatement = nullptr;
+    /** Whether the relation is read from the numbers written by Souffle */
+    bool readsNumbers = false;
+    /** Encoded symbols by their id in the database */
+    std::unordered_map<RamDomain, RamDomain> symbols;
     sqlite3* db = nullptr;
 };
 
@@ -50,11 +50,12 @@ public:
             if (relation.begin() != relation.end()) {
                 writeNullary();
             }
-            return;
-        }
-        for (const auto& current : relation) {
-            writeNext(current);
+        } else {
+            for (const auto& current : relation) {
+                writeNext(current);
+            }
         }
+        finish();
     }
 
     template <typename T>
@@ -67,6 +68,8 @@ protected:
 
     virtual void writeNullary() = 0;
     virtual void writeNextTuple(const RamDomain* tuple) = 0;
+    /** Completes the output after the last tuple, failures are thrown rather than lost on destruction */
+    virtual void finish() {}
     virtual void writeSize(std::size_t) {
         fatal("attempting to print size of a write operation");
     }
@@ -20,6 +20,8 @@
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/json11.h"
 
+#include <fstream>
+#include <iostream>
 #include <map>
 #include <ostream>
 #include <queue>
@@ -35,7 +37,8 @@ protected:
     WriteStreamJSON(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : WriteStream(rwOperation, symbolTable, recordTable),
-              useObjects(getOr(rwOperation, "format", "list") == "object") {
+              useObjects(getOr(rwOperation, "format", "list") == "object"),
+              ndjson(getOr(rwOperation, "ndjson", "false") == "true") {
         if (useObjects) {
             std::string err;
             params = Json::parse(rwOperation.at("params"), err);
@@ -46,8 +49,19 @@ protected:
     };
 
     const bool useObjects;
+    /** Write one tuple per line instead of a single array */
+    const bool ndjson;
     Json params;
 
+    /** Writes the separator preceding a tuple; isFirst is cleared */
+    void writeSeparator(std::ostream& destination, bool& isFirst) const {
+        if (!isFirst) {
+            destination << (ndjson ? "\n" : ",\n");
+        } else {
+            isFirst = false;
+        }
+    }
+
     void writeNextTupleJSON(std::ostream& destination, const RamDomain* tuple) {
         std::vector<Json> result;
 
@@ -195,17 +209,30 @@ public:
     WriteFileJSON(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : WriteStreamJSON(rwOperation, symbolTable, recordTable), isFirst(true),
-              file(getFileName(rwOperation), std::ios::out | std::ios::binary) {
-        file << "[";
+              buffer(mk<char[]>(bufferSize)) {
+        // the buffer has to be installed before the file is opened
+        file.rdbuf()->pubsetbuf(buffer.get(), bufferSize);
+        file.open(getFileName(rwOperation), std::ios::out | std::ios::binary);
+        if (!ndjson) {
+            file << "[";
+        }
     }
 
     ~WriteFileJSON() override {
-        file << "]\n";
+        if (!ndjson) {
+            file << "]";
+        }
+        if (!ndjson || !isFirst) {
+            file << "\n";
+        }
         file.close();
     }
 
 protected:
+    static constexpr std::size_t bufferSize = 1 << 20;
+
     bool isFirst;
+    Own<char[]> buffer;
     std::ofstream file;
 
     void writeNullary() override {
@@ -213,11 +240,7 @@ protected:
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        if (!isFirst) {
-            file << ",\n";
-        } else {
-            isFirst = false;
-        }
+        writeSeparator(file, isFirst);
         writeNextTupleJSON(file, tuple);
     }
 
@@ -242,11 +265,18 @@ public:
     WriteCoutJSON(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : WriteStreamJSON(rwOperation, symbolTable, recordTable), isFirst(true) {
-        std::cout << "[";
+        if (!ndjson) {
+            std::cout << "[";
+        }
     }
 
     ~WriteCoutJSON() override {
-        std::cout << "]\n";
+        if (!ndjson) {
+            std::cout << "]";
+        }
+        if (!ndjson || !isFirst) {
+            std::cout << "\n";
+        }
     };
 
 protected:
@@ -257,11 +287,7 @@ protected:
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        if (!isFirst) {
-            std::cout << ",\n";
-        } else {
-            isFirst = false;
-        }
+        writeSeparator(std::cout, isFirst);
         writeNextTupleJSON(std::cout, tuple);
     }
 };
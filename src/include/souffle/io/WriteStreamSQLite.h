@@ -17,7 +17,9 @@
 #include "souffle/RamTypes.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/io/WriteStream.h"
+#include "souffle/utility/ContainerUtil.h"
 #include <cassert>
+#include <cctype>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -33,22 +35,36 @@ namespace souffle {
 
 class RecordTable;
 
+/**
+ * Writes a relation into an SQLite database.
+ *
+ * The tuples are inserted by explicit transactions, which are committed
+ * every `batchsize` tuples (default 0, i.e., a single transaction). The
+ * pragmas `journal_mode` (default MEMORY) and `synchronous` (default OFF)
+ * of the connection can be set by the IO directive. The ids of the symbols
+ * already stored in the database are loaded once, such that each symbol is
+ * resolved without a round-trip to the database; the unique index on the
+ * symbols of a new database is only created after all tuples are written.
+ * The last transaction is committed by finish(), a relation whose writing
+ * fails is rolled back.
+ */
 class WriteStreamSQLite : public WriteStream {
 public:
     WriteStreamSQLite(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : WriteStream(rwOperation, symbolTable, recordTable), dbFilename(getFileName(rwOperation)),
-              relationName(rwOperation.at("name")) {
-        openDB();
+              relationName(rwOperation.at("name")),
+              batchSize(std::stoull(getOr(rwOperation, "batchsize", "0"))) {
+        openDB(getPragma(rwOperation, "journal_mode", "MEMORY"), getPragma(rwOperation, "synchronous", "OFF"));
         createTables();
         prepareStatements();
-        //        executeSQL("BEGIN TRANSACTION", db);
+        executeSQL("BEGIN TRANSACTION", db);
     }
 
     ~WriteStreamSQLite() override {
+        // a transaction that was not finished is rolled back on closing
         sqlite3_finalize(insertStatement);
         sqlite3_finalize(symbolInsertStatement);
-        sqlite3_finalize(symbolSelectStatement);
         sqlite3_close(db);
     }
 
@@ -77,6 +93,21 @@ protected:
         }
         sqlite3_clear_bindings(insertStatement);
         sqlite3_reset(insertStatement);
+
+        if (batchSize > 0 && ++pendingTuples == batchSize) {
+            executeSQL("COMMIT", db);
+            executeSQL("BEGIN TRANSACTION", db);
+            pendingTuples = 0;
+        }
+    }
+
+    void finish() override {
+        executeSQL("COMMIT", db);
+        if (createSymbolIndex) {
+            executeSQL("CREATE UNIQUE INDEX IF NOT EXISTS '" + symbolTableName + "_symbol' ON '" +
+                               symbolTableName + "'(symbol);",
+                    db);
+        }
     }
 
 private:
@@ -102,56 +133,84 @@ private:
         throw std::invalid_argument(error.str());
     }
 
-    uint64_t getSymbolTableIDFromDB(int index) {
-        if (sqlite3_bind_text(symbolSelectStatement, 1, symbolTable.unsafeDecode(index).c_str(), -1,
-                    SQLITE_TRANSIENT) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_bind_text: ");
+    /**
+     * Loads the ids of the symbols stored in the database by earlier writes.
+     */
+    void loadSymbols() {
+        sqlite3_stmt* selectStatement = nullptr;
+        std::string selectSQL = "SELECT id, symbol FROM '" + symbolTableName + "';";
+        if (sqlite3_prepare_v2(db, selectSQL.c_str(), -1, &selectStatement, nullptr) != SQLITE_OK) {
+            throwError("SQLite error in sqlite3_prepare_v2: ");
+        }
+        int rc;
+        while ((rc = sqlite3_step(selectStatement)) == SQLITE_ROW) {
+            const auto* symbol = reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 1));
+            dbSymbols.emplace(symbol == nullptr ? "" : symbol, sqlite3_column_int64(selectStatement, 0));
         }
-        if (sqlite3_step(symbolSelectStatement) != SQLITE_ROW) {
+        sqlite3_finalize(selectStatement);
+        if (rc != SQLITE_DONE) {
             throwError("SQLite error in sqlite3_step: ");
         }
-        uint64_t rowid = sqlite3_column_int64(symbolSelectStatement, 0);
-        sqlite3_clear_bindings(symbolSelectStatement);
-        sqlite3_reset(symbolSelectStatement);
-        return rowid;
+        symbolsLoaded = true;
     }
+
     uint64_t getSymbolTableID(int index) {
-        if (dbSymbolTable.count(index) != 0) {
-            return dbSymbolTable[index];
+        auto cached = dbSymbolTable.find(index);
+        if (cached != dbSymbolTable.end()) {
+            return cached->second;
         }
-
-        if (sqlite3_bind_text(symbolInsertStatement, 1, symbolTable.unsafeDecode(index).c_str(), -1,
-                    SQLITE_TRANSIENT) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_bind_text: ");
+        if (!symbolsLoaded) {
+            loadSymbols();
         }
-        // Either the insert succeeds and we have a new row id or it already exists and a select is needed.
+
+        // symbols not yet stored are inserted by the current transaction
+        const std::string& symbol = symbolTable.unsafeDecode(index);
         uint64_t rowid;
-        if (sqlite3_step(symbolInsertStatement) != SQLITE_DONE) {
-            // The symbol already exists so select it.
-            rowid = getSymbolTableIDFromDB(index);
+        auto stored = dbSymbols.find(symbol);
+        if (stored != dbSymbols.end()) {
+            rowid = stored->second;
         } else {
+            if (sqlite3_bind_text(symbolInsertStatement, 1, symbol.c_str(), -1, SQLITE_STATIC) != SQLITE_OK) {
+                throwError("SQLite error in sqlite3_bind_text: ");
+            }
+            if (sqlite3_step(symbolInsertStatement) != SQLITE_DONE) {
+                throwError("SQLite error in sqlite3_step: ");
+            }
             rowid = sqlite3_last_insert_rowid(db);
+            sqlite3_clear_bindings(symbolInsertStatement);
+            sqlite3_reset(symbolInsertStatement);
         }
-        sqlite3_clear_bindings(symbolInsertStatement);
-        sqlite3_reset(symbolInsertStatement);
 
         dbSymbolTable[index] = rowid;
         return rowid;
     }
 
-    void openDB() {
+    /**
+     * Returns the value of the given pragma, which is restricted to a keyword.
+     */
+    static std::string getPragma(const std::map<std::string, std::string>& rwOperation,
+            const std::string& pragma, const std::string& defaultValue) {
+        std::string value = getOr(rwOperation, pragma, defaultValue);
+        for (char c : value) {
+            if (!std::isalnum(static_cast<unsigned char>(c))) {
+                throw std::invalid_argument("Invalid value for SQLite pragma " + pragma + ": " + value);
+            }
+        }
+        return value;
+    }
+
+    void openDB(const std::string& journalMode, const std::string& synchronous) {
         if (sqlite3_open(dbFilename.c_str(), &db) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_open");
         }
         sqlite3_extended_result_codes(db, 1);
-        executeSQL("PRAGMA synchronous = OFF", db);
-        executeSQL("PRAGMA journal_mode = MEMORY", db);
+        executeSQL("PRAGMA synchronous = " + synchronous, db);
+        executeSQL("PRAGMA journal_mode = " + journalMode, db);
     }
 
     void prepareStatements() {
         prepareInsertStatement();
         prepareSymbolInsertStatement();
-        prepareSymbolSelectStatement();
     }
     void prepareSymbolInsertStatement() {
         std::stringstream insertSQL;
@@ -163,16 +222,6 @@ private:
         }
     }
 
-    void prepareSymbolSelectStatement() {
-        std::stringstream selectSQL;
-        selectSQL << "SELECT id FROM " << symbolTableName;
-        selectSQL << " WHERE symbol = @V0;";
-        const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, selectSQL.str().c_str(), -1, &symbolSelectStatement, &tail) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_prepare_v2: ");
-        }
-    }
-
     void prepareInsertStatement() {
         std::stringstream insertSQL;
         insertSQL << "INSERT INTO '_" << relationName << "' VALUES ";
@@ -244,10 +293,29 @@ private:
         executeSQL(createViewText.str(), db);
     }
     void createSymbolTable() {
+        if (tableExists(symbolTableName)) {
+            return;
+        }
+        // the unique index on the symbols is created after writing
         std::stringstream createTableText;
-        createTableText << "CREATE TABLE IF NOT EXISTS '" << symbolTableName << "' ";
-        createTableText << "(id INTEGER PRIMARY KEY, symbol TEXT UNIQUE);";
+        createTableText << "CREATE TABLE '" << symbolTableName << "' ";
+        createTableText << "(id INTEGER PRIMARY KEY, symbol TEXT);";
         executeSQL(createTableText.str(), db);
+        createSymbolIndex = true;
+        // there are no symbols to load
+        symbolsLoaded = true;
+    }
+
+    bool tableExists(const std::string& name) {
+        sqlite3_stmt* tableStatement = nullptr;
+        std::string selectSQL = "SELECT count(*) FROM sqlite_master WHERE type = 'table' AND name = ?;";
+        if (sqlite3_prepare_v2(db, selectSQL.c_str(), -1, &tableStatement, nullptr) != SQLITE_OK) {
+            throwError("SQLite error in sqlite3_prepare_v2: ");
+        }
+        sqlite3_bind_text(tableStatement, 1, name.c_str(), -1, SQLITE_STATIC);
+        bool exists = sqlite3_step(tableStatement) == SQLITE_ROW && sqlite3_column_int(tableStatement, 0) > 0;
+        sqlite3_finalize(tableStatement);
+        return exists;
     }
 
     /**
@@ -273,10 +341,19 @@ private:
     const std::string relationName;
     const std::string symbolTableName = "__SymbolTable";
 
+    /** Number of tuples per transaction, 0 for a single transaction */
+    const std::size_t batchSize;
+    std::size_t pendingTuples = 0;
+
+    /** Ids of the symbols stored in the database by their index in the symbol table */
     std::unordered_map<uint64_t, uint64_t> dbSymbolTable;
+    /** Ids of the symbols stored in the database before this write */
+    std::unordered_map<std::string, uint64_t> dbSymbols;
+    bool symbolsLoaded = false;
+    bool createSymbolIndex = false;
+
     sqlite3_stmt* insertStatement = nullptr;
     sqlite3_stmt* symbolInsertStatement = nullptr;
-    sqlite3_stmt* symbolSelectStatement = nullptr;
     sqlite3* db = nullptr;
 };
 
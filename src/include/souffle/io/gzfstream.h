@@ -9,35 +9,52 @@
 /************************************************************************
  *
  * @file gzfstream.h
- * A simple zlib wrapper to provide gzip file streams.
+ * A zlib wrapper to provide gzip file streams.
  *
  ***********************************************************************/
 
 #pragma once
 
+#include "souffle/utility/ParallelUtil.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include <zlib.h>
 
+#ifdef IS_PARALLEL
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
 namespace souffle {
 
 namespace gzfstream {
 
 namespace internal {
 
+/**
+ * A stream buffer reading and writing gzip files.
+ *
+ * Input is decompressed ahead of its consumption on a separate thread. Output
+ * is split into blocks which are deflated independently on the task pool,
+ * each primed with the tail of its predecessor as dictionary, and concatenated
+ * into a single gzip member.
+ */
 class gzfstreambuf : public std::streambuf {
 public:
-    gzfstreambuf() {
-        setp(buffer, buffer + (bufferSize - 1));
-        setg(buffer + reserveSize, buffer + reserveSize, buffer + reserveSize);
-    }
+    gzfstreambuf() = default;
 
     gzfstreambuf(const gzfstreambuf&) = delete;
 
-    gzfstreambuf(gzfstreambuf&& old) = default;
-
     gzfstreambuf* open(const std::string& filename, std::ios_base::openmode mode) {
         if (is_open()) {
             return nullptr;
@@ -47,11 +64,25 @@ public:
         }
 
         this->mode = mode;
-        std::string gzmode((mode & std::ios::in) != 0 ? "rb" : "wb");
-        fileHandle = gzopen(filename.c_str(), gzmode.c_str());
-
-        if (fileHandle == nullptr) {
-            return nullptr;
+        if ((mode & std::ios::in) != 0) {
+            fileHandle = gzopen(filename.c_str(), "rb");
+            if (fileHandle == nullptr) {
+                return nullptr;
+            }
+            gzbuffer(fileHandle, chunkSize);
+            current = std::make_unique<Chunk>();
+            setg(current->data + reserveSize, current->data + reserveSize, current->data + reserveSize);
+            startReadAhead();
+        } else {
+            outputFile = std::fopen(filename.c_str(), "wb");
+            if (outputFile == nullptr) {
+                return nullptr;
+            }
+            // gzip header: magic, deflate, no flags, no time, default level, unix
+            const unsigned char header[] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+            failed = std::fwrite(header, 1, sizeof(header), outputFile) != sizeof(header);
+            block.resize(blockSize);
+            setp(block.data(), block.data() + blockSize);
         }
         isOpen = true;
 
@@ -59,14 +90,23 @@ public:
     }
 
     gzfstreambuf* close() {
-        if (is_open()) {
-            sync();
-            isOpen = false;
-            if (gzclose(fileHandle) == Z_OK) {
-                return this;
-            }
+        if (!is_open()) {
+            return nullptr;
         }
-        return nullptr;
+        isOpen = false;
+        if ((mode & std::ios::in) != 0) {
+            stopReadAhead();
+            return gzclose(fileHandle) == Z_OK ? this : nullptr;
+        }
+        submitBlock(true);
+        unsigned char trailer[8];
+        for (int i = 0; i < 4; ++i) {
+            trailer[i] = static_cast<unsigned char>(crc >> (8 * i));
+            trailer[4 + i] = static_cast<unsigned char>(totalSize >> (8 * i));
+        }
+        failed |= std::fwrite(trailer, 1, sizeof(trailer), outputFile) != sizeof(trailer);
+        failed |= std::fclose(outputFile) != 0;
+        return failed ? nullptr : this;
     }
 
     bool is_open() const {
@@ -83,21 +123,19 @@ public:
 
 protected:
     int_type overflow(int c = EOF) override {
-        if (((mode & std::ios::out) == 0) || !isOpen) {
+        if (((mode & std::ios::out) == 0) || !isOpen || failed) {
             return EOF;
         }
 
+        if (pptr() == epptr()) {
+            submitBlock(false);
+        }
         if (c != EOF) {
             *pptr() = c;
             pbump(1);
         }
-        int toWrite = pptr() - pbase();
-        if (gzwrite(fileHandle, pbase(), toWrite) != toWrite) {
-            return EOF;
-        }
-        pbump(-toWrite);
 
-        return c;
+        return failed ? EOF : c;
     }
 
     int_type underflow() override {
@@ -112,35 +150,209 @@ protected:
         if (charsPutBack > reserveSize) {
             charsPutBack = reserveSize;
         }
-        memcpy(buffer + reserveSize - charsPutBack, gptr() - charsPutBack, charsPutBack);
-
-        int charsRead = gzread(fileHandle, buffer + reserveSize, bufferSize - reserveSize);
-        if (charsRead <= 0) {
+        std::unique_ptr<Chunk> next = nextChunk();
+        if (next == nullptr) {
             return EOF;
         }
+        memcpy(next->data + reserveSize - charsPutBack, gptr() - charsPutBack, charsPutBack);
+        recycleChunk(std::exchange(current, std::move(next)));
 
-        setg(buffer + reserveSize - charsPutBack, buffer + reserveSize, buffer + reserveSize + charsRead);
+        char* data = current->data;
+        setg(data + reserveSize - charsPutBack, data + reserveSize, data + reserveSize + current->size);
 
         return traits_type::to_int_type(*gptr());
     }
 
     int sync() override {
-        if ((pptr() != nullptr) && pptr() > pbase()) {
-            int toWrite = pptr() - pbase();
-            if (gzwrite(fileHandle, pbase(), toWrite) != toWrite) {
-                return -1;
-            }
-            pbump(-toWrite);
-        }
-        return 0;
+        // output is only emitted in whole blocks, the last one when closing
+        return failed ? -1 : 0;
     }
 
 private:
-    static constexpr unsigned int bufferSize = 65536;
+    static constexpr unsigned int chunkSize = 1 << 18;
     static constexpr unsigned int reserveSize = 16;
+    static constexpr unsigned int blockSize = 1 << 17;
+    static constexpr unsigned int dictionarySize = 1 << 15;
+
+    /** A buffer of decompressed input, preceded by the put-back area */
+    struct Chunk {
+        char data[reserveSize + chunkSize];
+        int size = 0;
+    };
+
+    /** A block of output and its compressed form */
+    struct Block {
+        std::string input;
+        std::string dictionary;
+        std::string output;
+        uLong crc = 0;
+        bool last = false;
+        bool ok = false;
+    };
+
+    /** Reads the next chunk of decompressed input; returns null at the end */
+    std::unique_ptr<Chunk> readChunk(std::unique_ptr<Chunk> chunk) {
+        if (chunk == nullptr) {
+            chunk = std::make_unique<Chunk>();
+        }
+        chunk->size = gzread(fileHandle, chunk->data + reserveSize, chunkSize);
+        return chunk->size > 0 ? std::move(chunk) : nullptr;
+    }
+
+#ifdef IS_PARALLEL
+    void startReadAhead() {
+        readAhead = std::thread([this]() {
+            std::unique_lock<std::mutex> guard(lock);
+            while (true) {
+                changed.wait(guard, [&]() { return stopping || ready.size() < readAheadDepth; });
+                if (stopping) {
+                    return;
+                }
+                std::unique_ptr<Chunk> chunk;
+                if (!spare.empty()) {
+                    chunk = std::move(spare.back());
+                    spare.pop_back();
+                }
+                guard.unlock();
+                chunk = readChunk(std::move(chunk));
+                guard.lock();
+                if (chunk == nullptr) {
+                    exhausted = true;
+                    changed.notify_all();
+                    return;
+                }
+                ready.push_back(std::move(chunk));
+                changed.notify_all();
+            }
+        });
+    }
+
+    void stopReadAhead() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        if (readAhead.joinable()) {
+            readAhead.join();
+        }
+    }
+
+    std::unique_ptr<Chunk> nextChunk() {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&]() { return exhausted || !ready.empty(); });
+        if (ready.empty()) {
+            return nullptr;
+        }
+        std::unique_ptr<Chunk> chunk = std::move(ready.front());
+        ready.pop_front();
+        guard.unlock();
+        changed.notify_all();
+        return chunk;
+    }
+
+    void recycleChunk(std::unique_ptr<Chunk> chunk) {
+        std::lock_guard<std::mutex> guard(lock);
+        spare.push_back(std::move(chunk));
+    }
+#else
+    void startReadAhead() {}
+
+    void stopReadAhead() {}
+
+    std::unique_ptr<Chunk> nextChunk() {
+        return readChunk(std::move(spare));
+    }
+
+    void recycleChunk(std::unique_ptr<Chunk> chunk) {
+        spare = std::move(chunk);
+    }
+#endif
+
+    /** Compresses a block into a raw deflate stream, finished only for the last block */
+    static void deflateBlock(Block& block) {
+        z_stream stream = {};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) !=
+                Z_OK) {
+            return;
+        }
+        if (!block.dictionary.empty()) {
+            deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(block.dictionary.data()),
+                    static_cast<uInt>(block.dictionary.size()));
+        }
+        // the sync flush marker is not covered by the bound
+        block.output.resize(deflateBound(&stream, static_cast<uLong>(block.input.size())) + 16);
+        stream.next_in = reinterpret_cast<Bytef*>(block.input.data());
+        stream.avail_in = static_cast<uInt>(block.input.size());
+        stream.next_out = reinterpret_cast<Bytef*>(block.output.data());
+        stream.avail_out = static_cast<uInt>(block.output.size());
+        const int status = deflate(&stream, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+        block.ok = (status == (block.last ? Z_STREAM_END : Z_OK)) && stream.avail_in == 0;
+        block.output.resize(block.output.size() - stream.avail_out);
+        deflateEnd(&stream);
+        block.crc = crc32(0L, reinterpret_cast<const Bytef*>(block.input.data()),
+                static_cast<uInt>(block.input.size()));
+    }
+
+    /**
+     * Moves the content of the put area into a new block. Blocks are
+     * compressed in parallel once enough of them are pending and written in
+     * order.
+     */
+    void submitBlock(bool last) {
+        Block next;
+        next.input.assign(pbase(), pptr());
+        next.dictionary = std::move(dictionary);
+        next.last = last;
+        const std::size_t tail = std::min<std::size_t>(next.input.size(), dictionarySize);
+        dictionary.assign(next.input, next.input.size() - tail, tail);
+        pending.push_back(std::move(next));
+        setp(block.data(), block.data() + blockSize);
+
+        if (!last && pending.size() < 2 * TaskPool::instance().getNumThreads()) {
+            return;
+        }
+
+        {
+            TaskGroup tasks;
+            for (auto& cur : pending) {
+                tasks.spawn([&cur]() { deflateBlock(cur); });
+            }
+            tasks.wait();
+        }
+        for (auto& cur : pending) {
+            failed |= !cur.ok;
+            crc = crc32_combine(crc, cur.crc, static_cast<z_off_t>(cur.input.size()));
+            totalSize += cur.input.size();
+            failed |= std::fwrite(cur.output.data(), 1, cur.output.size(), outputFile) != cur.output.size();
+        }
+        pending.clear();
+    }
 
-    char buffer[bufferSize] = {};
     gzFile fileHandle = {};
+    std::unique_ptr<Chunk> current;
+#ifdef IS_PARALLEL
+    static constexpr std::size_t readAheadDepth = 3;
+
+    std::thread readAhead;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::unique_ptr<Chunk>> ready;
+    std::vector<std::unique_ptr<Chunk>> spare;
+    bool stopping = false;
+    bool exhausted = false;
+#else
+    std::unique_ptr<Chunk> spare;
+#endif
+
+    std::FILE* outputFile = nullptr;
+    std::vector<char> block;
+    std::string dictionary;
+    std::vector<Block> pending;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    std::uint64_t totalSize = 0;
+    bool failed = false;
+
     bool isOpen = false;
     std::ios_base::openmode mode = std::ios_base::in;
 };
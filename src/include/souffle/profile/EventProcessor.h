@@ -535,6 +535,40 @@ public:
 
 } relationReadsProcessor;
 
+/**
+ * Memory Processor
+ */
+const class RelationMemoryProcessor : public EventProcessor {
+public:
+    RelationMemoryProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@memory", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& index = signature[2];
+        std::size_t bytes = va_arg(args, std::size_t);
+        int stratum = va_arg(args, int);
+        db.addSizeEntry({"program", "relation", relation, "memory", std::to_string(stratum), index}, bytes);
+    }
+} relationMemoryProcessor;
+
+/**
+ * Last Use Processor
+ */
+const class RelationLastUseProcessor : public EventProcessor {
+public:
+    RelationLastUseProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@last-use", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        std::size_t stratum = va_arg(args, std::size_t);
+        db.addSizeEntry({"program", "relation", relation, "last-use"}, stratum);
+    }
+} relationLastUseProcessor;
+
 /**
  * Config entry processor
  */
@@ -252,11 +252,21 @@ public:
             auto* postMaxRSS = as<SizeEntry>(directory.readEntry("post"));
             base.setPreMaxRSS(preMaxRSS->getSize());
             base.setPostMaxRSS(postMaxRSS->getSize());
+        } else if (directory.getKey() == "memory") {
+            for (const auto& stratum : directory.getKeys()) {
+                auto* indexes = as<DirectoryEntry>(directory.readEntry(stratum));
+                for (const auto& index : indexes->getKeys()) {
+                    auto* bytes = as<SizeEntry>(indexes->readEntry(index));
+                    base.setMemory(std::stoul(stratum), index, bytes->getSize());
+                }
+            }
         }
     }
     void visit(SizeEntry& size) override {
         if (size.getKey() == "reads") {
             base.addReads(size.getSize());
+        } else if (size.getKey() == "last-use") {
+            base.setLastUse(size.getSize());
         } else {
             DSNVisitor::visit(size);
         }
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -41,6 +42,11 @@ private:
     int ruleId = 0;
     int recursiveId = 0;
     std::size_t tuplesRead = 0;
+    // the last stratum using the relation, -1 if unknown
+    long lastUse = -1;
+
+    // the memory of each index at the end of each stratum
+    std::map<std::size_t, std::map<std::string, std::size_t>> memory;
 
     std::vector<std::shared_ptr<Iteration>> iterations;
 
@@ -248,6 +254,39 @@ public:
     void addReads(std::size_t tuplesRead) {
         this->tuplesRead += tuplesRead;
     }
+
+    long getLastUse() const {
+        return lastUse;
+    }
+
+    void setLastUse(long stratum) {
+        lastUse = stratum;
+    }
+
+    /**
+     * Return the memory of each index at the end of each stratum.
+     */
+    const std::map<std::size_t, std::map<std::string, std::size_t>>& getMemory() const {
+        return memory;
+    }
+
+    void setMemory(std::size_t stratum, const std::string& index, std::size_t bytes) {
+        memory[stratum][index] = bytes;
+    }
+
+    /**
+     * Return the memory of all indexes at the end of the given stratum.
+     */
+    std::size_t getMemory(std::size_t stratum) const {
+        std::size_t res = 0;
+        auto it = memory.find(stratum);
+        if (it != memory.end()) {
+            for (const auto& index : it->second) {
+                res += index.second;
+            }
+        }
+        return res;
+    }
 };
 
 }  // namespace profile
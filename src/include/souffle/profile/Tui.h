@@ -184,6 +184,7 @@ public:
             }
         } else if (c[0] == "memory") {
             memoryUsage();
+            memoryPeak();
         } else if (c[0] == "usage") {
             if (c.size() > 1) {
                 if (c[1][0] == 'R') {
@@ -701,7 +702,8 @@ public:
         std::printf("  %-30s%-5s %s\n", "configuration", "-", "display configuration settings for this run.");
         std::printf("  %-30s%-5s %s\n", "usage [relation id|rule id]", "-",
                 "display CPU usage graphs for a relation or rule.");
-        std::printf("  %-30s%-5s %s\n", "memory", "-", "display memory usage.");
+        std::printf("  %-30s%-5s %s\n", "memory", "-",
+                "display memory usage and the relations at the peak of their memory.");
         std::printf("  %-30s%-5s %s\n", "help", "-", "print this.");
 
         std::cout << "\nInteractive mode only commands:" << std::endl;
@@ -979,6 +981,78 @@ public:
         }
         std::cout << std::endl;
     }
+    /**
+     * Display the memory of the relations and their indexes after the stratum in which it peaked,
+     * and the relations still occupying memory after the last stratum using them.
+     */
+    void memoryPeak() {
+        const std::shared_ptr<ProgramRun>& run = out.getProgramRun();
+
+        // the memory of all relations at the end of each stratum
+        std::map<std::size_t, std::size_t> totals;
+        for (auto& cur : run->getRelationMap()) {
+            for (auto& stratum : cur.second->getMemory()) {
+                totals[stratum.first] += cur.second->getMemory(stratum.first);
+            }
+        }
+        if (totals.empty()) {
+            std::cout << "No memory of relations recorded.\n";
+            return;
+        }
+        auto peak = std::max_element(totals.begin(), totals.end(),
+                [](const auto& a, const auto& b) { return a.second < b.second; });
+        std::cout << "\nPeak memory of relations: " << Tools::formatMemory(peak->second / 1024)
+                  << " after stratum " << peak->first << "\n\n";
+
+        std::vector<std::pair<std::size_t, const Relation*>> contributors;
+        for (auto& cur : run->getRelationMap()) {
+            std::size_t bytes = cur.second->getMemory(peak->first);
+            if (bytes > 0) {
+                contributors.emplace_back(bytes, cur.second.get());
+            }
+        }
+        std::sort(contributors.rbegin(), contributors.rend());
+        if (contributors.size() > resultLimit) {
+            contributors.resize(resultLimit);
+        }
+        std::printf("%8s %7s  %s\n", "Memory", "Share", "Relation/Index");
+        for (auto& cur : contributors) {
+            std::printf("%8s %6.1f%%  %s\n", Tools::formatMemory(cur.first / 1024).c_str(),
+                    100.0 * cur.first / peak->second, cur.second->getName().c_str());
+            for (auto& index : cur.second->getMemory().at(peak->first)) {
+                std::printf("%8s %7s    %s\n", Tools::formatMemory(index.second / 1024).c_str(), "",
+                        index.first.c_str());
+            }
+        }
+
+        // relations are expired after their last use, unless they are output
+        std::cout << "\nRelations occupying memory after their last use:\n";
+        bool found = false;
+        for (auto& cur : run->getRelationMap()) {
+            const Relation& rel = *cur.second;
+            if (rel.getLastUse() < 0) {
+                continue;
+            }
+            std::size_t maxBytes = 0;
+            std::size_t lastLive = 0;
+            for (auto& stratum : rel.getMemory()) {
+                if (static_cast<long>(stratum.first) > rel.getLastUse()) {
+                    maxBytes = std::max(maxBytes, rel.getMemory(stratum.first));
+                    lastLive = stratum.first;
+                }
+            }
+            if (maxBytes > 0) {
+                std::printf("%8s  %s (last used in stratum %ld, live until stratum %zu)\n",
+                        Tools::formatMemory(maxBytes / 1024).c_str(), rel.getName().c_str(),
+                        rel.getLastUse(), lastLive);
+                found = true;
+            }
+        }
+        if (!found) {
+            std::cout << "none\n";
+        }
+    }
+
     void setupTabCompletion() {
         linereader.clearTabCompletion();
 
@@ -17,8 +17,12 @@
 #pragma once
 
 #include "souffle/SouffleInterface.h"
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 /**
  * Abstract base class for generated Datalog programs
@@ -77,6 +81,81 @@ public:
     void dumpOutputs() {
         program->dumpOutputs();
     }
+
+    /**
+     * Returns the number of tuples of a relation
+     */
+    std::size_t getSize(const std::string& relationName) {
+        return getRelation(relationName)->size();
+    }
+
+    /**
+     * Calls the corresponding method souffle::Relation::insertColumns in SouffleInterface.h
+     *
+     * The columns are given by the addresses of contiguous buffers of n RamDomain values each,
+     * e.g., the data pointers of NumPy arrays, which are read without copying them.
+     */
+    void insertColumns(
+            const std::string& relationName, const std::vector<std::uintptr_t>& columns, std::size_t n) {
+        auto* relation = getRelation(relationName, columns.size());
+        std::vector<const souffle::RamDomain*> buffers;
+        for (auto address : columns) {
+            buffers.push_back(reinterpret_cast<const souffle::RamDomain*>(address));
+        }
+        relation->insertColumns(buffers.data(), n);
+    }
+
+    /**
+     * Calls the corresponding method souffle::Relation::exportColumns in SouffleInterface.h
+     *
+     * The columns are given by the addresses of buffers with space for n RamDomain values each.
+     * Returns the number of tuples written.
+     */
+    std::size_t exportColumns(
+            const std::string& relationName, const std::vector<std::uintptr_t>& columns, std::size_t n) {
+        auto* relation = getRelation(relationName, columns.size());
+        std::vector<souffle::RamDomain*> buffers;
+        for (auto address : columns) {
+            buffers.push_back(reinterpret_cast<souffle::RamDomain*>(address));
+        }
+        return relation->exportColumns(buffers.data(), n);
+    }
+
+    /**
+     * Encodes symbols to their indexes in the symbol table, for columns of symbol attributes
+     */
+    std::vector<souffle::RamDomain> encodeSymbols(const std::vector<std::string>& symbols) {
+        std::vector<souffle::RamDomain> indexes(symbols.size());
+        program->getSymbolTable().encode(symbols.data(), symbols.size(), indexes.data());
+        return indexes;
+    }
+
+    /**
+     * Decodes indexes of the symbol table to their symbols
+     */
+    std::vector<std::string> decodeSymbols(const std::vector<souffle::RamDomain>& indexes) {
+        std::vector<std::string> symbols(indexes.size());
+        program->getSymbolTable().decode(indexes.data(), indexes.size(), symbols.data());
+        return symbols;
+    }
+
+private:
+    souffle::Relation* getRelation(const std::string& relationName) {
+        auto* relation = program->getRelation(relationName);
+        if (relation == nullptr) {
+            throw std::invalid_argument("unknown relation " + relationName);
+        }
+        return relation;
+    }
+
+    souffle::Relation* getRelation(const std::string& relationName, std::size_t columns) {
+        auto* relation = getRelation(relationName);
+        if (columns != relation->getArity()) {
+            throw std::invalid_argument("relation " + relationName + " requires " +
+                                        std::to_string(relation->getArity()) + " columns");
+        }
+        return relation;
+    }
 };
 
 /**
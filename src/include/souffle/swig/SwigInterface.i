@@ -19,8 +19,31 @@
 %include "std_string.i" 
 %include "std_map.i" 
 %include<std_vector.i>
+%include "stdint.i"
+%include "exception.i"
+
+namespace souffle {
+#if RAM_DOMAIN_SIZE == 64
+typedef int64_t RamDomain;
+#else
+typedef int32_t RamDomain;
+#endif
+}
+
 namespace std {
     %template(map_string_string) map<string, string>;
+    %template(vector_string) vector<string>;
+    %template(vector_ram_domain) vector<souffle::RamDomain>;
+    %template(vector_address) vector<uintptr_t>;
+}
+
+// invalid arguments of the bulk interface are raised as exceptions of the target language
+%exception {
+    try {
+        $action
+    } catch (const std::exception& e) {
+        SWIG_exception(SWIG_ValueError, e.what());
+    }
 }
 
 %{
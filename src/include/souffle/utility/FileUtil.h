@@ -17,16 +17,20 @@
 #pragma once
 
 #include <climits>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <sys/stat.h>
 
 #ifndef _WIN32
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #else
 #include <fcntl.h>
 #include <io.h>
@@ -299,4 +303,71 @@ public:
     }
 };
 
+/**
+ * A read-only view of the content of a file. The file is memory-mapped where
+ * this is supported and read into memory otherwise.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& fileName) {
+#ifndef _WIN32
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* addr = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                madvise(addr, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+                mapped = static_cast<const char*>(addr);
+                length = static_cast<std::size_t>(info.st_size);
+                ::close(fd);
+                opened = true;
+                return;
+            }
+        }
+        ::close(fd);
+#endif
+        std::ifstream in(fileName, std::ios::in | std::ios::binary);
+        if (in.is_open()) {
+            content.assign(std::istreambuf_iterator<char>(in), {});
+            opened = true;
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped != nullptr) {
+            munmap(const_cast<char*>(mapped), length);
+        }
+#endif
+    }
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    const char* begin() const {
+        return mapped != nullptr ? mapped : content.data();
+    }
+
+    const char* end() const {
+        return begin() + size();
+    }
+
+    std::size_t size() const {
+        return mapped != nullptr ? length : content.size();
+    }
+
+private:
+    const char* mapped = nullptr;
+    std::size_t length = 0;
+    std::string content;
+    bool opened = false;
+};
+
 }  // namespace souffle
@@ -0,0 +1,147 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NumaUtil.h
+ *
+ * @brief Placement of threads and memory on NUMA machines
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace souffle {
+
+/**
+ * Parses a list of cores in the format of the Linux sysfs, e.g. "0-3,8,10-11".
+ */
+inline std::vector<unsigned> parseCpuList(const std::string& list) {
+    std::vector<unsigned> cores;
+    std::stringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        std::size_t dash = range.find('-');
+        try {
+            unsigned first = std::stoul(range.substr(0, dash));
+            unsigned last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+            for (unsigned core = first; core <= last; ++core) {
+                cores.push_back(core);
+            }
+        } catch (...) {
+            // skip malformed entries, e.g. the trailing newline
+        }
+    }
+    return cores;
+}
+
+/**
+ * Obtains the cores of each NUMA node of this machine. If the topology is
+ * unknown, a single node holding all cores is assumed.
+ */
+inline const std::vector<std::vector<unsigned>>& getNumaNodes() {
+    static const std::vector<std::vector<unsigned>> nodes = []() {
+        std::vector<std::vector<unsigned>> res;
+#ifdef __linux__
+        // nodes are numbered consecutively, see /sys/devices/system/node/possible
+        for (unsigned node = 0;; ++node) {
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!in) {
+                break;
+            }
+            std::string list;
+            std::getline(in, list);
+            res.push_back(parseCpuList(list));
+        }
+#endif
+        // memory-only nodes do not host any threads
+        res.erase(std::remove_if(res.begin(), res.end(), [](const auto& cores) { return cores.empty(); }),
+                res.end());
+        if (res.empty()) {
+            res.emplace_back();
+            for (unsigned core = 0; core < std::max(1u, std::thread::hardware_concurrency()); ++core) {
+                res.back().push_back(core);
+            }
+        }
+        return res;
+    }();
+    return nodes;
+}
+
+/**
+ * Obtains the core of the given thread when spreading threads over the NUMA
+ * nodes in turn, such that each node serves the same share of the threads.
+ */
+inline unsigned getNumaCore(std::size_t thread, const std::vector<std::vector<unsigned>>& nodes) {
+    const auto& cores = nodes[thread % nodes.size()];
+    return cores[(thread / nodes.size()) % cores.size()];
+}
+
+inline unsigned getNumaCore(std::size_t thread) {
+    return getNumaCore(thread, getNumaNodes());
+}
+
+/**
+ * Pins the current thread to the core of the given thread index, if supported.
+ */
+inline void pinToNumaCore(std::size_t thread) {
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(getNumaCore(thread), &cores);
+    pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+#else
+    (void)thread;
+#endif
+}
+
+/**
+ * Spreads the pages of the given page-aligned memory region across the NUMA
+ * nodes, rather than placing them on the node of the thread touching them first.
+ */
+inline void interleaveNumaNodes(void* addr, std::size_t size) {
+#if defined(__linux__) && defined(SYS_mbind)
+    // the constants of the mempolicy interface, avoiding a dependency on libnuma
+    constexpr int MPOL_INTERLEAVE_POLICY = 3;
+    constexpr unsigned MPOL_MF_MOVE_FLAG = 1u << 1;
+    constexpr unsigned long MAX_NODES = 8 * sizeof(unsigned long);
+    static unsigned long mask = []() {
+        unsigned long res = 0;
+        for (unsigned node = 0; node < MAX_NODES; ++node) {
+            if (std::ifstream("/sys/devices/system/node/node" + std::to_string(node) + "/meminfo")) {
+                res |= 1ul << node;
+            }
+        }
+        return res;
+    }();
+    if (mask != 0) {
+        // pages touched already, e.g. by a previous owner of the memory, are moved as well
+        syscall(SYS_mbind, addr, size, MPOL_INTERLEAVE_POLICY, &mask, MAX_NODES + 1, MPOL_MF_MOVE_FLAG);
+    }
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+}  // end of namespace souffle
@@ -11,7 +11,8 @@
  * @file ParallelUtil.h
  *
  * A set of utilities abstracting from the underlying parallel library.
- * Currently supported APIs: OpenMP and Cilk
+ * Currently supported APIs: OpenMP and Cilk, complemented by a work-stealing
+ * task pool executing parallel loops and nested tasks.
  *
  ***********************************************************************/
 
@@ -35,6 +36,10 @@
 #define PARALLEL_START _Pragma("omp parallel") {
 #define PARALLEL_END }
 
+// support for a parallel region of a team that is not nested in the work of the task pool, whose threads
+// are busy already; inside a task, the region is run by the current thread alone
+#define PARALLEL_TEAM_START _Pragma("omp parallel if(!::souffle::TaskPool::inTask())") {
+
 // support for parallel loops
 #define pfor _Pragma("omp for schedule(dynamic)") for
 
@@ -63,6 +68,7 @@
 // support for a parallel region => sequential execution
 #define PARALLEL_START {
 #define PARALLEL_END }
+#define PARALLEL_TEAM_START {
 
 // support for parallel loops => simple sequential loop
 #define pfor for
@@ -98,9 +104,34 @@
 #define MAX_THREADS (1)
 #endif
 
+// support for parallel loops over partitions utilizing the task pool
+#define PARALLEL_TASKS_START(PARTS, IT) \
+    ::souffle::TaskPool::instance().parallelFor((PARTS).begin(), (PARTS).end(), [&](auto IT) {
+#define PARALLEL_TASKS_END });
+
+// support for parallel sections utilizing the task pool
+#define TASKS_START { ::souffle::TaskGroup tasks;
+#define TASKS_END tasks.wait(); }
+#define TASK_START tasks.spawn([&]() {
+#define TASK_END });
+
 #ifdef IS_PARALLEL
 
+#include "souffle/utility/NumaUtil.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace souffle {
 
@@ -457,6 +488,375 @@ public:
     }
 };
 
+class TaskGroup;
+
+/**
+ * A persistent pool of worker threads executing tasks by work stealing.
+ *
+ * Each worker owns a task queue; tasks are pushed to and popped from the back
+ * of the queue of the spawning thread, while idle workers steal from the front
+ * of the queues of others. Threads waiting for the completion of a task group
+ * keep executing pending tasks, hence tasks may spawn and wait for nested
+ * tasks (e.g. a parallel scan inside a parallel stratum) without blocking a
+ * worker. Threads not belonging to the pool share the first queue.
+ *
+ * The pool is started lazily on first use, utilizing the number of threads
+ * set up by configure() or the system default otherwise.
+ */
+class TaskPool {
+public:
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        stop();
+    }
+
+    /**
+     * Obtains the task pool shared by all parallel operations.
+     */
+    static TaskPool& instance() {
+        static TaskPool pool;
+        return pool;
+    }
+
+    /**
+     * Sets the number of threads, including the calling thread, and whether
+     * the threads are pinned to cores, spread evenly over the NUMA nodes.
+     * A thread count of zero selects the system default. Must not be called
+     * while tasks are in flight.
+     */
+    void configure(std::size_t numThreads, bool pin = false) {
+        std::lock_guard<std::mutex> guard(startLock);
+        if (pin) {
+            pinToNumaCore(0);
+        }
+        if (numThreads == threadCount && pin == pinThreads) {
+            return;
+        }
+        stopWorkers();
+        threadCount = numThreads;
+        pinThreads = pin;
+    }
+
+    /**
+     * Obtains the number of threads executing tasks of this pool.
+     */
+    std::size_t getNumThreads() {
+        start();
+        return queues.size();
+    }
+
+    /**
+     * Checks whether the current thread executes a task or its share of a
+     * parallel loop, i.e., whether the threads of the pool may all be busy.
+     */
+    static bool inTask() {
+        return taskDepth() > 0;
+    }
+
+    /**
+     * Applies the given body to each iterator of the random-access range
+     * [first, last). The elements are claimed in chunks of grain elements by
+     * the calling thread and up to one task per worker; ranges not exceeding
+     * a single chunk are processed sequentially by the calling thread.
+     * The first exception raised by the body is re-thrown in the caller.
+     */
+    template <typename Iter, typename Body>
+    void parallelFor(Iter first, Iter last, Body&& body, std::size_t grain = 1);
+
+private:
+    friend class TaskGroup;
+
+    /** A unit of work and the group awaiting its completion */
+    struct Task {
+        std::function<void()> run;
+        TaskGroup* group = nullptr;
+    };
+
+    /** The task queue of a single thread */
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    TaskPool() = default;
+
+    /** The index of the queue of the current thread */
+    static std::size_t& workerIndex() {
+        static thread_local std::size_t index = 0;
+        return index;
+    }
+
+    /** The number of tasks and parallel loops the current thread is executing */
+    static std::size_t& taskDepth() {
+        static thread_local std::size_t depth = 0;
+        return depth;
+    }
+
+    /** Starts the workers unless they are running already */
+    void start() {
+        if (running.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(startLock);
+        if (running.load(std::memory_order_relaxed)) {
+            return;
+        }
+        std::size_t numThreads = threadCount;
+        if (numThreads == 0) {
+            numThreads = std::max(1, MAX_THREADS);
+        }
+        for (std::size_t i = 0; i < numThreads; ++i) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (std::size_t i = 1; i < numThreads; ++i) {
+            workers.emplace_back([this, i]() { work(i); });
+        }
+        running.store(true, std::memory_order_release);
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> guard(startLock);
+        stopWorkers();
+    }
+
+    /** Terminates and joins the workers; the caller holds the start lock */
+    void stopWorkers() {
+        if (!running.load(std::memory_order_relaxed)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(idleLock);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        queues.clear();
+        stopping = false;
+        running.store(false, std::memory_order_release);
+    }
+
+    /** Enqueues a task into the queue of the current thread */
+    void push(Task task) {
+        auto& queue = *queues[workerIndex()];
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> guard(idleLock);
+        }
+        idle.notify_one();
+    }
+
+    /**
+     * Executes a pending task, preferring the latest task of the current
+     * thread over the oldest task of any other thread.
+     *
+     * @return true if a task has been executed, false if there was none
+     */
+    bool runPending();
+
+    /** The main loop of a worker */
+    void work(std::size_t index) {
+        workerIndex() = index;
+        if (pinThreads) {
+            pinToNumaCore(index);
+        }
+        while (true) {
+            if (runPending()) {
+                continue;
+            }
+            // spin for a while before going to sleep
+            detail::Waiter wait;
+            for (int i = 0; i < 2000 && queued.load(std::memory_order_acquire) == 0; ++i) {
+                wait();
+            }
+            std::unique_lock<std::mutex> guard(idleLock);
+            idle.wait(guard, [&]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    // guards starting and stopping the workers
+    std::mutex startLock;
+    std::atomic<bool> running{false};
+
+    // the configured number of threads, zero for the system default
+    std::size_t threadCount = 0;
+    bool pinThreads = false;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // the number of tasks waiting in any queue
+    std::atomic<std::size_t> queued{0};
+
+    // sleeping workers are woken up on new tasks and on termination
+    std::mutex idleLock;
+    std::condition_variable idle;
+    bool stopping = false;
+};
+
+/**
+ * A set of tasks spawned into the task pool which are awaited jointly.
+ */
+class TaskGroup {
+public:
+    TaskGroup(TaskPool& pool = TaskPool::instance()) : pool(pool) {
+        pool.start();
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        join();
+    }
+
+    /**
+     * Spawns the given function as a task of this group. Without any worker
+     * threads the function is executed right away.
+     */
+    template <typename F>
+    void spawn(F&& f) {
+        if (pool.queues.size() == 1) {
+            f();
+            return;
+        }
+        pending.fetch_add(1, std::memory_order_relaxed);
+        pool.push({std::forward<F>(f), this});
+    }
+
+    /**
+     * Waits for all tasks of this group, executing pending tasks meanwhile.
+     * The first exception raised by a task of this group is re-thrown.
+     */
+    void wait() {
+        join();
+        std::exception_ptr failure;
+        {
+            std::lock_guard<std::mutex> guard(errorLock);
+            std::swap(failure, error);
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    /**
+     * Records an exception to be re-thrown by wait().
+     */
+    void fail(std::exception_ptr failure) {
+        std::lock_guard<std::mutex> guard(errorLock);
+        if (!error) {
+            error = std::move(failure);
+        }
+    }
+
+private:
+    friend class TaskPool;
+
+    void join() {
+        detail::Waiter wait;
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!pool.runPending()) {
+                wait();
+            }
+        }
+    }
+
+    TaskPool& pool;
+    std::atomic<std::size_t> pending{0};
+    std::mutex errorLock;
+    std::exception_ptr error;
+};
+
+inline bool TaskPool::runPending() {
+    const std::size_t numQueues = queues.size();
+    const std::size_t self = workerIndex();
+    for (std::size_t i = 0; i < numQueues; ++i) {
+        if (queued.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+        auto& queue = *queues[(self + i) % numQueues];
+        std::unique_lock<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        Task task;
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        guard.unlock();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+
+        taskDepth()++;
+        try {
+            task.run();
+        } catch (...) {
+            task.group->fail(std::current_exception());
+        }
+        taskDepth()--;
+        task.group->pending.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+template <typename Iter, typename Body>
+void TaskPool::parallelFor(Iter first, Iter last, Body&& body, std::size_t grain) {
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t size = std::distance(first, last);
+    if (size <= grain || getNumThreads() == 1) {
+        for (; first != last; ++first) {
+            body(first);
+        }
+        return;
+    }
+
+    // participants claim chunks of elements until all have been processed
+    std::atomic<std::size_t> next{0};
+    auto claim = [&]() {
+        for (std::size_t i = next.fetch_add(grain); i < size; i = next.fetch_add(grain)) {
+            const std::size_t end = std::min(i + grain, size);
+            try {
+                for (std::size_t j = i; j < end; ++j) {
+                    body(first + j);
+                }
+            } catch (...) {
+                next.store(size);
+                throw;
+            }
+        }
+    };
+
+    TaskGroup group(*this);
+    const std::size_t numTasks = std::min(queues.size(), (size + grain - 1) / grain);
+    for (std::size_t i = 1; i < numTasks; ++i) {
+        group.spawn(claim);
+    }
+    taskDepth()++;
+    try {
+        claim();
+    } catch (...) {
+        group.fail(std::current_exception());
+    }
+    taskDepth()--;
+    group.wait();
+}
+
 #else
 
 namespace souffle {
@@ -560,6 +960,49 @@ public:
     }
 };
 
+/**
+ * A 'sequential' task pool executing all tasks by the calling thread.
+ */
+class TaskPool {
+public:
+    static TaskPool& instance() {
+        static TaskPool pool;
+        return pool;
+    }
+
+    void configure(std::size_t /* numThreads */, bool /* pin */ = false) {}
+
+    std::size_t getNumThreads() {
+        return 1;
+    }
+
+    static bool inTask() {
+        return false;
+    }
+
+    template <typename Iter, typename Body>
+    void parallelFor(Iter first, Iter last, Body&& body, std::size_t /* grain */ = 1) {
+        for (; first != last; ++first) {
+            body(first);
+        }
+    }
+};
+
+/**
+ * A 'sequential' task group executing tasks when they are spawned.
+ */
+class TaskGroup {
+public:
+    TaskGroup(TaskPool& /* pool */ = TaskPool::instance()) {}
+
+    template <typename F>
+    void spawn(F&& f) {
+        f();
+    }
+
+    void wait() {}
+};
+
 #endif
 
 /**
@@ -0,0 +1,97 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompiledTier.cpp
+ *
+ * Define the compiled tier of the tiered execution.
+ ***********************************************************************/
+
+#include "interpreter/CompiledTier.h"
+#include "Global.h"
+#include <cstdio>
+#include <iostream>
+#include <utility>
+#include <dlfcn.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace souffle::interpreter {
+
+CompiledTier::CompiledTier(const std::string& command, std::string sourceFilename,
+        std::string libraryFilename, std::vector<std::string> symbols)
+        : sourceFilename(std::move(sourceFilename)), libraryFilename(std::move(libraryFilename)),
+          symbols(std::move(symbols)) {
+    // run the build in its own process group, so that it can be terminated as a whole
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+    pid_t child;
+    if (posix_spawn(&child, "/bin/sh", nullptr, &attributes, const_cast<char**>(argv), environ) == 0) {
+        pid = child;
+    } else if (Global::config().has("verbose")) {
+        std::cerr << "Tiered execution: cannot start the compilation\n";
+    }
+    posix_spawnattr_destroy(&attributes);
+}
+
+CompiledTier::~CompiledTier() {
+    if (pid > 0) {
+        kill(-pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+    program.reset();
+    if (handle != nullptr) {
+        dlclose(handle);
+    }
+    std::remove(libraryFilename.c_str());
+    std::remove(sourceFilename.c_str());
+}
+
+SouffleProgram* CompiledTier::poll(bool wait) {
+    if (program != nullptr || pid <= 0) {
+        return program.get();
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, wait ? 0 : WNOHANG) != pid) {
+        return nullptr;
+    }
+    pid = 0;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        if (Global::config().has("verbose")) {
+            std::cerr << "Tiered execution: the compilation failed\n";
+        }
+        return nullptr;
+    }
+
+    handle = dlopen(libraryFilename.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        std::cerr << "Tiered execution: " << dlerror() << "\n";
+        return nullptr;
+    }
+    using Factory = SouffleProgram* (*)();
+    auto factory = reinterpret_cast<Factory>(dlsym(handle, "souffle_tiered_instance"));
+    if (factory == nullptr) {
+        std::cerr << "Tiered execution: " << dlerror() << "\n";
+        return nullptr;
+    }
+    program = Own<SouffleProgram>(factory());
+    if (Global::config().has("verbose")) {
+        std::cout << "Tiered execution: compiled program loaded\n";
+    }
+    return program.get();
+}
+
+}  // namespace souffle::interpreter
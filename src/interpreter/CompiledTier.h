@@ -0,0 +1,79 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompiledTier.h
+ *
+ * Declares the compiled tier of the tiered execution, i.e., the program
+ * compiled into a shared library while the interpreter runs.
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/SouffleInterface.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <string>
+#include <vector>
+
+namespace souffle::interpreter {
+
+/**
+ * Builds the synthesised program as a shared library in a background process.
+ * Once the library has been built, it is loaded and the interpreter may hand
+ * its remaining evaluation over to it at the next statement of the main
+ * program.
+ *
+ * The generated program encodes its string constants in the order given by
+ * the synthesiser; the interpreter encodes them in the same order, so that
+ * relations can be transferred without translating symbols.
+ */
+class CompiledTier {
+public:
+    /**
+     * Starts the build.
+     *
+     * @param command - shell command building the library
+     * @param sourceFilename - generated source, removed with the tier
+     * @param libraryFilename - library built by the command
+     * @param symbols - string constants in the order of their encoding in the generated program
+     */
+    CompiledTier(const std::string& command, std::string sourceFilename, std::string libraryFilename,
+            std::vector<std::string> symbols);
+
+    CompiledTier(const CompiledTier&) = delete;
+    CompiledTier& operator=(const CompiledTier&) = delete;
+
+    /** Terminates a running build and unloads the library */
+    ~CompiledTier();
+
+    /** Return the string constants in the order of their encoding */
+    const std::vector<std::string>& getSymbols() const {
+        return symbols;
+    }
+
+    /**
+     * Return the compiled program if it is available, null otherwise.
+     *
+     * @param wait - whether to wait for a running build
+     */
+    SouffleProgram* poll(bool wait = false);
+
+private:
+    std::string sourceFilename;
+    std::string libraryFilename;
+    std::vector<std::string> symbols;
+
+    /** Process group of the build; zero once it has terminated */
+    int pid = 0;
+
+    void* handle = nullptr;
+    Own<SouffleProgram> program;
+};
+
+}  // namespace souffle::interpreter
@@ -21,6 +21,7 @@
 #include "souffle/RamTypes.h"
 #include <cassert>
 #include <cstddef>
+#include <deque>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -34,14 +35,26 @@ class Context {
     using ViewPtr = Own<ViewWrapper>;
 
 public:
+    /** Results of the batched functors of a scan for a block of its tuples */
+    struct FunctorBatch {
+        /** Position of the current tuple in the block */
+        std::size_t position = 0;
+        /** Results of each functor for the tuples of the block */
+        std::vector<std::vector<RamDomain>> results;
+    };
+
+    /** The context is created with the tuple slots bound by the generated nodes,
+     * which are addressed like registers by their tuple ids */
     Context(std::size_t size = 0) : data(size) {}
 
     /** This constructor is used when program enter a new scope.
      * Only Subroutine value needs to be copied */
-    Context(Context& ctxt) : returnValues(ctxt.returnValues), args(ctxt.args) {}
+    Context(Context& ctxt)
+            : data(ctxt.data.size()), returnValues(ctxt.returnValues), args(ctxt.args) {}
     virtual ~Context() = default;
 
     const RamDomain*& operator[](std::size_t index) {
+        // only contexts not sized by the generator grow here
         if (index >= data.size()) {
             data.resize((index + 1));
         }
@@ -109,6 +122,29 @@ public:
         return views[id].get();
     }
 
+    /** @brief Return the buffer of tuples inserted into the given relation */
+    std::vector<RamDomain>& getInsertBuffer(RelationWrapper* rel) {
+        for (auto& buffer : insertBuffers) {
+            if (buffer.first == rel) {
+                return buffer.second;
+            }
+        }
+        return insertBuffers.emplace_back(rel, std::vector<RamDomain>()).second;
+    }
+
+    /** @brief Return the functor batch of a scan, slots are kept in place when others are added */
+    FunctorBatch& getFunctorBatch(std::size_t slot) {
+        if (functorBatches.size() < slot + 1) {
+            functorBatches.resize(slot + 1);
+        }
+        return functorBatches[slot];
+    }
+
+    /** @brief Take the insert buffers of this context */
+    std::vector<std::pair<RelationWrapper*, std::vector<RamDomain>>> takeInsertBuffers() {
+        return std::exchange(insertBuffers, {});
+    }
+
 private:
     /** @brief Run-time value */
     std::vector<const RamDomain*> data;
@@ -120,6 +156,10 @@ private:
     VecOwn<RamDomain[]> allocatedDataContainer;
     /** @brief Views */
     VecOwn<ViewWrapper> views;
+    /** @brief Flattened tuples of buffered inserts per target relation */
+    std::vector<std::pair<RelationWrapper*, std::vector<RamDomain>>> insertBuffers;
+    /** @brief Functor batches of scans */
+    std::deque<FunctorBatch> functorBatches;
 };
 
 }  // namespace souffle::interpreter
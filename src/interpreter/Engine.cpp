@@ -76,6 +76,7 @@
 #include "ram/TupleOperation.h"
 #include "ram/UnpackRecord.h"
 #include "ram/UserDefinedOperator.h"
+#include "ram/utility/LastUse.h"
 #include "ram/utility/Visitor.h"
 #include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
@@ -83,6 +84,7 @@
 #include "souffle/SignalHandler.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/TypeAttribute.h"
+#include "souffle/datastructure/Arena.h"
 #include "souffle/io/IOSystem.h"
 #include "souffle/io/ReadStream.h"
 #include "souffle/io/WriteStream.h"
@@ -105,6 +107,7 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -122,21 +125,14 @@ namespace souffle::interpreter {
 #define dynamicLibSuffix ".so";
 #endif
 
-// Aliases for foreign function interface.
-#if RAM_DOMAIN_SIZE == 64
-#define FFI_RamSigned ffi_type_sint64
-#define FFI_RamUnsigned ffi_type_uint64
-#define FFI_RamFloat ffi_type_double
-#else
-#define FFI_RamSigned ffi_type_sint32
-#define FFI_RamUnsigned ffi_type_uint32
-#define FFI_RamFloat ffi_type_float
-#endif
-
-#define FFI_Symbol ffi_type_pointer
-
 namespace {
 constexpr RamDomain RAM_BIT_SHIFT_MASK = RAM_DOMAIN_SIZE - 1;
+
+/** Number of tuples of a morsel, i.e., a partition of a deferred parallel scan */
+constexpr std::size_t MORSEL_SIZE = 1024;
+
+/** Number of tuples of a scan for which batched functors are called at once */
+constexpr std::size_t FUNCTOR_BATCH_SIZE = 64;
 }
 
 Engine::Engine(ram::TranslationUnit& tUnit)
@@ -145,14 +141,21 @@ Engine::Engine(ram::TranslationUnit& tUnit)
           isProvenance(Global::config().has("provenance")),
           numOfThreads(std::stoi(Global::config().get("jobs"))), tUnit(tUnit),
           isa(tUnit.getAnalysis<ram::analysis::IndexAnalysis>()) {
+    // profiling measures and provenance queries the relations in place
+    if (Global::config().has("stream-output") && !profileEnabled && !isProvenance) {
+        outputScheduler = mk<OutputScheduler>();
+    }
 #ifdef _OPENMP
     if (numOfThreads > 0) {
         omp_set_num_threads(numOfThreads);
     } else {
         // Update threads to the system default
-        numOfThreads = omp_get_num_threads();
+        numOfThreads = MAX_THREADS;
     }
 #endif
+    TaskPool::instance().configure(numOfThreads, Global::config().has("numa"));
+    Arena::setHugePages(Global::config().has("huge-pages"));
+    Arena::setNumaInterleave(Global::config().has("numa"));
 }
 
 Engine::RelationHandle& Engine::getRelationHandle(const std::size_t idx) {
@@ -266,6 +269,88 @@ void Engine::resetIterationNumber() {
     iteration = 0;
 }
 
+void Engine::setCompiledTier(CompiledTier& tier) {
+    compiledTier = &tier;
+    // encode the string constants as the compiled program does
+    for (const auto& symbol : tier.getSymbols()) {
+        symbolTable.encode(symbol);
+    }
+}
+
+void Engine::executeTiered(Context& ctxt) {
+    std::vector<const Node*> statements;
+    if (const auto* seq = dynamic_cast<const Sequence*>(main.get())) {
+        for (const auto& child : seq->getChildren()) {
+            statements.push_back(child.get());
+        }
+    } else {
+        statements.push_back(main.get());
+    }
+
+    std::size_t waitAt = statements.size();
+    if (Global::config().has("tiered-wait")) {
+        waitAt = std::stoul(Global::config().get("tiered-wait"));
+    }
+
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        // switch at the boundary of the statements, i.e., the strata
+        SouffleProgram* program = compiledTier != nullptr ? compiledTier->poll(i >= waitAt) : nullptr;
+        if (program != nullptr) {
+            if (outputScheduler != nullptr) {
+                outputScheduler->flush();
+            }
+            if (transferState(*program)) {
+                if (Global::config().has("verbose")) {
+                    std::cout << "Tiered execution: continuing with compiled statement " << i << "\n";
+                }
+                program->setNumThreads(numOfThreads);
+                program->runFrom(i, counter);
+                return;
+            }
+            compiledTier = nullptr;
+        }
+        if (!execute(statements[i], ctxt)) {
+            return;
+        }
+    }
+}
+
+bool Engine::transferState(SouffleProgram& program) {
+    // symbols: the constants are shared, the others are appended in the same order
+    SymbolTable& symbols = program.getSymbolTable();
+    for (std::size_t i = 0; i < symbolTable.size(); ++i) {
+        if (symbols.encode(symbolTable.decode(static_cast<RamDomain>(i))) != static_cast<RamDomain>(i)) {
+            if (Global::config().has("verbose")) {
+                std::cerr << "Tiered execution: symbol tables diverge, staying in the interpreter\n";
+            }
+            return false;
+        }
+    }
+
+    // records: the compiled program has not created any yet, so references are preserved
+    program.getRecordTable().packAll(recordTable);
+
+    // relations: temporary relations are empty between strata
+    for (const auto& handle : relations) {
+        if (handle == nullptr || (*handle)->size() == 0) {
+            continue;
+        }
+        const RelationWrapper& rel = **handle;
+        souffle::Relation* target = program.getRelation(rel.getName());
+        if (target == nullptr) {
+            continue;
+        }
+        souffle::tuple tuple(target);
+        for (const RamDomain* cur : rel) {
+            for (std::size_t i = 0; i < rel.getArity(); ++i) {
+                tuple[i] = cur[i];
+            }
+            target->insert(tuple);
+        }
+    }
+    return true;
+}
+
 void Engine::executeMain() {
     SignalHandler::instance()->set();
     if (Global::config().has("verbose")) {
@@ -275,11 +360,21 @@ void Engine::executeMain() {
     generateIR();
     assert(main != nullptr && "Executing an empty program");
 
-    Context ctxt;
-
     if (!profileEnabled) {
-        Context ctxt;
-        execute(main.get(), ctxt);
+        Context ctxt(numTupleSlots);
+        if (compiledTier != nullptr) {
+            executeTiered(ctxt);
+        } else {
+            execute(main.get(), ctxt);
+        }
+        if (outputScheduler != nullptr) {
+            try {
+                outputScheduler->flush();
+            } catch (std::exception& e) {
+                std::cerr << e.what();
+                exit(EXIT_FAILURE);
+            }
+        }
     } else {
         ProfileEventSingleton::instance().setOutputFile(Global::config().get("profile"));
         // Prepare the frequency table for threaded use
@@ -312,7 +407,12 @@ void Engine::executeMain() {
         visit(program, [&](const ram::Query&) { ++ruleCount; });
         ProfileEventSingleton::instance().makeConfigRecord("ruleCount", std::to_string(ruleCount));
 
-        Context ctxt;
+        // Store the last stratum using each relation, which is released afterwards unless it is output
+        for (const auto& cur : ram::getLastUses(program)) {
+            ProfileEventSingleton::instance().makeQuantityEvent("@last-use;" + cur.first, cur.second, 0);
+        }
+
+        Context ctxt(numTupleSlots);
         execute(main.get(), ctxt);
         ProfileEventSingleton::instance().stopTimer();
         for (auto const& cur : frequencies) {
@@ -328,6 +428,20 @@ void Engine::executeMain() {
     SignalHandler::instance()->reset();
 }
 
+void Engine::recordMemoryUsage(std::size_t stratum) {
+    for (const auto& handle : relations) {
+        if (handle == nullptr || (*handle)->size() == 0 || (*handle)->getName()[0] == '@') {
+            continue;
+        }
+        const RelationWrapper& rel = **handle;
+        for (std::size_t i = 0; i < rel.getNumberOfIndexes(); ++i) {
+            ProfileEventSingleton::instance().makeQuantityEvent(
+                    "@memory;" + rel.getName() + ";" + toString(rel.getIndexOrder(i)),
+                    rel.getIndexMemoryUsage(i), stratum);
+        }
+    }
+}
+
 void Engine::generateIR() {
     const ram::Program& program = tUnit.getProgram();
     NodeGenerator generator(*this);
@@ -339,14 +453,15 @@ void Engine::generateIR() {
     if (main == nullptr) {
         main = generator.generateTree(program.getMain());
     }
+    numTupleSlots = std::max(numTupleSlots, generator.getNumTupleSlots());
 }
 
 void Engine::executeSubroutine(
         const std::string& name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret) {
-    Context ctxt;
+    generateIR();
+    Context ctxt(numTupleSlots);
     ctxt.setReturnValues(ret);
     ctxt.setArguments(args);
-    generateIR();
     const ram::Program& program = tUnit.getProgram();
     auto subs = program.getSubroutines();
     std::size_t i = distance(subs.begin(), subs.find(name));
@@ -440,21 +555,16 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
     case FunctorOp::   opcode: BINARY_OP_SHIFT_MASK(tySigned   , op); \
     case FunctorOp::U##opcode: BINARY_OP_SHIFT_MASK(tyUnsigned , op);
 
-#define MINMAX_OP_SYM(op)                                        \
-    {                                                            \
-        auto result = EVAL_CHILD(RamDomain, 0);                  \
-        auto* result_val = &getSymbolTable().decode(result);     \
-        for (std::size_t i = 1; i < args.size(); i++) {          \
-            auto alt = EVAL_CHILD(RamDomain, i);                 \
-            if (alt == result) continue;                         \
-                                                                 \
-            const auto& alt_val = getSymbolTable().decode(alt);  \
-            if (*result_val op alt_val) {                        \
-                result_val = &alt_val;                           \
-                result = alt;                                    \
-            }                                                    \
-        }                                                        \
-        return result;                                           \
+#define MINMAX_OP_SYM(op)                                          \
+    {                                                              \
+        auto result = EVAL_CHILD(RamDomain, 0);                    \
+        for (std::size_t i = 1; i < args.size(); i++) {            \
+            auto alt = EVAL_CHILD(RamDomain, i);                   \
+            if (getSymbolTable().compare(result, alt) op 0) {      \
+                result = alt;                                      \
+            }                                                      \
+        }                                                          \
+        return result;                                             \
     }
 #define MINMAX_OP(ty, op)                           \
     {                                               \
@@ -648,49 +758,45 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         ESAC(NestedIntrinsicOperator)
 
         CASE(UserDefinedOperator)
+            // computed by the enclosing scan for the current block of its tuples
+            if (shadow.isBatched()) {
+                const auto& batch = ctxt.getFunctorBatch(shadow.getBatchSlot());
+                return batch.results[shadow.getBatchColumn()][batch.position];
+            }
+
             const std::string& name = cur.getName();
 
-            auto userFunctor = reinterpret_cast<void (*)()>(getMethodHandle(name));
+            auto userFunctor = shadow.getFunctor();
             if (userFunctor == nullptr) fatal("cannot find user-defined operator `%s`", name);
             std::size_t arity = cur.getArguments().size();
 
             if (cur.isStateful()) {
                 // prepare dynamic call environment
-                ffi_cif cif;
-                ffi_type* args[arity + 2];
                 void* values[arity + 2];
                 RamDomain intVal[arity];
                 ffi_arg rc;
 
                 /* Initialize arguments for ffi-call */
-                args[0] = args[1] = &ffi_type_pointer;
                 void* symbolTable = (void*)&getSymbolTable();
                 values[0] = &symbolTable;
                 void* recordTable = (void*)&getRecordTable();
                 values[1] = &recordTable;
                 for (std::size_t i = 0; i < arity; i++) {
                     intVal[i] = execute(shadow.getChild(i), ctxt);
-                    args[i + 2] = &FFI_RamSigned;
                     values[i + 2] = &intVal[i];
                 }
 
-                // Set codomain.
-                auto codomain = &FFI_RamSigned;
-
                 // Call the external function.
-                const auto prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity + 2, codomain, args);
-                if (prepStatus != FFI_OK) {
+                if (shadow.getPrepStatus() != FFI_OK) {
                     fatal("Failed to prepare CIF for user-defined operator `%s`; error code = %d", name,
-                            prepStatus);
+                            shadow.getPrepStatus());
                 }
-                ffi_call(&cif, userFunctor, &rc, values);
+                ffi_call(shadow.getCif(), userFunctor, &rc, values);
                 return static_cast<RamDomain>(rc);
             } else {
                 const std::vector<TypeAttribute>& types = cur.getArgsTypes();
 
                 // prepare dynamic call environment
-                ffi_cif cif;
-                ffi_type* args[arity];
                 void* values[arity];
                 RamDomain intVal[arity];
                 RamUnsigned uintVal[arity];
@@ -702,22 +808,18 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
                     RamDomain arg = execute(shadow.getChild(i), ctxt);
                     switch (types[i]) {
                         case TypeAttribute::Symbol:
-                            args[i] = &FFI_Symbol;
                             strVal[i] = getSymbolTable().decode(arg).c_str();
                             values[i] = &strVal[i];
                             break;
                         case TypeAttribute::Signed:
-                            args[i] = &FFI_RamSigned;
                             intVal[i] = arg;
                             values[i] = &intVal[i];
                             break;
                         case TypeAttribute::Unsigned:
-                            args[i] = &FFI_RamUnsigned;
                             uintVal[i] = ramBitCast<RamUnsigned>(arg);
                             values[i] = &uintVal[i];
                             break;
                         case TypeAttribute::Float:
-                            args[i] = &FFI_RamFloat;
                             floatVal[i] = ramBitCast<RamFloat>(arg);
                             values[i] = &floatVal[i];
                             break;
@@ -726,33 +828,20 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
                     }
                 }
 
-                // Get codomain.
-                auto codomain = &FFI_RamSigned;
-                switch (cur.getReturnType()) {
-                    case TypeAttribute::Symbol: codomain = &FFI_Symbol; break;
-                    case TypeAttribute::Signed: codomain = &FFI_RamSigned; break;
-                    case TypeAttribute::Unsigned: codomain = &FFI_RamUnsigned; break;
-                    case TypeAttribute::Float: codomain = &FFI_RamFloat; break;
-                    case TypeAttribute::ADT: fatal("Not implemented");
-                    case TypeAttribute::Record: fatal("Not implemented");
-                }
-
-                // Call the external function.
-                const auto prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity, codomain, args);
-                if (prepStatus != FFI_OK) {
+                if (shadow.getPrepStatus() != FFI_OK) {
                     fatal("Failed to prepare CIF for user-defined operator `%s`; error code = %d", name,
-                            prepStatus);
+                            shadow.getPrepStatus());
                 }
 
                 // Call †he functor and return
                 // Float return type needs special treatment, see https://stackoverflow.com/q/61577543
                 if (cur.getReturnType() == TypeAttribute::Float) {
                     RamFloat rvalue;
-                    ffi_call(&cif, userFunctor, &rvalue, values);
+                    ffi_call(shadow.getCif(), userFunctor, &rvalue, values);
                     return ramBitCast(rvalue);
                 } else {
                     ffi_arg rvalue;
-                    ffi_call(&cif, userFunctor, &rvalue, values);
+                    ffi_call(shadow.getCif(), userFunctor, &rvalue, values);
 
                     switch (cur.getReturnType()) {
                         case TypeAttribute::Signed: return static_cast<RamDomain>(rvalue);
@@ -836,9 +925,8 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         CASE(Constraint)
         // clang-format off
 #define COMPARE_NUMERIC(ty, op) return EVAL_LEFT(ty) op EVAL_RIGHT(ty)
-#define COMPARE_STRING(op)                                        \
-    return (getSymbolTable().decode(EVAL_LEFT(RamDomain)) op \
-            getSymbolTable().decode(EVAL_RIGHT(RamDomain)))
+#define COMPARE_STRING(op)                                                         \
+    return (getSymbolTable().compare(EVAL_LEFT(RamDomain), EVAL_RIGHT(RamDomain)) op 0)
 #define COMPARE_EQ_NE(opCode, op)                                         \
     case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamDomain  , op); \
     case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op);
@@ -910,6 +998,43 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 #undef COMPARE_EQ_NE
         ESAC(Constraint)
 
+        // there is no RAM counterpart of a fused constraint, its shadow is a ram::Constraint
+        case (I_FusedConstraint): {
+            const auto& shadow = *static_cast<const interpreter::FusedConstraint*>(node);
+            const auto& lhs = shadow.getLhs();
+            const auto& rhs = shadow.getRhs();
+            const RamDomain left = lhs.isConstant ? lhs.constant : ctxt[lhs.tupleId][lhs.element];
+            const RamDomain right = rhs.isConstant ? rhs.constant : ctxt[rhs.tupleId][rhs.element];
+        // clang-format off
+#define COMPARE_NUMERIC(ty, op) return ramBitCast<ty>(left) op ramBitCast<ty>(right)
+#define COMPARE_EQ_NE(opCode, op)                                         \
+    case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamDomain  , op); \
+    case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op);
+#define COMPARE(opCode, op)                                               \
+    case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamSigned  , op); \
+    case BinaryConstraintOp::U##opCode: COMPARE_NUMERIC(RamUnsigned, op); \
+    case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op);
+            // clang-format on
+
+            switch (shadow.getOperator()) {
+                COMPARE_EQ_NE(EQ, ==)
+                COMPARE_EQ_NE(NE, !=)
+
+                COMPARE(LT, <)
+                COMPARE(LE, <=)
+                COMPARE(GT, >)
+                COMPARE(GE, >=)
+
+                default: break;
+            }
+
+            { UNREACHABLE_BAD_CASE_ANALYSIS }
+
+#undef COMPARE_NUMERIC
+#undef COMPARE
+#undef COMPARE_EQ_NE
+        }
+
         CASE(TupleOperation)
             bool result = execute(shadow.getChild(), ctxt);
 
@@ -1011,6 +1136,10 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
             return execute(shadow.getNestedOperation(), ctxt);
         ESAC(UnpackRecord)
 
+        CASE(LeapfrogJoin)
+            return evalLeapfrogJoin(cur, shadow, ctxt);
+        ESAC(LeapfrogJoin)
+
 #define PARALLEL_AGGREGATE(Structure, Arity, ...)                       \
     CASE(ParallelAggregate, Structure, Arity)                           \
         const auto& rel = *static_cast<RelType*>(shadow.getRelation()); \
@@ -1111,12 +1240,42 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         ESAC(Sequence)
 
         CASE(Parallel)
-            for (const auto& child : shadow.getChildren()) {
-                if (!execute(child.get(), ctxt)) {
-                    return false;
+            const auto& children = shadow.getChildren();
+            auto runSequentially = [&]() {
+                for (const auto& child : children) {
+                    if (!execute(child.get(), ctxt)) {
+                        return false;
+                    }
                 }
+                return true;
+            };
+            // The profile database is not synchronized, hence profiled statements run sequentially.
+            // A parallel statement nested in a statement collecting morsels runs inline as well, so
+            // that its parallel operations add their morsels to the list from the collecting thread.
+            if (profileEnabled || morsels != nullptr) {
+                return runSequentially();
             }
-            return true;
+            if (numOfThreads > 1) {
+                // Morsel-driven execution: the children are started one after another, while the
+                // partitions of their parallel operations are collected as morsels, and all morsels
+                // of the statement are then processed by one team of workers. Thus, workers are
+                // balanced across all rules of a fixpoint iteration even if their deltas are small.
+                std::vector<std::function<void()>> collected;
+                morsels = &collected;
+                bool result;
+                try {
+                    result = runSequentially();
+                } catch (...) {
+                    morsels = nullptr;
+                    throw;
+                }
+                morsels = nullptr;
+                TaskPool::instance().parallelFor(
+                        collected.begin(), collected.end(), [](auto morsel) { (*morsel)(); });
+                mergeInsertBuffers();
+                return result;
+            }
+            return runSequentially();
         ESAC(Parallel)
 
         CASE(Loop)
@@ -1148,11 +1307,17 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
             return execute(shadow.getChild(), ctxt);
         ESAC(DebugInfo)
 
-#define CLEAR(Structure, Arity, ...)                              \
-    CASE(Clear, Structure, Arity)                                 \
-        auto& rel = *static_cast<RelType*>(shadow.getRelation()); \
-        rel.__purge();                                            \
-        return true;                                              \
+#define CLEAR(Structure, Arity, ...)                                \
+    CASE(Clear, Structure, Arity)                                   \
+        auto& rel = *static_cast<RelType*>(shadow.getRelation());   \
+        if (shadow.isRefilled()) {                                  \
+            rel.__reset();                                          \
+        } else if (streamedRelations.count(&rel) > 0) {             \
+            outputScheduler->schedule([&rel]() { rel.__purge(); }); \
+        } else {                                                    \
+            rel.__purge();                                          \
+        }                                                           \
+        return true;                                                \
     ESAC(Clear)
 
         FOR_EACH(CLEAR)
@@ -1160,6 +1325,9 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 
         CASE(Call)
             execute(subroutine[shadow.getSubroutineId()].get(), ctxt);
+            if (profileEnabled && isPrefix("stratum_", cur.getName())) {
+                recordMemoryUsage(std::stoul(cur.getName().substr(8)));
+            }
             return true;
         ESAC(Call)
 
@@ -1185,10 +1353,19 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
                 }
                 return true;
             } else if (op == "output" || op == "printsize") {
-                try {
+                auto write = [this, &directive, &rel]() {
                     IOSystem::getInstance()
                             .getWriter(directive, getSymbolTable(), getRecordTable())
                             ->writeAll(rel);
+                };
+                try {
+                    if (outputScheduler != nullptr) {
+                        // the relation is final once its stratum stores it
+                        streamedRelations.insert(&rel);
+                        outputScheduler->schedule(write);
+                    } else {
+                        write();
+                    }
                 } catch (std::exception& e) {
                     std::cerr << e.what();
                     exit(EXIT_FAILURE);
@@ -1348,14 +1525,91 @@ RamDomain Engine::evalProvenanceExistenceCheck(const ProvenanceExistenceCheck& s
     return (*equalRange.begin())[Arity - 1] <= execute(shadow.getChild(), ctxt);
 }
 
-template <typename Rel>
-RamDomain Engine::evalScan(const Rel& rel, const ram::Scan& cur, const Scan& shadow, Context& ctxt) {
-    for (const auto& tuple : rel.scan()) {
-        ctxt[cur.getTupleId()] = tuple.data();
-        if (!execute(shadow.getNestedOperation(), ctxt)) {
-            break;
+template <std::size_t Arity, typename Tuples>
+void Engine::scanTuples(Tuples&& tuples, std::size_t tupleId, const Scan& shadow, Context& ctxt) {
+    const auto& functors = shadow.getBatchedFunctors();
+    if (functors.empty()) {
+        for (const auto& tuple : tuples) {
+            ctxt[tupleId] = tuple.data();
+            if (!execute(shadow.getNestedOperation(), ctxt)) {
+                break;
+            }
         }
+        return;
     }
+
+    // copy blocks of tuples, as the iterators of some relations reuse a single tuple
+    std::vector<RamDomain> block(Arity * FUNCTOR_BATCH_SIZE);
+    std::size_t size = 0;
+    auto runBlock = [&]() {
+        auto& batch = ctxt.getFunctorBatch(shadow.getBatchSlot());
+        batch.results.resize(functors.size());
+        for (std::size_t i = 0; i < functors.size(); i++) {
+            callBatchFunctor(*functors[i], tupleId, block.data(), Arity, size, batch.results[i], ctxt);
+        }
+        const std::size_t numTuples = std::exchange(size, 0);
+        for (std::size_t i = 0; i < numTuples; i++) {
+            ctxt[tupleId] = block.data() + i * Arity;
+            batch.position = i;
+            if (!execute(shadow.getNestedOperation(), ctxt)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    for (const auto& tuple : tuples) {
+        std::copy(tuple.data(), tuple.data() + Arity, block.data() + size * Arity);
+        if (++size == FUNCTOR_BATCH_SIZE && !runBlock()) {
+            return;
+        }
+    }
+    if (size > 0) {
+        runBlock();
+    }
+}
+
+void Engine::callBatchFunctor(const UserDefinedOperator& functor, std::size_t tupleId, const RamDomain* block,
+        std::size_t arity, std::size_t size, std::vector<RamDomain>& results, Context& ctxt) {
+    const auto& op = *static_cast<const ram::UserDefinedOperator*>(functor.getShadow());
+    const auto& types = op.getArgsTypes();
+
+    // columns of arguments, numbers are passed in their bit representation
+    std::vector<std::vector<RamDomain>> values(types.size(), std::vector<RamDomain>(size));
+    for (std::size_t j = 0; j < size; j++) {
+        ctxt[tupleId] = block + j * arity;
+        for (std::size_t i = 0; i < types.size(); i++) {
+            values[i][j] = execute(functor.getChild(i), ctxt);
+        }
+    }
+    std::vector<std::vector<const char*>> symbols(types.size());
+    std::vector<const void*> args(types.size());
+    for (std::size_t i = 0; i < types.size(); i++) {
+        if (types[i] == TypeAttribute::Symbol) {
+            symbols[i].resize(size);
+            for (std::size_t j = 0; j < size; j++) {
+                symbols[i][j] = getSymbolTable().decode(values[i][j]).c_str();
+            }
+            args[i] = symbols[i].data();
+        } else {
+            args[i] = values[i].data();
+        }
+    }
+
+    results.resize(size);
+    if (op.getReturnType() == TypeAttribute::Symbol) {
+        std::vector<const char*> strings(size);
+        functor.getBatchFunctor()(size, args.data(), strings.data());
+        for (std::size_t j = 0; j < size; j++) {
+            results[j] = getSymbolTable().encode(strings[j]);
+        }
+    } else {
+        functor.getBatchFunctor()(size, args.data(), results.data());
+    }
+}
+
+template <typename Rel>
+RamDomain Engine::evalScan(const Rel& rel, const ram::Scan& cur, const Scan& shadow, Context& ctxt) {
+    scanTuples<Rel::Arity>(rel.scan(), cur.getTupleId(), shadow, ctxt);
     return true;
 }
 
@@ -1364,23 +1618,17 @@ RamDomain Engine::evalParallelScan(
         const Rel& rel, const ram::ParallelScan& cur, const ParallelScan& shadow, Context& ctxt) {
     auto viewContext = shadow.getViewContext();
 
-    auto pStream = rel.partitionScan(numOfThreads);
+    auto pStream = rel.partitionScan(getScanPartitionCount(rel.size()));
 
-    PARALLEL_START
+    auto viewInfo = viewContext->getViewInfoForNested();
+    forEachPartition(std::move(pStream), [this, &cur, &shadow, &ctxt, viewInfo](auto it) {
         Context newCtxt(ctxt);
-        auto viewInfo = viewContext->getViewInfoForNested();
         for (const auto& info : viewInfo) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
-        pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
-            for (const auto& tuple : *it) {
-                newCtxt[cur.getTupleId()] = tuple.data();
-                if (!execute(shadow.getNestedOperation(), newCtxt)) {
-                    break;
-                }
-            }
-        }
-    PARALLEL_END
+        scanTuples<Rel::Arity>(*it, cur.getTupleId(), shadow, newCtxt);
+        flushInsertBuffers(newCtxt);
+    });
     return true;
 }
 
@@ -1396,12 +1644,7 @@ RamDomain Engine::evalIndexScan(const ram::IndexScan& cur, const IndexScan& shad
     std::size_t viewId = shadow.getViewId();
     auto view = Rel::castView(ctxt.getView(viewId));
     // conduct range query
-    for (const auto& tuple : view->range(low, high)) {
-        ctxt[cur.getTupleId()] = tuple.data();
-        if (!execute(shadow.getNestedOperation(), ctxt)) {
-            break;
-        }
-    }
+    scanTuples<Arity>(view->range(low, high), cur.getTupleId(), shadow, ctxt);
     return true;
 }
 
@@ -1419,21 +1662,68 @@ RamDomain Engine::evalParallelIndexScan(
 
     std::size_t indexPos = shadow.getViewId();
     auto pStream = rel.partitionRange(indexPos, low, high, numOfThreads);
-    PARALLEL_START
+    auto viewInfo = viewContext->getViewInfoForNested();
+    forEachPartition(std::move(pStream), [this, &cur, &shadow, &ctxt, viewInfo](auto it) {
         Context newCtxt(ctxt);
-        auto viewInfo = viewContext->getViewInfoForNested();
         for (const auto& info : viewInfo) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
-        pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
-            for (const auto& tuple : *it) {
-                newCtxt[cur.getTupleId()] = tuple.data();
-                if (!execute(shadow.getNestedOperation(), newCtxt)) {
-                    break;
-                }
+        scanTuples<Rel::Arity>(*it, cur.getTupleId(), shadow, newCtxt);
+        flushInsertBuffers(newCtxt);
+    });
+    return true;
+}
+
+RamDomain Engine::evalLeapfrogJoin(const ram::LeapfrogJoin& cur, const LeapfrogJoin& shadow, Context& ctxt) {
+    const std::size_t numRelations = shadow.getNumRelations();
+
+    // create the bounds of each relation, the join column is unbounded
+    std::vector<std::vector<RamDomain>> lows(numRelations);
+    std::vector<std::vector<RamDomain>> highs(numRelations);
+    for (std::size_t i = 0; i < numRelations; i++) {
+        const auto& superInfo = shadow.getSuperInst(i);
+        auto& low = lows[i];
+        auto& high = highs[i];
+        low.resize(superInfo.first.size());
+        high.resize(superInfo.second.size());
+        CAL_SEARCH_BOUND(superInfo, low, high);
+    }
+
+    // seek the first value of the join column of the i-th relation not below
+    // the given value, or above it if strict
+    auto seek = [&](std::size_t i, bool strict, RamDomain& value) {
+        std::size_t pos = shadow.getPosition(i);
+        auto& key = strict ? highs[i] : lows[i];
+        key[pos] = value;
+        return ctxt.getView(shadow.getViewId() + i)->seek(key.data(), pos, strict, value);
+    };
+
+    // leapfrog over the relations until all of them agree on a value, starting
+    // at the value in the current relation, or above it if strict
+    RamDomain value[1] = {MIN_RAM_SIGNED};
+    std::size_t i = 0;
+    auto leapfrog = [&](bool strict) {
+        if (!seek(i, strict, value[0])) {
+            return false;
+        }
+        for (std::size_t matched = 1; matched < numRelations;) {
+            i = (i + 1) % numRelations;
+            RamDomain next = value[0];
+            if (!seek(i, false, next)) {
+                return false;
             }
+            matched = (next == value[0]) ? matched + 1 : 1;
+            value[0] = next;
         }
-    PARALLEL_END
+        return true;
+    };
+
+    ctxt[cur.getTupleId()] = value;
+    for (bool found = leapfrog(false); found; found = leapfrog(true)) {
+        if (!execute(shadow.getNestedOperation(), ctxt)) {
+            break;
+        }
+    }
     return true;
 }
 
@@ -1456,23 +1746,22 @@ RamDomain Engine::evalParallelIfExists(
         const Rel& rel, const ram::ParallelIfExists& cur, const ParallelIfExists& shadow, Context& ctxt) {
     auto viewContext = shadow.getViewContext();
 
-    auto pStream = rel.partitionScan(numOfThreads);
+    auto pStream = rel.partitionScan(getScanPartitionCount(rel.size()));
     auto viewInfo = viewContext->getViewInfoForNested();
-    PARALLEL_START
+    forEachPartition(std::move(pStream), [this, &cur, &shadow, &ctxt, viewInfo](auto it) {
         Context newCtxt(ctxt);
         for (const auto& info : viewInfo) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
-        pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
-            for (const auto& tuple : *it) {
-                newCtxt[cur.getTupleId()] = tuple.data();
-                if (execute(shadow.getCondition(), newCtxt)) {
-                    execute(shadow.getNestedOperation(), newCtxt);
-                    break;
-                }
+        for (const auto& tuple : *it) {
+            newCtxt[cur.getTupleId()] = tuple.data();
+            if (execute(shadow.getCondition(), newCtxt)) {
+                execute(shadow.getNestedOperation(), newCtxt);
+                break;
             }
         }
-    PARALLEL_END
+        flushInsertBuffers(newCtxt);
+    });
     return true;
 }
 
@@ -1515,25 +1804,73 @@ RamDomain Engine::evalParallelIndexIfExists(const Rel& rel, const ram::ParallelI
     std::size_t indexPos = shadow.getViewId();
     auto pStream = rel.partitionRange(indexPos, low, high, numOfThreads);
 
-    PARALLEL_START
+    forEachPartition(std::move(pStream), [this, &cur, &shadow, &ctxt, viewInfo](auto it) {
         Context newCtxt(ctxt);
         for (const auto& info : viewInfo) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
-        pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
-            for (const auto& tuple : *it) {
-                newCtxt[cur.getTupleId()] = tuple.data();
-                if (execute(shadow.getCondition(), newCtxt)) {
-                    execute(shadow.getNestedOperation(), newCtxt);
-                    break;
-                }
+        for (const auto& tuple : *it) {
+            newCtxt[cur.getTupleId()] = tuple.data();
+            if (execute(shadow.getCondition(), newCtxt)) {
+                execute(shadow.getNestedOperation(), newCtxt);
+                break;
             }
         }
-    PARALLEL_END
+        flushInsertBuffers(newCtxt);
+    });
 
     return true;
 }
 
+template <typename Partitions, typename Body>
+void Engine::forEachPartition(Partitions partitions, const Body& body) {
+    if (morsels == nullptr) {
+        TaskPool::instance().parallelFor(partitions.begin(), partitions.end(), body);
+        mergeInsertBuffers();
+        return;
+    }
+    // the partitions have to outlive the statement collecting the morsels
+    auto shared = std::make_shared<Partitions>(std::move(partitions));
+    for (auto it = shared->begin(); it != shared->end(); ++it) {
+        morsels->push_back([shared, it, body]() { body(it); });
+    }
+}
+
+std::size_t Engine::getScanPartitionCount(std::size_t size) const {
+    if (morsels == nullptr) {
+        return numOfThreads;
+    }
+    // small relations are still split for all workers as their nested operations may be costly
+    return std::max(numOfThreads, (size + MORSEL_SIZE - 1) / MORSEL_SIZE);
+}
+
+void Engine::flushInsertBuffers(Context& ctxt) {
+    auto buffers = ctxt.takeInsertBuffers();
+    if (buffers.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(pendingInsertsLock);
+    for (auto& buffer : buffers) {
+        pendingInserts.push_back(std::move(buffer));
+    }
+}
+
+void Engine::mergeInsertBuffers() {
+    auto pending = std::exchange(pendingInserts, {});
+    // group the buffers by their target relation
+    std::sort(pending.begin(), pending.end(),
+            [](const auto& a, const auto& b) { return std::less<RelationWrapper*>()(a.first, b.first); });
+    for (auto it = pending.begin(); it != pending.end();) {
+        auto& data = it->second;
+        auto next = std::next(it);
+        for (; next != pending.end() && next->first == it->first; ++next) {
+            data.insert(data.end(), next->second.begin(), next->second.end());
+        }
+        it->first->insertBatch(data);
+        it = next;
+    }
+}
+
 template <typename Aggregate, typename Iter>
 RamDomain Engine::evalAggregate(const Aggregate& aggregate, const Node& filter, const Node* expression,
         const Node& nestedOperation, const Iter& ranges, Context& ctxt) {
@@ -1720,8 +2057,13 @@ RamDomain Engine::evalInsert(Rel& rel, const Insert& shadow, Context& ctxt) {
         tuple[expr.first] = execute(expr.second.get(), ctxt);
     }
 
-    // insert in target relation
-    rel.insert(tuple);
+    // insert in target relation, or defer the insertion to the end of the query
+    if (shadow.isBuffered()) {
+        auto& buffer = ctxt.getInsertBuffer(&rel);
+        buffer.insert(buffer.end(), tuple.begin(), tuple.end());
+    } else {
+        rel.insert(tuple);
+    }
     return true;
 }
 
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "Global.h"
+#include "interpreter/CompiledTier.h"
 #include "interpreter/Context.h"
 #include "interpreter/Generator.h"
 #include "interpreter/Index.h"
@@ -27,13 +28,18 @@
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
+#include "souffle/io/OutputScheduler.h"
 #include "souffle/utility/ContainerUtil.h"
 #include <atomic>
 #include <cstddef>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 #ifdef _OPENMP
 #include <omp.h>
@@ -57,6 +63,8 @@ public:
 
     /** @brief Execute the main program */
     void executeMain();
+    /** @brief Hand the evaluation over to the compiled tier once it is available */
+    void setCompiledTier(CompiledTier& tier);
     /** @brief Execute the subroutine program */
     void executeSubroutine(
             const std::string& name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret);
@@ -64,6 +72,10 @@ public:
 private:
     /** @brief Generate intermediate representation from RAM */
     void generateIR();
+    /** @brief Execute the statements of the main program, switching to the compiled tier if possible */
+    void executeTiered(Context& ctxt);
+    /** @brief Transfer symbols, records and relations into a compiled program */
+    bool transferState(SouffleProgram& program);
     /** @brief Remove a relation from the environment */
     void dropRelation(const std::size_t relId);
     /** @brief Swap the content of two relations */
@@ -104,6 +116,14 @@ private:
     template <typename Rel>
     RamDomain evalProvenanceExistenceCheck(const ProvenanceExistenceCheck& shadow, Context& ctxt);
 
+    /** @brief Run the nested operation of a scan for each of the given tuples */
+    template <std::size_t Arity, typename Tuples>
+    void scanTuples(Tuples&& tuples, std::size_t tupleId, const Scan& shadow, Context& ctxt);
+
+    /** @brief Compute the results of a batched functor for a block of the tuples of a scan */
+    void callBatchFunctor(const UserDefinedOperator& functor, std::size_t tupleId, const RamDomain* block,
+            std::size_t arity, std::size_t size, std::vector<RamDomain>& results, Context& ctxt);
+
     template <typename Rel>
     RamDomain evalScan(const Rel& rel, const ram::Scan& cur, const Scan& shadow, Context& ctxt);
 
@@ -118,6 +138,8 @@ private:
     RamDomain evalParallelIndexScan(const Rel& rel, const ram::ParallelIndexScan& cur,
             const ParallelIndexScan& shadow, Context& ctxt);
 
+    RamDomain evalLeapfrogJoin(const ram::LeapfrogJoin& cur, const LeapfrogJoin& shadow, Context& ctxt);
+
     template <typename Rel>
     RamDomain evalIfExists(const Rel& rel, const ram::IfExists& cur, const IfExists& shadow, Context& ctxt);
 
@@ -153,6 +175,25 @@ private:
     template <typename Rel>
     RamDomain evalInsert(Rel& rel, const Insert& shadow, Context& ctxt);
 
+    /**
+     * Runs the body for each partition of a parallel operation, or defers the
+     * partitions to the morsels of the loop iteration under way.
+     */
+    template <typename Partitions, typename Body>
+    void forEachPartition(Partitions partitions, const Body& body);
+
+    /** Number of partitions of a parallel scan over a relation of the given size */
+    std::size_t getScanPartitionCount(std::size_t size) const;
+
+    /** Hands the insert buffers of a finished partition over to the engine */
+    void flushInsertBuffers(Context& ctxt);
+
+    /** Merges the buffered inserts of all finished partitions into their target relations */
+    void mergeInsertBuffers();
+
+    /** Records the memory of the indexes of all relations at the end of a stratum in the profile */
+    void recordMemoryUsage(std::size_t stratum);
+
     /** If profile is enable in this program */
     const bool profileEnabled;
     const bool frequencyCounterEnabled;
@@ -162,6 +203,8 @@ private:
     VecOwn<Node> subroutine;
     /** main program */
     Own<Node> main;
+    /** Number of tuple slots of an evaluation context */
+    std::size_t numTupleSlots = 0;
     /** Number of threads enabled for this program */
     std::size_t numOfThreads;
     /** Profile counter */
@@ -184,6 +227,18 @@ private:
     VecOwn<RelationHandle> relations;
     /** Symbol table */
     SymbolTable symbolTable;
+    /** Writes output relations in the background if streaming output is enabled */
+    Own<OutputScheduler> outputScheduler;
+    /** Relations handed to the output scheduler, which also releases them */
+    std::set<const RelationWrapper*> streamedRelations;
+    /** Compiled program taking over the evaluation in tiered execution */
+    CompiledTier* compiledTier = nullptr;
+    /** Morsels of the parallel statement under way, if partitions are deferred */
+    std::vector<std::function<void()>>* morsels = nullptr;
+    /** Insert buffers of finished partitions, which are not merged yet */
+    std::vector<std::pair<RelationWrapper*, std::vector<RamDomain>>> pendingInserts;
+    /** Guards the insert buffers of finished partitions */
+    std::mutex pendingInsertsLock;
 };
 
 }  // namespace souffle::interpreter
@@ -44,6 +44,12 @@ NodePtr NodeGenerator::generateTree(const ram::Node& root) {
         } else if (const auto* provExists = as<ram::ProvenanceExistenceCheck>(node)) {
             encodeIndexPos(*provExists);
             encodeView(provExists);
+        } else if (const auto* join = as<ram::LeapfrogJoin>(node)) {
+            // a view for each relation, with consecutive ids
+            encodeView(join);
+            for (std::size_t i = 1; i < join->getNumRelations(); i++) {
+                getNextViewId();
+            }
         }
     });
     // Parse program
@@ -83,7 +89,55 @@ NodePtr NodeGenerator::visit_(type_identity<ram::UserDefinedOperator>, const ram
     for (const auto& arg : op.getArguments()) {
         children.push_back(dispatch(*arg));
     }
-    return mk<UserDefinedOperator>(I_UserDefinedOperator, &op, std::move(children));
+
+    // resolve the functor and its call interface once, a missing functor is reported when called
+    const std::string& name = op.getName();
+    auto functor = reinterpret_cast<void (*)()>(engine.getMethodHandle(name));
+    UserDefinedOperator::BatchFunctor batchFunctor = nullptr;
+    std::vector<ffi_type*> argTypes;
+    ffi_type* returnType = &FFI_RamSigned;
+
+    auto toFFIType = [](TypeAttribute type) -> ffi_type* {
+        switch (type) {
+            case TypeAttribute::Symbol: return &FFI_Symbol;
+            case TypeAttribute::Signed: return &FFI_RamSigned;
+            case TypeAttribute::Unsigned: return &FFI_RamUnsigned;
+            case TypeAttribute::Float: return &FFI_RamFloat;
+            case TypeAttribute::ADT:
+            case TypeAttribute::Record: return nullptr;
+        }
+        return nullptr;
+    };
+
+    if (op.isStateful()) {
+        // symbol and record table followed by the arguments
+        argTypes.assign(2, &ffi_type_pointer);
+        argTypes.insert(argTypes.end(), op.getArguments().size(), &FFI_RamSigned);
+    } else {
+        batchFunctor = reinterpret_cast<UserDefinedOperator::BatchFunctor>(
+                engine.getMethodHandle("souffle_batch_" + name));
+        for (const auto& type : op.getArgsTypes()) {
+            argTypes.push_back(toFFIType(type));
+        }
+        returnType = toFFIType(op.getReturnType());
+    }
+
+    // unsupported types are reported when called
+    if (returnType == nullptr || contains(argTypes, nullptr)) {
+        argTypes.clear();
+        returnType = &ffi_type_void;
+    }
+
+    auto res = mk<UserDefinedOperator>(I_UserDefinedOperator, &op, std::move(children), functor,
+            batchFunctor, std::move(argTypes), returnType);
+
+    // the results are computed for blocks of tuples by the enclosing scan
+    auto slot = functorBatchSlots.find(&op);
+    if (slot != functorBatchSlots.end() && batchFunctor != nullptr) {
+        res->setBatch(slot->second, functorBatches[slot->second].size());
+        functorBatches[slot->second].push_back(res.get());
+    }
+    return res;
 }
 
 NodePtr NodeGenerator::visit_(
@@ -165,6 +219,12 @@ NodePtr NodeGenerator::visit_(
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Constraint>, const ram::Constraint& relOp) {
+    FusedConstraint::Operand lhs{};
+    FusedConstraint::Operand rhs{};
+    if (isFusableConstraintOp(relOp.getOperator()) && encodeFusedOperand(relOp.getLHS(), lhs) &&
+            encodeFusedOperand(relOp.getRHS(), rhs)) {
+        return mk<FusedConstraint>(I_FusedConstraint, &relOp, relOp.getOperator(), lhs, rhs);
+    }
     return mk<Constraint>(I_Constraint, &relOp, dispatch(relOp.getLHS()), dispatch(relOp.getRHS()));
 }
 
@@ -184,7 +244,10 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Scan>, const ram::Scan& scan) {
     std::size_t relId = encodeRelation(scan.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("Scan", lookup(scan.getRelation()));
-    return mk<Scan>(type, &scan, rel, visit_(type_identity<ram::TupleOperation>(), scan));
+    std::size_t batchSlot = batchFunctors(scan);
+    auto res = mk<Scan>(type, &scan, rel, visit_(type_identity<ram::TupleOperation>(), scan));
+    res->setBatchedFunctors(batchSlot, functorBatches[batchSlot]);
+    return res;
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::ParallelScan>, const ram::ParallelScan& pScan) {
@@ -192,7 +255,9 @@ NodePtr NodeGenerator::visit_(type_identity<ram::ParallelScan>, const ram::Paral
     std::size_t relId = encodeRelation(pScan.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("ParallelScan", lookup(pScan.getRelation()));
+    std::size_t batchSlot = batchFunctors(pScan);
     auto res = mk<ParallelScan>(type, &pScan, rel, visit_(type_identity<ram::TupleOperation>(), pScan));
+    res->setBatchedFunctors(batchSlot, functorBatches[batchSlot]);
     res->setViewContext(parentQueryViewContext);
     return res;
 }
@@ -201,8 +266,11 @@ NodePtr NodeGenerator::visit_(type_identity<ram::IndexScan>, const ram::IndexSca
     orderingContext.addTupleWithIndexOrder(iScan.getTupleId(), iScan);
     SuperInstruction indexOperation = getIndexSuperInstInfo(iScan);
     NodeType type = constructNodeType("IndexScan", lookup(iScan.getRelation()));
-    return mk<IndexScan>(type, &iScan, nullptr, visit_(type_identity<ram::TupleOperation>(), iScan),
+    std::size_t batchSlot = batchFunctors(iScan);
+    auto res = mk<IndexScan>(type, &iScan, nullptr, visit_(type_identity<ram::TupleOperation>(), iScan),
             encodeView(&iScan), std::move(indexOperation));
+    res->setBatchedFunctors(batchSlot, functorBatches[batchSlot]);
+    return res;
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::ParallelIndexScan>, const ram::ParallelIndexScan& piscan) {
@@ -211,8 +279,10 @@ NodePtr NodeGenerator::visit_(type_identity<ram::ParallelIndexScan>, const ram::
     std::size_t relId = encodeRelation(piscan.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("ParallelIndexScan", lookup(piscan.getRelation()));
+    std::size_t batchSlot = batchFunctors(piscan);
     auto res = mk<ParallelIndexScan>(type, &piscan, rel, visit_(type_identity<ram::TupleOperation>(), piscan),
             encodeIndexPos(piscan), std::move(indexOperation));
+    res->setBatchedFunctors(batchSlot, functorBatches[batchSlot]);
     res->setViewContext(parentQueryViewContext);
     return res;
 }
@@ -266,6 +336,59 @@ NodePtr NodeGenerator::visit_(
             visit_(type_identity<ram::TupleOperation>(), unpack));
 }
 
+NodePtr NodeGenerator::visit_(type_identity<ram::LeapfrogJoin>, const ram::LeapfrogJoin& join) {
+    std::vector<std::size_t> positions;
+    std::vector<SuperInstruction> superInsts;
+    for (std::size_t i = 0; i < join.getNumRelations(); i++) {
+        std::size_t arity = getArity(join.getRelation(i));
+        auto interpreterRel = encodeRelation(join.getRelation(i));
+        auto order = (*getRelationHandle(interpreterRel))->getIndexOrder(encodeIndexPos(join, i));
+        const auto pattern = join.getPattern(i);
+        SuperInstruction superInst(arity);
+        for (std::size_t j = 0; j < arity; ++j) {
+            const auto* value = pattern[order[j]];
+            if (order[j] == join.getColumn(i)) {
+                // joins that cannot seek were replaced by the LeapfrogFallbackTransformer
+                assert(j == std::size_t(std::count_if(pattern.begin(), pattern.end(),
+                                    [](const ram::Expression* e) { return !isUndefValue(e); })) &&
+                        "join column must follow the bound attributes");
+                positions.push_back(j);
+            }
+
+            // Unbounded
+            if (isUndefValue(value)) {
+                superInst.first[j] = MIN_RAM_SIGNED;
+                superInst.second[j] = MAX_RAM_SIGNED;
+                continue;
+            }
+
+            // Constant
+            if (isA<ram::NumericConstant>(value)) {
+                superInst.first[j] = as<ram::NumericConstant>(value)->getConstant();
+                superInst.second[j] = superInst.first[j];
+                continue;
+            }
+
+            // TupleElement
+            if (const auto* tuple = as<ram::TupleElement>(value)) {
+                std::size_t tupleId = tuple->getTupleId();
+                std::size_t newElementId = orderingContext.mapOrder(tupleId, tuple->getElement());
+                superInst.tupleFirst.push_back({j, tupleId, newElementId});
+                superInst.tupleSecond.push_back({j, tupleId, newElementId});
+                continue;
+            }
+
+            // Generic expression
+            superInst.exprFirst.push_back(std::pair<std::size_t, Own<Node>>(j, dispatch(*value)));
+            superInst.exprSecond.push_back(std::pair<std::size_t, Own<Node>>(j, dispatch(*value)));
+        }
+        superInsts.push_back(std::move(superInst));
+    }
+    orderingContext.addNewTuple(join.getTupleId(), 1);
+    return mk<LeapfrogJoin>(I_LeapfrogJoin, &join, visit_(type_identity<ram::TupleOperation>(), join),
+            encodeView(&join), std::move(positions), std::move(superInsts));
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::Aggregate>, const ram::Aggregate& aggregate) {
     // Notice: Aggregate is sensitive to the visiting order of the subexprs in order to make
     // orderCtxt consistent. The order of visiting should be the same as the order of execution during
@@ -351,7 +474,7 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Insert>, const ram::Insert& ins
     std::size_t relId = encodeRelation(insert.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("Insert", lookup(insert.getRelation()));
-    return mk<Insert>(type, &insert, rel, std::move(superOp));
+    return mk<Insert>(type, &insert, rel, std::move(superOp), insert.isBuffered());
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::SubroutineReturn>, const ram::SubroutineReturn& ret) {
@@ -415,8 +538,9 @@ NodePtr NodeGenerator::visit_(type_identity<ram::DebugInfo>, const ram::DebugInf
 NodePtr NodeGenerator::visit_(type_identity<ram::Clear>, const ram::Clear& clear) {
     std::size_t relId = encodeRelation(clear.getRelation());
     auto rel = getRelationHandle(relId);
-    NodeType type = constructNodeType("Clear", lookup(clear.getRelation()));
-    return mk<Clear>(type, &clear, rel);
+    const auto& ramRelation = lookup(clear.getRelation());
+    NodeType type = constructNodeType("Clear", ramRelation);
+    return mk<Clear>(type, &clear, rel, clear.isRefilled());
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::LogSize>, const ram::LogSize& size) {
@@ -470,6 +594,13 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Query>, const ram::Query& query
         };
     });
 
+    visit(*next, [&](const ram::LeapfrogJoin& join) {
+        for (std::size_t i = 0; i < join.getNumRelations(); i++) {
+            viewContext->addViewInfoForNested(
+                    encodeRelation(join.getRelation(i)), encodeIndexPos(join, i), encodeView(&join) + i);
+        }
+    });
+
     visit(*next, [&](const ram::AbstractParallel&) { viewContext->isParallel = true; });
 
     auto res = mk<Query>(I_Query, &query, dispatch(*next));
@@ -523,6 +654,11 @@ std::size_t NodeGenerator::encodeIndexPos(RamNode& node) {
     return i;
 };
 
+std::size_t NodeGenerator::encodeIndexPos(const ram::LeapfrogJoin& join, std::size_t i) {
+    ram::analysis::SearchSignature signature = engine.isa->getSearchSignature(&join, i);
+    return engine.isa->getIndexSelection(join.getRelation(i)).getLexOrderNum(signature);
+}
+
 std::size_t NodeGenerator::encodeView(const ram::Node* node) {
     auto pos = viewTable.find(node);
     if (pos != viewTable.end()) {
@@ -722,6 +858,99 @@ SuperInstruction NodeGenerator::getInsertSuperInstInfo(const ram::Insert& exist)
     return superOp;
 }
 
+bool NodeGenerator::isFusableConstraintOp(BinaryConstraintOp op) {
+    switch (op) {
+        case BinaryConstraintOp::EQ:
+        case BinaryConstraintOp::FEQ:
+        case BinaryConstraintOp::NE:
+        case BinaryConstraintOp::FNE:
+        case BinaryConstraintOp::LT:
+        case BinaryConstraintOp::ULT:
+        case BinaryConstraintOp::FLT:
+        case BinaryConstraintOp::LE:
+        case BinaryConstraintOp::ULE:
+        case BinaryConstraintOp::FLE:
+        case BinaryConstraintOp::GT:
+        case BinaryConstraintOp::UGT:
+        case BinaryConstraintOp::FGT:
+        case BinaryConstraintOp::GE:
+        case BinaryConstraintOp::UGE:
+        case BinaryConstraintOp::FGE: return true;
+        default: return false;
+    }
+}
+
+bool NodeGenerator::encodeFusedOperand(const ram::Expression& expr, FusedConstraint::Operand& operand) {
+    // Constant
+    if (const auto* num = as<ram::NumericConstant>(expr)) {
+        operand.isConstant = true;
+        operand.constant = num->getConstant();
+        return true;
+    }
+    if (const auto* str = as<ram::StringConstant>(expr)) {
+        operand.isConstant = true;
+        operand.constant = engine.getSymbolTable().encode(str->getConstant());
+        return true;
+    }
+
+    // TupleElement
+    if (const auto* tuple = as<ram::TupleElement>(expr)) {
+        operand.isConstant = false;
+        operand.tupleId = tuple->getTupleId();
+        operand.element = orderingContext.mapOrder(operand.tupleId, tuple->getElement());
+        return true;
+    }
+    return false;
+}
+
+std::size_t NodeGenerator::batchFunctors(const ram::TupleOperation& scan) {
+    const std::size_t slot = functorBatches.size();
+    functorBatches.emplace_back();
+
+    // Operators are computed for all tuples of a block before the nested operation
+    // runs. Only the values of an unconditional insert or return directly below the
+    // scan are computed for every tuple anyway; below a filter, a break or a nested
+    // search, an operator may be guarded against tuples it is not defined on.
+    std::vector<ram::Expression*> values;
+    const ram::Operation& nested = scan.getOperation();
+    if (isA<ram::Insert>(nested) && !isA<ram::GuardedInsert>(nested)) {
+        values = as<ram::Insert>(nested)->getValues();
+    } else if (const auto* subroutineReturn = as<ram::SubroutineReturn>(nested)) {
+        values = subroutineReturn->getValues();
+    }
+
+    auto isBatchable = [](TypeAttribute type) {
+        return type == TypeAttribute::Signed || type == TypeAttribute::Unsigned ||
+               type == TypeAttribute::Float || type == TypeAttribute::Symbol;
+    };
+    auto batch = [&](const ram::UserDefinedOperator& op) {
+        const auto& types = op.getArgsTypes();
+        bool batchable = !op.isStateful() && isBatchable(op.getReturnType()) &&
+                         std::all_of(types.begin(), types.end(), isBatchable) &&
+                         functorBatchSlots.count(&op) == 0;
+        bool usesScan = false;
+        for (const auto* arg : op.getArguments()) {
+            if (const auto* element = as<ram::TupleElement>(arg)) {
+                usesScan = usesScan || element->getTupleId() == scan.getTupleId();
+            } else {
+                batchable = batchable && (isA<ram::NumericConstant>(arg) || isA<ram::StringConstant>(arg) ||
+                                                 isA<ram::SubroutineArgument>(arg));
+            }
+        }
+        if (usesScan && batchable) {
+            functorBatchSlots[&op] = slot;
+        }
+    };
+    for (const auto* value : values) {
+        visit(*value, batch);
+    }
+    return slot;
+}
+
+std::size_t NodeGenerator::getNumTupleSlots() const {
+    return orderingContext.getNumTuples();
+}
+
 // -- Definition of OrderingContext --
 
 NodeGenerator::OrderingContext::OrderingContext(NodeGenerator& generator) : generator(generator) {}
@@ -748,6 +977,10 @@ void NodeGenerator::OrderingContext::addTupleWithIndexOrder(std::size_t tupleId,
     insertOrder(tupleId, order);
 }
 
+std::size_t NodeGenerator::OrderingContext::getNumTuples() const {
+    return tupleOrders.size();
+}
+
 std::size_t NodeGenerator::OrderingContext::mapOrder(std::size_t tupleId, std::size_t elementId) const {
     return tupleOrders[tupleId][elementId];
 }
@@ -40,6 +40,7 @@
 #include "ram/Extend.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/GuardedInsert.h"
 #include "ram/IO.h"
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
@@ -48,6 +49,7 @@
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
+#include "ram/LeapfrogJoin.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/LogSize.h"
 #include "ram/LogTimer.h"
@@ -97,6 +99,7 @@
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <typeinfo>
 #include <unordered_map>
@@ -125,6 +128,11 @@ public:
      */
     NodePtr generateTree(const ram::Node& root);
 
+    /**
+     * @brief Return the number of tuple slots a context needs for the generated trees.
+     */
+    std::size_t getNumTupleSlots() const;
+
     NodePtr visit_(type_identity<ram::NumericConstant>, const ram::NumericConstant& num) override;
 
     NodePtr visit_(type_identity<ram::StringConstant>, const ram::StringConstant& num) override;
@@ -186,6 +194,8 @@ public:
 
     NodePtr visit_(type_identity<ram::UnpackRecord>, const ram::UnpackRecord& unpack) override;
 
+    NodePtr visit_(type_identity<ram::LeapfrogJoin>, const ram::LeapfrogJoin& join) override;
+
     NodePtr visit_(type_identity<ram::Aggregate>, const ram::Aggregate& aggregate) override;
 
     NodePtr visit_(type_identity<ram::ParallelAggregate>, const ram::ParallelAggregate& pAggregate) override;
@@ -272,6 +282,9 @@ private:
         /** @brief Map the decoded order of elementId based on current context */
         std::size_t mapOrder(std::size_t tupleId, std::size_t elementId) const;
 
+        /** @brief Return the number of tuples bound so far */
+        std::size_t getNumTuples() const;
+
     private:
         void insertOrder(std::size_t tupleId, const Order& order);
         std::vector<Order> tupleOrders;
@@ -292,6 +305,9 @@ private:
     template <class RamNode>
     std::size_t encodeIndexPos(RamNode& node);
 
+    /** @brief Return the index id of the i-th relation of a leapfrog join */
+    std::size_t encodeIndexPos(const ram::LeapfrogJoin& join, std::size_t i);
+
     /** @brief Encode and return the View id of an operation. */
     std::size_t encodeView(const ram::Node* node);
 
@@ -336,6 +352,27 @@ private:
      */
     SuperInstruction getInsertSuperInstInfo(const ram::Insert& exist);
 
+    /** @brief Return true if a constraint with the given operator can be fused */
+    static bool isFusableConstraintOp(BinaryConstraintOp op);
+
+    /**
+     * @brief Encode a constant or tuple element operand of a fused constraint.
+     * Return false if the expression has to be evaluated as a node.
+     */
+    bool encodeFusedOperand(const ram::Expression& expr, FusedConstraint::Operand& operand);
+
+    /**
+     * @brief Choose the user-defined operators below a scan whose results are
+     * computed for blocks of its tuples, and return the slot of their batch.
+     *
+     * An operator is batched by the scan if it has a batched variant and its
+     * arguments are constants or elements of the scanned tuple and of tuples
+     * bound outside the scan. It must also be computed for every tuple of the
+     * scan, i.e., be part of the values of an insert or return directly nested
+     * in the scan rather than below a condition.
+     */
+    std::size_t batchFunctors(const ram::TupleOperation& scan);
+
     /** Environment encoding, store a mapping from ram::Node to its operation index id. */
     std::unordered_map<const ram::Node*, std::size_t> indexTable;
     /** Points to the current viewContext during the generation.
@@ -354,6 +391,10 @@ private:
     std::unordered_map<std::string, const ram::Relation*> relationMap;
     /** ordering context */
     OrderingContext orderingContext = OrderingContext(*this);
+    /** Slots of the functor batches of scans by the batched operators */
+    std::unordered_map<const ram::UserDefinedOperator*, std::size_t> functorBatchSlots;
+    /** Batched operators of each slot */
+    std::vector<std::vector<const UserDefinedOperator*>> functorBatches;
     /** Reference to the engine instance */
     Engine& engine;
 };
@@ -22,14 +22,17 @@
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/StreamUtil.h"
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iosfwd>
 #include <iterator>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -137,8 +140,39 @@ inline std::ostream& operator<<(std::ostream& out, const Order& order) {
  */
 struct ViewWrapper {
     virtual ~ViewWrapper() = default;
+
+    /**
+     * Seeks the first entry not below the given key, or above it if strict, with
+     * the key and entries in the order of the index. If the entry agrees with the
+     * key on all elements before the given position, its element at the position
+     * is stored in value.
+     */
+    virtual bool seek(const RamDomain* key, std::size_t pos, bool strict, RamDomain& value) = 0;
 };
 
+namespace detail {
+/**
+ * Detects data structures partitioning a range of elements themselves, rather than
+ * relying on the generic partitioning of the range's iterators.
+ */
+template <typename Data, typename Tuple, typename = void>
+struct has_partition_range : std::false_type {};
+
+template <typename Data, typename Tuple>
+struct has_partition_range<Data, Tuple,
+        std::void_t<decltype(std::declval<const Data&>().partitionRange(
+                std::declval<const Tuple&>(), std::size_t(0)))>> : std::true_type {};
+
+/**
+ * Detects data structures which can be cleared while retaining their memory.
+ */
+template <typename Data, typename = void>
+struct has_reset : std::false_type {};
+
+template <typename Data>
+struct has_reset<Data, std::void_t<decltype(std::declval<Data&>().reset())>> : std::true_type {};
+}  // namespace detail
+
 /**
  * An index is an abstraction of a data structure
  */
@@ -190,6 +224,23 @@ public:
             }
             return {data.lower_bound(low, hints), data.upper_bound(high, hints)};
         }
+
+        bool seek(const RamDomain* key, std::size_t pos, bool strict, RamDomain& value) override {
+            Tuple bound;
+            std::copy_n(key, Arity, bound.begin());
+            auto it = strict ? data.upper_bound(bound, hints) : data.lower_bound(bound, hints);
+            if (it == data.end()) {
+                return false;
+            }
+            const auto& entry = *it;
+            for (std::size_t i = 0; i < pos; i++) {
+                if (entry[i] != bound[i]) {
+                    return false;
+                }
+            }
+            value = entry[pos];
+            return true;
+        }
     };
 
 public:
@@ -294,6 +345,13 @@ public:
      */
     std::vector<souffle::range<iterator>> partitionRange(
             const Tuple& low, const Tuple& high, int partitionCount) const {
+        if constexpr (detail::has_partition_range<Data, Tuple>::value) {
+            // the bounds of such data structures are determined by the lower bound only
+            if (cmp(low, high) > 0) {
+                return {};
+            }
+            return data.partitionRange(low, partitionCount);
+        }
         auto ranges = this->range(low, high);
         auto chunks = ranges.partition(partitionCount);
         std::vector<souffle::range<iterator>> res;
@@ -304,12 +362,31 @@ public:
         return res;
     }
 
+    /**
+     * Obtains the number of bytes occupied by this index.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(data) + data.getMemoryUsage();
+    }
+
     /**
      * Clears the content of this index, turning it empty.
      */
     void clear() {
         data.clear();
     }
+
+    /**
+     * Clears the content of this index, retaining its memory for subsequent insertions
+     * if supported by the data structure.
+     */
+    void reset() {
+        if constexpr (detail::has_reset<Data>::value) {
+            data.reset();
+        } else {
+            data.clear();
+        }
+    }
 };
 
 /**
@@ -382,6 +459,11 @@ public:
         souffle::range<iterator> range(const Tuple& /* l */, const Tuple& /* h */) const {
             return {iterator(data), iterator()};
         }
+
+        bool seek(const RamDomain* /* key */, std::size_t /* pos */, bool /* strict */,
+                RamDomain& /* value */) override {
+            return false;
+        }
     };
 
 public:
@@ -436,9 +518,17 @@ public:
         return this->partitionScan(0);
     }
 
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this);
+    }
+
     void clear() {
         data = false;
     }
+
+    void reset() {
+        data = false;
+    }
 };
 
 /**
@@ -25,17 +25,33 @@
 
 #include "interpreter/Util.h"
 #include "ram/Relation.h"
+#include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include <ffi.h>
+
+// Aliases for foreign function interface.
+#if RAM_DOMAIN_SIZE == 64
+#define FFI_RamSigned ffi_type_sint64
+#define FFI_RamUnsigned ffi_type_uint64
+#define FFI_RamFloat ffi_type_double
+#else
+#define FFI_RamSigned ffi_type_sint32
+#define FFI_RamUnsigned ffi_type_uint32
+#define FFI_RamFloat ffi_type_float
+#endif
+
+#define FFI_Symbol ffi_type_pointer
 
 namespace souffle {
 namespace ram {
@@ -71,6 +87,7 @@ struct RelationWrapper;
     FOR_EACH(Expand, ExistenceCheck)\
     FOR_EACH_PROVENANCE(Expand, ProvenanceExistenceCheck)\
     Forward(Constraint)\
+    Forward(FusedConstraint)\
     Forward(TupleOperation)\
     FOR_EACH(Expand, Scan)\
     FOR_EACH(Expand, ParallelScan)\
@@ -81,6 +98,7 @@ struct RelationWrapper;
     FOR_EACH(Expand, IndexIfExists)\
     FOR_EACH(Expand, ParallelIndexIfExists)\
     Forward(UnpackRecord)\
+    Forward(LeapfrogJoin)\
     FOR_EACH(Expand, Aggregate)\
     FOR_EACH(Expand, ParallelAggregate)\
     FOR_EACH(Expand, IndexAggregate)\
@@ -467,9 +485,86 @@ class IntrinsicOperator : public CompoundNode {
 
 /**
  * @class UserDefinedOperator
+ *
+ * The functor is resolved and its call interface is prepared once, when the
+ * node is generated. A functor `f` of a plain (stateless) user-defined
+ * operator may additionally provide the batched variant
+ *
+ *     void souffle_batch_f(size_t n, const void* const* args, void* results);
+ *
+ * where args[i] points to n values of the i-th parameter and results to the
+ * space for n return values, using the same C types as `f` itself. If it
+ * exists and the arguments only depend on the tuples of an enclosing scan,
+ * the scan calls the batched variant once for each block of its tuples (see
+ * Scan::getBatchedFunctors), and the operator reads the result of the current
+ * tuple. Otherwise, `f` is called through libffi.
  */
 class UserDefinedOperator : public CompoundNode {
-    using CompoundNode::CompoundNode;
+public:
+    using BatchFunctor = void (*)(std::size_t, const void* const*, void*);
+
+    UserDefinedOperator(enum NodeType ty, const ram::Node* sdw, VecOwn<Node> children, void (*functor)(),
+            BatchFunctor batchFunctor, std::vector<ffi_type*> argTypes, ffi_type* returnType)
+            : CompoundNode(ty, sdw, std::move(children)), functor(functor), batchFunctor(batchFunctor),
+              argTypes(std::move(argTypes)) {
+        prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, this->argTypes.size(), returnType,
+                this->argTypes.empty() ? nullptr : this->argTypes.data());
+    }
+
+    UserDefinedOperator(const UserDefinedOperator&) = delete;
+    UserDefinedOperator& operator=(const UserDefinedOperator&) = delete;
+
+    /** @brief get the functor, nullptr if it could not be found */
+    void (*getFunctor() const)() {
+        return functor;
+    }
+
+    /** @brief get the batched variant of the functor, nullptr if there is none */
+    BatchFunctor getBatchFunctor() const {
+        return batchFunctor;
+    }
+
+    /** @brief get the prepared call interface of the functor */
+    ffi_cif* getCif() const {
+        return &cif;
+    }
+
+    /** @brief get the status of preparing the call interface */
+    ffi_status getPrepStatus() const {
+        return prepStatus;
+    }
+
+    /** @brief check whether the results are computed in batches by an enclosing scan */
+    bool isBatched() const {
+        return batchSlot != std::numeric_limits<std::size_t>::max();
+    }
+
+    /** @brief get the slot of the functor batch of the enclosing scan in the context */
+    std::size_t getBatchSlot() const {
+        return batchSlot;
+    }
+
+    /** @brief get the position of the results among the functors of the batch */
+    std::size_t getBatchColumn() const {
+        return batchColumn;
+    }
+
+    /** @brief compute the results in batches of the enclosing scan in the given slot */
+    void setBatch(std::size_t slot, std::size_t column) {
+        batchSlot = slot;
+        batchColumn = column;
+    }
+
+private:
+    void (*const functor)();
+    const BatchFunctor batchFunctor;
+    /** Parameter types referenced by the call interface */
+    std::vector<ffi_type*> argTypes;
+    /** Read-only after construction, hence shared by all threads */
+    mutable ffi_cif cif;
+    ffi_status prepStatus;
+    std::size_t batchSlot = std::numeric_limits<std::size_t>::max();
+    std::size_t batchColumn = 0;
 };
 
 /**
@@ -585,6 +680,43 @@ class Constraint : public BinaryNode {
     using BinaryNode::BinaryNode;
 };
 
+/**
+ * @class FusedConstraint
+ * @brief A numeric constraint whose operands are constants or tuple elements.
+ *        The operands are read in place rather than evaluated as child nodes.
+ */
+class FusedConstraint : public Node {
+public:
+    /** @brief An operand is either a constant or an element of a runtime tuple */
+    struct Operand {
+        bool isConstant;
+        RamDomain constant;
+        std::size_t tupleId;
+        std::size_t element;
+    };
+
+    FusedConstraint(
+            enum NodeType ty, const ram::Node* sdw, BinaryConstraintOp op, Operand lhs, Operand rhs)
+            : Node(ty, sdw), op(op), lhs(lhs), rhs(rhs) {}
+
+    BinaryConstraintOp getOperator() const {
+        return op;
+    }
+
+    const Operand& getLhs() const {
+        return lhs;
+    }
+
+    const Operand& getRhs() const {
+        return rhs;
+    }
+
+private:
+    const BinaryConstraintOp op;
+    const Operand lhs;
+    const Operand rhs;
+};
+
 /**
  * @class TupleOperation
  */
@@ -599,6 +731,26 @@ class Scan : public Node, public NestedOperation, public RelationalOperation {
 public:
     Scan(enum NodeType ty, const ram::Node* sdw, RelationHandle* relHandle, Own<Node> nested)
             : Node(ty, sdw), NestedOperation(std::move(nested)), RelationalOperation(relHandle) {}
+
+    /** @brief get the batched functors whose results are computed for blocks of the scanned tuples */
+    const std::vector<const UserDefinedOperator*>& getBatchedFunctors() const {
+        return batchedFunctors;
+    }
+
+    /** @brief get the slot of the results of the batched functors in the context */
+    std::size_t getBatchSlot() const {
+        return batchSlot;
+    }
+
+    /** @brief compute the results of functors in blocks of the scanned tuples */
+    void setBatchedFunctors(std::size_t slot, std::vector<const UserDefinedOperator*> functors) {
+        batchSlot = slot;
+        batchedFunctors = std::move(functors);
+    }
+
+private:
+    std::size_t batchSlot = 0;
+    std::vector<const UserDefinedOperator*> batchedFunctors;
 };
 
 /**
@@ -682,6 +834,37 @@ protected:
     Own<Node> expr;
 };
 
+/**
+ * @class LeapfrogJoin
+ * @brief Joins relations through consecutive views, starting at the view id
+ */
+class LeapfrogJoin : public Node, public NestedOperation, public ViewOperation {
+public:
+    LeapfrogJoin(enum NodeType ty, const ram::Node* sdw, Own<Node> nested, std::size_t viewId,
+            std::vector<std::size_t> positions, std::vector<SuperInstruction> superInsts)
+            : Node(ty, sdw), NestedOperation(std::move(nested)), ViewOperation(viewId),
+              positions(std::move(positions)), superInsts(std::move(superInsts)) {}
+
+    /** @brief get number of joined relations */
+    inline std::size_t getNumRelations() const {
+        return positions.size();
+    }
+
+    /** @brief get position of the join column in the index order of the i-th relation */
+    inline std::size_t getPosition(std::size_t i) const {
+        return positions[i];
+    }
+
+    /** @brief get bounds of the i-th relation in the index order */
+    inline const SuperInstruction& getSuperInst(std::size_t i) const {
+        return superInsts[i];
+    }
+
+protected:
+    const std::vector<std::size_t> positions;
+    const std::vector<SuperInstruction> superInsts;
+};
+
 /**
  * @class Aggregate
  */
@@ -751,8 +934,18 @@ public:
  */
 class Insert : public Node, public SuperOperation, public RelationalOperation {
 public:
-    Insert(enum NodeType ty, const ram::Node* sdw, RelationHandle* relHandle, SuperInstruction superInst)
-            : Node(ty, sdw), SuperOperation(std::move(superInst)), RelationalOperation(relHandle) {}
+    Insert(enum NodeType ty, const ram::Node* sdw, RelationHandle* relHandle, SuperInstruction superInst,
+            bool buffered = false)
+            : Node(ty, sdw), SuperOperation(std::move(superInst)), RelationalOperation(relHandle),
+              buffered(buffered) {}
+
+    /** @brief Whether the tuple is appended to the insert buffer of the context */
+    bool isBuffered() const {
+        return buffered;
+    }
+
+protected:
+    const bool buffered;
 };
 
 /**
@@ -828,8 +1021,16 @@ class DebugInfo : public UnaryNode {
  */
 class Clear : public Node, public RelationalOperation {
 public:
-    Clear(enum NodeType ty, const ram::Node* sdw, RelationHandle* handle)
-            : Node(ty, sdw), RelationalOperation(handle) {}
+    Clear(enum NodeType ty, const ram::Node* sdw, RelationHandle* handle, bool refilled)
+            : Node(ty, sdw), RelationalOperation(handle), refilled(refilled) {}
+
+    /** Whether the relation is refilled by the next iteration of a loop */
+    bool isRefilled() const {
+        return refilled;
+    }
+
+private:
+    const bool refilled;
 };
 
 /**
@@ -63,6 +63,28 @@ public:
         return relation.contains(t.data);
     }
 
+    /** Insert tuples given column by column */
+    void insertColumns(const RamDomain* const* columns, std::size_t n) override {
+        std::vector<RamDomain> t(getArity());
+        for (std::size_t row = 0; row < n; row++) {
+            for (std::size_t i = 0; i < t.size(); i++) {
+                t[i] = columns[i][row];
+            }
+            relation.insert(t.data());
+        }
+    }
+
+    /** Export tuples column by column */
+    std::size_t exportColumns(RamDomain* const* columns, std::size_t n) const override {
+        std::size_t row = 0;
+        for (auto it = relation.begin(); row < n && it != relation.end(); ++it, ++row) {
+            for (std::size_t i = 0; i < getArity(); i++) {
+                columns[i][row] = (*it)[i];
+            }
+        }
+        return row;
+    }
+
     /** Iterator to first tuple */
     iterator begin() const override {
         return RelInterface::iterator(mk<RelInterface::iterator_base>(id, this, relation.begin()));
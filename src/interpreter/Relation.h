@@ -21,6 +21,8 @@
 #include "souffle/RamTypes.h"
 #include "souffle/SouffleInterface.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
@@ -107,6 +109,9 @@ public:
 
     virtual void insert(const RamDomain*) = 0;
 
+    /** Inserts a buffer of consecutive tuples; the buffer is used as scratch space */
+    virtual void insertBatch(std::vector<RamDomain>& data) = 0;
+
     virtual bool contains(const RamDomain*) const = 0;
 
     virtual std::size_t size() const = 0;
@@ -134,6 +139,16 @@ public:
      */
     virtual Order getIndexOrder(std::size_t) const = 0;
 
+    /**
+     * Return the number of indexes.
+     */
+    virtual std::size_t getNumberOfIndexes() const = 0;
+
+    /**
+     * Return the number of bytes occupied by an index.
+     */
+    virtual std::size_t getIndexMemoryUsage(std::size_t) const = 0;
+
     /**
      * Obtains a view on an index of this relation, facilitating hint-supported accesses.
      *
@@ -217,6 +232,40 @@ public:
         insert(constructTuple(data));
     }
 
+    void insertBatch(std::vector<RamDomain>& data) override {
+        if constexpr (Arity == 0) {
+            if (!data.empty()) {
+                insert(Tuple{});
+            }
+        } else {
+            // Sort and deduplicate the tuples in the order of the main index, such that
+            // consecutive insertions hit the same leaves.
+            const Order& order = main->getOrder();
+            std::vector<Tuple> tuples(data.size() / Arity);
+            for (std::size_t i = 0; i < tuples.size(); ++i) {
+                tuples[i] = order.encode(constructTuple(&data[i * Arity]));
+            }
+            std::sort(tuples.begin(), tuples.end());
+            tuples.erase(std::unique(tuples.begin(), tuples.end()), tuples.end());
+
+            // only new tuples have to be added to the secondary indexes
+            std::size_t fresh = 0;
+            for (const auto& tuple : tuples) {
+                Tuple decoded = order.decode(tuple);
+                if (main->insert(decoded)) {
+                    tuples[fresh++] = decoded;
+                }
+            }
+            tuples.resize(fresh);
+            TaskPool::instance().parallelFor(
+                    std::next(indexes.begin()), indexes.end(), [&](auto index) {
+                        for (const auto& tuple : tuples) {
+                            (*index)->insert(tuple);
+                        }
+                    });
+        }
+    }
+
     bool contains(const RamDomain* data) const override {
         return contains(constructTuple(data));
     }
@@ -233,6 +282,14 @@ public:
         return indexes[idx]->getOrder();
     }
 
+    std::size_t getNumberOfIndexes() const override {
+        return indexes.size();
+    }
+
+    std::size_t getIndexMemoryUsage(std::size_t idx) const override {
+        return indexes[idx]->getMemoryUsage();
+    }
+
     class iterator_base : public RelationWrapper::iterator_base {
         iterator iter;
         Order order;
@@ -381,6 +438,15 @@ public:
         }
     }
 
+    /**
+     * Clear all indexes, retaining their memory for the next iteration of a fixpoint
+     */
+    void __reset() {
+        for (auto& idx : indexes) {
+            idx->reset();
+        }
+    }
+
     /**
      * Check if a tuple exists in relation
      */
@@ -287,4 +287,72 @@ TEST(Reordering, Iteration) {
     }
 }
 
+TEST(InsertBatch, Indexes) {
+    // create a binary relation with a secondary index of order {1, 0}
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(2);
+    SearchSignature secondCheck(2);
+    secondCheck[1] = AttributeConstraint::Equal;
+    SearchSet searches = {existenceCheck, secondCheck};
+    LexOrder mainOrder = {0, 1};
+    LexOrder secondOrder = {1, 0};
+    OrderCollection orders = {mainOrder, secondOrder};
+    mapping.insert({existenceCheck, mainOrder});
+    mapping.insert({secondCheck, secondOrder});
+    IndexCluster indexSelection(mapping, searches, orders);
+
+    Relation<2, interpreter::Btree> rel(0, "test", indexSelection);
+    rel.insert(souffle::Tuple<RamDomain, 2>{3, 4});
+
+    // the batch contains duplicates and a tuple of the relation
+    std::vector<RamDomain> batch = {5, 6, 1, 2, 3, 4, 1, 2};
+    rel.insertBatch(batch);
+    EXPECT_EQ(3, rel.size());
+    EXPECT_TRUE(rel.contains(souffle::Tuple<RamDomain, 2>{1, 2}));
+    EXPECT_TRUE(rel.contains(souffle::Tuple<RamDomain, 2>{5, 6}));
+
+    // the secondary index holds the encoded tuples
+    souffle::Tuple<RamDomain, 2> encoded{2, 1};
+    EXPECT_TRUE(rel.contains(1, encoded, encoded));
+    encoded = {6, 5};
+    EXPECT_TRUE(rel.contains(1, encoded, encoded));
+}
+
+TEST(Reset, Indexes) {
+    // create a binary relation with a secondary index of order {1, 0}
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(2);
+    SearchSignature secondCheck(2);
+    secondCheck[1] = AttributeConstraint::Equal;
+    SearchSet searches = {existenceCheck, secondCheck};
+    LexOrder mainOrder = {0, 1};
+    LexOrder secondOrder = {1, 0};
+    OrderCollection orders = {mainOrder, secondOrder};
+    mapping.insert({existenceCheck, mainOrder});
+    mapping.insert({secondCheck, secondOrder});
+    IndexCluster indexSelection(mapping, searches, orders);
+
+    Relation<2, interpreter::Btree> rel(0, "test", indexSelection);
+    for (RamDomain i = 0; i < 1000; i++) {
+        rel.insert(souffle::Tuple<RamDomain, 2>{i, i + 1});
+    }
+    std::size_t memory = rel.getIndexMemoryUsage(0) + rel.getIndexMemoryUsage(1);
+
+    // the indexes are emptied but retain their memory
+    rel.__reset();
+    EXPECT_TRUE(rel.empty());
+    EXPECT_FALSE(rel.contains(souffle::Tuple<RamDomain, 2>{1, 2}));
+    EXPECT_EQ(memory, rel.getIndexMemoryUsage(0) + rel.getIndexMemoryUsage(1));
+
+    rel.insert(souffle::Tuple<RamDomain, 2>{1, 2});
+    EXPECT_EQ(1, rel.size());
+    souffle::Tuple<RamDomain, 2> encoded{2, 1};
+    EXPECT_TRUE(rel.contains(1, encoded, encoded));
+
+    // purging releases the memory
+    rel.__purge();
+    EXPECT_TRUE(rel.empty());
+    EXPECT_LT(rel.getIndexMemoryUsage(0) + rel.getIndexMemoryUsage(1), memory);
+}
+
 }  // namespace souffle::interpreter::test
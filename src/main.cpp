@@ -14,6 +14,7 @@
  *
  ***********************************************************************/
 
+#include "CompilationCache.h"
 #include "Global.h"
 #include "ast/Node.h"
 #include "ast/Program.h"
@@ -43,6 +44,7 @@
 #include "ast/transform/PartitionBodyLiterals.h"
 #include "ast/transform/Pipeline.h"
 #include "ast/transform/PragmaChecker.h"
+#include "ast/transform/PreparedQuery.h"
 #include "ast/transform/ReduceExistentials.h"
 #include "ast/transform/RemoveBooleanConstraints.h"
 #include "ast/transform/RemoveEmptyRelations.h"
@@ -64,12 +66,14 @@
 #include "ast2ram/seminaive/UnitTranslator.h"
 #include "ast2ram/utility/TranslatorContext.h"
 #include "config.h"
+#include "interpreter/CompiledTier.h"
 #include "interpreter/Engine.h"
 #include "interpreter/ProgInterface.h"
 #include "parser/ParserDriver.h"
 #include "ram/Node.h"
 #include "ram/Program.h"
 #include "ram/TranslationUnit.h"
+#include "ram/analysis/DataStructureAdvisor.h"
 #include "ram/transform/CollapseFilters.h"
 #include "ram/transform/Conditional.h"
 #include "ram/transform/EliminateDuplicates.h"
@@ -78,9 +82,11 @@
 #include "ram/transform/HoistConditions.h"
 #include "ram/transform/IfConversion.h"
 #include "ram/transform/IfExistsConversion.h"
+#include "ram/transform/LeapfrogFallback.h"
 #include "ram/transform/Loop.h"
 #include "ram/transform/MakeIndex.h"
 #include "ram/transform/Parallel.h"
+#include "ram/transform/RelaxIndex.h"
 #include "ram/transform/ReorderConditions.h"
 #include "ram/transform/ReorderFilterBreak.h"
 #include "ram/transform/ReportIndex.h"
@@ -118,9 +124,9 @@
 namespace souffle {
 
 /**
- * Executes a binary file.
+ * Executes a binary file. Unless it is kept, a temporary binary is removed afterwards.
  */
-void executeBinary(const std::string& binaryFilename) {
+void executeBinary(const std::string& binaryFilename, bool keep = false) {
     assert(!binaryFilename.empty() && "binary filename cannot be blank");
 
     // check whether the executable exists
@@ -147,7 +153,7 @@ void executeBinary(const std::string& binaryFilename) {
 
     int exitCode = system(exePath.c_str());
 
-    if (Global::config().get("dl-program").empty()) {
+    if (Global::config().get("dl-program").empty() && !keep) {
         remove(binaryFilename.c_str());
         remove((binaryFilename + ".cpp").c_str());
     }
@@ -159,9 +165,9 @@ void executeBinary(const std::string& binaryFilename) {
 }
 
 /**
- * Compiles the given source file to a binary file.
+ * Completes the command compiling the given source file with the configured libraries.
  */
-void compileToBinary(std::string compileCmd, const std::string& sourceFilename) {
+std::string compileCommand(std::string compileCmd, const std::string& sourceFilename) {
     // add source code
     compileCmd += ' ';
     for (const std::string& path : splitString(Global::config().get("library-dir"), ' ')) {
@@ -180,13 +186,50 @@ void compileToBinary(std::string compileCmd, const std::string& sourceFilename)
     }
 
     compileCmd += sourceFilename;
+    return compileCmd;
+}
 
+/**
+ * Compiles the given source file to a binary file.
+ */
+void compileToBinary(const std::string& compileCmd, const std::string& sourceFilename) {
     // run executable
-    if (system(compileCmd.c_str()) != 0) {
+    if (system(compileCommand(compileCmd, sourceFilename).c_str()) != 0) {
         throw std::invalid_argument("failed to compile C++ source <" + sourceFilename + ">");
     }
 }
 
+/**
+ * Synthesises the program and starts compiling it into a shared library, which
+ * takes over from the interpreter in tiered execution.
+ */
+Own<interpreter::CompiledTier> startCompiledTier(
+        ram::TranslationUnit& ramTranslationUnit, const std::string& compileCmd) {
+    auto synthesiser = mk<synthesiser::Synthesiser>(ramTranslationUnit);
+
+    // the temporary file only reserves a base name
+    std::string baseFilename = tempFile();
+    std::remove(baseFilename.c_str());
+    std::string sourceFilename = baseFilename + ".cpp";
+
+    bool withSharedLibrary;
+    {
+        std::ofstream os{sourceFilename};
+        synthesiser->generateCode(os, identifier(simpleName(baseFilename)), withSharedLibrary);
+    }
+    if (withSharedLibrary) {
+        if (!Global::config().has("libraries")) {
+            Global::config().set("libraries", "functors");
+        }
+        if (!Global::config().has("library-dir")) {
+            Global::config().set("library-dir", ".");
+        }
+    }
+
+    return mk<interpreter::CompiledTier>(compileCommand(compileCmd + " -S", sourceFilename),
+            sourceFilename, baseFilename + ".so", synthesiser->getSymbols());
+}
+
 int main(int argc, char** argv) {
     /* Time taking for overall runtime */
     auto souffle_start = std::chrono::high_resolution_clock::now();
@@ -251,11 +294,37 @@ int main(int argc, char** argv) {
                 {"pragma", 'P', "OPTIONS", "", false, "Set pragma options."},
                 {"provenance", 't', "[ none | explain | explore ]", "", false,
                         "Enable provenance instrumentation and interaction."},
+                {"stream-output", '\7', "", "", false,
+                        "Write output relations in the background as soon as they are final, and "
+                        "release them unless they are read afterwards."},
+                {"tiered", '\10', "", "", false,
+                        "Start interpreting right away while the program is compiled in the background, "
+                        "and continue with the compiled program at the next stratum once it is ready."},
+                {"tiered-wait", '\17', "N", "", false,
+                        "In tiered execution, wait for the compiled program before stratum <N> at the "
+                        "latest."},
+                {"cache-dir", '\11', "DIR", "", false,
+                        "Cache compiled programs in <DIR> and run a cached program instead of compiling "
+                        "it again."},
+                {"cache-size", '\12', "MB", "1024", false,
+                        "Limit the size of the compilation cache to <MB> megabytes."},
+                {"huge-pages", '\13', "", "", false,
+                        "Back the indexes of large relations by transparent huge pages."},
+                {"numa", '\14', "", "", false,
+                        "Pin threads to cores spread over the NUMA nodes, and interleave the indexes of "
+                        "large relations across the nodes."},
+                {"prepared-query", '\15', "QUERIES", "", false,
+                        "Prepare demand-driven queries <RELATION>:<ADORNMENT>,... of the relations for "
+                        "the attributes bound by the adornment, e.g. path:bf, answered by subroutines."},
+                {"leapfrog", '\16', "[ auto | all | none ]", "", false,
+                        "Evaluate the joins of rules variable by variable with leapfrog joins: for "
+                        "cyclic rule bodies if evaluated by a single thread (auto, the default), for "
+                        "all rules joining several relations (all), or never (none)."},
                 {"verbose", 'v', "", "", false, "Verbose output."},
                 {"version", '\3', "", "", false, "Version."},
                 {"show", '\4',
-                        "[ parse-errors | precedence-graph | scc-graph | transformed-datalog | "
-                        "transformed-ram | type-analysis ]",
+                        "[ data-structures | parse-errors | precedence-graph | scc-graph | "
+                        "transformed-datalog | transformed-ram | type-analysis ]",
                         "", false, "Print selected program information."},
                 {"parse-errors", '\5', "", "", false, "Show parsing errors, if any, then exit."},
                 {"help", 'h', "", "", false, "Display this help message."},
@@ -378,6 +447,17 @@ int main(int argc, char** argv) {
         if (Global::config().has("live-profile") && !Global::config().has("profile")) {
             Global::config().set("profile");
         }
+
+        /* check the size of the compilation cache */
+        if (Global::config().has("cache-dir") && !isNumber(Global::config().get("cache-size").c_str())) {
+            throw std::runtime_error("--cache-size may only be set to a number of megabytes.");
+        }
+
+        /* check the leapfrog join mode */
+        if (Global::config().has("leapfrog") && !Global::config().has("leapfrog", "auto") &&
+                !Global::config().has("leapfrog", "all") && !Global::config().has("leapfrog", "none")) {
+            throw std::runtime_error("--leapfrog may only be set to auto, all or none.");
+        }
     } catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         exit(EXIT_FAILURE);
@@ -414,6 +494,46 @@ int main(int argc, char** argv) {
     cmd += " " + Global::config().get("");
     FILE* in = popen(cmd.c_str(), "r");
 
+    // ------- compilation cache -------------
+
+    // only programs which are compiled and run are cached
+    Own<CompilationCache> cache;
+    std::string cacheKey;
+    std::string source;
+    if (Global::config().has("cache-dir") && Global::config().has("compile") &&
+            !Global::config().has("dl-program") && !Global::config().has("generate") &&
+            !Global::config().has("swig")) {
+        try {
+            cache = mk<CompilationCache>(Global::config().get("cache-dir"),
+                    std::stoull(Global::config().get("cache-size")) << 20);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        // the key covers the pre-processed program, hence it is read ahead of parsing
+        char buffer[1 << 16];
+        std::size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            source.append(buffer, length);
+        }
+        if (pclose(in) == -1) {
+            perror(nullptr);
+            throw std::runtime_error("failed to close pre-processor pipe");
+        }
+        cacheKey = CompilationCache::computeKey(source);
+
+        std::string cachedBinary = cache->lookup(cacheKey);
+        if (!cachedBinary.empty()) {
+            if (Global::config().has("verbose")) {
+                std::cout << "Running cached program " << cachedBinary << "\n";
+            }
+            executeBinary(cachedBinary, true);
+            return 0;
+        }
+        in = source.empty() ? nullptr : fmemopen(source.data(), source.size(), "r");
+    }
+
     /* Time taking for parsing */
     auto parser_start = std::chrono::high_resolution_clock::now();
 
@@ -423,11 +543,16 @@ int main(int argc, char** argv) {
     ErrorReport errReport(Global::config().has("no-warn"));
     DebugReport debugReport;
     Own<ast::TranslationUnit> astTranslationUnit =
-            ParserDriver::parseTranslationUnit("<stdin>", in, errReport, debugReport);
-
-    // close input pipe
-    int preprocessor_status = pclose(in);
-    if (preprocessor_status == -1) {
+            cache != nullptr && in == nullptr
+                    ? ParserDriver::parseTranslationUnit(source, errReport, debugReport)
+                    : ParserDriver::parseTranslationUnit("<stdin>", in, errReport, debugReport);
+
+    // close input pipe, unless its output has been read ahead for the cache
+    if (cache != nullptr) {
+        if (in != nullptr) {
+            fclose(in);
+        }
+    } else if (pclose(in) == -1) {
         perror(nullptr);
         throw std::runtime_error("failed to close pre-processor pipe");
     }
@@ -490,7 +615,8 @@ int main(int argc, char** argv) {
             mk<ast::transform::FixpointTransformer>(mk<ast::transform::PipelineTransformer>(
                     mk<ast::transform::ResolveAnonymousRecordAliasesTransformer>(),
                     mk<ast::transform::FoldAnonymousRecords>())),
-            mk<ast::transform::SemanticChecker>(), mk<ast::transform::GroundWitnessesTransformer>(),
+            mk<ast::transform::SemanticChecker>(), mk<ast::transform::PreparedQueryTransformer>(),
+            mk<ast::transform::GroundWitnessesTransformer>(),
             mk<ast::transform::UniqueAggregationVariablesTransformer>(),
             mk<ast::transform::MaterializeSingletonAggregationTransformer>(),
             mk<ast::transform::FixpointTransformer>(
@@ -611,6 +737,8 @@ int main(int argc, char** argv) {
                 mk<ExpandFilterTransformer>(), mk<HoistConditionsTransformer>(),
                 mk<CollapseFiltersTransformer>(), mk<EliminateDuplicatesTransformer>(),
                 mk<ReorderConditionsTransformer>(), mk<LoopTransformer>(mk<ReorderFilterBreak>()),
+                mk<LoopTransformer>(mk<RelaxIndexTransformer>()),
+                mk<LoopTransformer>(mk<LeapfrogFallbackTransformer>()), mk<CollapseFiltersTransformer>(),
                 mk<ConditionalTransformer>(
                         // job count of 0 means all cores are used.
                         []() -> bool { return std::stoi(Global::config().get("jobs")) != 1; },
@@ -630,6 +758,12 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    // Output the data structures chosen from the profile, and why, and return
+    if (Global::config().get("show") == "data-structures") {
+        ramTranslationUnit->getAnalysis<ram::analysis::DataStructureAdvisorAnalysis>()->print(std::cout);
+        return 0;
+    }
+
     try {
         if (!Global::config().has("compile") && !Global::config().has("dl-program") &&
                 !Global::config().has("generate") && !Global::config().has("swig")) {
@@ -641,8 +775,22 @@ int main(int argc, char** argv) {
                 profiler = std::thread([]() { profile::Tui().runProf(); });
             }
 
+            // compile in the background for tiered execution
+            Own<interpreter::CompiledTier> compiledTier;
+            if (Global::config().has("tiered") && !Global::config().has("profile") &&
+                    !Global::config().has("provenance")) {
+                auto cmd = findTool("souffle-compile", souffleExecutable, ".");
+                if (!isExecutable(cmd)) {
+                    throw std::runtime_error("failed to locate souffle-compile");
+                }
+                compiledTier = startCompiledTier(*ramTranslationUnit, cmd);
+            }
+
             // configure and execute interpreter
             Own<interpreter::Engine> interpreter(mk<interpreter::Engine>(*ramTranslationUnit));
+            if (compiledTier != nullptr) {
+                interpreter->setCompiledTier(*compiledTier);
+            }
             interpreter->executeMain();
             // If the profiler was started, join back here once it exits.
             if (profiler.joinable()) {
@@ -721,6 +869,9 @@ int main(int argc, char** argv) {
                 compileToBinary(compileCmd, sourceFilename);
             } else if (Global::config().has("compile")) {
                 compileToBinary(findCompileCmd(), sourceFilename);
+                if (cache != nullptr) {
+                    cache->store(cacheKey, baseFilename);
+                }
                 /* Report overall run-time in verbose mode */
                 // run compiled C++ program if requested.
                 if (!Global::config().has("dl-program") && !Global::config().has("swig")) {
@@ -123,6 +123,7 @@ WS [ \t\r\v\f]
 "magic"                               { return yy::parser::make_MAGIC_QUALIFIER(yylloc); }
 "brie"                                { return yy::parser::make_BRIE_QUALIFIER(yylloc); }
 "btree"                               { return yy::parser::make_BTREE_QUALIFIER(yylloc); }
+"hash"                                { return yy::parser::make_HASH_QUALIFIER(yylloc); }
 "min"                                 { return yy::parser::make_MIN(yylloc); }
 "max"                                 { return yy::parser::make_MAX(yylloc); }
 "as"                                  { return yy::parser::make_AS(yylloc); }
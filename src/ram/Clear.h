@@ -32,27 +32,43 @@ namespace souffle::ram {
  * @class Clear
  * @brief Delete tuples of a relation
  *
- * This retains the target relation, but cleans its content
+ * This retains the target relation, but cleans its content. The memory of a
+ * relation that is refilled by the next iteration of a loop is kept for
+ * reuse, otherwise it is released.
  *
  * For example:
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
  * CLEAR A
+ * CLEAR @new_B REFILLED
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 
 class Clear : public RelationStatement {
 public:
-    Clear(std::string rel) : RelationStatement(rel) {}
+    Clear(std::string rel, bool refilled = false) : RelationStatement(rel), refilled(refilled) {}
+
+    /** @brief Whether the relation is refilled by the next iteration of a loop */
+    bool isRefilled() const {
+        return refilled;
+    }
 
     Clear* cloning() const override {
-        return new Clear(relation);
+        return new Clear(relation, refilled);
     }
 
 protected:
     void print(std::ostream& os, int tabpos) const override {
         os << times(" ", tabpos);
-        os << "CLEAR " << relation << std::endl;
+        os << "CLEAR " << relation << (refilled ? " REFILLED" : "") << std::endl;
     }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<Clear>(node);
+        return RelationStatement::equal(other) && refilled == other.refilled;
+    }
+
+    /** Whether the relation is refilled by the next iteration of a loop */
+    const bool refilled;
 };
 
 }  // namespace souffle::ram
@@ -42,11 +42,17 @@ namespace souffle::ram {
  *   ...
  *     INSERT (t0.a, t0.b, t0.c) INTO @new_X
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * A buffered insert of a parallel query appends the tuple to a buffer
+ * of the executing thread instead. The buffers are sorted, deduplicated
+ * and merged into the target relation when the query has finished, which
+ * avoids the contention of many threads inserting into the same nodes of
+ * the target relation.
  */
 class Insert : public Operation {
 public:
-    Insert(std::string rel, VecOwn<Expression> expressions)
-            : relation(std::move(rel)), expressions(std::move(expressions)) {
+    Insert(std::string rel, VecOwn<Expression> expressions, bool buffered = false)
+            : relation(std::move(rel)), expressions(std::move(expressions)), buffered(buffered) {
         for (auto const& expr : expressions) {
             assert(expr != nullptr && "Expression is a null-pointer");
         }
@@ -62,6 +68,11 @@ public:
         return toPtrVector(expressions);
     }
 
+    /** @brief Whether the tuple is inserted via a thread-local buffer */
+    bool isBuffered() const {
+        return buffered;
+    }
+
     std::vector<const Node*> getChildNodes() const override {
         std::vector<const Node*> res;
         for (const auto& expr : expressions) {
@@ -75,7 +86,7 @@ public:
         for (auto& expr : expressions) {
             newValues.emplace_back(expr->cloning());
         }
-        return new Insert(relation, std::move(newValues));
+        return new Insert(relation, std::move(newValues), buffered);
     }
 
     void apply(const NodeMapper& map) override {
@@ -87,13 +98,14 @@ public:
 protected:
     void print(std::ostream& os, int tabpos) const override {
         os << times(" ", tabpos);
-        os << "INSERT (" << join(expressions, ", ", print_deref<Own<Expression>>()) << ") INTO " << relation
-           << std::endl;
+        os << (buffered ? "BUFFERED INSERT (" : "INSERT (")
+           << join(expressions, ", ", print_deref<Own<Expression>>()) << ") INTO " << relation << std::endl;
     }
 
     bool equal(const Node& node) const override {
         const auto& other = asAssert<Insert>(node);
-        return relation == other.relation && equal_targets(expressions, other.expressions);
+        return relation == other.relation && equal_targets(expressions, other.expressions) &&
+               buffered == other.buffered;
     }
 
     /** Relation name */
@@ -101,6 +113,9 @@ protected:
 
     /* Arguments of insert operation */
     VecOwn<Expression> expressions;
+
+    /** Insert via a thread-local buffer */
+    bool buffered;
 };
 
 }  // namespace souffle::ram
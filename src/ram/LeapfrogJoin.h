@@ -0,0 +1,178 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LeapfrogJoin.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Expression.h"
+#include "ram/NestedOperation.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/TupleOperation.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class LeapfrogJoin
+ * @brief Enumerate the values of a variable shared by several relations
+ *
+ * Binds the single element of its tuple to each value v such that every
+ * relation contains a tuple with v in its join column that matches the
+ * pattern of the relation, i.e., the values bound by outer operations. The
+ * values are found by a leapfrog join, seeking in the index of each relation
+ * ordered by the pattern followed by the join column. A nest of leapfrog joins,
+ * one per variable, evaluates a multi-way join in worst-case optimal time,
+ * whereas nested loops over the relations may produce intermediate results
+ * beyond the size of the output for cyclic joins.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *   LEAPFROG t1.0 IN edge(t0.0,t1.0) AND edge(t1.0,_)
+ *   ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class LeapfrogJoin : public TupleOperation {
+public:
+    LeapfrogJoin(std::vector<std::string> relations, std::vector<VecOwn<Expression>> patterns,
+            std::vector<std::size_t> columns, int ident, Own<Operation> nested, std::string profileText = "")
+            : TupleOperation(ident, std::move(nested), std::move(profileText)),
+              relations(std::move(relations)), patterns(std::move(patterns)), columns(std::move(columns)) {
+        assert(this->relations.size() == this->patterns.size() && "Component mismatch");
+        assert(this->relations.size() == this->columns.size() && "Component mismatch");
+        assert(!this->relations.empty() && "No relation to join");
+        for (std::size_t i = 0; i < this->patterns.size(); i++) {
+            assert(this->columns[i] < this->patterns[i].size() && "Join column out of range");
+            assert(allValidPtrs(this->patterns[i]));
+            assert(isUndefValue(this->patterns[i][this->columns[i]].get()) && "Join column is bound");
+        }
+    }
+
+    /** @brief Get number of joined relations */
+    std::size_t getNumRelations() const {
+        return relations.size();
+    }
+
+    /** @brief Get i-th joined relation */
+    const std::string& getRelation(std::size_t i) const {
+        return relations.at(i);
+    }
+
+    /**
+     * @brief Get pattern of the i-th joined relation
+     *
+     * The pattern holds the value of each bound attribute, and is undefined
+     * for the join column and all unbound attributes.
+     */
+    std::vector<Expression*> getPattern(std::size_t i) const {
+        return toPtrVector(patterns.at(i));
+    }
+
+    /** @brief Get join column of the i-th joined relation */
+    std::size_t getColumn(std::size_t i) const {
+        return columns.at(i);
+    }
+
+    std::vector<const Node*> getChildNodes() const override {
+        auto res = TupleOperation::getChildNodes();
+        for (const auto& pattern : patterns) {
+            for (const auto& value : pattern) {
+                res.push_back(value.get());
+            }
+        }
+        return res;
+    }
+
+    LeapfrogJoin* cloning() const override {
+        std::vector<VecOwn<Expression>> resPatterns;
+        for (const auto& pattern : patterns) {
+            resPatterns.push_back(clone(pattern));
+        }
+        return new LeapfrogJoin(relations, std::move(resPatterns), columns, getTupleId(),
+                clone(getOperation()), getProfileText());
+    }
+
+    void apply(const NodeMapper& map) override {
+        TupleOperation::apply(map);
+        for (auto& pattern : patterns) {
+            for (auto& value : pattern) {
+                value = map(std::move(value));
+            }
+        }
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "LEAPFROG t" << getTupleId() << ".0 IN ";
+        for (std::size_t i = 0; i < relations.size(); i++) {
+            if (i > 0) {
+                os << " AND ";
+            }
+            os << relations[i] << "(";
+            for (std::size_t j = 0; j < patterns[i].size(); j++) {
+                if (j > 0) {
+                    os << ",";
+                }
+                if (j == columns[i]) {
+                    os << "t" << getTupleId() << ".0";
+                } else if (isUndefValue(patterns[i][j].get())) {
+                    os << "_";
+                } else {
+                    os << *patterns[i][j];
+                }
+            }
+            os << ")";
+        }
+        os << std::endl;
+        NestedOperation::print(os, tabpos + 1);
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<LeapfrogJoin>(node);
+        if (!TupleOperation::equal(other) || relations != other.relations || columns != other.columns) {
+            return false;
+        }
+        for (std::size_t i = 0; i < patterns.size(); i++) {
+            if (!equal_targets(patterns[i], other.patterns[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Joined relations */
+    const std::vector<std::string> relations;
+
+    /** Pattern of each joined relation */
+    std::vector<VecOwn<Expression>> patterns;
+
+    /** Join column of each joined relation */
+    const std::vector<std::size_t> columns;
+};
+
+}  // namespace souffle::ram
@@ -0,0 +1,306 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file DataStructureAdvisor.cpp
+ *
+ * Implementation of the data-structure advisor.
+ *
+ ***********************************************************************/
+
+#include "ram/analysis/DataStructureAdvisor.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/IndexOperation.h"
+#include "ram/Insert.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/RelationOperation.h"
+#include "ram/Swap.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/analysis/Index.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/RamTypes.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/profile/Relation.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace souffle::ram::analysis {
+
+namespace {
+
+/** Relations with at least this many tuples are considered large */
+constexpr std::size_t largeRelation = 100000;
+
+/** Default number of bytes of a B-tree node */
+constexpr std::size_t defaultBlockSize = 256;
+
+/** Get the relation whose semi-naive evaluation uses the given temporary relation */
+std::string getBaseName(const std::string& name) {
+    static const std::vector<std::string> prefixes = {"@delta_", "@new_"};
+    for (const auto& prefix : prefixes) {
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            return name.substr(prefix.size());
+        }
+    }
+    return name;
+}
+
+/** Check whether an expression is the given element of a tuple */
+bool isElement(const Expression* expr, int tupleId, std::size_t element) {
+    const auto* tupleElement = as<TupleElement>(expr);
+    return tupleElement != nullptr && tupleElement->getTupleId() == tupleId &&
+           tupleElement->getElement() == element;
+}
+
+}  // namespace
+
+void DataStructureAdvisorAnalysis::run(const TranslationUnit& translationUnit) {
+    const auto* indexAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+
+    auto run = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    profiled = Global::config().has("profile-use") && !Global::config().has("provenance");
+    if (profiled) {
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+        findEquivalences(translationUnit);
+    }
+
+    // advise the relations themselves first, temporary relations follow them
+    const auto relations = translationUnit.getProgram().getRelations();
+    for (const auto* rel : relations) {
+        if (getBaseName(rel->getName()) != rel->getName()) {
+            continue;
+        }
+        DataStructure& dataStructure = dataStructures[rel->getName()];
+        dataStructure.representation = rel->getRepresentation();
+        if (indexAnalysis->isHashRelation(rel->getName())) {
+            dataStructure.representation = RelationRepresentation::HASH;
+            dataStructure.reasons.push_back("hashed by the index analysis, all searches are equalities");
+        } else if (profiled) {
+            dataStructure = advise(translationUnit, *rel, *run);
+        }
+    }
+    for (const auto* rel : relations) {
+        const std::string base = getBaseName(rel->getName());
+        if (base != rel->getName()) {
+            DataStructure dataStructure;
+            dataStructure.representation = rel->getRepresentation();
+            if (dataStructures.count(base) > 0) {
+                dataStructure = dataStructures.at(base);
+                dataStructure.reasons = {"shares the data structure of " + base};
+            }
+            dataStructures[rel->getName()] = dataStructure;
+        }
+    }
+
+    // swapped relations must share their data structure
+    visit(translationUnit.getProgram(), [&](const Swap& swap) {
+        auto& first = dataStructures[swap.getFirstRelation()];
+        auto& second = dataStructures[swap.getSecondRelation()];
+        if (first.representation != second.representation || first.blockSize != second.blockSize ||
+                first.linearSearch != second.linearSearch) {
+            first.representation = second.representation = RelationRepresentation::DEFAULT;
+            first.blockSize = second.blockSize = defaultBlockSize;
+            first.linearSearch = second.linearSearch = false;
+        }
+    });
+}
+
+DataStructure DataStructureAdvisorAnalysis::advise(
+        const TranslationUnit& translationUnit, const Relation& rel, const profile::ProgramRun& run) const {
+    const auto* indexAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+    const std::string& name = rel.getName();
+    const std::size_t arity = rel.getArity();
+
+    DataStructure dataStructure;
+    dataStructure.representation = rel.getRepresentation();
+    auto& reasons = dataStructure.reasons;
+
+    if (rel.isNullary()) {
+        reasons.push_back("nullary relations hold a flag only");
+        return dataStructure;
+    }
+    if (equivalences.count(name) > 0) {
+        reasons.push_back("its rules close it under symmetry and transitivity, consider eqrel if it is "
+                          "reflexive as well");
+    }
+
+    const auto* profiledRel = run.getRelation(name);
+    if (profiledRel == nullptr) {
+        reasons.push_back("not in the profile");
+        return dataStructure;
+    }
+
+    // observations of the profiled run
+    const std::size_t inserts = profiledRel->size();
+    const std::size_t reads = profiledRel->getReads();
+    const std::size_t tupleBytes = arity * sizeof(RamDomain);
+    std::size_t memory = 0;
+    for (const auto& stratum : profiledRel->getMemory()) {
+        memory = std::max(memory, profiledRel->getMemory(stratum.first));
+    }
+    std::stringstream observed;
+    observed << inserts << " tuples inserted, ";
+    if (reads > 0) {
+        observed << reads << " read";
+    } else {
+        observed << "reads not profiled (--profile-frequency)";
+    }
+    if (memory > 0 && inserts > 0) {
+        observed << ", " << memory / inserts << " bytes per tuple for " << tupleBytes << " bytes of data";
+    }
+    reasons.push_back(observed.str());
+
+    const auto indexSelection = indexAnalysis->getIndexSelection(name);
+    const std::size_t numOrders = indexSelection.getAllOrders().size();
+    bool equalitiesOnly = true;
+    for (const auto& search : indexSelection.getSearches()) {
+        for (std::size_t i = 0; i < search.arity(); i++) {
+            equalitiesOnly = equalitiesOnly && search[i] != AttributeConstraint::Inequal;
+        }
+    }
+    const bool large = inserts >= largeRelation;
+    const bool insertHeavy = reads > 0 && reads < inserts;
+    const bool lookupHeavy = reads > inserts;
+
+    if (rel.getRepresentation() != RelationRepresentation::DEFAULT) {
+        reasons.push_back("representation " + toString(rel.getRepresentation()) + " annotated");
+    } else if (large && arity >= 2 && insertHeavy && numOrders == 1 && equalitiesOnly) {
+        dataStructure.representation = RelationRepresentation::BRIE;
+        reasons.push_back("brie: large and inserted into more often than read, and its searches bind "
+                          "prefixes of a single order, which one trie shares among tuples");
+        return dataStructure;
+    } else {
+        std::stringstream why;
+        why << "btree: ";
+        if (!large) {
+            why << "fewer than " << largeRelation << " tuples";
+        } else if (arity < 2) {
+            why << "unary tuples share no prefixes";
+        } else if (!insertHeavy) {
+            why << "read at least as often as inserted into";
+        } else if (numOrders != 1) {
+            why << "searched in " << numOrders << " orders";
+        } else {
+            why << "searched by inequalities";
+        }
+        reasons.push_back(why.str());
+    }
+
+    // tune the nodes of B-trees, which indirect relations of high arity do not use
+    const auto representation = rel.getRepresentation();
+    if (representation != RelationRepresentation::BTREE &&
+            (representation != RelationRepresentation::DEFAULT || arity > 6)) {
+        return dataStructure;
+    }
+    std::size_t blockSize = defaultBlockSize;
+    while (blockSize / tupleBytes < 8) {
+        blockSize *= 2;
+    }
+    if (blockSize != defaultBlockSize) {
+        reasons.push_back(toString(blockSize) + " bytes per node to hold at least 8 tuples");
+    }
+    if (large && lookupHeavy) {
+        blockSize *= 2;
+        reasons.push_back(toString(blockSize) + " bytes per node to lower the tree for frequent lookups");
+    }
+    dataStructure.blockSize = blockSize;
+    dataStructure.linearSearch = blockSize / tupleBytes <= 16;
+    if (dataStructure.linearSearch) {
+        reasons.push_back("linear search in nodes of at most 16 tuples");
+    }
+    return dataStructure;
+}
+
+void DataStructureAdvisorAnalysis::findEquivalences(const TranslationUnit& translationUnit) {
+    std::set<std::string> symmetric;
+    std::set<std::string> transitive;
+    visit(translationUnit.getProgram(), [&](const Query& query) {
+        // tuple identifiers are unique within a query
+        std::map<int, const RelationOperation*> tuples;
+        visit(query, [&](const RelationOperation& operation) {
+            tuples[operation.getTupleId()] = &operation;
+        });
+        auto relationOf = [&](const Expression* expr) -> const RelationOperation* {
+            const auto* element = as<TupleElement>(expr);
+            if (element == nullptr || tuples.count(element->getTupleId()) == 0) {
+                return nullptr;
+            }
+            return tuples.at(element->getTupleId());
+        };
+
+        visit(query, [&](const Insert& insert) {
+            const std::string name = getBaseName(insert.getRelation());
+            const auto values = insert.getValues();
+            if (values.size() != 2) {
+                return;
+            }
+            const auto* first = relationOf(values[0]);
+            const auto* second = relationOf(values[1]);
+            if (first == nullptr || second == nullptr || getBaseName(first->getRelation()) != name ||
+                    getBaseName(second->getRelation()) != name) {
+                return;
+            }
+            const int x = first->getTupleId();
+            const int y = second->getTupleId();
+
+            // r(x, y) :- r(y, x).
+            if (x == y && isElement(values[0], x, 1) && isElement(values[1], x, 0)) {
+                symmetric.insert(name);
+            }
+
+            // r(x, z) :- r(x, y), r(y, z).
+            const auto* inner = as<IndexOperation>(second);
+            if (x != y && isElement(values[0], x, 0) && isElement(values[1], y, 1) && inner != nullptr &&
+                    isElement(inner->getRangePattern().first.at(0), x, 1)) {
+                transitive.insert(name);
+            }
+        });
+    });
+    for (const auto& name : symmetric) {
+        if (transitive.count(name) > 0) {
+            equivalences.insert(name);
+        }
+    }
+}
+
+void DataStructureAdvisorAnalysis::print(std::ostream& os) const {
+    if (!profiled) {
+        return;
+    }
+    for (const auto& [name, dataStructure] : dataStructures) {
+        if (getBaseName(name) != name) {
+            continue;
+        }
+        os << "Relation " << name << ": ";
+        if (dataStructure.representation == RelationRepresentation::DEFAULT) {
+            os << RelationRepresentation::BTREE;
+        } else {
+            os << dataStructure.representation;
+        }
+        if (dataStructure.blockSize != defaultBlockSize || dataStructure.linearSearch) {
+            os << " (" << dataStructure.blockSize << " bytes per node, "
+               << (dataStructure.linearSearch ? "linear" : "binary") << " search)";
+        }
+        os << "\n";
+        for (const auto& reason : dataStructure.reasons) {
+            os << "  - " << reason << "\n";
+        }
+    }
+}
+
+}  // namespace souffle::ram::analysis
@@ -0,0 +1,113 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file DataStructureAdvisor.h
+ *
+ * Analysis choosing the data structure of each relation from the profile
+ * of a previous run (--profile-use).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RelationTag.h"
+#include "ram/Relation.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Analysis.h"
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace souffle::profile {
+class ProgramRun;
+}
+
+namespace souffle::ram::analysis {
+
+/**
+ * @class DataStructure
+ * @brief The data structure chosen for a relation
+ */
+struct DataStructure {
+    /** Representation of the relation, HASH if the index analysis hashes it */
+    RelationRepresentation representation = RelationRepresentation::DEFAULT;
+
+    /** Number of bytes of a B-tree node */
+    std::size_t blockSize = 256;
+
+    /** Whether B-tree nodes are searched linearly instead of by bisection */
+    bool linearSearch = false;
+
+    /** Why the data structure was chosen */
+    std::vector<std::string> reasons;
+};
+
+/**
+ * @class DataStructureAdvisorAnalysis
+ * @brief Analysis choosing the representation and the B-tree parameters of relations
+ *
+ * Without a profile, every relation keeps its annotated representation and
+ * the default B-tree parameters. With a profile, relations without an
+ * annotation are assigned a representation from the observed number of
+ * tuples inserted and read, their arity, and the index orders their searches
+ * need:
+ *  - brie for large relations of higher arity that are inserted into more
+ *    often than read, and that are searched in a single order, so that one
+ *    trie shares the prefixes of all tuples, and
+ *  - btree otherwise.
+ * The nodes of B-trees hold at least 8 tuples, and twice the default bytes
+ * for large lookup-heavy relations to lower the trees. Nodes holding up to 16
+ * tuples are searched linearly.
+ *
+ * Relations whose rules close them under symmetry and transitivity are
+ * reported as eqrel candidates, but they keep their representation, as an
+ * eqrel also adds the reflexive pairs of its elements.
+ *
+ * Temporary relations of semi-naive evaluation share the data structure of
+ * their relation, so that they can be swapped.
+ */
+class DataStructureAdvisorAnalysis : public Analysis {
+public:
+    DataStructureAdvisorAnalysis(const char* id) : Analysis(id) {}
+
+    static constexpr const char* name = "data-structure-advisor";
+
+    void run(const TranslationUnit& translationUnit) override;
+
+    /** Print the chosen data structures and their reasons */
+    void print(std::ostream& os) const override;
+
+    /** Get the data structure of a relation */
+    const DataStructure& getDataStructure(const std::string& relName) const {
+        return dataStructures.at(relName);
+    }
+
+private:
+    /** Choose the data structure of a relation with profile data */
+    DataStructure advise(const TranslationUnit& translationUnit, const Relation& rel,
+            const profile::ProgramRun& run) const;
+
+    /** Collect the relations whose rules are symmetric and transitive */
+    void findEquivalences(const TranslationUnit& translationUnit);
+
+    /** Data structure of each relation */
+    std::map<std::string, DataStructure> dataStructures;
+
+    /** Relations closed under symmetry and transitivity by their rules */
+    std::set<std::string> equivalences;
+
+    /** Whether a profile was used */
+    bool profiled = false;
+};
+
+}  // namespace souffle::ram::analysis
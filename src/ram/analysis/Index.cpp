@@ -18,20 +18,38 @@
 #include "Global.h"
 #include "RelationTag.h"
 #include "ram/Expression.h"
+#include "ram/Extend.h"
+#include "ram/IO.h"
+#include "ram/IndexIfExists.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Loop.h"
+#include "ram/NestedOperation.h"
 #include "ram/Node.h"
+#include "ram/ParallelIndexIfExists.h"
+#include "ram/ParallelIndexScan.h"
 #include "ram/Program.h"
+#include "ram/Query.h"
 #include "ram/Relation.h"
 #include "ram/Swap.h"
 #include "ram/TranslationUnit.h"
 #include "ram/analysis/Relation.h"
 #include "ram/utility/Utils.h"
 #include "ram/utility/Visitor.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/profile/Relation.h"
+#include "souffle/profile/Rule.h"
+#include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <optional>
 #include <queue>
 
 namespace souffle::ram::analysis {
@@ -219,6 +237,11 @@ const MaxMatching::Matchings& MaxMatching::solve() {
     return match;
 }
 
+IndexCluster IndexSelectionStrategy::solve(
+        const SearchSet& searches, const SearchStatistics& /* statistics */) const {
+    return solve(searches);
+}
+
 IndexCluster MinIndexSelectionStrategy::solve(const SearchSet& searches) const {
     OrderCollection orders;
     SignatureOrderMap indexSelection;
@@ -316,6 +339,124 @@ IndexCluster MinIndexSelectionStrategy::solve(const SearchSet& searches) const {
     return IndexCluster(indexSelection, searches, orders);
 }
 
+namespace {
+/** Number of columns a search binds, counting a range as half a column */
+double getBoundColumns(const SearchSignature& search) {
+    double bound = 0;
+    for (auto constraint : search) {
+        if (constraint == AttributeConstraint::Equal) {
+            bound += 1;
+        } else if (constraint == AttributeConstraint::Inequal) {
+            bound += 0.5;
+        }
+    }
+    return bound;
+}
+}  // namespace
+
+IndexCluster WeightedIndexSelectionStrategy::solve(
+        const SearchSet& searches, const SearchStatistics& statistics) const {
+    if (searches.empty() || statistics.size == 0) {
+        return solve(searches);
+    }
+    const std::size_t size = statistics.size;
+    const std::size_t arity = searches.begin()->arity();
+
+    // every tuple is inserted into every index
+    const double maintenance = size * std::log2(std::max<std::size_t>(size, 2));
+
+    // greedily drop the search whose index saves the most, as long as one saves anything
+    SearchSet kept = searches;
+    std::size_t numOrders = solve(kept).getAllOrders().size();
+    while (true) {
+        auto best = kept.end();
+        double bestGain = 0;
+        std::size_t bestNumOrders = numOrders;
+        for (auto it = kept.begin(); it != kept.end(); ++it) {
+            const SearchSignature& search = *it;
+            auto runs = statistics.runs.find(search);
+            if (runs == statistics.runs.end() || search == SearchSignature::getFullSearchSignature(arity)) {
+                continue;
+            }
+            SearchSet rest = kept;
+            rest.erase(search);
+            const auto orders = solve(rest).getAllOrders();
+            if (orders.size() >= numOrders) {
+                continue;
+            }
+            std::size_t orderIndex = 0;
+            const double extraMatches =
+                    getMatches(relax(search, orders, orderIndex), size) - getMatches(search, size);
+            const double gain = (numOrders - orders.size()) * maintenance - runs->second * extraMatches;
+            if (gain > bestGain) {
+                best = it;
+                bestGain = gain;
+                bestNumOrders = orders.size();
+            }
+        }
+        if (best == kept.end()) {
+            break;
+        }
+        kept.erase(best);
+        numOrders = bestNumOrders;
+    }
+    if (kept.size() == searches.size()) {
+        return solve(searches);
+    }
+
+    // answer the dropped searches by prefixes of the remaining orders
+    const IndexCluster cover = solve(kept);
+    const OrderCollection orders = cover.getAllOrders();
+    SignatureOrderMap indexSelection;
+    SignatureMap relaxedSearches;
+    SearchSet answered = kept;
+    for (const auto& search : kept) {
+        indexSelection.insert({search, cover.getLexOrder(search)});
+    }
+    for (const auto& search : searches) {
+        if (kept.find(search) != kept.end()) {
+            continue;
+        }
+        std::size_t orderIndex = 0;
+        SearchSignature relaxed = relax(search, orders, orderIndex);
+        relaxedSearches.insert({search, relaxed});
+        if (!relaxed.empty() && indexSelection.count(relaxed) == 0) {
+            indexSelection.insert({relaxed, orders.at(orderIndex)});
+            answered.insert(relaxed);
+        }
+        indexSelection.insert({search, relaxed.empty() ? orders.at(orderIndex) : indexSelection.at(relaxed)});
+    }
+    return IndexCluster(indexSelection, answered, orders, relaxedSearches);
+}
+
+SearchSignature WeightedIndexSelectionStrategy::relax(
+        const SearchSignature& search, const OrderCollection& orders, std::size_t& orderIndex) const {
+    SearchSignature best(search.arity());
+    orderIndex = 0;
+    for (std::size_t i = 0; i < orders.size(); i++) {
+        SearchSignature prefix(search.arity());
+        for (AttributeIndex column : orders[i]) {
+            prefix[column] = search[column];
+            // an order can only be searched up to the first column that is not an equality
+            if (search[column] != AttributeConstraint::Equal) {
+                break;
+            }
+        }
+        if (getBoundColumns(prefix) > getBoundColumns(best)) {
+            best = prefix;
+            orderIndex = i;
+        }
+    }
+    return best;
+}
+
+double WeightedIndexSelectionStrategy::getMatches(const SearchSignature& search, std::size_t size) const {
+    if (search.arity() == 0) {
+        return 1;
+    }
+    return std::pow(size, 1 - getBoundColumns(search) / search.arity());
+}
+
 Chain MinIndexSelectionStrategy::getChain(const SearchSignature umn, const MaxMatching::Matchings& match,
         const SearchBipartiteMap& mapping) const {
     SearchSignature start = umn;  // start at an unmatched node
@@ -399,6 +540,10 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
             relationToSearches[exists->getRelation()].insert(getSearchSignature(exists));
         } else if (const auto* provExists = as<ProvenanceExistenceCheck>(node)) {
             relationToSearches[provExists->getRelation()].insert(getSearchSignature(provExists));
+        } else if (const auto* join = as<LeapfrogJoin>(node)) {
+            for (std::size_t i = 0; i < join->getNumRelations(); i++) {
+                relationToSearches[join->getRelation(i)].insert(getSearchSignature(join, i));
+            }
         } else if (const auto* ramRel = as<Relation>(node)) {
             relationToSearches[ramRel->getName()].insert(getSearchSignature(ramRel));
         }
@@ -434,12 +579,288 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
         }
     }
 
-    // find optimal indexes for relations
+    // find optimal indexes for relations, weighing searches by their use if a profile is given
+    const auto statistics = getStatistics(translationUnit);
+    if (!statistics.empty()) {
+        solver = mk<WeightedIndexSelectionStrategy>();
+    }
     for (auto& relToSearch : relationToSearches) {
         const std::string& relation = relToSearch.first;
         auto& searches = relToSearch.second;
-        indexCover.insert({relation, solver->solve(searches)});
+        auto relStatistics = statistics.find(relation);
+        if (relStatistics != statistics.end()) {
+            indexCover.insert({relation, solver->solve(searches, relStatistics->second)});
+        } else {
+            indexCover.insert({relation, solver->solve(searches)});
+        }
+    }
+
+    // choose hash indexes for relations only searched by equalities
+    std::set<std::string> outputRelations;
+    visit(translationUnit.getProgram(), [&](const IO& io) {
+        const auto& directives = io.getDirectives();
+        auto operation = directives.find("operation");
+        if (operation != directives.end() && operation->second != "input") {
+            outputRelations.insert(io.getRelation());
+        }
+    });
+    for (auto& relToSearch : relationToSearches) {
+        const std::string& relation = relToSearch.first;
+        const Relation& rel = relAnalysis->lookup(relation);
+        if (isHashable(rel, relToSearch.second, contains(outputRelations, relation))) {
+            hashRelations.insert(relation);
+        }
+    }
+
+    // swapped relations must share their data structure
+    visit(translationUnit.getProgram(), [&](const Swap& swap) {
+        const std::string& relA = swap.getFirstRelation();
+        const std::string& relB = swap.getSecondRelation();
+        if (isHashRelation(relA) != isHashRelation(relB)) {
+            hashRelations.erase(relA);
+            hashRelations.erase(relB);
+        }
+    });
+
+    // hash relations have an index for each search, so none is relaxed
+    for (const auto& relation : hashRelations) {
+        if (indexCover.at(relation).hasRelaxedSearches()) {
+            indexCover.at(relation) = solver->solve(relationToSearches.at(relation));
+        }
     }
+
+    findLazyOrders(translationUnit);
+}
+
+void IndexAnalysis::findLazyOrders(const TranslationUnit& translationUnit) {
+    const Program& program = translationUnit.getProgram();
+
+    // A relation that a fixpoint loop inserts into needs the indexes searched
+    // by the loop while it grows. Its other indexes are only searched once it
+    // is complete, e.g., by later strata, so that they are materialised in bulk
+    // on their first search rather than maintained on every insertion.
+    std::set<std::string> loopRelations;
+    std::map<std::string, std::set<LexOrder>> loopOrders;
+    visit(program, [&](const Loop& loop) {
+        std::set<std::string> inserted;
+        visit(loop, [&](const Insert& insert) { inserted.insert(insert.getRelation()); });
+        visit(loop, [&](const Extend& extend) { inserted.insert(extend.getTargetRelation()); });
+        auto searched = [&](const std::string& relation, const SearchSignature& search) {
+            if (contains(inserted, relation) && !search.empty()) {
+                loopOrders[relation].insert(indexCover.at(relation).getLexOrder(search));
+            }
+        };
+        visit(loop, [&](const Node& node) {
+            if (const auto* indexSearch = as<IndexOperation>(node)) {
+                searched(indexSearch->getRelation(), getSearchSignature(indexSearch));
+            } else if (const auto* exists = as<ExistenceCheck>(node)) {
+                searched(exists->getRelation(), getSearchSignature(exists));
+            } else if (const auto* provExists = as<ProvenanceExistenceCheck>(node)) {
+                searched(provExists->getRelation(), getSearchSignature(provExists));
+            } else if (const auto* join = as<LeapfrogJoin>(node)) {
+                for (std::size_t i = 0; i < join->getNumRelations(); i++) {
+                    searched(join->getRelation(i), getSearchSignature(join, i));
+                }
+            }
+        });
+        loopRelations.insert(inserted.begin(), inserted.end());
+    });
+
+    // swapped relations must keep the same data structure
+    visit(program, [&](const Swap& swap) {
+        loopRelations.erase(swap.getFirstRelation());
+        loopRelations.erase(swap.getSecondRelation());
+    });
+
+    for (const auto& relation : loopRelations) {
+        if (indexCover.count(relation) == 0 || isHashRelation(relation)) {
+            continue;
+        }
+        auto& cover = indexCover.at(relation);
+        const auto orders = cover.getAllOrders();
+        const std::size_t master = cover.getMasterOrderNum(relAnalysis->lookup(relation).getArity());
+        for (std::size_t i = 0; i < orders.size(); i++) {
+            if (i != master && !contains(loopOrders[relation], orders[i])) {
+                cover.setLazyOrder(orders[i]);
+            }
+        }
+    }
+}
+
+bool IndexAnalysis::isHashable(const Relation& rel, const SearchSet& searches, bool isOutput) const {
+    const auto representation = rel.getRepresentation();
+    if (rel.isNullary() || (representation != RelationRepresentation::HASH &&
+                                   representation != RelationRepresentation::DEFAULT)) {
+        return false;
+    }
+
+    // floats equal as values, i.e., -0.0 and 0.0, differ in their hash
+    for (const auto& type : rel.getAttributeTypes()) {
+        if (type[0] == 'f') {
+            return false;
+        }
+    }
+
+    // a hash index answers equalities only
+    std::size_t numHashIndexes = 1;
+    for (const auto& search : searches) {
+        for (std::size_t i = 0; i < search.arity(); i++) {
+            if (search[i] == AttributeConstraint::Inequal) {
+                return false;
+            }
+        }
+        if (search != SearchSignature::getFullSearchSignature(search.arity())) {
+            numHashIndexes++;
+        }
+    }
+    if (representation == RelationRepresentation::HASH) {
+        return true;
+    }
+
+    // Otherwise, keep the ordered output of btrees, and their sharing of an index
+    // among searches whose equalities extend each other. Besides the index of each
+    // search, a hash relation needs an index of all columns to detect duplicates.
+    return !isOutput && numHashIndexes <= indexCover.at(rel.getName()).getAllOrders().size() + 1;
+}
+
+namespace {
+/** Split the profile text of an operation into its fields, unescaping semicolons */
+std::vector<std::string> splitProfileText(const std::string& profileText) {
+    std::vector<std::string> fields(1);
+    for (std::size_t i = 0; i < profileText.size(); i++) {
+        if (profileText[i] == '\\' && i + 1 < profileText.size() && profileText[i + 1] == ';') {
+            fields.back() += ';';
+            i++;
+        } else if (profileText[i] == ';') {
+            fields.emplace_back();
+        } else {
+            fields.back() += profileText[i];
+        }
+    }
+    return fields;
+}
+
+/**
+ * Get how often the nested operation of an operation ran in the profiled run,
+ * or how often the operation itself ran if it is the outermost operation of
+ * its query, from the profile text "@frequency-atom;relation;version;rule;
+ * atom;original rule;level;" of the operation
+ */
+std::optional<std::size_t> getFrequency(
+        const profile::ProgramRun& run, const std::string& profileText, bool outermost) {
+    const auto fields = splitProfileText(profileText);
+    if (fields.size() < 7 || fields[0] != "@frequency-atom") {
+        return std::nullopt;
+    }
+    const auto* rel = run.getRelation(fields[1]);
+    if (rel == nullptr) {
+        return std::nullopt;
+    }
+    const std::string& rule = fields[3];
+    const std::string& atom = fields[4];
+    const bool recursive = rule != fields[5];
+    const std::size_t level = std::stoul(fields[6]);
+
+    // the query of the outermost operation runs once, or once per iteration
+    if (outermost) {
+        return recursive ? std::max<std::size_t>(rel->getIterations().size(), 1) : 1;
+    }
+
+    std::optional<std::size_t> frequency;
+    auto addAtoms = [&](const profile::Rule& profiledRule) {
+        for (const auto& profiledAtom : profiledRule.getAtoms()) {
+            if (profiledAtom.rule == rule && profiledAtom.identifier == atom && profiledAtom.level == level) {
+                frequency = frequency.value_or(0) + profiledAtom.frequency;
+            }
+        }
+    };
+    if (recursive) {
+        for (const auto& iteration : rel->getIterations()) {
+            for (const auto& profiledRule : iteration->getRules()) {
+                addAtoms(*profiledRule.second);
+            }
+        }
+    } else {
+        for (const auto& profiledRule : rel->getRuleMap()) {
+            addAtoms(*profiledRule.second);
+        }
+    }
+    return frequency;
+}
+}  // namespace
+
+std::map<std::string, SearchStatistics> IndexAnalysis::getStatistics(
+        const TranslationUnit& translationUnit) const {
+    std::map<std::string, SearchStatistics> statistics;
+    if (!Global::config().has("profile-use") || Global::config().has("provenance")) {
+        return statistics;
+    }
+    auto run = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    profile::Reader(Global::config().get("profile-use"), run).processFile();
+    const Program& program = translationUnit.getProgram();
+
+    // Only the searches of index scans and index if-exists operations are relaxed,
+    // and only if their runs are profiled. Swapped relations keep the same indexes.
+    std::map<std::string, SearchSet> pinned;
+    std::set<std::string> swapped;
+    visit(program, [&](const Node& node) {
+        if (const auto* exists = as<ExistenceCheck>(node)) {
+            pinned[exists->getRelation()].insert(getSearchSignature(exists));
+        } else if (const auto* provExists = as<ProvenanceExistenceCheck>(node)) {
+            pinned[provExists->getRelation()].insert(getSearchSignature(provExists));
+        } else if (const auto* join = as<LeapfrogJoin>(node)) {
+            for (std::size_t i = 0; i < join->getNumRelations(); i++) {
+                pinned[join->getRelation(i)].insert(getSearchSignature(join, i));
+            }
+        } else if (const auto* swap = as<Swap>(node)) {
+            swapped.insert(swap->getFirstRelation());
+            swapped.insert(swap->getSecondRelation());
+        }
+    });
+
+    // runs of a search are the runs of the nested operation of the closest profiled operation around it
+    std::map<std::string, std::unordered_map<SearchSignature, std::size_t, SearchSignature::Hasher>> runs;
+    std::function<void(const Operation&, std::optional<std::size_t>)> collect =
+            [&](const Operation& op, std::optional<std::size_t> numRuns) {
+                if (const auto* search = as<IndexOperation>(op)) {
+                    const bool relaxable = (isA<IndexScan>(op) || isA<IndexIfExists>(op)) &&
+                                           !isA<ParallelIndexScan>(op) && !isA<ParallelIndexIfExists>(op);
+                    if (relaxable && numRuns.has_value()) {
+                        runs[search->getRelation()][getSearchSignature(search)] += *numRuns;
+                    } else {
+                        pinned[search->getRelation()].insert(getSearchSignature(search));
+                    }
+                }
+                if (const auto* nested = as<NestedOperation>(op)) {
+                    if (!nested->getProfileText().empty()) {
+                        numRuns = getFrequency(*run, nested->getProfileText(), false);
+                    }
+                    collect(nested->getOperation(), numRuns);
+                }
+            };
+    visit(program, [&](const Query& query) {
+        const auto* outer = as<NestedOperation>(query.getOperation());
+        if (outer != nullptr && !outer->getProfileText().empty()) {
+            collect(*outer, getFrequency(*run, outer->getProfileText(), true));
+        } else {
+            collect(query.getOperation(), std::nullopt);
+        }
+    });
+
+    for (const auto& [relation, relRuns] : runs) {
+        const auto* profiledRel = run->getRelation(relation);
+        if (profiledRel == nullptr || swapped.count(relation) > 0) {
+            continue;
+        }
+        SearchStatistics& relStatistics = statistics[relation];
+        relStatistics.size = profiledRel->size();
+        for (const auto& [search, numRuns] : relRuns) {
+            if (!contains(pinned[relation], search)) {
+                relStatistics.runs.insert({search, numRuns});
+            }
+        }
+    }
+    return statistics;
 }
 
 void IndexAnalysis::print(std::ostream& os) const {
@@ -447,7 +868,7 @@ void IndexAnalysis::print(std::ostream& os) const {
         const std::string& relName = cur.first;
         const auto& selection = cur.second;
 
-        os << "Relation " << relName << "\n";
+        os << "Relation " << relName << (isHashRelation(relName) ? " (hash)" : "") << "\n";
 
         /* print searches */
         os << "\tNumber of Searches: " << selection.getSearches().size() << "\n";
@@ -457,11 +878,19 @@ void IndexAnalysis::print(std::ostream& os) const {
             os << "\n";
         }
 
+        /* print searches answered by a prefix of another index */
+        for (auto& search : relationToSearches.at(relName)) {
+            auto relaxed = selection.getRelaxedSearch(search);
+            if (relaxed != search) {
+                os << "\t\t" << search << " relaxed to " << relaxed << "\n";
+            }
+        }
+
         /* print indexes */
         os << "\tNumber of Indexes: " << selection.getAllOrders().size() << "\n";
         for (auto& order : selection.getAllOrders()) {
             os << "\t\t";
-            os << join(order, "<") << "\n";
+            os << join(order, "<") << (selection.isLazyOrder(order) ? " (lazy)" : "") << "\n";
             os << "\n";
         }
     }
@@ -536,6 +965,22 @@ SearchSignature IndexAnalysis::getSearchSignature(const ExistenceCheck* existChe
     return searchSignature(rel->getArity(), existCheck->getValues());
 }
 
+SearchSignature IndexAnalysis::getSearchSignature(const LeapfrogJoin* join, std::size_t i) const {
+    const Relation* rel = &relAnalysis->lookup(join->getRelation(i));
+    // the join column is ordered after the bound attributes, such that the
+    // index can seek the values of the join column for a given pattern
+    SearchSignature keys = searchSignature(rel->getArity(), join->getPattern(i));
+    keys[join->getColumn(i)] = AttributeConstraint::Inequal;
+    return keys;
+}
+
+bool IndexAnalysis::isSeekable(const LeapfrogJoin* join, std::size_t i) const {
+    const SearchSignature search = getSearchSignature(join, i);
+    const std::size_t numBound = std::count(search.begin(), search.end(), AttributeConstraint::Equal);
+    const LexOrder order = indexCover.at(join->getRelation(i)).getLexOrder(search);
+    return numBound < order.size() && order[numBound] == join->getColumn(i);
+}
+
 SearchSignature IndexAnalysis::getSearchSignature(const Relation* ramRel) const {
     return SearchSignature::getFullSearchSignature(ramRel->getArity());
 }
@@ -19,6 +19,7 @@
 #include "ram/AbstractExistenceCheck.h"
 #include "ram/ExistenceCheck.h"
 #include "ram/IndexOperation.h"
+#include "ram/LeapfrogJoin.h"
 #include "ram/ProvenanceExistenceCheck.h"
 #include "ram/Relation.h"
 #include "ram/TranslationUnit.h"
@@ -363,6 +364,18 @@ private:
     NodeSearchMap nodeToSignature;
 };
 
+/**
+ * @class SearchStatistics
+ * @Brief Profiled use of the searches of a relation
+ */
+struct SearchStatistics {
+    /** number of tuples of the relation, each inserted into every index */
+    std::size_t size = 0;
+
+    /** number of times each search ran; searches without a count are never relaxed */
+    std::unordered_map<SearchSignature, std::size_t, SearchSignature::Hasher> runs;
+};
+
 /**
  * @class IndexSelectionStrategy
  * @brief Abstracts selection strategy for index analysis
@@ -373,10 +386,15 @@ public:
 
     /** @brief Run analysis for a RAM translation unit */
     virtual IndexCluster solve(const SearchSet& searches) const = 0;
+
+    /** @brief Run analysis weighing the searches by their profiled use, which is ignored by default */
+    virtual IndexCluster solve(const SearchSet& searches, const SearchStatistics& statistics) const;
 };
 
 class MinIndexSelectionStrategy : public IndexSelectionStrategy {
 public:
+    using IndexSelectionStrategy::solve;
+
     /** @Brief map the keys in the key set to lexicographical order */
     IndexCluster solve(const SearchSet& searches) const override;
 
@@ -443,6 +461,45 @@ protected:
     }
 };
 
+/**
+ * @class WeightedIndexSelectionStrategy
+ * @Brief computes an index cover weighing index maintenance against
+ *        the searches answered by each index
+ *
+ * Every index costs a B-tree insertion for each tuple of the relation. Starting
+ * from the minimal index cover, searches are dropped from the cover greedily as
+ * long as the insertions saved by the indexes that are no longer needed exceed
+ * the extra tuples the dropped searches visit over the runs recorded in the
+ * profile. A dropped search is relaxed to the longest prefix of a remaining
+ * order that it binds, i.e., to the columns it binds by equality, followed by
+ * its range column if that is the next column of the order, and the rest of
+ * the search is left to a filter (see RelaxIndexTransformer).
+ *
+ * A search binding c of the k columns of a relation of n tuples is assumed to
+ * visit n^(1-c/k) tuples, where a range counts as half a column.
+ */
+class WeightedIndexSelectionStrategy : public MinIndexSelectionStrategy {
+public:
+    using MinIndexSelectionStrategy::solve;
+
+    /** @Brief map the searches to orders, relaxing searches whose indexes do not pay off */
+    IndexCluster solve(const SearchSet& searches, const SearchStatistics& statistics) const override;
+
+protected:
+    /**
+     * @Brief get the longest prefix of one of the orders that the search binds
+     * @param search the search to relax
+     * @param orders the orders to choose a prefix of
+     * @param orderIndex set to the index of the chosen order
+     * @result the columns of the prefix with the constraints of the search
+     */
+    SearchSignature relax(
+            const SearchSignature& search, const OrderCollection& orders, std::size_t& orderIndex) const;
+
+    /** @Brief estimate the number of tuples a search visits */
+    double getMatches(const SearchSignature& search, std::size_t size) const;
+};
+
 /**
  * @class IndexCluster
  * @Brief Encapsulates the result of the IndexAnalysis
@@ -451,8 +508,9 @@ protected:
 class IndexCluster {
 public:
     IndexCluster(const SignatureOrderMap& indexSelection, const SearchSet& searchSet,
-            const OrderCollection& orders)
-            : indexSelection(indexSelection), searches(searchSet.begin(), searchSet.end()), orders(orders) {}
+            const OrderCollection& orders, const SignatureMap& relaxedSearches = {})
+            : indexSelection(indexSelection), searches(searchSet.begin(), searchSet.end()), orders(orders),
+              relaxedSearches(relaxedSearches) {}
 
     const OrderCollection getAllOrders() const {
         return orders;
@@ -473,10 +531,50 @@ public:
         return std::distance(orders.begin(), it);
     }
 
+    /**
+     * @Brief Get the search that answers a search on the indexes
+     *
+     * A search without an index of its own is relaxed to a prefix of the order
+     * it is mapped to; the search itself is returned otherwise.
+     */
+    const SearchSignature getRelaxedSearch(SearchSignature cols) const {
+        auto it = relaxedSearches.find(cols);
+        return it == relaxedSearches.end() ? cols : it->second;
+    }
+
+    /** Check whether searches were relaxed */
+    bool hasRelaxedSearches() const {
+        return !relaxedSearches.empty();
+    }
+
+    /**
+     * @Brief Get the position of the master order, i.e., the first order over all columns
+     *
+     * The index of the master order holds the tuples of the relation; it is
+     * never lazy. The position is the number of orders if none is full.
+     */
+    std::size_t getMasterOrderNum(std::size_t arity) const {
+        auto it = std::find_if(
+                orders.begin(), orders.end(), [&](const LexOrder& order) { return order.size() == arity; });
+        return std::distance(orders.begin(), it);
+    }
+
+    /** Check whether the index of an order is only materialised when it is first searched */
+    bool isLazyOrder(const LexOrder& order) const {
+        return lazyOrders.count(order) > 0;
+    }
+
+    /** Materialise the index of an order when it is first searched instead of on every insertion */
+    void setLazyOrder(const LexOrder& order) {
+        lazyOrders.insert(order);
+    }
+
 private:
     SignatureOrderMap indexSelection;
     SearchCollection searches;
     OrderCollection orders;
+    SignatureMap relaxedSearches;
+    std::set<LexOrder> lazyOrders;
 };
 
 /**
@@ -498,6 +596,18 @@ public:
         return indexCover.at(relName);
     }
 
+    /**
+     * @Brief Check whether a relation is stored in hash indexes
+     *
+     * A relation is stored in hash indexes, one over all columns and one over
+     * the equalities of each search, if it is only searched by equalities, and
+     * either qualified as hash, or neither ordered output nor fewer indexes
+     * speak for a btree.
+     */
+    bool isHashRelation(const std::string& relName) const {
+        return hashRelations.count(relName) > 0;
+    }
+
     /**
      * @Brief Get index signature for an Ram IndexOperation operation
      * @param  Index-relation-search operation
@@ -519,6 +629,22 @@ public:
      */
     SearchSignature getSearchSignature(const ProvenanceExistenceCheck* existCheck) const;
 
+    /**
+     * @Brief Get the index signature of a relation joined by a leapfrog join
+     * @param Leapfrog join
+     * @param Position of the relation in the join
+     * @result index signature with the pattern as equalities followed by the join column
+     */
+    SearchSignature getSearchSignature(const LeapfrogJoin* join, std::size_t i) const;
+
+    /**
+     * @Brief Check whether the index of a relation joined by a leapfrog join can seek its join column
+     * @param Leapfrog join
+     * @param Position of the relation in the join
+     * @result true if the order of the index places the join column right after the bound attributes
+     */
+    bool isSeekable(const LeapfrogJoin* join, std::size_t i) const;
+
     /**
      * @Brief Get the default index signature for a relation (the total-order index)
      * @param ramRel RAM-relation
@@ -536,6 +662,18 @@ public:
     bool isTotalSignature(const AbstractExistenceCheck* existCheck) const;
 
 private:
+    /** Check whether the searches of a relation are answered by hash indexes */
+    bool isHashable(const Relation& rel, const SearchSet& searches, bool isOutput) const;
+
+    /** Mark the indexes that the fixpoint loops inserting into their relations do not search as lazy */
+    void findLazyOrders(const TranslationUnit& translationUnit);
+
+    /**
+     * Collect the sizes of relations and the runs of their searches from the
+     * profile of a previous run (--profile-use), if any
+     */
+    std::map<std::string, SearchStatistics> getStatistics(const TranslationUnit& translationUnit) const;
+
     /** relation analysis for looking up relations by name */
     RelationAnalysis* relAnalysis;
 
@@ -545,6 +683,9 @@ private:
     Own<IndexSelectionStrategy> solver;
     std::map<std::string, IndexCluster> indexCover;
     std::map<std::string, SearchSet> relationToSearches;
+
+    /** relations stored in hash indexes */
+    std::set<std::string> hashRelations;
 };
 
 }  // namespace souffle::ram::analysis
@@ -30,6 +30,7 @@
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
 #include "ram/IndexScan.h"
+#include "ram/LeapfrogJoin.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
 #include "ram/Negation.h"
@@ -104,6 +105,17 @@ int LevelAnalysis::getLevel(const Node* node) const {
             return level;
         }
 
+        // leapfrog join
+        int visit_(type_identity<LeapfrogJoin>, const LeapfrogJoin& join) override {
+            int level = -1;
+            for (std::size_t i = 0; i < join.getNumRelations(); i++) {
+                for (auto* value : join.getPattern(i)) {
+                    level = std::max(level, dispatch(*value));
+                }
+            }
+            return level;
+        }
+
         // choice
         int visit_(type_identity<IfExists>, const IfExists& choice) override {
             return std::max(-1, dispatch(choice.getCondition()));
@@ -0,0 +1,176 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file data_structure_advisor_test.cpp
+ *
+ * Tests the choice of data structures from a profile.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Expression.h"
+#include "ram/IO.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/Swap.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/analysis/DataStructureAdvisor.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace souffle::ram {
+
+using analysis::DataStructureAdvisorAnalysis;
+
+namespace test {
+
+Own<Relation> makeRelation(const std::string& name, std::size_t arity,
+        RelationRepresentation representation = RelationRepresentation::DEFAULT) {
+    std::vector<std::string> names;
+    std::vector<std::string> types;
+    for (std::size_t i = 0; i < arity; i++) {
+        names.push_back("a" + std::to_string(i));
+        types.push_back("i:number");
+    }
+    return mk<Relation>(name, arity, 0, names, types, representation);
+}
+
+VecOwn<Expression> makeElements(int first, std::size_t firstElement, int second, std::size_t secondElement) {
+    VecOwn<Expression> elements;
+    elements.push_back(mk<TupleElement>(first, firstElement));
+    elements.push_back(mk<TupleElement>(second, secondElement));
+    return elements;
+}
+
+/** A search of a binary relation binding its first column to the given element */
+RamPattern makeFirstColumnPattern(int tuple, std::size_t element) {
+    RamBound lower;
+    RamBound upper;
+    lower.push_back(mk<TupleElement>(tuple, element));
+    lower.push_back(mk<UndefValue>());
+    upper.push_back(mk<TupleElement>(tuple, element));
+    upper.push_back(mk<UndefValue>());
+    return RamPattern(std::move(lower), std::move(upper));
+}
+
+/**
+ * A program with an equivalence over eq, a large relation big searched by
+ * its first column, and relations lookup and wide without searches.
+ */
+Own<Program> makeProgram() {
+    VecOwn<Relation> relations;
+    relations.push_back(makeRelation("eq", 2));
+    relations.push_back(makeRelation("@delta_eq", 2));
+    relations.push_back(makeRelation("@new_eq", 2));
+    relations.push_back(makeRelation("big", 2));
+    relations.push_back(makeRelation("small", 1));
+    relations.push_back(makeRelation("lookup", 2));
+    relations.push_back(makeRelation("wide", 4));
+    relations.push_back(makeRelation("fixed", 3, RelationRepresentation::BTREE));
+
+    VecOwn<Statement> statements;
+    // eq(x, y) :- eq(y, x).
+    statements.push_back(
+            mk<Query>(mk<Scan>("@delta_eq", 0, mk<Insert>("@new_eq", makeElements(0, 1, 0, 0)))));
+    // eq(x, z) :- eq(x, y), eq(y, z).
+    statements.push_back(mk<Query>(mk<Scan>("@delta_eq", 0,
+            mk<IndexScan>("eq", 1, makeFirstColumnPattern(0, 1),
+                    mk<Insert>("@new_eq", makeElements(0, 0, 1, 1))))));
+    // lookup(x, y) :- small(x), big(x, y).
+    statements.push_back(mk<Query>(mk<Scan>("small", 0,
+            mk<IndexScan>("big", 1, makeFirstColumnPattern(0, 0),
+                    mk<Insert>("lookup", makeElements(1, 0, 1, 1))))));
+    statements.push_back(mk<Swap>("@delta_eq", "@new_eq"));
+    // keep the relations from being hashed
+    for (const std::string name : {"eq", "big", "small", "lookup", "wide"}) {
+        statements.push_back(mk<IO>(name, std::map<std::string, std::string>{{"operation", "output"}}));
+    }
+    return mk<Program>(std::move(relations), mk<Sequence>(std::move(statements)),
+            std::map<std::string, Own<Statement>>());
+}
+
+TEST(DataStructureAdvisor, WithoutProfile) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(makeProgram(), errorReport, debugReport);
+    const auto* advisor = translationUnit.getAnalysis<DataStructureAdvisorAnalysis>();
+
+    for (const std::string name : {"eq", "@new_eq", "big", "lookup", "wide"}) {
+        const auto& dataStructure = advisor->getDataStructure(name);
+        EXPECT_EQ(RelationRepresentation::DEFAULT, dataStructure.representation);
+        EXPECT_EQ(256, dataStructure.blockSize);
+        EXPECT_FALSE(dataStructure.linearSearch);
+    }
+    EXPECT_EQ(RelationRepresentation::BTREE, advisor->getDataStructure("fixed").representation);
+}
+
+TEST(DataStructureAdvisor, WithProfile) {
+    const std::string profile = "data_structure_advisor_test.json";
+    std::ofstream(profile) << R"({ "root": { "program": { "relation": {
+        "eq": { "num-tuples": 5000, "reads": 100 },
+        "big": { "num-tuples": 500000, "reads": 1000, "memory": { "1": { "0 1": 12000000 } } },
+        "lookup": { "num-tuples": 300000, "reads": 900000 },
+        "wide": { "num-tuples": 50000, "reads": 10 },
+        "fixed": { "num-tuples": 10 }
+    } } } })";
+    Global::config().set("profile-use", profile);
+
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(makeProgram(), errorReport, debugReport);
+    const auto* advisor = translationUnit.getAnalysis<DataStructureAdvisorAnalysis>();
+    Global::config().unset("profile-use");
+    std::remove(profile.c_str());
+
+    // large, insert-heavy, and searched in a single order
+    EXPECT_EQ(RelationRepresentation::BRIE, advisor->getDataStructure("big").representation);
+
+    // small relations keep btrees, equivalences are only reported
+    const auto& eq = advisor->getDataStructure("eq");
+    EXPECT_EQ(RelationRepresentation::DEFAULT, eq.representation);
+    EXPECT_EQ(256, eq.blockSize);
+    EXPECT_EQ(3, eq.reasons.size());
+    EXPECT_EQ(RelationRepresentation::DEFAULT, advisor->getDataStructure("@delta_eq").representation);
+
+    // large lookup-heavy relations get larger nodes
+    const auto& lookup = advisor->getDataStructure("lookup");
+    EXPECT_EQ(RelationRepresentation::DEFAULT, lookup.representation);
+    EXPECT_EQ(512, lookup.blockSize);
+    EXPECT_FALSE(lookup.linearSearch);
+
+    // nodes of 16 tuples of arity 4 are searched linearly
+    const auto& wide = advisor->getDataStructure("wide");
+    EXPECT_EQ(256, wide.blockSize);
+    EXPECT_TRUE(wide.linearSearch);
+
+    // annotations are kept, and relations without profile data are left alone
+    EXPECT_EQ(RelationRepresentation::BTREE, advisor->getDataStructure("fixed").representation);
+    EXPECT_EQ(256, advisor->getDataStructure("small").blockSize);
+    EXPECT_FALSE(advisor->getDataStructure("small").linearSearch);
+}
+
+}  // namespace test
+}  // namespace souffle::ram
@@ -0,0 +1,181 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file lazy_index_test.cpp
+ *
+ * Tests the indexes that are materialised on their first search.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "RelationTag.h"
+#include "ram/Expression.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Loop.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/Swap.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/analysis/Index.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace souffle::ram {
+
+using analysis::IndexAnalysis;
+using analysis::LexOrder;
+
+namespace test {
+
+TEST(LazyIndex, OrdersNotSearchedByLoop) {
+    // path is kept a btree, as a relation searched by equalities only would be hashed
+    VecOwn<Relation> relations;
+    relations.emplace_back(new Relation("path", 3, 0, {"x", "y", "z"}, {"i:number", "i:number", "i:number"},
+            RelationRepresentation::BTREE));
+    for (const std::string name : {"@delta_path", "@new_path", "query", "result"}) {
+        relations.emplace_back(new Relation(name, 3, 0, {"x", "y", "z"},
+                {"i:number", "i:number", "i:number"}, RelationRepresentation::DEFAULT));
+    }
+
+    // the fixpoint searches path by its first column
+    // FOR t0 IN @delta_path
+    //  FOR t1 IN path ON INDEX t1.x = t0.1 AND t1.y = ⊥ AND t1.z = ⊥
+    //   INSERT (t0.0, t1.1, t1.2) INTO @new_path
+    RamPattern loopPattern;
+    loopPattern.first.emplace_back(new TupleElement(0, 1));
+    loopPattern.first.emplace_back(new UndefValue);
+    loopPattern.first.emplace_back(new UndefValue);
+    loopPattern.second.emplace_back(new TupleElement(0, 1));
+    loopPattern.second.emplace_back(new UndefValue);
+    loopPattern.second.emplace_back(new UndefValue);
+    VecOwn<Expression> newPath;
+    newPath.emplace_back(new TupleElement(0, 0));
+    newPath.emplace_back(new TupleElement(1, 1));
+    newPath.emplace_back(new TupleElement(1, 2));
+    VecOwn<Expression> path;
+    path.emplace_back(new TupleElement(0, 0));
+    path.emplace_back(new TupleElement(0, 1));
+    path.emplace_back(new TupleElement(0, 2));
+    VecOwn<Statement> loop;
+    loop.push_back(mk<Query>(mk<Scan>("@delta_path", 0,
+            mk<IndexScan>("path", 1, std::move(loopPattern), mk<Insert>("@new_path", std::move(newPath))))));
+    loop.push_back(mk<Query>(mk<Scan>("@new_path", 0, mk<Insert>("path", std::move(path)))));
+    loop.push_back(mk<Swap>("@delta_path", "@new_path"));
+
+    // a later stratum searches the complete path by its last column
+    // FOR t0 IN query
+    //  FOR t1 IN path ON INDEX t1.x = ⊥ AND t1.y = ⊥ AND t1.z = t0.0
+    //   INSERT (t1.0, t1.1, t1.2) INTO result
+    RamPattern queryPattern;
+    queryPattern.first.emplace_back(new UndefValue);
+    queryPattern.first.emplace_back(new UndefValue);
+    queryPattern.first.emplace_back(new TupleElement(0, 0));
+    queryPattern.second.emplace_back(new UndefValue);
+    queryPattern.second.emplace_back(new UndefValue);
+    queryPattern.second.emplace_back(new TupleElement(0, 0));
+    VecOwn<Expression> result;
+    result.emplace_back(new TupleElement(1, 0));
+    result.emplace_back(new TupleElement(1, 1));
+    result.emplace_back(new TupleElement(1, 2));
+    VecOwn<Statement> statements;
+    statements.push_back(mk<Loop>(mk<Sequence>(std::move(loop))));
+    statements.push_back(mk<Query>(mk<Scan>("query", 0,
+            mk<IndexScan>("path", 1, std::move(queryPattern), mk<Insert>("result", std::move(result))))));
+
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(mk<Program>(std::move(relations), mk<Sequence>(std::move(statements)),
+                                            std::map<std::string, Own<Statement>>()),
+            errorReport, debugReport);
+    const auto& selection = translationUnit.getAnalysis<IndexAnalysis>()->getIndexSelection("path");
+
+    // the master index over all columns is maintained during the loop
+    EXPECT_EQ(2, selection.getAllOrders().size());
+    EXPECT_FALSE(selection.isLazyOrder(LexOrder{0, 1, 2}));
+    EXPECT_TRUE(selection.isLazyOrder(LexOrder{2}));
+}
+
+TEST(LazyIndex, TwoFullOrders) {
+    VecOwn<Relation> relations;
+    relations.emplace_back(new Relation("path", 3, 0, {"x", "y", "z"}, {"i:number", "i:number", "i:number"},
+            RelationRepresentation::BTREE));
+    for (const std::string name : {"@delta_path", "@new_path", "query", "result"}) {
+        relations.emplace_back(new Relation(name, 3, 0, {"x", "y", "z"},
+                {"i:number", "i:number", "i:number"}, RelationRepresentation::DEFAULT));
+    }
+
+    // the fixpoint inserts into path without searching it
+    VecOwn<Expression> path;
+    path.emplace_back(new TupleElement(0, 0));
+    path.emplace_back(new TupleElement(0, 1));
+    path.emplace_back(new TupleElement(0, 2));
+    VecOwn<Statement> loop;
+    loop.push_back(mk<Query>(mk<Scan>("@new_path", 0, mk<Insert>("path", std::move(path)))));
+    loop.push_back(mk<Swap>("@delta_path", "@new_path"));
+
+    // later strata search the complete path by two columns and a range of the third,
+    // each over all columns but in a different order
+    // FOR t0 IN query
+    //  FOR t1 IN path ON INDEX t0.0 <= t1.x <= 100 AND t1.y = t0.1 AND t1.z = t0.2
+    //   INSERT (t1.0, t1.1, t1.2) INTO result
+    // FOR t0 IN query
+    //  FOR t1 IN path ON INDEX t1.x = t0.0 AND t1.y = t0.1 AND t0.2 <= t1.z <= 100
+    //   INSERT (t1.0, t1.1, t1.2) INTO result
+    VecOwn<Statement> statements;
+    statements.push_back(mk<Loop>(mk<Sequence>(std::move(loop))));
+    for (std::size_t range : {0, 2}) {
+        RamPattern queryPattern;
+        for (std::size_t i = 0; i < 3; i++) {
+            queryPattern.first.emplace_back(new TupleElement(0, i));
+            if (i == range) {
+                queryPattern.second.emplace_back(new SignedConstant(100));
+            } else {
+                queryPattern.second.emplace_back(new TupleElement(0, i));
+            }
+        }
+        VecOwn<Expression> result;
+        for (std::size_t i = 0; i < 3; i++) {
+            result.emplace_back(new TupleElement(1, i));
+        }
+        statements.push_back(mk<Query>(mk<Scan>("query", 0,
+                mk<IndexScan>("path", 1, std::move(queryPattern), mk<Insert>("result", std::move(result))))));
+    }
+
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(mk<Program>(std::move(relations), mk<Sequence>(std::move(statements)),
+                                            std::map<std::string, Own<Statement>>()),
+            errorReport, debugReport);
+    const auto& selection = translationUnit.getAnalysis<IndexAnalysis>()->getIndexSelection("path");
+
+    // only the master index, the first one over all columns, holds the tuples during the loop
+    const auto orders = selection.getAllOrders();
+    EXPECT_EQ(2, orders.size());
+    EXPECT_EQ(3, orders[0].size());
+    EXPECT_EQ(3, orders[1].size());
+    EXPECT_EQ(0, selection.getMasterOrderNum(3));
+    EXPECT_FALSE(selection.isLazyOrder(orders[0]));
+    EXPECT_TRUE(selection.isLazyOrder(orders[1]));
+}
+
+}  // namespace test
+}  // namespace souffle::ram
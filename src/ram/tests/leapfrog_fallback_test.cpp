@@ -0,0 +1,172 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file leapfrog_fallback_test.cpp
+ *
+ * Tests the replacement of leapfrog joins by nested loops.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "RelationTag.h"
+#include "ram/Condition.h"
+#include "ram/Conjunction.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/LeapfrogJoin.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/analysis/Index.h"
+#include "ram/transform/LeapfrogFallback.h"
+#include "ram/utility/Visitor.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace souffle::ram {
+
+using analysis::IndexAnalysis;
+using transform::LeapfrogFallbackTransformer;
+
+namespace test {
+
+/**
+ * LEAPFROG t1.0 IN edge(t0.0,t1.0) AND edge(t1.0,_)
+ *  LEAPFROG t2.0 IN edge(t1.0,t2.0) AND edge(t2.0,t0.0)
+ *   INSERT (t0.0, t1.0, t2.0) INTO triangle
+ */
+Own<LeapfrogJoin> makeTriangleJoin() {
+    VecOwn<Expression> values;
+    for (int i = 0; i < 3; i++) {
+        values.emplace_back(new TupleElement(i, 0));
+    }
+    std::vector<VecOwn<Expression>> innerPatterns;
+    innerPatterns.emplace_back();
+    innerPatterns.back().emplace_back(new TupleElement(1, 0));
+    innerPatterns.back().emplace_back(new UndefValue);
+    innerPatterns.emplace_back();
+    innerPatterns.back().emplace_back(new UndefValue);
+    innerPatterns.back().emplace_back(new TupleElement(0, 0));
+    auto inner = mk<LeapfrogJoin>(std::vector<std::string>{"edge", "edge"}, std::move(innerPatterns),
+            std::vector<std::size_t>{1, 0}, 2, mk<Insert>("triangle", std::move(values)));
+
+    std::vector<VecOwn<Expression>> outerPatterns;
+    outerPatterns.emplace_back();
+    outerPatterns.back().emplace_back(new TupleElement(0, 0));
+    outerPatterns.back().emplace_back(new UndefValue);
+    outerPatterns.emplace_back();
+    outerPatterns.back().emplace_back(new UndefValue);
+    outerPatterns.back().emplace_back(new UndefValue);
+    return mk<LeapfrogJoin>(std::vector<std::string>{"edge", "edge"}, std::move(outerPatterns),
+            std::vector<std::size_t>{1, 0}, 1, std::move(inner));
+}
+
+/** Triangles of edges, each starting at a node of the unary relation node */
+Own<Program> makeProgram() {
+    VecOwn<Relation> relations;
+    relations.emplace_back(new Relation("node", 1, 0, {"x"}, {"i:number"}, RelationRepresentation::DEFAULT));
+    relations.emplace_back(
+            new Relation("edge", 2, 0, {"x", "y"}, {"i:number", "i:number"}, RelationRepresentation::BTREE));
+    relations.emplace_back(new Relation("triangle", 3, 0, {"x", "y", "z"},
+            {"i:number", "i:number", "i:number"}, RelationRepresentation::BTREE));
+
+    VecOwn<Statement> statements;
+    statements.push_back(mk<Query>(mk<Scan>("node", 0, makeTriangleJoin())));
+    return mk<Program>(std::move(relations), mk<Sequence>(std::move(statements)),
+            std::map<std::string, Own<Statement>>());
+}
+
+TEST(LeapfrogFallback, Seekable) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(makeProgram(), errorReport, debugReport);
+    const auto* indexAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+    visit(translationUnit.getProgram(), [&](const LeapfrogJoin& join) {
+        for (std::size_t i = 0; i < join.getNumRelations(); i++) {
+            EXPECT_TRUE(indexAnalysis->isSeekable(&join, i));
+        }
+    });
+    EXPECT_FALSE(LeapfrogFallbackTransformer().apply(translationUnit));
+}
+
+TEST(LeapfrogFallback, NestedLoop) {
+    const auto join = makeTriangleJoin();
+    const auto loop = LeapfrogFallbackTransformer::toNestedLoop(*join);
+
+    // FOR t1 IN edge ON INDEX t1.0 = t0.0
+    //  IF (t1.1,_) IN edge
+    //   LEAPFROG t2.0 IN edge(t1.1,t2.0) AND edge(t2.0,t0.0)
+    //    INSERT (t0.0, t1.1, t2.0) INTO triangle
+    const auto* scan = as<IndexScan>(loop);
+    EXPECT_TRUE(scan != nullptr);
+    EXPECT_EQ("edge", scan->getRelation());
+    EXPECT_EQ(1, scan->getTupleId());
+    const auto pattern = scan->getRangePattern();
+    EXPECT_EQ(TupleElement(0, 0), *pattern.first[0]);
+    EXPECT_EQ(TupleElement(0, 0), *pattern.second[0]);
+    EXPECT_TRUE(isUndefValue(pattern.first[1]));
+    EXPECT_TRUE(isUndefValue(pattern.second[1]));
+
+    const auto* filter = as<Filter>(scan->getOperation());
+    EXPECT_TRUE(filter != nullptr);
+    VecOwn<Expression> values;
+    values.emplace_back(new TupleElement(1, 1));
+    values.emplace_back(new UndefValue);
+    EXPECT_EQ(ExistenceCheck("edge", std::move(values)), filter->getCondition());
+
+    const auto* inner = as<LeapfrogJoin>(filter->getOperation());
+    EXPECT_TRUE(inner != nullptr);
+    EXPECT_EQ(TupleElement(1, 1), *inner->getPattern(0)[0]);
+    EXPECT_EQ(TupleElement(0, 0), *inner->getPattern(1)[1]);
+    const auto* insert = as<Insert>(inner->getOperation());
+    EXPECT_TRUE(insert != nullptr);
+    EXPECT_EQ(TupleElement(0, 0), *insert->getValues()[0]);
+    EXPECT_EQ(TupleElement(1, 1), *insert->getValues()[1]);
+    EXPECT_EQ(TupleElement(2, 0), *insert->getValues()[2]);
+
+    // a join without bound attributes scans its first relation
+    std::vector<VecOwn<Expression>> patterns;
+    patterns.emplace_back();
+    patterns.back().emplace_back(new UndefValue);
+    patterns.back().emplace_back(new UndefValue);
+    patterns.emplace_back();
+    patterns.back().emplace_back(new UndefValue);
+    VecOwn<Expression> targets;
+    targets.emplace_back(new TupleElement(1, 0));
+    const LeapfrogJoin unbound(std::vector<std::string>{"edge", "node"}, std::move(patterns),
+            std::vector<std::size_t>{1, 0}, 1, mk<Insert>("target", std::move(targets)));
+    const auto fullLoop = LeapfrogFallbackTransformer::toNestedLoop(unbound);
+    EXPECT_TRUE(isA<Scan>(fullLoop));
+    EXPECT_FALSE(isA<IndexScan>(fullLoop));
+    const auto* fullFilter = as<Filter>(as<Scan>(fullLoop)->getOperation());
+    EXPECT_TRUE(fullFilter != nullptr);
+    VecOwn<Expression> nodeValues;
+    nodeValues.emplace_back(new TupleElement(1, 1));
+    EXPECT_EQ(ExistenceCheck("node", std::move(nodeValues)), fullFilter->getCondition());
+    VecOwn<Expression> targetValues;
+    targetValues.emplace_back(new TupleElement(1, 1));
+    EXPECT_EQ(Insert("target", std::move(targetValues)), fullFilter->getOperation());
+}
+
+}  // namespace test
+}  // namespace souffle::ram
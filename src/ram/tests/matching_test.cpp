@@ -118,4 +118,74 @@ TEST(Matching, TestOver64BitSignature) {
     EXPECT_EQ(num, 2);
 }
 
+TEST(Matching, WeightedKeepsFrequentSearches) {
+    WeightedIndexSelectionStrategy order;
+    std::size_t arity = 3;
+
+    SearchSignature first = setBits(arity, 1);
+    SearchSignature second = setBits(arity, 2);
+    SearchSignature full = setBits(arity, 7);
+    SearchSet searches = {first, second, full};
+
+    SearchStatistics statistics;
+    statistics.size = 1000;
+    statistics.runs = {{first, 1000}, {second, 1000000}};
+    auto selection = order.solve(searches, statistics);
+    EXPECT_EQ(selection.getAllOrders().size(), 2);
+    EXPECT_EQ(selection.getRelaxedSearch(second), second);
+    EXPECT_FALSE(selection.hasRelaxedSearches());
+}
+
+TEST(Matching, WeightedRelaxesRareSearches) {
+    WeightedIndexSelectionStrategy order;
+    std::size_t arity = 3;
+
+    SearchSignature first = setBits(arity, 1);
+    SearchSignature second = setBits(arity, 2);
+    SearchSignature full = setBits(arity, 7);
+    SearchSet searches = {first, second, full};
+
+    // without a profile, every search has an index
+    EXPECT_EQ(order.solve(searches).getAllOrders().size(), 2);
+
+    // the second column is searched too rarely to be worth an index of its own
+    SearchStatistics statistics;
+    statistics.size = 1000;
+    statistics.runs = {{first, 1000}, {second, 1}};
+    auto selection = order.solve(searches, statistics);
+    EXPECT_EQ(selection.getAllOrders().size(), 1);
+    EXPECT_TRUE(selection.getRelaxedSearch(second).empty());
+    EXPECT_EQ(selection.getRelaxedSearch(first), first);
+    EXPECT_EQ(selection.getSearches().size(), 2);
+
+    // searches without runs keep their index
+    statistics.runs.erase(second);
+    EXPECT_EQ(order.solve(searches, statistics).getAllOrders().size(), 2);
+}
+
+TEST(Matching, WeightedRelaxesToRangePrefix) {
+    WeightedIndexSelectionStrategy order;
+    std::size_t arity = 3;
+
+    SearchSignature first = setBits(arity, 1);
+    SearchSignature second = setBits(arity, 5);
+    SearchSignature full = setBits(arity, 7);
+    SearchSignature range = setBits(arity, 3);
+    range[2] = AttributeConstraint::Inequal;
+    SearchSet searches = {first, second, full, range};
+
+    SearchStatistics statistics;
+    statistics.size = 100000;
+    statistics.runs = {{first, 100}, {second, 100}, {range, 10}};
+    auto selection = order.solve(searches, statistics);
+    EXPECT_EQ(selection.getAllOrders().size(), 1);
+    EXPECT_EQ(selection.getAllOrders()[0], LexOrder({0, 2, 1}));
+
+    // the range on the third column follows the equality on the first column in the order
+    SearchSignature relaxed = setBits(arity, 1);
+    relaxed[2] = AttributeConstraint::Inequal;
+    EXPECT_EQ(selection.getRelaxedSearch(range), relaxed);
+    EXPECT_EQ(selection.getLexOrder(relaxed), LexOrder({0, 2, 1}));
+}
+
 }  // namespace souffle::ram
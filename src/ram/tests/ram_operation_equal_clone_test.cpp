@@ -32,6 +32,7 @@
 #include "ram/IndexIfExists.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
+#include "ram/LeapfrogJoin.h"
 #include "ram/Negation.h"
 #include "ram/Operation.h"
 #include "ram/PackRecord.h"
@@ -175,6 +176,43 @@ TEST(RamParallelIndexScan, CloneAndEquals) {
     delete c;
 }
 
+TEST(RamLeapfrogJoin, CloneAndEquals) {
+    Relation edge("edge", 2, 1, {"x", "y"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    Relation vertex("vertex", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    // successors of vertex t0.0 with a successor
+    // LEAPFROG t1.0 IN edge(t0.0,t1.0) AND edge(t1.0,_)
+    //  INSERT (t1.0) INTO vertex
+    auto makeJoin = []() {
+        VecOwn<Expression> insert_args;
+        insert_args.emplace_back(new TupleElement(1, 0));
+        auto insert = mk<Insert>("vertex", std::move(insert_args));
+        std::vector<VecOwn<Expression>> patterns(2);
+        patterns[0].emplace_back(new TupleElement(0, 0));
+        patterns[0].emplace_back(new UndefValue);
+        patterns[1].emplace_back(new UndefValue);
+        patterns[1].emplace_back(new UndefValue);
+        return mk<LeapfrogJoin>(std::vector<std::string>{"edge", "edge"}, std::move(patterns),
+                std::vector<std::size_t>{1, 0}, 1, std::move(insert));
+    };
+
+    auto a = makeJoin();
+    auto b = makeJoin();
+    EXPECT_EQ(*a, *b);
+    EXPECT_NE(a.get(), b.get());
+
+    LeapfrogJoin* c = a->cloning();
+    EXPECT_EQ(*a, *c);
+    EXPECT_NE(a.get(), c);
+    delete c;
+
+    // joining on another column differs
+    std::vector<VecOwn<Expression>> patterns(1);
+    patterns[0].emplace_back(new UndefValue);
+    patterns[0].emplace_back(new UndefValue);
+    LeapfrogJoin d({"edge"}, std::move(patterns), {0}, 1, clone(a->getOperation()));
+    EXPECT_FALSE(*a == d);
+}
+
 TEST(RamIfExists, CloneAndEquals) {
     Relation edge("edge", 2, 1, {"x", "y"}, {"i", "i"}, RelationRepresentation::DEFAULT);
     // choose an edge not adjcent to vertex 5
@@ -494,6 +532,18 @@ TEST(RamInsert, CloneAndEquals) {
     EXPECT_EQ(a, *c);
     EXPECT_NE(&a, c);
     delete c;
+
+    // BUFFERED INSERT (t0.1, t0.3) INTO A
+    VecOwn<Expression> d_args;
+    d_args.emplace_back(new TupleElement(0, 1));
+    d_args.emplace_back(new TupleElement(0, 3));
+    Insert d("A", std::move(d_args), true);
+    EXPECT_NE(a, d);
+
+    Insert* e = d.cloning();
+    EXPECT_EQ(d, *e);
+    EXPECT_TRUE(e->isBuffered());
+    delete e;
 }
 
 TEST(RamSubroutineReturn, CloneAndEquals) {
@@ -90,6 +90,15 @@ TEST(Clear, CloneAndEquals) {
     EXPECT_EQ(a, *c);
     EXPECT_NE(&a, c);
     delete c;
+
+    // CLEAR A REFILLED
+    Clear d("A", true);
+    EXPECT_NE(a, d);
+
+    Clear* e = d.cloning();
+    EXPECT_EQ(d, *e);
+    EXPECT_TRUE(e->isRefilled());
+    delete e;
 }
 
 TEST(Extend, CloneAndEquals) {
@@ -0,0 +1,184 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file relax_index_test.cpp
+ *
+ * Tests the relaxation of rarely run searches to a prefix of another index.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Condition.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/transform/RelaxIndex.h"
+#include "ram/utility/Visitor.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace souffle::ram {
+
+using transform::RelaxIndexTransformer;
+
+namespace test {
+
+/**
+ * FOR t0 IN q
+ *  FOR t1 IN relation ON INDEX t1.x = t0.0 AND t1.y = t0.0
+ *   INSERT (t1.x, t1.y, t1.z) INTO out
+ *
+ * where a pattern binds column y if eq1 is set, and ranges over column z from
+ * t0.0 to 100 otherwise. The runs of the index scan are profiled as rule.
+ */
+Own<Statement> makeQuery(const std::string& relation, const std::string& rule, bool eq0, bool eq1) {
+    RamPattern pattern;
+    pattern.first.emplace_back(eq0 ? static_cast<Expression*>(new TupleElement(0, 0)) : new UndefValue);
+    pattern.second.emplace_back(eq0 ? static_cast<Expression*>(new TupleElement(0, 0)) : new UndefValue);
+    pattern.first.emplace_back(eq1 ? static_cast<Expression*>(new TupleElement(0, 0)) : new UndefValue);
+    pattern.second.emplace_back(eq1 ? static_cast<Expression*>(new TupleElement(0, 0)) : new UndefValue);
+    pattern.first.emplace_back(eq1 ? static_cast<Expression*>(new UndefValue) : new TupleElement(0, 0));
+    pattern.second.emplace_back(eq1 ? static_cast<Expression*>(new UndefValue) : new SignedConstant(100));
+
+    VecOwn<Expression> values;
+    for (std::size_t i = 0; i < 3; i++) {
+        values.emplace_back(new TupleElement(1, i));
+    }
+    return mk<Query>(mk<Scan>("q", 0,
+            mk<IndexScan>(relation, 1, std::move(pattern), mk<Insert>("out", std::move(values))),
+            "@frequency-atom;out;0;" + rule + ";" + relation + "(x,y,z);" + rule + ";1;"));
+}
+
+/**
+ * A program whose relations r and s are searched often by a prefix of their
+ * columns, and rarely by a range over column z.
+ */
+Own<Program> makeProgram() {
+    VecOwn<Relation> relations;
+    relations.emplace_back(new Relation("q", 1, 0, {"x"}, {"i:number"}, RelationRepresentation::DEFAULT));
+    for (const std::string name : {"r", "s", "out"}) {
+        relations.emplace_back(new Relation(name, 3, 0, {"x", "y", "z"}, {"i:number", "i:number", "i:number"},
+                RelationRepresentation::DEFAULT));
+    }
+
+    VecOwn<Statement> statements;
+    statements.push_back(makeQuery("r", "r_hot", true, true));
+    statements.push_back(makeQuery("r", "r_cold", true, false));
+    statements.push_back(makeQuery("s", "s_hot", true, true));
+    statements.push_back(makeQuery("s", "s_cold", false, false));
+    return mk<Program>(std::move(relations), mk<Sequence>(std::move(statements)),
+            std::map<std::string, Own<Statement>>());
+}
+
+/** Operations nested directly in the outer scan of each query */
+std::vector<const Operation*> getSearches(const Program& program) {
+    std::vector<const Operation*> searches;
+    visit(program, [&](const Query& query) {
+        searches.push_back(&as<Scan>(query.getOperation())->getOperation());
+    });
+    return searches;
+}
+
+TEST(RelaxIndex, WithoutProfile) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(makeProgram(), errorReport, debugReport);
+    EXPECT_FALSE(RelaxIndexTransformer().apply(translationUnit));
+}
+
+TEST(RelaxIndex, WithProfile) {
+    const std::string profile = "relax_index_test.json";
+    std::ofstream(profile) << R"json({ "root": { "program": { "relation": {
+        "r": { "num-tuples": 10000 },
+        "s": { "num-tuples": 10000 },
+        "out": { "num-tuples": 100, "non-recursive-rule": {
+            "r_hot": { "source-locator": "relax_index_test.dl [1:1-1:30]",
+                "atom-frequency": { "r_hot": { "r(x,y,z)": { "level": 1, "num-tuples": 1000000 } } } },
+            "r_cold": { "source-locator": "relax_index_test.dl [2:1-2:30]",
+                "atom-frequency": { "r_cold": { "r(x,y,z)": { "level": 1, "num-tuples": 10 } } } },
+            "s_hot": { "source-locator": "relax_index_test.dl [3:1-3:30]",
+                "atom-frequency": { "s_hot": { "s(x,y,z)": { "level": 1, "num-tuples": 1000000 } } } },
+            "s_cold": { "source-locator": "relax_index_test.dl [4:1-4:30]",
+                "atom-frequency": { "s_cold": { "s(x,y,z)": { "level": 1, "num-tuples": 1 } } } }
+        } }
+    } } } })json";
+    Global::config().set("profile-use", profile);
+
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    TranslationUnit translationUnit(makeProgram(), errorReport, debugReport);
+    const bool changed = RelaxIndexTransformer().apply(translationUnit);
+    Global::config().unset("profile-use");
+    std::remove(profile.c_str());
+
+    EXPECT_TRUE(changed);
+    const auto originalProgram = makeProgram();
+    const auto original = getSearches(*originalProgram);
+    const auto searches = getSearches(translationUnit.getProgram());
+    EXPECT_EQ(4, searches.size());
+
+    // t1.z >= t0.0 AND t1.z <= 100
+    Conjunction range(mk<Constraint>(BinaryConstraintOp::GE, mk<TupleElement>(1, 2), mk<TupleElement>(0, 0)),
+            mk<Constraint>(BinaryConstraintOp::LE, mk<TupleElement>(1, 2), mk<SignedConstant>(100)));
+
+    // the frequent searches keep their indexes
+    EXPECT_EQ(*original[0], *searches[0]);
+    EXPECT_EQ(*original[2], *searches[2]);
+
+    // the range over r is answered by the index of x and y, searched by x only
+    const auto* relaxedScan = as<IndexScan>(searches[1]);
+    EXPECT_TRUE(relaxedScan != nullptr);
+    const auto pattern = relaxedScan->getRangePattern();
+    EXPECT_EQ(TupleElement(0, 0), *pattern.first[0]);
+    EXPECT_EQ(TupleElement(0, 0), *pattern.second[0]);
+    for (std::size_t i = 1; i < 3; i++) {
+        EXPECT_TRUE(isUndefValue(pattern.first[i]));
+        EXPECT_TRUE(isUndefValue(pattern.second[i]));
+    }
+    const auto* relaxedFilter = as<Filter>(relaxedScan->getOperation());
+    EXPECT_TRUE(relaxedFilter != nullptr);
+    EXPECT_EQ(range, relaxedFilter->getCondition());
+    EXPECT_EQ(as<IndexScan>(original[1])->getOperation(), relaxedFilter->getOperation());
+
+    // no prefix of the index of s binds z, so the range over s scans the relation
+    const auto* fullScan = as<Scan>(searches[3]);
+    EXPECT_TRUE(fullScan != nullptr);
+    EXPECT_FALSE(isA<IndexScan>(searches[3]));
+    EXPECT_EQ("s", fullScan->getRelation());
+    const auto* fullFilter = as<Filter>(fullScan->getOperation());
+    EXPECT_TRUE(fullFilter != nullptr);
+    EXPECT_EQ(range, fullFilter->getCondition());
+    EXPECT_EQ(as<IndexScan>(original[3])->getOperation(), fullFilter->getOperation());
+}
+
+}  // namespace test
+}  // namespace souffle::ram
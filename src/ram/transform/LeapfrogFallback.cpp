@@ -0,0 +1,105 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LeapfrogFallback.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/LeapfrogFallback.h"
+#include "ram/Condition.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/Node.h"
+#include "ram/Query.h"
+#include "ram/Scan.h"
+#include "ram/TupleElement.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+Own<Operation> LeapfrogFallbackTransformer::toNestedLoop(const LeapfrogJoin& join) {
+    const int identifier = join.getTupleId();
+    const std::size_t column = join.getColumn(0);
+
+    // the value of the join is the join column of the scanned tuple
+    std::function<Own<Node>(Own<Node>)> joinValue = [&](Own<Node> node) -> Own<Node> {
+        if (const auto* element = as<TupleElement>(node)) {
+            if (element->getTupleId() == identifier) {
+                return mk<TupleElement>(identifier, column);
+            }
+        }
+        node->apply(makeLambdaRamMapper(joinValue));
+        return node;
+    };
+    Own<Operation> nested = clone(join.getOperation());
+    nested->apply(makeLambdaRamMapper(joinValue));
+
+    // the other relations must contain the value in their join columns
+    VecOwn<Condition> conditions;
+    for (std::size_t i = 1; i < join.getNumRelations(); i++) {
+        VecOwn<Expression> values;
+        const auto pattern = join.getPattern(i);
+        for (std::size_t j = 0; j < pattern.size(); j++) {
+            if (j == join.getColumn(i)) {
+                values.push_back(mk<TupleElement>(identifier, column));
+            } else {
+                values.push_back(clone(pattern[j]));
+            }
+        }
+        conditions.push_back(mk<ExistenceCheck>(join.getRelation(i), std::move(values)));
+    }
+    if (!conditions.empty()) {
+        nested = mk<Filter>(toCondition(conditions), std::move(nested));
+    }
+
+    const auto pattern = join.getPattern(0);
+    if (std::all_of(pattern.begin(), pattern.end(), [](const Expression* e) { return isUndefValue(e); })) {
+        return mk<Scan>(join.getRelation(0), identifier, std::move(nested), join.getProfileText());
+    }
+    RamPattern range;
+    for (const auto* value : pattern) {
+        range.first.push_back(clone(value));
+        range.second.push_back(clone(value));
+    }
+    return mk<IndexScan>(
+            join.getRelation(0), identifier, std::move(range), std::move(nested), join.getProfileText());
+}
+
+bool LeapfrogFallbackTransformer::replaceLeapfrogJoins(Program& program) {
+    bool changed = false;
+    visit(program, [&](const Query& query) {
+        std::function<Own<Node>(Own<Node>)> joinRewriter = [&](Own<Node> node) -> Own<Node> {
+            if (const auto* join = as<LeapfrogJoin>(node)) {
+                bool seekable = true;
+                for (std::size_t i = 0; i < join->getNumRelations(); i++) {
+                    seekable = seekable && idxAnalysis->isSeekable(join, i);
+                }
+                if (!seekable) {
+                    node = toNestedLoop(*join);
+                    changed = true;
+                }
+            }
+            node->apply(makeLambdaRamMapper(joinRewriter));
+            return node;
+        };
+        const_cast<Query*>(&query)->apply(makeLambdaRamMapper(joinRewriter));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,88 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LeapfrogFallback.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/LeapfrogJoin.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Index.h"
+#include "ram/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class LeapfrogFallbackTransformer
+ * @brief Replaces leapfrog joins that cannot seek in their indexes by nested loops
+ *
+ * A leapfrog join seeks the values of its join column in the index of each
+ * relation, which requires the index to order the join column right after the
+ * bound attributes of the pattern. If the index selection does not provide
+ * such an index for a relation, the join enumerates the values of the first
+ * relation and checks the others for each of them instead.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    LEAPFROG t1.0 IN edge(t0.0,t1.0) AND edge(t1.0,_)
+ *     ... t1.0 ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    FOR t1 IN edge ON INDEX t1.0 = t0.0
+ *     IF (t1.1,_) IN edge
+ *      ... t1.1 ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * As the searches of the rewritten operations change the index selection,
+ * the transformer is applied until no leapfrog join is replaced.
+ */
+class LeapfrogFallbackTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "LeapfrogFallbackTransformer";
+    }
+
+    /**
+     * @brief Replace the leapfrog joins of the program that cannot seek in their indexes
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool replaceLeapfrogJoins(Program& program);
+
+    /**
+     * @brief Translate a leapfrog join to a loop over its first relation
+     * @param join the leapfrog join
+     * @return a scan of the first relation checking the other relations for its join column
+     */
+    static Own<Operation> toNestedLoop(const LeapfrogJoin& join);
+
+protected:
+    analysis::IndexAnalysis* idxAnalysis{nullptr};
+
+    bool transform(TranslationUnit& translationUnit) override {
+        idxAnalysis = translationUnit.getAnalysis<analysis::IndexAnalysis>();
+        return replaceLeapfrogJoins(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
@@ -13,6 +13,8 @@
  ***********************************************************************/
 
 #include "ram/transform/Parallel.h"
+#include "Global.h"
+#include "RelationTag.h"
 #include "ram/Condition.h"
 #include "ram/Expression.h"
 #include "ram/Node.h"
@@ -20,6 +22,7 @@
 #include "ram/Program.h"
 #include "ram/Relation.h"
 #include "ram/Statement.h"
+#include "ram/SubroutineReturn.h"
 #include "ram/utility/Visitor.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
@@ -96,13 +99,76 @@ bool ParallelTransformer::parallelizeOperations(Program& program) {
             node->apply(makeLambdaRamMapper(parallelRewriter));
             return node;
         };
-        // guardedInsert cannot be parallelized
+        // guardedInsert cannot be parallelized, nor can the values returned by a subroutine,
+        // which are appended tuple by tuple
         bool isGuardedInsert = false;
         visit(query, [&](const GuardedInsert&) { isGuardedInsert = true; });
+        visit(query, [&](const SubroutineReturn&) { isGuardedInsert = true; });
         if (isGuardedInsert == false) {
             const_cast<Query*>(&query)->apply(makeLambdaRamMapper(parallelRewriter));
+            if (bufferInserts(*const_cast<Query*>(&query))) {
+                changed = true;
+            }
+        }
+    });
+    return changed;
+}
+
+bool ParallelTransformer::isContended(const Query& query, const Insert& insert) const {
+    const Relation& rel = relAnalysis->lookup(insert.getRelation());
+    if (rel.isNullary() || rel.getRepresentation() == RelationRepresentation::EQREL ||
+            Global::config().has("provenance")) {
+        return false;
+    }
+
+    // a query reading its target relation must observe its own insertions
+    bool readsTarget = false;
+    visit(query, [&](const RelationOperation& op) {
+        readsTarget |= op.getRelation() == insert.getRelation();
+    });
+    visit(query, [&](const AbstractExistenceCheck& check) {
+        readsTarget |= check.getRelation() == insert.getRelation();
+    });
+    visit(query, [&](const LeapfrogJoin& join) {
+        for (std::size_t i = 0; i < join.getNumRelations(); i++) {
+            readsTarget |= join.getRelation(i) == insert.getRelation();
         }
     });
+    if (readsTarget) {
+        return false;
+    }
+
+    // If the leading value stems from the partitioned tuple, the threads insert
+    // into mostly disjoint ranges of the target relation. Otherwise, e.g., for
+    // constants or values of inner loops, all threads compete for the same nodes.
+    const auto* leading = as<TupleElement>(insert.getValues()[0]);
+    return leading == nullptr || leading->getTupleId() != 0;
+}
+
+bool ParallelTransformer::bufferInserts(Query& query) {
+    // only the partitions of parallel loops run concurrently; parallel
+    // aggregates are reduced by each thread instead
+    bool isParallelLoop = false;
+    visit(query, [&](const ParallelScan&) { isParallelLoop = true; });
+    visit(query, [&](const ParallelIndexScan&) { isParallelLoop = true; });
+    visit(query, [&](const ParallelIfExists&) { isParallelLoop = true; });
+    visit(query, [&](const ParallelIndexIfExists&) { isParallelLoop = true; });
+    if (!isParallelLoop) {
+        return false;
+    }
+
+    bool changed = false;
+    std::function<Own<Node>(Own<Node>)> bufferRewriter = [&](Own<Node> node) -> Own<Node> {
+        if (const auto* insert = as<Insert>(node)) {
+            if (!isA<GuardedInsert>(insert) && !insert->isBuffered() && isContended(query, *insert)) {
+                changed = true;
+                return mk<Insert>(insert->getRelation(), clone(insert->getValues()), true);
+            }
+        }
+        node->apply(makeLambdaRamMapper(bufferRewriter));
+        return node;
+    };
+    query.apply(makeLambdaRamMapper(bufferRewriter));
     return changed;
 }
 
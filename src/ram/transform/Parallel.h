@@ -14,7 +14,9 @@
 
 #pragma once
 
+#include "ram/Insert.h"
 #include "ram/Program.h"
+#include "ram/Query.h"
 #include "ram/TranslationUnit.h"
 #include "ram/analysis/Relation.h"
 #include "ram/transform/Transformer.h"
@@ -42,6 +44,10 @@ namespace souffle::ram::transform {
  *     ...
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
  *
+ * Inserts of a parallel loop whose leading value does not stem from the
+ * partitioned tuple t0 are likely to collide across threads in the target
+ * relation. They are turned into buffered inserts, which are merged into the
+ * target relation in bulk after the query.
  */
 class ParallelTransformer : public Transformer {
 public:
@@ -57,6 +63,12 @@ public:
     bool parallelizeOperations(Program& program);
 
 protected:
+    /** Marks the contended inserts of a parallel query as buffered */
+    bool bufferInserts(Query& query);
+
+    /** Estimates whether threads of a parallel query compete for the target of the insert */
+    bool isContended(const Query& query, const Insert& insert) const;
+
     bool transform(TranslationUnit& translationUnit) override {
         relAnalysis = translationUnit.getAnalysis<analysis::RelationAnalysis>();
         return parallelizeOperations(translationUnit.getProgram());
@@ -0,0 +1,130 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RelaxIndex.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/RelaxIndex.h"
+#include "ram/Condition.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IfExists.h"
+#include "ram/IndexIfExists.h"
+#include "ram/IndexScan.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/ParallelIndexIfExists.h"
+#include "ram/ParallelIndexScan.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/MiscUtil.h"
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+using analysis::AttributeConstraint;
+using analysis::SearchSignature;
+
+Own<Condition> RelaxIndexTransformer::relaxPattern(
+        const IndexOperation& search, const SearchSignature& relaxed, RamPattern& pattern) {
+    const auto& attributeTypes = relAnalysis->lookup(search.getRelation()).getAttributeTypes();
+    const auto lower = search.getRangePattern().first;
+    const auto upper = search.getRangePattern().second;
+    const int identifier = search.getTupleId();
+
+    VecOwn<Condition> conditions;
+    for (std::size_t i = 0; i < lower.size(); i++) {
+        if (relaxed[i] != AttributeConstraint::None) {
+            pattern.first.push_back(clone(lower[i]));
+            pattern.second.push_back(clone(upper[i]));
+            continue;
+        }
+        pattern.first.push_back(mk<UndefValue>());
+        pattern.second.push_back(mk<UndefValue>());
+
+        // check the bounds of the column that is no longer searched on the index
+        const auto& type = attributeTypes[i];
+        if (isUndefValue(lower[i]) && isUndefValue(upper[i])) {
+            continue;
+        } else if (*lower[i] == *upper[i]) {
+            conditions.push_back(
+                    mk<Constraint>(getEqConstraint(type), mk<TupleElement>(identifier, i), clone(lower[i])));
+            continue;
+        }
+        if (!isUndefValue(lower[i])) {
+            conditions.push_back(mk<Constraint>(
+                    getGreaterEqualConstraint(type), mk<TupleElement>(identifier, i), clone(lower[i])));
+        }
+        if (!isUndefValue(upper[i])) {
+            conditions.push_back(mk<Constraint>(
+                    getLessEqualConstraint(type), mk<TupleElement>(identifier, i), clone(upper[i])));
+        }
+    }
+    return toCondition(conditions);
+}
+
+bool RelaxIndexTransformer::relaxSearches(Program& program) {
+    bool changed = false;
+    visit(program, [&](const Query& query) {
+        std::function<Own<Node>(Own<Node>)> searchRewriter = [&](Own<Node> node) -> Own<Node> {
+            const auto* search = as<IndexOperation>(node);
+            if (search != nullptr && !isA<ParallelIndexScan>(node) && !isA<ParallelIndexIfExists>(node)) {
+                const SearchSignature signature = idxAnalysis->getSearchSignature(search);
+                const SearchSignature relaxed =
+                        idxAnalysis->getIndexSelection(search->getRelation()).getRelaxedSearch(signature);
+                if (relaxed != signature) {
+                    RamPattern pattern;
+                    Own<Condition> condition = relaxPattern(*search, relaxed, pattern);
+                    const std::string& rel = search->getRelation();
+                    const int identifier = search->getTupleId();
+                    if (const auto* indexScan = as<IndexScan>(node)) {
+                        auto nested = mk<Filter>(std::move(condition), clone(indexScan->getOperation()));
+                        if (relaxed.empty()) {
+                            node = mk<Scan>(rel, identifier, std::move(nested), indexScan->getProfileText());
+                        } else {
+                            node = mk<IndexScan>(rel, identifier, std::move(pattern), std::move(nested),
+                                    indexScan->getProfileText());
+                        }
+                        changed = true;
+                    } else if (const auto* indexIfExists = as<IndexIfExists>(node)) {
+                        condition = mk<Conjunction>(
+                                std::move(condition), clone(indexIfExists->getCondition()));
+                        if (relaxed.empty()) {
+                            node = mk<IfExists>(rel, identifier, std::move(condition),
+                                    clone(indexIfExists->getOperation()), indexIfExists->getProfileText());
+                        } else {
+                            node = mk<IndexIfExists>(rel, identifier, std::move(condition),
+                                    std::move(pattern), clone(indexIfExists->getOperation()),
+                                    indexIfExists->getProfileText());
+                        }
+                        changed = true;
+                    }
+                }
+            }
+            node->apply(makeLambdaRamMapper(searchRewriter));
+            return node;
+        };
+        const_cast<Query*>(&query)->apply(makeLambdaRamMapper(searchRewriter));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
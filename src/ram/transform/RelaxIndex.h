@@ -0,0 +1,93 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RelaxIndex.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Condition.h"
+#include "ram/IndexOperation.h"
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Index.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include <memory>
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class RelaxIndexTransformer
+ * @brief Answers searches without an index of their own by a prefix of
+ *        another index and a filter
+ *
+ * With a profile, the index analysis may drop rarely run searches from the
+ * index cover of a relation if the indexes they need cost more to maintain
+ * than they save (see WeightedIndexSelectionStrategy). Such a search is
+ * relaxed to a prefix of a remaining index, and the constraints of the other
+ * columns are checked by a filter.
+ *
+ * For example, for indexes over columns (x) and (x, z) only,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    FOR t1 IN A ON INDEX t1.x = t0.0 AND t1.y = t0.1
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    FOR t1 IN A ON INDEX t1.x = t0.0
+ *     IF t1.y = t0.1
+ *      ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class RelaxIndexTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "RelaxIndexTransformer";
+    }
+
+    /**
+     * @brief Relax the searches of index scans and index if-exists operations
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool relaxSearches(Program& program);
+
+protected:
+    /**
+     * @brief Restrict the pattern of a search to a relaxed search
+     * @param search the index operation
+     * @param relaxed the columns of the search that remain on the index
+     * @param pattern set to the bounds of the remaining columns
+     * @return the constraints of the other columns
+     */
+    Own<Condition> relaxPattern(
+            const IndexOperation& search, const analysis::SearchSignature& relaxed, RamPattern& pattern);
+
+    analysis::IndexAnalysis* idxAnalysis{nullptr};
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+
+    bool transform(TranslationUnit& translationUnit) override {
+        idxAnalysis = translationUnit.getAnalysis<analysis::IndexAnalysis>();
+        relAnalysis = translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return relaxSearches(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
@@ -20,6 +20,7 @@
 #include "ram/Program.h"
 #include "ram/TranslationUnit.h"
 #include "ram/analysis/Complexity.h"
+#include "ram/analysis/DataStructureAdvisor.h"
 #include "ram/analysis/Index.h"
 #include "ram/analysis/Level.h"
 #include "ram/transform/Transformer.h"
@@ -33,8 +34,9 @@ namespace souffle::ram::transform {
 
 /**
  * @class ReportIndexSetsTransformer
- * @brief does not transform the program but reports on the index sets
- *        if the debug-report flag is enabled.
+ * @brief does not transform the program but reports on the index sets,
+ *        and on the data structures chosen from a profile, if the
+ *        debug-report flag is enabled.
  *
  */
 class ReportIndexTransformer : public Transformer {
@@ -46,6 +48,7 @@ public:
 protected:
     bool transform(TranslationUnit& translationUnit) override {
         translationUnit.getAnalysis<analysis::IndexAnalysis>();
+        translationUnit.getAnalysis<analysis::DataStructureAdvisorAnalysis>();
         return false;
     }
 };
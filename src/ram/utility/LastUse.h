@@ -0,0 +1,81 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LastUse.h
+ *
+ * Determines the strata accessing relations for the last time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/AbstractExistenceCheck.h"
+#include "ram/BinRelationStatement.h"
+#include "ram/Clear.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/Insert.h"
+#include "ram/LeapfrogJoin.h"
+#include "ram/Program.h"
+#include "ram/RelationOperation.h"
+#include "ram/RelationSize.h"
+#include "ram/RelationStatement.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace souffle::ram {
+
+/**
+ * @brief Determine the last stratum accessing each relation
+ *
+ * Clearing a relation is not an access; relations are cleared once they
+ * are not accessed any more. Auxiliary relations, e.g., the deltas of
+ * recursive strata, are not included.
+ */
+inline std::map<std::string, std::size_t> getLastUses(const Program& program) {
+    std::map<std::string, std::size_t> lastUse;
+    for (const auto& sub : program.getSubroutines()) {
+        if (!isPrefix("stratum_", sub.first)) {
+            continue;
+        }
+        std::size_t stratum = std::stoul(sub.first.substr(8));
+        auto use = [&](const std::string& rel) {
+            if (rel[0] != '@') {
+                lastUse[rel] = std::max(lastUse[rel], stratum);
+            }
+        };
+        visit(*sub.second, [&](const RelationOperation& op) { use(op.getRelation()); });
+        visit(*sub.second, [&](const LeapfrogJoin& join) {
+            for (std::size_t i = 0; i < join.getNumRelations(); i++) {
+                use(join.getRelation(i));
+            }
+        });
+        visit(*sub.second, [&](const AbstractExistenceCheck& check) { use(check.getRelation()); });
+        visit(*sub.second, [&](const EmptinessCheck& check) { use(check.getRelation()); });
+        visit(*sub.second, [&](const RelationSize& size) { use(size.getRelation()); });
+        visit(*sub.second, [&](const Insert& insert) { use(insert.getRelation()); });
+        visit(*sub.second, [&](const RelationStatement& stmt) {
+            if (!isA<Clear>(stmt)) {
+                use(stmt.getRelation());
+            }
+        });
+        visit(*sub.second, [&](const BinRelationStatement& stmt) {
+            use(stmt.getFirstRelation());
+            use(stmt.getSecondRelation());
+        });
+    }
+    return lastUse;
+}
+
+}  // namespace souffle::ram
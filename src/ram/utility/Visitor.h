@@ -47,6 +47,7 @@
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
+#include "ram/LeapfrogJoin.h"
 #include "ram/ListStatement.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/LogSize.h"
@@ -149,6 +150,7 @@ struct Visitor : public souffle::Visitor<R, NodeType, Params...> {
         SOUFFLE_VISITOR_FORWARD(Scan);
         SOUFFLE_VISITOR_FORWARD(ParallelIndexScan);
         SOUFFLE_VISITOR_FORWARD(IndexScan);
+        SOUFFLE_VISITOR_FORWARD(LeapfrogJoin);
         SOUFFLE_VISITOR_FORWARD(ParallelIfExists);
         SOUFFLE_VISITOR_FORWARD(IfExists);
         SOUFFLE_VISITOR_FORWARD(ParallelIndexIfExists);
@@ -217,6 +219,7 @@ protected:
     SOUFFLE_VISITOR_LINK(ParallelScan, Scan);
     SOUFFLE_VISITOR_LINK(IndexScan, IndexOperation);
     SOUFFLE_VISITOR_LINK(ParallelIndexScan, IndexScan);
+    SOUFFLE_VISITOR_LINK(LeapfrogJoin, TupleOperation);
     SOUFFLE_VISITOR_LINK(IfExists, RelationOperation);
     SOUFFLE_VISITOR_LINK(ParallelIfExists, IfExists);
     SOUFFLE_VISITOR_LINK(IndexIfExists, IndexOperation);
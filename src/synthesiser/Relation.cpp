@@ -27,6 +27,28 @@ using namespace ram;
 using ram::analysis::LexOrder;
 using ram::analysis::SearchSignature;
 
+bool Relation::isLazyIndex(std::size_t index) const {
+    const auto orders = indexSelection.getAllOrders();
+    return !isProvenance && index != masterIndex && index < orders.size() &&
+           indexSelection.isLazyOrder(orders[index]);
+}
+
+void Relation::generateLazyIndex(std::ostream& out, std::size_t index, bool indirect) const {
+    // the index is only searched once the relation is complete, so that it is
+    // built in bulk from the master index on its first search
+    out << "mutable std::atomic<bool> materialised_" << index << "{false};\n";
+    out << "void materialise_" << index << "() const {\n";
+    out << "if (materialised_" << index << ".load(std::memory_order_acquire)) return;\n";
+    out << "auto lease = materialise_lock.acquire();\n";
+    out << "if (materialised_" << index << ".load(std::memory_order_relaxed)) return;\n";
+    out << "t_ind_" << index << "::operation_hints hints;\n";
+    out << "for (const auto" << (indirect ? "*" : "&") << " t : ind_" << masterIndex << ") {\n";
+    out << "ind_" << index << ".insert(t, hints);\n";
+    out << "}\n";
+    out << "materialised_" << index << ".store(true, std::memory_order_release);\n";
+    out << "}\n";
+}
+
 std::string Relation::getTypeAttributeString(const std::vector<std::string>& attributeTypes,
         const std::unordered_set<uint32_t>& attributesUsed) const {
     std::stringstream type;
@@ -44,7 +66,9 @@ std::string Relation::getTypeAttributeString(const std::vector<std::string>& att
 }
 
 Own<Relation> Relation::getSynthesiserRelation(
-        const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance) {
+        const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance,
+        const ram::analysis::DataStructure& dataStructure) {
+    const auto representation = dataStructure.representation;
     Relation* rel;
 
     // Handle the qualifier in souffle code
@@ -52,20 +76,25 @@ Own<Relation> Relation::getSynthesiserRelation(
         rel = new DirectRelation(ramRel, indexSelection, isProvenance);
     } else if (ramRel.isNullary()) {
         rel = new NullaryRelation(ramRel, indexSelection, isProvenance);
-    } else if (ramRel.getRepresentation() == RelationRepresentation::BTREE) {
-        rel = new DirectRelation(ramRel, indexSelection, isProvenance);
-    } else if (ramRel.getRepresentation() == RelationRepresentation::BRIE) {
+    } else if (representation == RelationRepresentation::HASH) {
+        // chosen by the index analysis for explicit hash and suitable default relations
+        rel = new HashRelation(ramRel, indexSelection, isProvenance);
+    } else if (representation == RelationRepresentation::BTREE) {
+        rel = new DirectRelation(ramRel, indexSelection, isProvenance, dataStructure.blockSize,
+                dataStructure.linearSearch);
+    } else if (representation == RelationRepresentation::BRIE) {
         rel = new BrieRelation(ramRel, indexSelection, isProvenance);
-    } else if (ramRel.getRepresentation() == RelationRepresentation::EQREL) {
+    } else if (representation == RelationRepresentation::EQREL) {
         rel = new EqrelRelation(ramRel, indexSelection, isProvenance);
-    } else if (ramRel.getRepresentation() == RelationRepresentation::INFO) {
+    } else if (representation == RelationRepresentation::INFO) {
         rel = new InfoRelation(ramRel, indexSelection, isProvenance);
     } else {
         // Handle the data structure command line flag
         if (ramRel.getArity() > 6) {
             rel = new IndirectRelation(ramRel, indexSelection, isProvenance);
         } else {
-            rel = new DirectRelation(ramRel, indexSelection, isProvenance);
+            rel = new DirectRelation(ramRel, indexSelection, isProvenance, dataStructure.blockSize,
+                    dataStructure.linearSearch);
         }
     }
 
@@ -122,7 +151,6 @@ void DirectRelation::computeIndices() {
     // generate a full index if no indices exist
     assert(!inds.empty() && "no full index in relation");
 
-    std::size_t index_nr = 0;
     // expand all search orders to be full
     for (auto& ind : inds) {
         // use a set as a cache for fast lookup
@@ -151,12 +179,9 @@ void DirectRelation::computeIndices() {
             // add provenance annotations to the index, but in reverse order
             ind.push_back(getArity() - relation.getAuxiliaryArity() + 1);
             ind.push_back(getArity() - relation.getAuxiliaryArity());
-            masterIndex = 0;
-        } else if (ind.size() == getArity()) {
-            masterIndex = index_nr;
         }
-        index_nr++;
     }
+    masterIndex = isProvenance ? 0 : indexSelection.getMasterOrderNum(getArity());
     assert(masterIndex < inds.size() && "no full index in relation");
     computedIndices = inds;
 }
@@ -182,6 +207,18 @@ std::string DirectRelation::getTypeName() {
         res << "__" << search;
     }
 
+    // distinguish tuned B-trees
+    if (blockSize != 256 || linearSearch) {
+        res << "__" << blockSize << (linearSearch ? "l" : "b");
+    }
+
+    // distinguish lazily materialised indexes
+    for (std::size_t i = 0; i < getIndices().size(); i++) {
+        if (isLazyIndex(i)) {
+            res << "__lazy_" << i;
+        }
+    }
+
     return res.str();
 }
 
@@ -307,14 +344,31 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
                    "souffle::detail::default_strategy<t_tuple>::type,"
                 << comparator_aux << ",updater_" << getTypeName() << ">;\n";
         } else {
+            // the node size and search strategy are only given if tuned
+            std::string tuning;
+            if (blockSize != 256 || linearSearch) {
+                tuning = ",std::allocator<t_tuple>," + std::to_string(blockSize) + ",souffle::detail::" +
+                         (linearSearch ? "linear_search" : "binary_search");
+            }
             if (ind.size() == arity) {
-                out << "using t_ind_" << i << " = btree_set<t_tuple," << comparator << ">;\n";
+                out << "using t_ind_" << i << " = btree_set<t_tuple," << comparator << tuning << ">;\n";
             } else {
                 // without provenance, some indices may be not full, so we use btree_multiset for those
-                out << "using t_ind_" << i << " = btree_multiset<t_tuple," << comparator << ">;\n";
+                out << "using t_ind_" << i << " = btree_multiset<t_tuple," << comparator << tuning << ">;\n";
             }
         }
-        out << "t_ind_" << i << " ind_" << i << ";\n";
+        if (isLazyIndex(i)) {
+            out << "mutable t_ind_" << i << " ind_" << i << ";\n";
+            generateLazyIndex(out, i, false);
+        } else {
+            out << "t_ind_" << i << " ind_" << i << ";\n";
+        }
+    }
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        if (isLazyIndex(i)) {
+            out << "mutable Lock materialise_lock;\n";
+            break;
+        }
     }
 
     // typedef master index iterator to be struct iterator
@@ -342,6 +396,9 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         << ")) {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         if (i != masterIndex && provenanceIndexNumbers.find(i) == provenanceIndexNumbers.end()) {
+            if (isLazyIndex(i)) {
+                out << "if (materialised_" << i << ".load(std::memory_order_acquire)) ";
+            }
             out << "ind_" << i << ".insert(t, h.hints_" << i << "_lower"
                 << ");\n";
         }
@@ -426,6 +483,9 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
             }
         }
 
+        if (isLazyIndex(indNum)) {
+            out << "materialise_" << indNum << "();\n";
+        }
         out << "t_comparator_" << indNum << " comparator;\n";
         out << "int cmp = comparator(lower, upper);\n";
 
@@ -472,6 +532,19 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "void purge() {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         out << "ind_" << i << ".clear();\n";
+        if (isLazyIndex(i)) {
+            out << "materialised_" << i << " = false;\n";
+        }
+    }
+    out << "}\n";
+
+    // reset method, retaining the memory of the indexes for the next iteration of a fixpoint
+    out << "void reset() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".reset();\n";
+        if (isLazyIndex(i)) {
+            out << "materialised_" << i << " = false;\n";
+        }
     }
     out << "}\n";
 
@@ -504,6 +577,15 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // getIndexMemoryUsage method
+    out << "std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {\n";
+    out << "return {";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "{\"" << inds[i] << "\", ind_" << i << ".getMemoryUsage()}, ";
+    }
+    out << "};\n";
+    out << "}\n";
+
     // end struct
     out << "};\n";
 }  // namespace souffle
@@ -520,14 +602,7 @@ void IndirectRelation::computeIndices() {
     // generate a full index if no indices exist
     assert(!inds.empty() && "no full index in relation");
 
-    // check for full index
-    for (std::size_t i = 0; i < inds.size(); i++) {
-        auto& ind = inds[i];
-        if (ind.size() == getArity()) {
-            masterIndex = i;
-            break;
-        }
-    }
+    masterIndex = indexSelection.getMasterOrderNum(getArity());
     assert(masterIndex < inds.size() && "no full index in relation");
     computedIndices = inds;
 }
@@ -553,6 +628,13 @@ std::string IndirectRelation::getTypeName() {
         res << "__" << search;
     }
 
+    // distinguish lazily materialised indexes
+    for (std::size_t i = 0; i < getIndices().size(); i++) {
+        if (isLazyIndex(i)) {
+            res << "__lazy_" << i;
+        }
+    }
+
     return res.str();
 }
 
@@ -650,7 +732,18 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
             out << "using t_ind_" << i << " = btree_multiset<const t_tuple*," << comparator << ">;\n";
         }
 
-        out << "t_ind_" << i << " ind_" << i << ";\n";
+        if (isLazyIndex(i)) {
+            out << "mutable t_ind_" << i << " ind_" << i << ";\n";
+            generateLazyIndex(out, i, true);
+        } else {
+            out << "t_ind_" << i << " ind_" << i << ";\n";
+        }
+    }
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        if (isLazyIndex(i)) {
+            out << "mutable Lock materialise_lock;\n";
+            break;
+        }
     }
 
     // typedef deref iterators
@@ -684,6 +777,9 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "}\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         if (i != masterIndex) {
+            if (isLazyIndex(i)) {
+                out << "if (materialised_" << i << ".load(std::memory_order_acquire)) ";
+            }
             out << "ind_" << i << ".insert(masterCopy, h.hints_" << i << "_lower"
                 << ");\n";
         }
@@ -765,6 +861,9 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
             }
         }
 
+        if (isLazyIndex(indNum)) {
+            out << "materialise_" << indNum << "();\n";
+        }
         out << "t_comparator_" << indNum << " comparator;\n";
         out << "int cmp = comparator(&lower, &upper);\n";
 
@@ -818,6 +917,20 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "void purge() {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         out << "ind_" << i << ".clear();\n";
+        if (isLazyIndex(i)) {
+            out << "materialised_" << i << " = false;\n";
+        }
+    }
+    out << "dataTable.clear();\n";
+    out << "}\n";
+
+    // reset method, retaining the memory of the indexes for the next iteration of a fixpoint
+    out << "void reset() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".reset();\n";
+        if (isLazyIndex(i)) {
+            out << "materialised_" << i << " = false;\n";
+        }
     }
     out << "dataTable.clear();\n";
     out << "}\n";
@@ -840,6 +953,16 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // getIndexMemoryUsage method
+    out << "std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {\n";
+    out << "return {";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "{\"" << inds[i] << "\", ind_" << i << ".getMemoryUsage()}, ";
+    }
+    out << "{\"tuples\", dataTable.getMemoryUsage()}";
+    out << "};\n";
+    out << "}\n";
+
     // end struct
     out << "};\n";
 }
@@ -1096,6 +1219,11 @@ void BrieRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // reset method, tries do not retain their memory
+    out << "void reset() {\n";
+    out << "purge();\n";
+    out << "}\n";
+
     // begin and end iterators
     out << "iterator begin() const {\n";
     out << "return iterator_" << masterIndex << "(ind_" << masterIndex << ".begin());\n";
@@ -1114,6 +1242,15 @@ void BrieRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // getIndexMemoryUsage method
+    out << "std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {\n";
+    out << "return {";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "{\"" << inds[i] << "\", ind_" << i << ".getMemoryUsage()}, ";
+    }
+    out << "};\n";
+    out << "}\n";
+
     // orderOut and orderIn methods for reordering tuples according to index orders
     for (std::size_t i = 0; i < numIndexes; i++) {
         auto ind = inds[i];
@@ -1138,6 +1275,228 @@ void BrieRelation::generateTypeStruct(std::ostream& out) {
     out << "};\n";
 }
 
+// -------- Hash Relation --------
+
+/** Generate index set for a hash relation, i.e., one index per distinct key */
+void HashRelation::computeIndices() {
+    assert(!isProvenance && "hash relations cannot be used with provenance");
+
+    // the master index covers all columns and rejects duplicates
+    LexOrder full;
+    for (std::size_t i = 0; i < getArity(); i++) {
+        full.push_back(i);
+    }
+    computedIndices = {full};
+    masterIndex = 0;
+
+    // every other search is answered by an index over the columns of its equalities
+    for (auto& search : indexSelection.getSearches()) {
+        LexOrder key;
+        for (std::size_t i = 0; i < getArity(); i++) {
+            assert(search[i] != analysis::AttributeConstraint::Inequal && "inequality in hash relation");
+            if (search[i] == analysis::AttributeConstraint::Equal) {
+                key.push_back(i);
+            }
+        }
+        if (std::find(computedIndices.begin(), computedIndices.end(), key) == computedIndices.end()) {
+            computedIndices.push_back(key);
+        }
+    }
+}
+
+/** Get the number of the index answering a search */
+std::size_t HashRelation::getIndexNum(SearchSignature search) const {
+    LexOrder key;
+    for (std::size_t i = 0; i < getArity(); i++) {
+        if (search[i] == analysis::AttributeConstraint::Equal) {
+            key.push_back(i);
+        }
+    }
+    auto it = std::find(computedIndices.begin(), computedIndices.end(), key);
+    assert(it != computedIndices.end() && "no index for search");
+    return std::distance(computedIndices.begin(), it);
+}
+
+/** Generate type name of a hash relation */
+std::string HashRelation::getTypeName() {
+    std::stringstream res;
+    res << "t_hash_" << getArity();
+
+    for (auto& ind : getIndices()) {
+        res << "__" << join(ind, "_");
+    }
+
+    for (auto& search : indexSelection.getSearches()) {
+        res << "__" << search;
+    }
+
+    return res.str();
+}
+
+/** Generate type struct of a hash relation */
+void HashRelation::generateTypeStruct(std::ostream& out) {
+    std::size_t arity = getArity();
+    const auto& inds = getIndices();
+    std::size_t numIndexes = inds.size();
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+    out << "static constexpr Relation::arity_type Arity = " << arity << ";\n";
+
+    // stored tuple type
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+
+    // the master index is unique, all others chain the tuples of a key
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "using t_ind_" << i << " = HashIndex<t_tuple," << (i == masterIndex ? "true" : "false") << ","
+            << join(inds[i], ",") << ">;\n";
+        out << "t_ind_" << i << " ind_" << i << ";\n";
+    }
+
+    // typedef master index iterator to be struct iterator
+    out << "using iterator = t_ind_" << masterIndex << "::iterator;\n";
+
+    // hash indexes need no operation hints
+    out << "struct context {};\n";
+    out << "context createContext() { return context(); }\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "if (ind_" << masterIndex << ".insert(t)) {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        if (i != masterIndex) {
+            out << "ind_" << i << ".insert(t);\n";
+        }
+    }
+    out << "return true;\n";
+    out << "} else return false;\n";
+    out << "}\n";  // end of insert(t_tuple&)
+
+    out << "bool insert(const t_tuple& t, context& /* h */) {\n";
+    out << "return insert(t);\n";
+    out << "}\n";  // end of insert(t_tuple&, context&)
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "return insert(tuple);\n";
+    out << "}\n";  // end of insert(RamDomain*)
+
+    std::vector<std::string> decls;
+    std::vector<std::string> params;
+    for (std::size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
+
+    // contains methods
+    out << "bool contains(const t_tuple& t, context& /* h */) const {\n";
+    out << "return ind_" << masterIndex << ".contains(t);\n";
+    out << "}\n";
+
+    out << "bool contains(const t_tuple& t) const {\n";
+    out << "return ind_" << masterIndex << ".contains(t);\n";
+    out << "}\n";
+
+    // size method
+    out << "std::size_t size() const {\n";
+    out << "return ind_" << masterIndex << ".size();\n";
+    out << "}\n";
+
+    // find methods
+    out << "iterator find(const t_tuple& t, context& /* h */) const {\n";
+    out << "return ind_" << masterIndex << ".find(t);\n";
+    out << "}\n";
+
+    out << "iterator find(const t_tuple& t) const {\n";
+    out << "return ind_" << masterIndex << ".find(t);\n";
+    out << "}\n";
+
+    // empty lowerUpperRange method
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */, context& /* h */) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    // lowerUpperRange methods for each pattern, looking up the values of its equalities
+    for (auto search : indexSelection.getSearches()) {
+        std::size_t indNum = getIndexNum(search);
+
+        out << "range<t_ind_" << indNum << "::chain_iterator> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& /* upper */, context& /* h */) const {\n";
+        out << "return ind_" << indNum << ".equalRange(lower);\n";
+        out << "}\n";
+
+        out << "range<t_ind_" << indNum << "::chain_iterator> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& /* upper */) const {\n";
+        out << "return ind_" << indNum << ".equalRange(lower);\n";
+        out << "}\n";
+    }
+
+    // empty method
+    out << "bool empty() const {\n";
+    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "}\n";
+
+    // partition method for parallelism
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "return ind_" << masterIndex << ".getChunks(400);\n";
+    out << "}\n";
+
+    // purge method
+    out << "void purge() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".clear();\n";
+    }
+    out << "}\n";
+
+    // reset method, retaining the memory of the indexes for the next iteration of a fixpoint
+    out << "void reset() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".reset();\n";
+    }
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return ind_" << masterIndex << ".end();\n";
+    out << "}\n";
+
+    // printStatistics method
+    out << "void printStatistics(std::ostream& o) const {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "o << \" arity " << arity << " hash index " << i << " key " << inds[i] << "\\n\";\n";
+        out << "ind_" << i << ".printStats(o);\n";
+    }
+    out << "}\n";
+
+    // getIndexMemoryUsage method
+    out << "std::vector<std::pair<std::string, std::size_t>> getIndexMemoryUsage() const {\n";
+    out << "return {";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "{\"" << inds[i] << "\", ind_" << i << ".getMemoryUsage()}, ";
+    }
+    out << "};\n";
+    out << "}\n";
+
+    // end struct
+    out << "};\n";
+}
+
 // -------- Eqrel Relation --------
 
 /** Generate index set for a eqrel relation, which should be empty */
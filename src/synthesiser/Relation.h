@@ -9,6 +9,7 @@
 #pragma once
 
 #include "ram/Relation.h"
+#include "ram/analysis/DataStructureAdvisor.h"
 #include "ram/analysis/Index.h"
 #include <cstddef>
 #include <cstdint>
@@ -70,9 +71,16 @@ public:
 
     /** Factory method to generate a SynthesiserRelation */
     static Own<Relation> getSynthesiserRelation(const ram::Relation& ramRel,
-            const ram::analysis::IndexCluster& indexSelection, bool isProvenance);
+            const ram::analysis::IndexCluster& indexSelection, bool isProvenance,
+            const ram::analysis::DataStructure& dataStructure);
 
 protected:
+    /** Check whether an index is only materialised when it is first searched */
+    bool isLazyIndex(std::size_t index) const;
+
+    /** Generate the members and the materialise method of a lazy index */
+    void generateLazyIndex(std::ostream& out, std::size_t index, bool indirect) const;
+
     /** Ram relation referred to by this */
     const ram::Relation& relation;
 
@@ -119,13 +127,21 @@ public:
 
 class DirectRelation : public Relation {
 public:
-    DirectRelation(
-            const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance)
-            : Relation(ramRel, indexSelection, isProvenance) {}
+    DirectRelation(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection,
+            bool isProvenance, std::size_t blockSize = 256, bool linearSearch = false)
+            : Relation(ramRel, indexSelection, isProvenance), blockSize(blockSize),
+              linearSearch(linearSearch) {}
 
     void computeIndices() override;
     std::string getTypeName() override;
     void generateTypeStruct(std::ostream& out) override;
+
+private:
+    /** Number of bytes of a B-tree node */
+    const std::size_t blockSize;
+
+    /** Whether B-tree nodes are searched linearly */
+    const bool linearSearch;
 };
 
 class IndirectRelation : public Relation {
@@ -150,6 +166,21 @@ public:
     void generateTypeStruct(std::ostream& out) override;
 };
 
+class HashRelation : public Relation {
+public:
+    HashRelation(
+            const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance)
+            : Relation(ramRel, indexSelection, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+
+private:
+    /** Get the number of the index answering a search */
+    std::size_t getIndexNum(ram::analysis::SearchSignature search) const;
+};
+
 class EqrelRelation : public Relation {
 public:
     EqrelRelation(
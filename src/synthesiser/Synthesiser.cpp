@@ -82,7 +82,9 @@
 #include "ram/UnpackRecord.h"
 #include "ram/UnsignedConstant.h"
 #include "ram/UserDefinedOperator.h"
+#include "ram/analysis/DataStructureAdvisor.h"
 #include "ram/analysis/Index.h"
+#include "ram/utility/LastUse.h"
 #include "ram/utility/Utils.h"
 #include "ram/utility/Visitor.h"
 #include "souffle/BinaryConstraintOps.h"
@@ -114,6 +116,7 @@
 namespace souffle::synthesiser {
 
 using json11::Json;
+using ram::analysis::DataStructureAdvisorAnalysis;
 using ram::analysis::IndexAnalysis;
 using namespace ram;
 using namespace stream_write_qualified_char_as_number;
@@ -215,6 +218,10 @@ std::set<const ram::Relation*> Synthesiser::getReferencedRelations(const Operati
             res.insert(lookup(provExists->getRelation()));
         } else if (auto insert = as<Insert>(node)) {
             res.insert(lookup(insert->getRelation()));
+        } else if (auto join = as<LeapfrogJoin>(node)) {
+            for (std::size_t i = 0; i < join->getNumRelations(); i++) {
+                res.insert(lookup(join->getRelation(i)));
+            }
         }
     });
     return res;
@@ -370,10 +377,18 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << R"_(if (!outputDirectory.empty()) {)_";
                 out << R"_(directiveMap["output-dir"] = outputDirectory;)_";
                 out << "}\n";
+                // streamed relations are final here and written in the background
+                bool isStreamed = contains(synthesiser.streamedRelations, io.getRelation());
+                if (isStreamed) {
+                    out << "outputScheduler.schedule([this, directiveMap]() {";
+                }
                 out << "IOSystem::getInstance().getWriter(";
                 out << "directiveMap, symTable, recordTable";
                 out << ")->writeAll(*" << synthesiser.getRelationName(synthesiser.lookup(io.getRelation()))
                     << ");\n";
+                if (isStreamed) {
+                    out << "});\n";
+                }
                 out << "} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
             } else {
                 assert("Wrong i/o operation");
@@ -423,6 +438,11 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             bool isParallel = false;
             visit(*next, [&](const AbstractParallel&) { isParallel = true; });
 
+            // parallel aggregates rely on reductions of an OpenMP team, others on the task pool
+            bool isParallelAggregate = false;
+            visit(*next, [&](const ParallelAggregate&) { isParallelAggregate = true; });
+            visit(*next, [&](const ParallelIndexAggregate&) { isParallelAggregate = true; });
+
             // reset preamble
             preamble.str("");
             preamble.clear();
@@ -435,6 +455,25 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 preamble << "->createContext());\n";
             }
 
+            // buffered inserts of a parallel loop collect the tuples of each task, which are
+            // merged into the shared buffer of the query at the end of the task
+            std::vector<const ram::Relation*> bufferedRelations;
+            visit(*next, [&](const Insert& insert) {
+                const auto* rel = synthesiser.lookup(insert.getRelation());
+                if (insert.isBuffered() && !contains(bufferedRelations, rel)) {
+                    bufferedRelations.push_back(rel);
+                }
+            });
+            assert((bufferedRelations.empty() || (isParallel && !isParallelAggregate)) &&
+                    "buffered inserts require a parallel loop");
+            for (const ram::Relation* rel : bufferedRelations) {
+                const auto& bufferName = synthesiser.getRelationName(rel) + "_buffer";
+                const auto tupleType = "Tuple<RamDomain," + toString(rel->getArity()) + ">";
+                out << "std::vector<" << tupleType << "> " << bufferName << ";\n";
+                out << "Lock " << bufferName << "_lock;\n";
+                preamble << "std::vector<" << tupleType << "> " << bufferName << "_local;\n";
+            }
+
             // discharge conditions that require a context
             if (isParallel) {
                 if (requireCtx.size() > 0) {
@@ -459,8 +498,32 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 }
             }
 
-            if (isParallel) {
+            for (const ram::Relation* rel : bufferedRelations) {
+                const auto& bufferName = synthesiser.getRelationName(rel) + "_buffer";
+                out << "if (!" << bufferName << "_local.empty()) {\n";
+                out << "auto lease = " << bufferName << "_lock.acquire();\n";
+                out << bufferName << ".insert(" << bufferName << ".end(), " << bufferName
+                    << "_local.begin(), " << bufferName << "_local.end());\n";
+                out << "}\n";
+            }
+
+            if (isParallelAggregate) {
                 out << "PARALLEL_END\n";  // end parallel
+            } else if (isParallel) {
+                out << "PARALLEL_TASKS_END\n";  // end parallel tasks
+            }
+
+            // merge the buffered tuples in order, such that consecutive insertions hit the same nodes
+            for (const ram::Relation* rel : bufferedRelations) {
+                const auto& relName = synthesiser.getRelationName(rel);
+                const auto& bufferName = relName + "_buffer";
+                out << "std::sort(" << bufferName << ".begin(), " << bufferName << ".end());\n";
+                out << bufferName << ".erase(std::unique(" << bufferName << ".begin(), " << bufferName
+                    << ".end()), " << bufferName << ".end());\n";
+                out << "CREATE_OP_CONTEXT(" << bufferName << "_ctxt," << relName << "->createContext());\n";
+                out << "for (const auto& tuple : " << bufferName << ") {\n";
+                out << relName << "->insert(tuple,READ_OP_CONTEXT(" << bufferName << "_ctxt));\n";
+                out << "}\n";
             }
 
             out << "}\n";
@@ -476,11 +539,22 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
         void visit_(type_identity<Clear>, const Clear& clear, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
 
-            if (!synthesiser.lookup(clear.getRelation())->isTemp()) {
+            if (!synthesiser.lookup(clear.getRelation())->isTemp() && !synthesiser.inPreparedQuery) {
                 out << "if (performIO) ";
             }
-            out << synthesiser.getRelationName(synthesiser.lookup(clear.getRelation())) << "->"
-                << "purge();\n";
+            // streamed relations are released once they have been written
+            if (contains(synthesiser.streamedRelations, clear.getRelation())) {
+                out << "outputScheduler.schedule([this]() {"
+                    << synthesiser.getRelationName(synthesiser.lookup(clear.getRelation())) << "->"
+                    << "purge();});\n";
+            } else if (clear.isRefilled()) {
+                // the next iteration of the loop refills the relation
+                out << synthesiser.getRelationName(synthesiser.lookup(clear.getRelation())) << "->"
+                    << "reset();\n";
+            } else {
+                out << synthesiser.getRelationName(synthesiser.lookup(clear.getRelation())) << "->"
+                    << "purge();\n";
+            }
 
             PRINT_END_COMMENT(out);
         }
@@ -520,20 +594,25 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 return;
             }
 
-            // more than one => parallel sections
-
-            // start parallel section
-            out << "SECTIONS_START;\n";
-
-            // put each thread in another section
-            for (const auto& cur : stmts) {
-                out << "SECTION_START;\n";
-                dispatch(*cur, out);
-                out << "SECTION_END\n";
+            // more than one => parallel sections, executed as tasks unless profiling
+            // since the profile database is not synchronized
+            if (Global::config().has("profile")) {
+                out << "SECTIONS_START;\n";
+                for (const auto& cur : stmts) {
+                    out << "SECTION_START;\n";
+                    dispatch(*cur, out);
+                    out << "SECTION_END\n";
+                }
+                out << "SECTIONS_END;\n";
+            } else {
+                out << "TASKS_START;\n";
+                for (const auto& cur : stmts) {
+                    out << "TASK_START;\n";
+                    dispatch(*cur, out);
+                    out << "TASK_END\n";
+                }
+                out << "TASKS_END;\n";
             }
-
-            // done
-            out << "SECTIONS_END;\n";
             PRINT_END_COMMENT(out);
         }
 
@@ -583,6 +662,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "{\n";
             out << " std::vector<RamDomain> args, ret;\n";
             out << "subroutine_" << distance(subs.begin(), subs.find(call.getName())) << "(args, ret);\n";
+            if (Global::config().has("profile") && isPrefix("stratum_", call.getName())) {
+                out << "recordMemoryUsage(" << call.getName().substr(8) << ");\n";
+            }
             out << "}\n";
             PRINT_END_COMMENT(out);
         }
@@ -667,9 +749,8 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_BEGIN_COMMENT(out);
 
             out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START\n";
+            out << "PARALLEL_TASKS_START(part, it)\n";
             out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
             out << "try{\n";
             out << "for(const auto& env0 : *it) {\n";
 
@@ -677,7 +758,6 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
             out << "}\n";
             out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
-            out << "}\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -742,9 +822,8 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_BEGIN_COMMENT(out);
 
             out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START\n";
+            out << "PARALLEL_TASKS_START(part, it)\n";
             out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
             out << "try{\n";
             out << "for(const auto& env0 : *it) {\n";
             out << "if( ";
@@ -759,7 +838,6 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "}\n";
             out << "}\n";
             out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
-            out << "}\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -791,6 +869,79 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visit_(type_identity<LeapfrogJoin>, const LeapfrogJoin& join, std::ostream& out) override {
+            const auto id = std::to_string(join.getTupleId());
+            const std::size_t numRelations = join.getNumRelations();
+            PRINT_BEGIN_COMMENT(out);
+            out << "{\n";
+
+            // the range of each relation matching its pattern, and a seek within it to the
+            // first value of the join column not below the given value, or above it if strict
+            std::stringstream seek;
+            seek << "auto seek" << id << " = [&](std::size_t i, bool strict, RamDomain& value) -> bool {\n";
+            seek << "switch (i) {\n";
+            for (std::size_t i = 0; i < numRelations; i++) {
+                const auto* rel = synthesiser.lookup(join.getRelation(i));
+                auto relName = synthesiser.getRelationName(rel);
+                auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*rel) + ")";
+                auto keys = isa->getSearchSignature(&join, i);
+                auto column = join.getColumn(i);
+                auto range = relName + "->lowerUpperRange_" + toString(keys);
+                auto suffix = id + "_" + std::to_string(i);
+
+                auto bounds = getPaddedRangeBounds(*rel, join.getPattern(i), join.getPattern(i));
+                out << "const auto lower" << suffix << " = " << bounds.first.str() << ";\n";
+                out << "const auto upper" << suffix << " = " << bounds.second.str() << ";\n";
+                out << "const auto end" << suffix << " = " << range << "(lower" << suffix << ",upper"
+                    << suffix << "," << ctxName << ").end();\n";
+
+                seek << "case " << i << ": {\n";
+                seek << "auto it = end" << suffix << ";\n";
+                seek << "if (strict) {\n";
+                seek << "auto key = upper" << suffix << ";\n";
+                seek << "key[" << column << "] = value;\n";
+                seek << "it = " << range << "(lower" << suffix << ",key," << ctxName << ").end();\n";
+                seek << "} else {\n";
+                seek << "auto key = lower" << suffix << ";\n";
+                seek << "key[" << column << "] = value;\n";
+                seek << "it = " << range << "(key,upper" << suffix << "," << ctxName << ").begin();\n";
+                seek << "}\n";
+                seek << "if (it == end" << suffix << ") return false;\n";
+                seek << "value = (*it)[" << column << "];\n";
+                seek << "return true;\n";
+                seek << "}\n";
+            }
+            seek << "}\n";
+            seek << "return false;\n";
+            seek << "};\n";
+            out << seek.str();
+
+            // leapfrog over the relations until all of them agree on a value, starting
+            // at the value in the current relation, or above it if strict
+            out << "Tuple<RamDomain,1> env" << id << "{{lower" << id << "_0[" << join.getColumn(0)
+                << "]}};\n";
+            out << "std::size_t cur" << id << " = 0;\n";
+            out << "auto leapfrog" << id << " = [&](bool strict) -> bool {\n";
+            out << "if (!seek" << id << "(cur" << id << ", strict, env" << id << "[0])) return false;\n";
+            out << "for (std::size_t matched = 1; matched < " << numRelations << ";) {\n";
+            out << "cur" << id << " = (cur" << id << " + 1) % " << numRelations << ";\n";
+            out << "RamDomain next = env" << id << "[0];\n";
+            out << "if (!seek" << id << "(cur" << id << ", false, next)) return false;\n";
+            out << "matched = (next == env" << id << "[0]) ? matched + 1 : 1;\n";
+            out << "env" << id << "[0] = next;\n";
+            out << "}\n";
+            out << "return true;\n";
+            out << "};\n";
+
+            out << "for (bool found" << id << " = leapfrog" << id << "(false); found" << id << "; found" << id
+                << " = leapfrog" << id << "(true)) {\n";
+            visit_(type_identity<TupleOperation>(), join, out);
+            out << "}\n";
+
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
         void visit_(type_identity<ParallelIndexScan>, const ParallelIndexScan& piscan,
                 std::ostream& out) override {
             const auto* rel = synthesiser.lookup(piscan.getRelation());
@@ -816,9 +967,8 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 << "lowerUpperRange_" << keys << "(" << rangeBounds.first.str() << ","
                 << rangeBounds.second.str() << ");\n";
             out << "auto part = range.partition();\n";
-            out << "PARALLEL_START\n";
+            out << "PARALLEL_TASKS_START(part, it)\n";
             out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end(); ++it) { \n";
             out << "try{\n";
             out << "for(const auto& env0 : *it) {\n";
 
@@ -826,7 +976,6 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
             out << "}\n";
             out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
-            out << "}\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -891,9 +1040,8 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 << "lowerUpperRange_" << keys << "(" << rangeBounds.first.str() << ","
                 << rangeBounds.second.str() << ");\n";
             out << "auto part = range.partition();\n";
-            out << "PARALLEL_START\n";
+            out << "PARALLEL_TASKS_START(part, it)\n";
             out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end(); ++it) { \n";
             out << "try{";
             out << "for(const auto& env0 : *it) {\n";
             out << "if( ";
@@ -908,7 +1056,6 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "}\n";
             out << "}\n";
             out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
-            out << "}\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -1046,7 +1193,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             }
 
             out << preamble.str();
-            out << "PARALLEL_START\n";
+            out << "PARALLEL_TEAM_START\n";
             // check whether there is an index to use
             if (keys.empty()) {
                 out << "#pragma omp for reduction(" << op << ":" << sharedVariable << ")\n";
@@ -1330,7 +1477,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 // shortcut: use relation size
                 out << "env" << identifier << "[0] = " << relName << "->"
                     << "size();\n";
-                out << "PARALLEL_START\n";
+                out << "PARALLEL_TEAM_START\n";
                 out << preamble.str();
                 visit_(type_identity<TupleOperation>(), aggregate, out);
                 PRINT_END_COMMENT(out);
@@ -1412,7 +1559,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
             // create a partitioning of the relation to iterate over simeltaneously
             out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START\n";
+            out << "PARALLEL_TEAM_START\n";
             out << preamble.str();
             // pragma statement
             out << "#pragma omp for reduction(" << op << ":" << sharedVariable << ")\n";
@@ -1674,9 +1821,13 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "Tuple<RamDomain," << arity << "> tuple{{" << join(insert.getValues(), ",", rec)
                 << "}};\n";
 
-            // insert tuple
-            out << relName << "->"
-                << "insert(tuple," << ctxName << ");\n";
+            // insert tuple, or defer the insertion to the end of the query
+            if (insert.isBuffered()) {
+                out << relName << "_buffer_local.push_back(tuple);\n";
+            } else {
+                out << relName << "->"
+                    << "insert(tuple," << ctxName << ");\n";
+            }
 
             PRINT_END_COMMENT(out);
         }
@@ -1725,11 +1876,11 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
     out << ")";                 \
     break
 #define COMPARE_STRING(op)                \
-    out << "(symTable.decode(";           \
+    out << "(symTable.compare(";          \
     EVAL_CHILD(RamDomain, getLHS);        \
-    out << ") " #op " symTable.decode(";  \
+    out << ", ";                          \
     EVAL_CHILD(RamDomain, getRHS);        \
-    out << "))";                          \
+    out << ") " #op " 0)";                \
     break
 #define COMPARE_EQ_NE(opCode, op)                                         \
     case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamDomain  , op); \
@@ -1946,16 +2097,15 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
         void visit_(
                 type_identity<IntrinsicOperator>, const IntrinsicOperator& op, std::ostream& out) override {
-#define MINMAX_SYMBOL(op)                   \
-    {                                       \
-        out << "symTable.encode(" #op "({"; \
-        for (auto& cur : args) {            \
-            out << "symTable.decode(";      \
-            dispatch(*cur, out);            \
-            out << "), ";                   \
-        }                                   \
-        out << "}))";                       \
-        break;                              \
+#define MINMAX_SYMBOL(op)                                                                   \
+    {                                                                                       \
+        out << #op "({";                                                                    \
+        for (auto& cur : args) {                                                            \
+            dispatch(*cur, out);                                                            \
+            out << ", ";                                                                    \
+        }                                                                                   \
+        out << "}, [&](RamDomain a, RamDomain b) { return symTable.compare(a, b) < 0; })"; \
+        break;                                                                              \
     }
 
             PRINT_BEGIN_COMMENT(out);
@@ -2322,6 +2472,7 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     // ---------------------------------------------------------------
     const Program& prog = translationUnit.getProgram();
     auto* idxAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+    auto* dataStructures = translationUnit.getAnalysis<DataStructureAdvisorAnalysis>();
     // ---------------------------------------------------------------
     //                      Code Generation
     // ---------------------------------------------------------------
@@ -2398,7 +2549,8 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
         auto relationType =
                 Relation::getSynthesiserRelation(*rel, idxAnalysis->getIndexSelection(rel->getName()),
-                        Global::config().has("provenance") && !isProvInfo);
+                        Global::config().has("provenance") && !isProvInfo,
+                        dataStructures->getDataStructure(rel->getName()));
 
         generateRelationTypeStruct(os, std::move(relationType));
     }
@@ -2503,6 +2655,12 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         }
     });
 
+    // profiling measures and provenance queries the relations in place
+    if (Global::config().has("stream-output") && !Global::config().has("profile") &&
+            !Global::config().has("provenance")) {
+        streamedRelations = storeRelations;
+    }
+
     for (auto rel : prog.getRelations()) {
         // get some table details
         const std::string& datalogName = rel->getName();
@@ -2511,7 +2669,8 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
         auto relationType =
                 Relation::getSynthesiserRelation(*rel, idxAnalysis->getIndexSelection(datalogName),
-                        Global::config().has("provenance") && !isProvInfo);
+                        Global::config().has("provenance") && !isProvInfo,
+                        dataStructures->getDataStructure(datalogName));
         const std::string& type = relationType->getTypeName();
 
         // defining table
@@ -2568,7 +2727,11 @@ SignalHandler*          signalHandler {SignalHandler::instance()};
 std::atomic<RamDomain>  ctr {};
 std::atomic<std::size_t>     iter {};
 bool                    performIO = false;
-
+)_";
+    if (!streamedRelations.empty()) {
+        os << "OutputScheduler         outputScheduler;\n";
+    }
+    os << R"_(
 void runFunction(std::string  inputDirectoryArg   = "",
                  std::string  outputDirectoryArg  = "",
                  bool         performIOArg        = false) {
@@ -2581,9 +2744,22 @@ void runFunction(std::string  inputDirectoryArg   = "",
 #if defined(_OPENMP)
     if (0 < getNumThreads()) { omp_set_num_threads(getNumThreads()); }
 #endif
-
-    signalHandler->set();
 )_";
+    if (Global::config().has("numa")) {
+        // the threads of OpenMP are pinned once, as they persist across parallel regions
+        os << "TaskPool::instance().configure(getNumThreads(), true);\n";
+        os << "Arena::setNumaInterleave(true);\n";
+        os << "#if defined(_OPENMP)\n";
+        os << "#pragma omp parallel\n";
+        os << "pinToNumaCore(omp_get_thread_num());\n";
+        os << "#endif\n";
+    } else {
+        os << "TaskPool::instance().configure(getNumThreads());\n";
+    }
+    os << "signalHandler->set();\n";
+    if (Global::config().has("huge-pages")) {
+        os << "Arena::setHugePages(true);\n";
+    }
     if (Global::config().has("verbose")) {
         os << "signalHandler->enableLogging();\n";
     }
@@ -2605,11 +2781,21 @@ void runFunction(std::string  inputDirectoryArg   = "",
         // Store configuration
         os << R"_(ProfileEventSingleton::instance().makeConfigRecord("relationCount", std::to_string()_"
            << relationCount << "));";
+        // Store the last stratum using each relation
+        for (const auto& cur : ram::getLastUses(prog)) {
+            os << "ProfileEventSingleton::instance().makeQuantityEvent(R\"_(@last-use;" << cur.first
+               << ")_\", " << cur.second << ", 0);\n";
+        }
     }
 
     // emit code
     emitCode(os, prog.getMain());
 
+    // wait for the outputs written in the background
+    if (!streamedRelations.empty()) {
+        os << "try {outputScheduler.flush();} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
+    }
+
     if (Global::config().has("profile")) {
         os << "}\n";
         os << "ProfileEventSingleton::instance().stopTimer();\n";
@@ -2645,6 +2831,38 @@ void runFunction(std::string  inputDirectoryArg   = "",
         os << "if (profiler.joinable()) { profiler.join(); }\n";
     }
     os << "}\n";
+
+    // resume an evaluation started by the interpreter at a statement of the main program
+    if (Global::config().has("tiered")) {
+        os << "public:\nvoid runFrom(std::size_t statement, RamDomain counter) override {\n";
+        os << "performIO = true;\n";
+        os << "ctr = counter;\n";
+        os << "#if defined(_OPENMP)\n";
+        os << "if (0 < getNumThreads()) { omp_set_num_threads(getNumThreads()); }\n";
+        os << "#endif\n";
+        os << "TaskPool::instance().configure(getNumThreads()"
+           << (Global::config().has("numa") ? ", true" : "") << ");\n";
+        os << "signalHandler->set();\n";
+        std::vector<const Statement*> statements;
+        if (const auto* seq = as<Sequence>(prog.getMain())) {
+            for (const auto& stmt : seq->getStatements()) {
+                statements.push_back(stmt);
+            }
+        } else {
+            statements.push_back(&prog.getMain());
+        }
+        for (std::size_t i = 0; i < statements.size(); ++i) {
+            os << "if (statement <= " << i << ") {\n";
+            emitCode(os, *statements[i]);
+            os << "}\n";
+        }
+        if (!streamedRelations.empty()) {
+            os << "try {outputScheduler.flush();} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
+        }
+        os << "signalHandler->reset();\n";
+        os << "}\n";
+    }
+
     // issue printAll method
     os << "public:\n";
     os << "void printAll(std::string outputDirectoryArg = \"\") override {\n";
@@ -2790,7 +3008,9 @@ void runFunction(std::string  inputDirectoryArg   = "",
             }
 
             // emit code for subroutine
+            inPreparedQuery = isPrefix("query_", sub.first);
             emitCode(os, *sub.second);
+            inPreparedQuery = false;
 
             // issue end of subroutine
             os << "}\n";
@@ -2817,6 +3037,22 @@ void runFunction(std::string  inputDirectoryArg   = "",
                << ")_\", reads[" << cur.second << "],0);\n";
         }
         os << "}\n";  // end of dumpFreqs() method
+
+        // recordMemoryUsage method
+        os << "void recordMemoryUsage(int stratum) {\n";
+        for (auto rel : prog.getRelations()) {
+            if (rel->getName()[0] == '@') {
+                continue;
+            }
+            const std::string& name = getRelationName(*rel);
+            os << "if (!" << name << "->empty()) {\n";
+            os << "for (const auto& index : " << name << "->getIndexMemoryUsage()) {\n";
+            os << "ProfileEventSingleton::instance().makeQuantityEvent(R\"_(@memory;" << rel->getName()
+               << ";)_\" + index.first, index.second, stratum);\n";
+            os << "}\n";
+            os << "}\n";
+        }
+        os << "}\n";  // end of recordMemoryUsage() method
     }
     os << "};\n";  // end of class declaration
 
@@ -2835,6 +3071,12 @@ void runFunction(std::string  inputDirectoryArg   = "",
     os << "};\n";
     os << "extern \"C\" {\n";
     os << "factory_" << classname << " __factory_" << classname << "_instance;\n";
+    if (Global::config().has("tiered")) {
+        // entry point of the shared library loaded for tiered execution
+        os << "SouffleProgram* souffle_tiered_instance() {\n";
+        os << "return new " << classname << "();\n";
+        os << "}\n";
+    }
     os << "}\n";
     os << "}\n";
     os << "#else\n";
@@ -65,6 +65,12 @@ private:
     /** Symbol map */
     mutable std::vector<std::string> symbolIndex;
 
+    /** Relations written and released by the output scheduler */
+    std::set<std::string> streamedRelations;
+
+    /** Whether the code of a prepared query is emitted, which clears relations regardless of IO */
+    bool inPreparedQuery = false;
+
 protected:
     /** Get record table */
     const RecordTable& getRecordTable();
@@ -129,5 +135,10 @@ public:
 
     /** Generate code */
     void generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary);
+
+    /** Get the symbols of the generated program in the order of their encoding */
+    const std::vector<std::string>& getSymbols() const {
+        return symbolIndex;
+    }
 };
 }  // namespace souffle::synthesiser
@@ -21,6 +21,8 @@
 #include <algorithm>
 #include <iostream>
 #include <random>
+#include <set>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -380,6 +382,34 @@ TEST(EqRelTest, IterBasic) {
     EXPECT_EQ(count, br.size());
 }
 
+TEST(EqRelTest, IterInsert) {
+    EqRel br;
+    br.insert(1, 2);
+    br.insert(3, 4);
+
+    // inserting pairs of a set does not re-link the member lists
+    auto it = br.begin();
+    br.insert(2, 1);
+    ++it;
+
+    // merging sets does, so iteration must not go on
+    br.insert(2, 3);
+    bool thrown = false;
+    try {
+        ++it;
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    std::size_t count = 0;
+    for (auto x : br) {
+        ++count;
+        testutil::ignore(x);
+    }
+    EXPECT_EQ(16, count);
+}
+
 TEST(EqRelTest, IterRange) {
     // write some tests to use that templated range for different indexes too
     EqRel br;
@@ -524,6 +554,85 @@ TEST(EqRelTest, IterPartition) {
     EXPECT_EQ(br.size(), values.size());
 }
 
+TEST(EqRelTest, ClassSize) {
+    EqRel br;
+    EXPECT_EQ(br.classSize(1), 0);
+
+    br.insert(1, 2);
+    br.insert(3, 4);
+    EXPECT_EQ(br.classSize(1), 2);
+    EXPECT_EQ(br.classSize(4), 2);
+    EXPECT_EQ(br.size(), 8);
+
+    // size and iteration must reflect insertions interleaved with lookups
+    br.insert(2, 3);
+    EXPECT_EQ(br.classSize(1), 4);
+    EXPECT_EQ(br.size(), 16);
+
+    std::size_t count = 0;
+    for (auto x : br.getBoundaries<1>({{4, 0}})) {
+        EXPECT_EQ(x[0], 4);
+        ++count;
+    }
+    EXPECT_EQ(count, 4);
+
+    br.insert(5, 5);
+    EXPECT_EQ(br.classSize(5), 1);
+    count = 0;
+    for (auto x : br) {
+        ++count;
+        testutil::ignore(x);
+    }
+    EXPECT_EQ(count, 17);
+}
+
+TEST(EqRelTest, IterPartitionSkewed) {
+    // one large set and many singletons
+    EqRel br;
+    const RamDomain N = 100;
+    for (RamDomain i = 0; i < N; ++i) {
+        br.insert(0, i);
+    }
+    for (RamDomain i = N; i < 2 * N; ++i) {
+        br.insert(i, i);
+    }
+    EXPECT_EQ(std::size_t(N * N + N), br.size());
+
+    const std::size_t chunks = 50;
+    auto parts = br.partition(chunks);
+    std::set<std::pair<RamDomain, RamDomain>> values;
+    std::size_t count = 0;
+    std::size_t largest = 0;
+    for (auto part : parts) {
+        std::size_t n = 0;
+        for (auto x : part) {
+            values.insert(std::make_pair(x[0], x[1]));
+            ++n;
+        }
+        count += n;
+        largest = std::max(largest, n);
+    }
+
+    // every pair is covered exactly once, by chunks of balanced size
+    EXPECT_EQ(br.size(), count);
+    EXPECT_EQ(br.size(), values.size());
+    EXPECT_TRUE(largest <= 2 * br.size() / chunks);
+    // singletons are grouped rather than being given a chunk each
+    EXPECT_LT(parts.size(), 2 * chunks);
+
+    // partitioning the pairs (5, _)
+    std::size_t total = 0;
+    parts = br.partitionRange({{5, MIN_RAM_SIGNED}}, 10);
+    EXPECT_EQ(10, parts.size());
+    for (auto part : parts) {
+        for (auto x : part) {
+            EXPECT_EQ(x[0], 5);
+            ++total;
+        }
+    }
+    EXPECT_EQ(std::size_t(N), total);
+}
+
 TEST(EqRelTest, Scaling) {
     const int N = 100;
 
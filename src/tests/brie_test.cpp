@@ -446,36 +446,45 @@ TEST(SparseArray, MemoryUsage) {
         // an empty one should be small
         EXPECT_TRUE(a.empty());
         // EXPECT_EQ(56, a.getMemoryUsage());
-        EXPECT_EQ(40, a.getMemoryUsage());
+        EXPECT_EQ(48, a.getMemoryUsage());
 
         // a single element should have the same size as an empty one
         a.update(12, 15);
         EXPECT_FALSE(a.empty());
         // EXPECT_EQ(56, a.getMemoryUsage());
-        EXPECT_EQ(560, a.getMemoryUsage());
+        EXPECT_EQ(568, a.getMemoryUsage());
 
         // more than one => there are nodes
         a.update(14, 18);
         EXPECT_FALSE(a.empty());
 
         // EXPECT_EQ(576, a.getMemoryUsage());
-        EXPECT_EQ(560, a.getMemoryUsage());
+        EXPECT_EQ(568, a.getMemoryUsage());
+
+        // copies account for their own nodes, cleared ones release them
+        SparseArray<int> b(a);
+        EXPECT_EQ(568, b.getMemoryUsage());
+        a.clear();
+        EXPECT_EQ(48, a.getMemoryUsage());
+        a = std::move(b);
+        EXPECT_EQ(568, a.getMemoryUsage());
+        EXPECT_EQ(48, b.getMemoryUsage());
     } else {
         SparseArray<int> a;
 
         // an empty one should be small
         EXPECT_TRUE(a.empty());
-        EXPECT_EQ(28, a.getMemoryUsage());
+        EXPECT_EQ(32, a.getMemoryUsage());
 
         // a single element should have the same size as an empty one
         a.update(12, 15);
         EXPECT_FALSE(a.empty());
-        EXPECT_EQ(288, a.getMemoryUsage());
+        EXPECT_EQ(292, a.getMemoryUsage());
 
         // more than one => there are nodes
         a.update(14, 18);
         EXPECT_FALSE(a.empty());
-        EXPECT_EQ(288, a.getMemoryUsage());
+        EXPECT_EQ(292, a.getMemoryUsage());
     }
 }
 
@@ -1644,6 +1653,66 @@ TEST(Trie, Size) {
     EXPECT_EQ(5, t.size());
 }
 
+TEST(Trie, Partition_Skewed) {
+    using entry_t = typename Trie<3>::entry_type;
+
+    // a single dominant first column, as well as a dominant second column within it
+    Trie<3> t;
+    std::set<entry_t> should;
+    for (RamDomain i = 0; i < 50; ++i) {
+        for (RamDomain j = 0; j < 200; ++j) {
+            entry_t e{1, j < 100 ? 7 : j, i};
+            t.insert(e);
+            should.insert(e);
+        }
+        entry_t e{i + 2, i, i};
+        t.insert(e);
+        should.insert(e);
+    }
+    EXPECT_EQ(should.size(), t.size());
+
+    const unsigned chunks = 20;
+    auto parts = t.partition(chunks);
+    EXPECT_TRUE(chunks / 2 <= parts.size());
+
+    // the partition covers each entry exactly once, in order
+    std::vector<entry_t> is;
+    std::size_t largest = 0;
+    for (const auto& part : parts) {
+        std::size_t n = 0;
+        for (const auto& cur : part) {
+            is.push_back(cur);
+            ++n;
+        }
+        largest = std::max(largest, n);
+    }
+    EXPECT_EQ(std::vector<entry_t>(should.begin(), should.end()), is);
+
+    // no chunk exceeds twice the requested share
+    EXPECT_TRUE(largest <= 2 * should.size() / chunks);
+}
+
+TEST(Trie, Partition_1D) {
+    Trie<1> t;
+    for (RamDomain i = 0; i < 10000; i += 3) {
+        t.insert({i});
+    }
+
+    auto parts = t.partition(10);
+    EXPECT_TRUE(5 <= parts.size());
+
+    std::size_t count = 0;
+    RamDomain last = -1;
+    for (const auto& part : parts) {
+        for (const auto& cur : part) {
+            EXPECT_LT(last, cur[0]);
+            last = cur[0];
+            ++count;
+        }
+    }
+    EXPECT_EQ(t.size(), count);
+}
+
 TEST(Trie, Limits) {
     Trie<2> data;
 
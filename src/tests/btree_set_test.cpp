@@ -501,6 +501,78 @@ TEST(BTreeSet, Clear) {
     EXPECT_TRUE(t.empty());
 }
 
+TEST(BTreeSet, MemoryUsage) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    EXPECT_EQ(sizeof(test_set), t.getMemoryUsage());
+
+    // the accounted memory grows with the nodes of the tree
+    std::size_t last = t.getMemoryUsage();
+    for (int i = 0; i < 1000; i++) {
+        t.insert(i);
+        EXPECT_FALSE(t.getMemoryUsage() < last);
+        last = t.getMemoryUsage();
+    }
+    EXPECT_LT(sizeof(test_set) + 1000 * sizeof(int), t.getMemoryUsage());
+
+    // copies and moves take the memory of the nodes along
+    test_set c = t;
+    EXPECT_LT(sizeof(test_set) + 1000 * sizeof(int), c.getMemoryUsage());
+    std::size_t copied = c.getMemoryUsage();
+    test_set m(std::move(c));
+    EXPECT_EQ(copied, m.getMemoryUsage());
+    EXPECT_EQ(sizeof(test_set), c.getMemoryUsage());
+
+    t.clear();
+    EXPECT_EQ(sizeof(test_set), t.getMemoryUsage());
+}
+
+TEST(BTreeSet, Reset) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    for (int i = 0; i < 10000; i++) {
+        t.insert(i);
+    }
+    std::size_t used = t.getMemoryUsage();
+
+    // the memory of the nodes is retained
+    t.reset();
+    EXPECT_TRUE(t.empty());
+    EXPECT_EQ(0, t.size());
+    EXPECT_EQ(used, t.getMemoryUsage());
+    EXPECT_FALSE(t.contains(5));
+
+    // and reused by the next round of insertions
+    for (int i = 0; i < 10000; i++) {
+        t.insert(i);
+    }
+    EXPECT_EQ(10000, t.size());
+    EXPECT_EQ(used, t.getMemoryUsage());
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_TRUE(t.contains(i));
+    }
+
+    t.clear();
+    EXPECT_EQ(sizeof(test_set), t.getMemoryUsage());
+}
+
+TEST(BTreeSet, ResetStrings) {
+    using test_set = btree_set<std::string, detail::comparator<std::string>, std::allocator<std::string>, 16>;
+
+    // keys which are not trivially destructible are destroyed on reset
+    test_set t;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 1000; i++) {
+            t.insert(std::string(100, 'a') + std::to_string(i));
+        }
+        EXPECT_EQ(1000, t.size());
+        t.reset();
+        EXPECT_TRUE(t.empty());
+    }
+}
+
 TEST(BTreeSet, ChunkSplit) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
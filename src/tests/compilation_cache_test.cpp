@@ -0,0 +1,115 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file compilation_cache_test.cpp
+ *
+ * Tests the cache of compiled programs.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "CompilationCache.h"
+#include "Global.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <utime.h>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+/** Creates a fresh directory for a cache */
+std::string makeCacheDir() {
+    char templ[] = "./souffle_cacheXXXXXX";
+    return mkdtemp(templ);
+}
+
+/** Writes an executable of the given size */
+std::string makeExecutable(const std::string& dir, std::size_t size) {
+    std::string name = dir + "/program";
+    std::ofstream(name) << std::string(size, 'x');
+    return name;
+}
+
+/** Sets the last use of an entry to the given time */
+void setLastUse(const std::string& path, time_t time) {
+    struct utimbuf times = {time, time};
+    utime(path.c_str(), &times);
+}
+
+}  // namespace
+
+TEST(CompilationCache, Key) {
+    Global::config().set("jobs", "1");
+    std::string key = CompilationCache::computeKey("a(1).");
+    EXPECT_EQ(key, CompilationCache::computeKey("a(1)."));
+    EXPECT_NE(key, CompilationCache::computeKey("a(2)."));
+
+    // cache options do not influence the program
+    Global::config().set("cache-dir", "somewhere");
+    EXPECT_EQ(key, CompilationCache::computeKey("a(1)."));
+
+    // other options do
+    Global::config().set("jobs", "4");
+    EXPECT_NE(key, CompilationCache::computeKey("a(1)."));
+    Global::config().set("jobs", "1");
+    Global::config().set("pragma", "legacy");
+    EXPECT_NE(key, CompilationCache::computeKey("a(1)."));
+}
+
+TEST(CompilationCache, StoreAndLookup) {
+    std::string dir = makeCacheDir();
+    CompilationCache cache(dir + "/nested/cache", 1 << 20);
+    EXPECT_EQ("", cache.lookup("key"));
+
+    std::string program = makeExecutable(dir, 100);
+    cache.store("key", program);
+    std::string entry = cache.lookup("key");
+    EXPECT_EQ(dir + "/nested/cache/key", entry);
+
+    std::ifstream in(entry);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(std::string(100, 'x'), content);
+
+    std::system(("rm -rf " + dir).c_str());
+}
+
+TEST(CompilationCache, Eviction) {
+    std::string dir = makeCacheDir();
+    CompilationCache cache(dir + "/cache", 300);
+    std::string program = makeExecutable(dir, 100);
+
+    cache.store("a", program);
+    setLastUse(dir + "/cache/a", 1000);
+    cache.store("b", program);
+    setLastUse(dir + "/cache/b", 2000);
+    cache.store("c", program);
+    setLastUse(dir + "/cache/c", 3000);
+
+    // looking up a makes b the least recently used entry
+    EXPECT_NE("", cache.lookup("a"));
+    cache.store("d", program);
+
+    EXPECT_NE("", cache.lookup("a"));
+    EXPECT_EQ("", cache.lookup("b"));
+    EXPECT_NE("", cache.lookup("c"));
+    EXPECT_NE("", cache.lookup("d"));
+
+    std::system(("rm -rf " + dir).c_str());
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -327,6 +327,37 @@ TEST(DjTest, Clear) {
     ds.clear();
 }
 
+TEST(DjTest, ClassMembers) {
+    souffle::DisjointSet ds;
+    constexpr std::size_t N = 10;
+    for (std::size_t i = 0; i < N; ++i) {
+        ds.makeNode();
+    }
+    EXPECT_EQ(ds.pairs(), N);
+
+    // two sets: the even and the odd nodes
+    for (std::size_t i = 2; i < N; ++i) {
+        ds.unionNodes(i - 2, i);
+    }
+    EXPECT_EQ(ds.classSize(0), N / 2);
+    EXPECT_EQ(ds.classSize(1), N / 2);
+    EXPECT_EQ(ds.pairs(), 2 * (N / 2) * (N / 2));
+
+    // walking the member list of a set visits each of its members exactly once
+    std::size_t count = 0;
+    parent_t cur = 4;
+    do {
+        EXPECT_EQ(cur % 2, 0);
+        ++count;
+        cur = ds.next(cur);
+    } while (cur != 4);
+    EXPECT_EQ(count, N / 2);
+
+    ds.unionNodes(3, 8);
+    EXPECT_EQ(ds.classSize(7), N);
+    EXPECT_EQ(ds.pairs(), N * N);
+}
+
 #ifdef _OPENMP
 TEST(DjTest, ParallelScaling) {
     // insert, union, and stuff in parallel, then check things are in the valid sets
@@ -353,6 +384,10 @@ TEST(DjTest, ParallelScaling) {
     for (std::size_t i = 0; i < N; ++i) {
         EXPECT_EQ(rep, ds.findNode(i));
     }
+
+    // the set sizes must have been maintained under concurrent unions
+    EXPECT_EQ(ds.classSize(0), N);
+    EXPECT_EQ(ds.pairs(), N * N);
 }
 #endif  // ifdef _OPENMP
 
@@ -0,0 +1,117 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file gzfstream_test.cpp
+ *
+ * Tests writing and reading back gzip files.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#ifdef USE_LIBZ
+
+#include "souffle/io/gzfstream.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+/** Returns the name of a fresh file */
+std::string makeFileName() {
+    char templ[] = "./souffle_gzXXXXXX";
+    int fd = mkstemp(templ);
+    close(fd);
+    return templ;
+}
+
+/** Lines of varying length and content, so that blocks are not trivially compressible */
+std::string makeContent(std::size_t numLines) {
+    std::string content;
+    unsigned int state = 42;
+    for (std::size_t i = 0; i < numLines; i++) {
+        state = state * 1103515245 + 12345;
+        content += std::to_string(i) + "\t" + std::to_string(state % 100000) + "\tsymbol" +
+                   std::string(state % 23, 'a' + static_cast<char>(state % 26)) + "\n";
+    }
+    return content;
+}
+
+/** Writes the content in a gzip file and returns the decompressed file */
+std::string roundTrip(const std::string& content) {
+    std::string fileName = makeFileName();
+    {
+        gzfstream::ogzfstream out(fileName);
+        out << content;
+    }
+    std::string result;
+    {
+        gzfstream::igzfstream in(fileName);
+        result.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    std::remove(fileName.c_str());
+    return result;
+}
+
+}  // namespace
+
+TEST(GZipStream, Empty) {
+    EXPECT_EQ("", roundTrip(""));
+}
+
+TEST(GZipStream, SingleBlock) {
+    const std::string content = makeContent(100);
+    EXPECT_EQ(content, roundTrip(content));
+}
+
+TEST(GZipStream, ManyBlocks) {
+    // exceeds the pending blocks of four threads and several chunks of input
+    TaskPool::instance().configure(4);
+    const std::string content = makeContent(200000);
+    EXPECT_LT(1 << 20, content.size());
+    EXPECT_EQ(content, roundTrip(content));
+}
+
+TEST(GZipStream, ManyBlocksSequential) {
+    TaskPool::instance().configure(1);
+    const std::string content = makeContent(50000);
+    EXPECT_EQ(content, roundTrip(content));
+}
+
+TEST(GZipStream, Lines) {
+    const std::string content = makeContent(10000);
+    std::string fileName = makeFileName();
+    {
+        gzfstream::ogzfstream out(fileName);
+        out << content;
+    }
+    gzfstream::igzfstream in(fileName);
+    std::string line;
+    std::size_t numLines = 0;
+    while (std::getline(in, line)) {
+        EXPECT_EQ(std::to_string(numLines), line.substr(0, line.find('\t')));
+        numLines++;
+    }
+    EXPECT_EQ(10000, numLines);
+    std::remove(fileName.c_str());
+}
+
+}  // namespace test
+}  // namespace souffle
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file hash_index_test.cpp
+ *
+ * A test case testing the hash index of tuples.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/HashIndex.h"
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+namespace test {
+
+using Pair = Tuple<RamDomain, 2>;
+using PairSet = HashIndex<Pair, true, 0, 1>;
+using FirstIndex = HashIndex<Pair, false, 0>;
+
+TEST(HashIndex, Basic) {
+    PairSet set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({1, 2}));
+    EXPECT_TRUE(set.begin() == set.end());
+
+    EXPECT_TRUE(set.insert({1, 2}));
+    EXPECT_FALSE(set.insert({1, 2}));
+    EXPECT_TRUE(set.insert({2, 1}));
+
+    EXPECT_EQ(2, set.size());
+    EXPECT_TRUE(set.contains({1, 2}));
+    EXPECT_TRUE(set.contains({2, 1}));
+    EXPECT_FALSE(set.contains({1, 1}));
+
+    EXPECT_TRUE(set.find({2, 1}) != set.end());
+    EXPECT_TRUE(*set.find({2, 1}) == Pair({2, 1}));
+    EXPECT_TRUE(set.find({2, 2}) == set.end());
+}
+
+TEST(HashIndex, Growth) {
+    const RamDomain n = 100000;
+    PairSet set;
+    for (RamDomain i = 0; i < n; i++) {
+        EXPECT_TRUE(set.insert({i, -i}));
+    }
+    EXPECT_EQ(n, set.size());
+
+    std::set<Pair> scanned(set.begin(), set.end());
+    EXPECT_EQ(n, scanned.size());
+    for (RamDomain i = 0; i < n; i++) {
+        EXPECT_TRUE(set.contains({i, -i}));
+        EXPECT_FALSE(set.contains({i, i + 1}));
+    }
+}
+
+TEST(HashIndex, EqualRange) {
+    FirstIndex index;
+    for (RamDomain i = 0; i < 100; i++) {
+        for (RamDomain j = 0; j < i; j++) {
+            index.insert({i, j});
+        }
+    }
+    EXPECT_EQ(99 * 100 / 2, index.size());
+
+    for (RamDomain i = 0; i < 100; i++) {
+        std::set<RamDomain> values;
+        for (const auto& pair : index.equalRange({i, 0})) {
+            EXPECT_EQ(i, pair[0]);
+            values.insert(pair[1]);
+        }
+        EXPECT_EQ(static_cast<std::size_t>(i), values.size());
+        EXPECT_EQ(i == 0, index.equalRange({i, 0}).empty());
+    }
+    EXPECT_TRUE(index.equalRange({100, 0}).empty());
+}
+
+TEST(HashIndex, Chunks) {
+    PairSet set;
+    EXPECT_TRUE(set.getChunks(10).empty());
+
+    for (RamDomain i = 0; i < 10000; i++) {
+        set.insert({i % 97, i});
+    }
+    std::size_t count = 0;
+    std::set<Pair> scanned;
+    for (const auto& chunk : set.getChunks(100)) {
+        for (const auto& pair : chunk) {
+            scanned.insert(pair);
+            count++;
+        }
+    }
+    EXPECT_EQ(10000, count);
+    EXPECT_EQ(10000, scanned.size());
+}
+
+TEST(HashIndex, ClearAndReset) {
+    PairSet set;
+    for (RamDomain i = 0; i < 1000; i++) {
+        set.insert({i, i});
+    }
+    const std::size_t memory = set.getMemoryUsage();
+
+    // resetting retains the entries and the largest tables, only the smaller tables are released
+    set.reset();
+    const std::size_t retained = set.getMemoryUsage();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({1, 1}));
+    EXPECT_LT(retained, memory);
+    EXPECT_TRUE(set.insert({1, 1}));
+    EXPECT_TRUE(set.contains({1, 1}));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_LT(set.getMemoryUsage(), retained);
+    EXPECT_TRUE(set.insert({1, 1}));
+    EXPECT_EQ(1, set.size());
+}
+
+#ifdef _OPENMP
+TEST(HashIndex, ParallelInsert) {
+    const RamDomain n = 100000;
+    std::vector<Pair> pairs;
+    for (RamDomain i = 0; i < n; i++) {
+        pairs.push_back({i % 1000, i});
+    }
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(1));
+
+    PairSet set;
+    FirstIndex index;
+    std::size_t duplicates = 0;
+#pragma omp parallel for reduction(+ : duplicates)
+    for (std::size_t i = 0; i < pairs.size(); i++) {
+        if (set.insert(pairs[i])) {
+            index.insert(pairs[i]);
+        }
+        duplicates += set.insert(pairs[i]) ? 1 : 0;
+    }
+
+    EXPECT_EQ(0, duplicates);
+    EXPECT_EQ(n, set.size());
+    EXPECT_EQ(n, index.size());
+    for (RamDomain i = 0; i < 1000; i++) {
+        std::size_t count = 0;
+        for (const auto& pair : index.equalRange({i, 0})) {
+            EXPECT_EQ(i, pair[0]);
+            count++;
+        }
+        EXPECT_EQ(n / 1000, count);
+    }
+}
+#endif
+
+}  // namespace test
+
+}  // namespace souffle
@@ -16,8 +16,13 @@
 
 #include "tests/test.h"
 
+#include "souffle/utility/NumaUtil.h"
 #include "souffle/utility/ParallelUtil.h"
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace souffle {
 
@@ -93,5 +98,141 @@ TEST(ParallelUtils, OptimisticReadWriteLock) {
 
     EXPECT_EQ(2 * (N / K), c);
 }
+
+TEST(TaskPool, ParallelFor) {
+    TaskPool::instance().configure(4);
+
+    std::vector<int> data(100000);
+    std::iota(data.begin(), data.end(), 0);
+
+    std::atomic<long> sum{0};
+    TaskPool::instance().parallelFor(
+            data.begin(), data.end(), [&](auto it) { sum += *it; }, 64);
+
+    EXPECT_EQ(100000L * 99999L / 2, sum);
+
+    // empty and small ranges are processed by the caller
+    std::vector<int> visited;
+    TaskPool::instance().parallelFor(data.begin(), data.begin(), [&](auto it) { visited.push_back(*it); });
+    EXPECT_TRUE(visited.empty());
+    TaskPool::instance().parallelFor(
+            data.begin(), data.begin() + 10, [&](auto it) { visited.push_back(*it); }, 16);
+    EXPECT_EQ(10, visited.size());
+}
+
+TEST(TaskPool, Nested) {
+    TaskPool::instance().configure(4);
+
+    const int N = 200;
+    std::vector<int> outer(N);
+    std::atomic<int> count{0};
+
+    TaskPool::instance().parallelFor(outer.begin(), outer.end(), [&](auto) {
+        std::vector<int> inner(N);
+        TaskPool::instance().parallelFor(inner.begin(), inner.end(), [&](auto) { count++; });
+    });
+
+    EXPECT_EQ(N * N, count);
+
+    // nested groups of tasks
+    std::atomic<int> leaves{0};
+    TaskGroup group;
+    for (int i = 0; i < 8; i++) {
+        group.spawn([&]() {
+            TaskGroup nested;
+            for (int j = 0; j < 8; j++) {
+                nested.spawn([&]() { leaves++; });
+            }
+            nested.wait();
+        });
+    }
+    group.wait();
+
+    EXPECT_EQ(64, leaves);
+}
+
+TEST(TaskPool, TeamsInTasks) {
+    TaskPool::instance().configure(4);
+    EXPECT_FALSE(TaskPool::inTask());
+
+    // parallel regions of teams run on a single thread inside the work of the pool
+    std::vector<int> data(64);
+    std::atomic<int> inTask{0};
+    std::atomic<int> teamSize{0};
+    TaskPool::instance().parallelFor(data.begin(), data.end(), [&](auto) {
+        inTask += TaskPool::inTask() ? 1 : 0;
+        PARALLEL_TEAM_START
+#ifdef _OPENMP
+        teamSize.fetch_add(omp_get_num_threads());
+#else
+        teamSize.fetch_add(1);
+#endif
+        PARALLEL_END
+    });
+    EXPECT_EQ(TaskPool::instance().getNumThreads() > 1 ? 64 : 0, inTask);
+    EXPECT_EQ(64, teamSize);
+    EXPECT_FALSE(TaskPool::inTask());
+
+#ifdef _OPENMP
+    // outside of the pool, the team is started as usual
+    omp_set_num_threads(4);
+    teamSize = 0;
+    PARALLEL_TEAM_START
+    teamSize++;
+    PARALLEL_END
+    EXPECT_EQ(4, teamSize);
+#endif
+}
+
+TEST(TaskPool, Exception) {
+    TaskPool::instance().configure(4);
+
+    std::vector<int> data(1000);
+    bool caught = false;
+    try {
+        TaskPool::instance().parallelFor(data.begin(), data.end(), [&](auto it) {
+            if (it - data.begin() == 500) {
+                throw std::runtime_error("failure");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    EXPECT_TRUE(caught);
+
+    // the pool remains usable
+    std::atomic<int> count{0};
+    TaskPool::instance().parallelFor(data.begin(), data.end(), [&](auto) { count++; });
+    EXPECT_EQ(1000, count);
+}
+
+TEST(TaskPool, Reconfigure) {
+    for (std::size_t n : {1, 2, 3, 8}) {
+        TaskPool::instance().configure(n, true);
+        EXPECT_EQ(n, TaskPool::instance().getNumThreads());
+
+        std::vector<int> data(1000);
+        std::atomic<int> count{0};
+        TaskPool::instance().parallelFor(data.begin(), data.end(), [&](auto) { count++; });
+        EXPECT_EQ(1000, count);
+    }
+}
+
+TEST(Numa, CpuList) {
+    EXPECT_EQ((std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}), parseCpuList("0-3,8,10-11\n"));
+    EXPECT_EQ((std::vector<unsigned>{5}), parseCpuList("5"));
+    EXPECT_EQ((std::vector<unsigned>{}), parseCpuList(""));
+    EXPECT_FALSE(getNumaNodes().empty());
+}
+
+TEST(Numa, Spread) {
+    // threads alternate between the nodes before filling up their cores
+    std::vector<std::vector<unsigned>> nodes = {{0, 1, 2}, {4, 5, 6}};
+    std::vector<unsigned> cores;
+    for (std::size_t thread = 0; thread < 8; ++thread) {
+        cores.push_back(getNumaCore(thread, nodes));
+    }
+    EXPECT_EQ((std::vector<unsigned>{0, 4, 1, 5, 2, 6, 0, 4}), cores);
+}
 }  // namespace test
 }  // end namespace souffle
@@ -44,4 +44,19 @@ TEST(SymbolTable, Inserts) {
     EXPECT_EQ(X.size(), 4);
 }
 
+TEST(SymbolTable, Compare) {
+    const std::vector<std::string> symbols = {"", "a", std::string("a\0", 2), "ab", "abcdefgh", "abcdefgh1",
+            "abcdefgh2", "abcdefghi", "b", "\xff", "\x7f", "Z", "abcdefgg~"};
+    SymbolTable table;
+    for (const auto& left : symbols) {
+        for (const auto& right : symbols) {
+            const int expected = left.compare(right);
+            const int actual = table.compare(table.encode(left), table.encode(right));
+            EXPECT_EQ(expected < 0, actual < 0);
+            EXPECT_EQ(expected == 0, actual == 0);
+            EXPECT_EQ(expected > 0, actual > 0);
+        }
+    }
+}
+
 }  // namespace souffle::test
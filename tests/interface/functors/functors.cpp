@@ -17,6 +17,7 @@
 #include "souffle/SymbolTable.h"
 #include <charconv>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -54,6 +55,10 @@ const char* ioo(FF_int n) {
     }
 }
 
+FF_int inv(FF_int n) {
+    return 100 / n;
+}
+
 FF_int factorial(FF_uint x) {
     if (x == 0) {
         return 1;
@@ -77,6 +82,40 @@ FF_float incr(FF_float x) {
     return x + 1.0;
 }
 
+// Batched Functors
+void souffle_batch_foo(size_t n, const void* const* args, void* results) {
+    const auto* ns = static_cast<const FF_int*>(args[0]);
+    const auto* ss = static_cast<const char* const*>(args[1]);
+    auto* rs = static_cast<FF_int*>(results);
+    for (size_t i = 0; i < n; i++) {
+        rs[i] = foo(ns[i], ss[i]);
+    }
+}
+
+void souffle_batch_ioo(size_t n, const void* const* args, void* results) {
+    const auto* ns = static_cast<const FF_int*>(args[0]);
+    auto* rs = static_cast<const char**>(results);
+    for (size_t i = 0; i < n; i++) {
+        rs[i] = ioo(ns[i]);
+    }
+}
+
+void souffle_batch_inv(size_t n, const void* const* args, void* results) {
+    const auto* ns = static_cast<const FF_int*>(args[0]);
+    auto* rs = static_cast<FF_int*>(results);
+    for (size_t i = 0; i < n; i++) {
+        rs[i] = inv(ns[i]);
+    }
+}
+
+void souffle_batch_incr(size_t n, const void* const* args, void* results) {
+    const auto* xs = static_cast<const FF_float*>(args[0]);
+    auto* rs = static_cast<FF_float*>(results);
+    for (size_t i = 0; i < n; i++) {
+        rs[i] = incr(xs[i]);
+    }
+}
+
 // Stateful Functors
 souffle::RamDomain mycat(souffle::SymbolTable* symbolTable, souffle::RecordTable* recordTable,
         souffle::RamDomain arg1, souffle::RamDomain arg2) {
@@ -0,0 +1,85 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file driver.cpp
+ *
+ * Driver program exchanging columns of tuples with a Souffle program
+ * using the OO-interface
+ *
+ ***********************************************************************/
+
+#include "souffle/SouffleInterface.h"
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+/**
+ * Error handler
+ */
+void error(std::string txt) {
+    std::cerr << "error: " << txt << "\n";
+    exit(1);
+}
+
+/**
+ * Main program
+ */
+int main(int /* argc */, char** /* argv */) {
+    // create an instance of program "insert_columns"
+    SouffleProgram* prog = ProgramFactory::newInstance("insert_columns");
+    if (prog == nullptr) {
+        error("cannot find program insert_columns");
+    }
+    Relation* edge = prog->getRelation("edge");
+    if (edge == nullptr) {
+        error("cannot find relation edge");
+    }
+
+    // encode the columns of relation "edge" with a single lookup of the symbol table
+    std::vector<std::string> sources = {"A", "B", "C", "D", "E", "F"};
+    std::vector<std::string> targets = {"B", "C", "D", "E", "F", "A"};
+    std::vector<RamDomain> sourceColumn(sources.size());
+    std::vector<RamDomain> targetColumn(targets.size());
+    prog->getSymbolTable().encode(sources.data(), sources.size(), sourceColumn.data());
+    prog->getSymbolTable().encode(targets.data(), targets.size(), targetColumn.data());
+
+    // insert all tuples at once
+    const RamDomain* edgeColumns[] = {sourceColumn.data(), targetColumn.data()};
+    edge->insertColumns(edgeColumns, sources.size());
+
+    // run program
+    prog->run();
+
+    // export output relation "path" into columns
+    Relation* path = prog->getRelation("path");
+    if (path == nullptr) {
+        error("cannot find relation path");
+    }
+    std::vector<RamDomain> srcColumn(path->size());
+    std::vector<RamDomain> destColumn(path->size());
+    RamDomain* pathColumns[] = {srcColumn.data(), destColumn.data()};
+    std::size_t n = path->exportColumns(pathColumns, path->size());
+    if (n != path->size()) {
+        error("cannot export relation path");
+    }
+
+    // decode the columns and print source and destination nodes
+    std::vector<std::string> src(n);
+    std::vector<std::string> dest(n);
+    prog->getSymbolTable().decode(srcColumn.data(), n, src.data());
+    prog->getSymbolTable().decode(destColumn.data(), n, dest.data());
+    for (std::size_t i = 0; i < n; i++) {
+        std::cout << src[i] << "-" << dest[i] << "\n";
+    }
+
+    // free program analysis
+    delete prog;
+}
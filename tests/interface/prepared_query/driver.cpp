@@ -0,0 +1,89 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file driver.cpp
+ *
+ * Driver program running several prepared queries on one program instance
+ *
+ ***********************************************************************/
+
+#include "souffle/SouffleInterface.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+/**
+ * Error handler
+ */
+void error(std::string txt) {
+    std::cerr << "error: " << txt << "\n";
+    exit(1);
+}
+
+/**
+ * Run a query and print its answer, each tuple prefixed by the query
+ */
+void query(SouffleProgram* prog, const std::string& relation, const std::string& adornment,
+        const std::vector<RamDomain>& args, const std::string& label, bool symbol = false) {
+    std::vector<RamDomain> answer = prog->executeQuery(relation, adornment, args);
+    if (answer.size() % 2 != 0) {
+        error("answer of " + label + " is not a list of pairs");
+    }
+    if (answer.empty()) {
+        std::cout << label << ": none\n";
+    }
+    for (std::size_t i = 0; i < answer.size(); i += 2) {
+        std::cout << label << ": ";
+        if (symbol) {
+            std::cout << prog->getSymbolTable().decode(answer[i]);
+        } else {
+            std::cout << answer[i];
+        }
+        std::cout << " " << answer[i + 1] << "\n";
+    }
+}
+
+/**
+ * Main program
+ */
+int main(int argc, char** argv) {
+    // check number of arguments
+    if (argc != 2) {
+        error("wrong number of arguments!");
+    }
+
+    // create an instance of program "prepared_query"
+    if (SouffleProgram* prog = ProgramFactory::newInstance("prepared_query")) {
+        // load all input relations from the fact directory, and store path in the current directory;
+        // the queries below must not store it again with their answers
+        prog->runAll(argv[1], ".");
+
+        // the answers of a query do not leak into the next one
+        query(prog, "path", "bf", {1}, "1 path(1,_)");
+        query(prog, "path", "bf", {4}, "2 path(4,_)");
+        query(prog, "path", "bf", {1}, "3 path(1,_)");
+        query(prog, "path", "bf", {9}, "4 path(9,_)");
+
+        // a different adornment of the same relation
+        query(prog, "path", "fb", {6}, "5 path(_,6)");
+
+        // a query re-running the strata of path and label
+        SymbolTable& symbols = prog->getSymbolTable();
+        query(prog, "label", "bf", {symbols.encode("b")}, "6 label(b,_)", true);
+        query(prog, "label", "bf", {symbols.encode("a")}, "7 label(a,_)", true);
+        query(prog, "path", "bf", {5}, "8 path(5,_)");
+
+        delete prog;
+    } else {
+        error("cannot find program prepared_query");
+    }
+}